@@ -0,0 +1,125 @@
+/*
+ * Interlaced Core Library
+ * Copyright (c) 2025 Your Name or Organization
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Measures the cost of logging calls that are filtered out, either at runtime
+// by Logger::set_level or at compile time by INTERLACED_CORE_MIN_LOG_LEVEL.
+
+#include "interlaced_core/logging.hpp"
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace interlaced::core::logging;
+
+namespace {
+
+    const std::string kMessage = "Filtered debug message";
+
+    // Keep the loop counter observable so the loop itself is not removed
+    template<typename T>
+    inline void do_not_optimize(T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : "+r"(value) : : "memory");
+#else
+        volatile T sink = value;
+        (void)sink;
+#endif
+    }
+
+    template<typename Body>
+    double ns_per_call(uint64_t iterations, Body body) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; ++i) {
+            body(i);
+            do_not_optimize(i);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(iterations);
+    }
+
+    template<typename Body>
+    void report(const char* name, uint64_t iterations, Body body) {
+        std::cout << "  " << name << ": " << ns_per_call(iterations, body) << " ns/call" << std::endl;
+    }
+
+    template<typename Body>
+    void report_threaded(const char* name, unsigned threads, uint64_t iterations, Body body) {
+        std::vector<double> results(threads);
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&results, t, iterations, body]() {
+                results[t] = ns_per_call(iterations, body);
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        double worst = 0.0;
+        for (double result : results) {
+            worst = result > worst ? result : worst;
+        }
+        std::cout << "  " << name << " (" << threads << " threads, slowest): " << worst << " ns/call" << std::endl;
+    }
+
+}
+
+int main() {
+    const uint64_t iterations = 20000000;
+    unsigned threads = std::thread::hardware_concurrency();
+    if (threads < 2) {
+        threads = 2;
+    }
+
+    Logger::set_level(LOG_ERROR);
+
+    std::cout << "Disabled logging call cost (INTERLACED_CORE_MIN_LOG_LEVEL="
+              << INTERLACED_CORE_MIN_LOG_LEVEL << ", runtime level ERROR)" << std::endl;
+
+    report("Logger::is_enabled(LOG_DEBUG)", iterations, [](uint64_t) {
+        bool enabled = Logger::is_enabled(LOG_DEBUG);
+        do_not_optimize(enabled);
+    });
+    report("Logger::debug(message)", iterations, [](uint64_t) {
+        Logger::debug(kMessage);
+    });
+    report("Logger::debug(format, arg)", iterations, [](uint64_t i) {
+        Logger::debug("Value {}", i);
+    });
+    report("Logger::info(message, key, value)", iterations, [](uint64_t i) {
+        Logger::info(kMessage, "key", i);
+    });
+    report("LOG_DEBUG(message)", iterations, [](uint64_t) {
+        LOG_DEBUG(kMessage);
+    });
+    report("LOG_WARNING(message)", iterations, [](uint64_t) {
+        LOG_WARNING(kMessage);
+    });
+    report_threaded("Logger::debug(format, arg)", threads, iterations / 4, [](uint64_t i) {
+        Logger::debug("Value {}", i);
+    });
+
+    return 0;
+}
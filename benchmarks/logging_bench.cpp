@@ -0,0 +1,352 @@
+/*
+ * Interlaced Core Library
+ * Copyright (c) 2025 Your Name or Organization
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Measures logging throughput and per-call latency for each logging path
+// across 1..N producer threads, and prints the results as JSON (or CSV) so
+// runs can be compared between versions of logging.hpp.
+//
+// Usage: logging_bench [--threads N] [--messages M] [--format json|csv]
+//                      [--output FILE] [--scenario NAME]...
+
+#include "interlaced_core/logging.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace interlaced::core::logging;
+
+namespace {
+
+    // Stream buffer that discards everything, so the output device is not measured
+    class NullBuffer : public std::streambuf {
+    protected:
+        int_type overflow(int_type ch) override {
+            return traits_type::not_eof(ch);
+        }
+
+        std::streamsize xsputn(const char*, std::streamsize n) override {
+            return n;
+        }
+    };
+
+    NullBuffer null_buffer;
+    std::ostream null_stream(&null_buffer);
+
+    // Formatter in the style of a typical user-supplied LogFormatter: builds a string per call
+    class BenchFormatter : public LogFormatter {
+    public:
+        std::string format(LogLevel level, const std::string& message,
+                           const std::tm& time_info, const char* file = nullptr, int line = 0) override {
+            char timestamp[32];
+            std::strftime(timestamp, sizeof(timestamp), "%H:%M:%S", &time_info);
+            std::string out = "<";
+            out += timestamp;
+            out += "> ";
+            out += log_level_to_string(level);
+            out += ": ";
+            out += message;
+            if (file && line > 0) {
+                out += " @";
+                out += file;
+            }
+            return out;
+        }
+    };
+
+    const std::string kMessage = "Request handled by the benchmark worker thread";
+    const std::string kBenchDirectory = "logging_bench_files";
+
+    struct Scenario {
+        const char* name;
+        const char* description;
+        void (*setup)();
+        void (*log)(uint64_t i);
+    };
+
+    void use_null_streams() {
+        Logger::set_file_logging("", 0, 0);
+        Logger::set_formatter(nullptr);
+        Logger::set_output_streams(null_stream, null_stream);
+        Logger::set_level(LOG_INFO);
+    }
+
+    void use_file(size_t max_file_size) {
+        use_null_streams();
+        std::filesystem::remove_all(kBenchDirectory);
+        std::filesystem::create_directories(kBenchDirectory);
+        Logger::set_file_logging(kBenchDirectory + "/bench.log", max_file_size, 3);
+    }
+
+    const Scenario kScenarios[] = {
+        {"filtered", "Logger::debug(format, arg) below the runtime level",
+         [] {
+             use_null_streams();
+             Logger::set_level(LOG_ERROR);
+         },
+         [](uint64_t i) { Logger::debug("Value {}", i); }},
+        {"ostream", "Logger::info(message) to an ostream with the default formatter",
+         [] { use_null_streams(); },
+         [](uint64_t) { Logger::info(kMessage); }},
+        {"file", "Logger::info(message) to a RotatingFileLogger that never rotates",
+         [] { use_file(size_t(1) << 40); },
+         [](uint64_t) { Logger::info(kMessage); }},
+        {"file_rotating", "Logger::info(message) to a RotatingFileLogger rotating every 1MB",
+         [] { use_file(1024 * 1024); },
+         [](uint64_t) { Logger::info(kMessage); }},
+        {"file_rotating_async", "file_rotating with writes handed to io_uring (or a writer thread)",
+         [] {
+             use_file(1024 * 1024);
+             Logger::enable_file_async_writes();
+         },
+         [](uint64_t) { Logger::info(kMessage); }},
+        {"custom_formatter", "Logger::info(message) through a custom LogFormatter",
+         [] {
+             use_null_streams();
+             Logger::set_formatter(std::make_unique<BenchFormatter>());
+         },
+         [](uint64_t) { Logger::info(kMessage); }},
+        {"format_template", "Logger::info(\"{} templates\", args...)",
+         [] { use_null_streams(); },
+         [](uint64_t i) { Logger::info("Request {} served in {}ms with status {}", i, 1.5, "OK"); }},
+        {"structured", "Logger::info(message, key, value, ...)",
+         [] { use_null_streams(); },
+         [](uint64_t i) { Logger::info(kMessage, "request_id", i, "status", 200, "cached", false); }},
+    };
+
+    struct Result {
+        std::string scenario;
+        unsigned threads = 0;
+        uint64_t messages = 0;
+        double seconds = 0;
+        double messages_per_second = 0;
+        uint64_t p50_ns = 0;
+        uint64_t p99_ns = 0;
+        uint64_t p999_ns = 0;
+        uint64_t max_ns = 0;
+    };
+
+    uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // Median cost of reading the clock, which every latency sample includes once
+    uint64_t timer_overhead_ns() {
+        std::vector<uint64_t> samples(10000);
+        for (auto& sample : samples) {
+            const uint64_t start = now_ns();
+            sample = now_ns() - start;
+        }
+        std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+        return samples[samples.size() / 2];
+    }
+
+    uint64_t percentile(const std::vector<uint64_t>& sorted, double fraction) {
+        if (sorted.empty()) {
+            return 0;
+        }
+        const size_t index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1));
+        return sorted[index];
+    }
+
+    Result run(const Scenario& scenario, unsigned threads, uint64_t messages) {
+        scenario.setup();
+
+        // Warm up per-thread buffers and caches before measuring
+        for (uint64_t i = 0; i < 1000; ++i) {
+            scenario.log(i);
+        }
+        Logger::flush();
+
+        std::vector<std::vector<uint64_t>> latencies(threads, std::vector<uint64_t>(messages));
+        std::atomic<unsigned> ready{0};
+        std::atomic<bool> go{false};
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t]() {
+                std::vector<uint64_t>& samples = latencies[t];
+                ready.fetch_add(1);
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                for (uint64_t i = 0; i < messages; ++i) {
+                    const uint64_t start = now_ns();
+                    scenario.log(i);
+                    samples[i] = now_ns() - start;
+                }
+            });
+        }
+        while (ready.load() != threads) {
+            std::this_thread::yield();
+        }
+        const uint64_t start = now_ns();
+        go.store(true, std::memory_order_release);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        Logger::flush();
+        const uint64_t elapsed = now_ns() - start;
+
+        std::vector<uint64_t> all;
+        all.reserve(static_cast<size_t>(threads) * messages);
+        for (const auto& samples : latencies) {
+            all.insert(all.end(), samples.begin(), samples.end());
+        }
+        std::sort(all.begin(), all.end());
+
+        Result result;
+        result.scenario = scenario.name;
+        result.threads = threads;
+        result.messages = all.size();
+        result.seconds = static_cast<double>(elapsed) / 1e9;
+        result.messages_per_second = result.seconds > 0 ? static_cast<double>(all.size()) / result.seconds : 0;
+        result.p50_ns = percentile(all, 0.50);
+        result.p99_ns = percentile(all, 0.99);
+        result.p999_ns = percentile(all, 0.999);
+        result.max_ns = all.empty() ? 0 : all.back();
+        return result;
+    }
+
+    void write_json(std::ostream& out, const std::vector<Result>& results, uint64_t overhead, uint64_t messages) {
+        out << "{\n";
+        out << "  \"benchmark\": \"logging_bench\",\n";
+        out << "  \"schema_version\": 1,\n";
+#if defined(__VERSION__)
+        out << "  \"compiler\": \"" << __VERSION__ << "\",\n";
+#endif
+        out << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+        out << "  \"messages_per_thread\": " << messages << ",\n";
+        out << "  \"timer_overhead_ns\": " << overhead << ",\n";
+        out << "  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            out << "    {\"scenario\": \"" << r.scenario << "\", \"threads\": " << r.threads
+                << ", \"messages\": " << r.messages << ", \"seconds\": " << r.seconds
+                << ", \"messages_per_sec\": " << static_cast<uint64_t>(r.messages_per_second)
+                << ", \"p50_ns\": " << r.p50_ns << ", \"p99_ns\": " << r.p99_ns
+                << ", \"p999_ns\": " << r.p999_ns << ", \"max_ns\": " << r.max_ns << "}"
+                << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n";
+        out << "}\n";
+    }
+
+    void write_csv(std::ostream& out, const std::vector<Result>& results) {
+        out << "scenario,threads,messages,seconds,messages_per_sec,p50_ns,p99_ns,p999_ns,max_ns\n";
+        for (const Result& r : results) {
+            out << r.scenario << ',' << r.threads << ',' << r.messages << ',' << r.seconds << ','
+                << static_cast<uint64_t>(r.messages_per_second) << ',' << r.p50_ns << ',' << r.p99_ns << ','
+                << r.p999_ns << ',' << r.max_ns << '\n';
+        }
+    }
+
+    void usage() {
+        std::cerr << "Usage: logging_bench [--threads N] [--messages M] [--format json|csv] [--output FILE]"
+                  << " [--scenario NAME]..." << std::endl;
+        std::cerr << "Scenarios:" << std::endl;
+        for (const Scenario& scenario : kScenarios) {
+            std::cerr << "  " << scenario.name << ": " << scenario.description << std::endl;
+        }
+    }
+
+}
+
+int main(int argc, char* argv[]) {
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t messages = 100000;
+    std::string format = "json";
+    std::string output;
+    std::vector<std::string> selected;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--threads" && has_value) {
+            max_threads = static_cast<unsigned>(std::max(1L, std::strtol(argv[++i], nullptr, 10)));
+        } else if (arg == "--messages" && has_value) {
+            messages = std::max<uint64_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--format" && has_value) {
+            format = argv[++i];
+        } else if (arg == "--output" && has_value) {
+            output = argv[++i];
+        } else if (arg == "--scenario" && has_value) {
+            selected.push_back(argv[++i]);
+        } else {
+            usage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    if (format != "json" && format != "csv") {
+        usage();
+        return 1;
+    }
+
+    // 1, 2, 4, ... threads, always ending with max_threads
+    std::vector<unsigned> thread_counts;
+    for (unsigned threads = 1; threads < max_threads; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    std::vector<Result> results;
+    for (const Scenario& scenario : kScenarios) {
+        if (!selected.empty() && std::find(selected.begin(), selected.end(), scenario.name) == selected.end()) {
+            continue;
+        }
+        for (unsigned threads : thread_counts) {
+            std::cerr << "Running " << scenario.name << " with " << threads << " thread(s)..." << std::endl;
+            results.push_back(run(scenario, threads, messages));
+        }
+    }
+
+    // Restore the defaults and remove the files written by the file scenarios
+    Logger::set_file_logging("", 0, 0);
+    Logger::set_formatter(nullptr);
+    Logger::set_output_streams(std::cout, std::cerr);
+    std::filesystem::remove_all(kBenchDirectory);
+
+    std::ofstream file;
+    if (!output.empty()) {
+        file.open(output);
+        if (!file) {
+            std::cerr << "Cannot write " << output << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = output.empty() ? std::cout : file;
+    if (format == "csv") {
+        write_csv(out, results);
+    } else {
+        write_json(out, results, timer_overhead_ns(), messages);
+    }
+    return 0;
+}
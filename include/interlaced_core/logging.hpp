@@ -32,7 +32,94 @@
 #include <sstream>
 #include <memory>
 #include <fstream>
+#include <filesystem>
 #include <functional>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <vector>
+#include <string_view>
+#include <charconv>
+#include <cstdio>
+#include <ctime>
+#include <type_traits>
+#include <limits>
+#include <cstring>
+#include <cstdint>
+#include <unordered_map>
+#include <deque>
+#include <optional>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <csignal>
+#include <cstddef>
+#include <cerrno>
+#include <sys/stat.h>
+
+// Platform-specific includes for native file output
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netdb.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+// io_uring is driven through its raw system calls, so liburing is not needed
+#if defined(__linux__) && defined(__has_include) && !defined(INTERLACED_CORE_DISABLE_IO_URING)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <poll.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#define INTERLACED_CORE_HAS_IO_URING 1
+#endif
+#endif
+#endif
+
+// SSE2 is part of every x86-64 target; the log search scanner falls back to scalar code elsewhere
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#include <emmintrin.h>
+#define INTERLACED_CORE_HAS_SSE2 1
+#endif
+
+/**
+ * @brief Numeric log levels for use in preprocessor conditions
+ *
+ * These mirror the LogLevel enum and can be passed to INTERLACED_CORE_MIN_LOG_LEVEL.
+ */
+#define INTERLACED_CORE_LOG_LEVEL_DEBUG   0
+#define INTERLACED_CORE_LOG_LEVEL_INFO    1
+#define INTERLACED_CORE_LOG_LEVEL_WARNING 2
+#define INTERLACED_CORE_LOG_LEVEL_ERROR   3
+#define INTERLACED_CORE_LOG_LEVEL_OFF     4
+
+/**
+ * @brief Compile-time minimum log level
+ *
+ * Messages below this level are removed at compile time: the LOG_* macros expand
+ * to nothing and the Logger methods for those levels have empty bodies.
+ * Define it before including this header (or on the compiler command line), e.g.
+ * -DINTERLACED_CORE_MIN_LOG_LEVEL=INTERLACED_CORE_LOG_LEVEL_WARNING.
+ */
+#ifndef INTERLACED_CORE_MIN_LOG_LEVEL
+#ifdef INTERLACED_CORE_DISABLE_DEBUG_LOGS
+#define INTERLACED_CORE_MIN_LOG_LEVEL INTERLACED_CORE_LOG_LEVEL_INFO
+#else
+#define INTERLACED_CORE_MIN_LOG_LEVEL INTERLACED_CORE_LOG_LEVEL_DEBUG
+#endif
+#endif
 
 // Platform-specific time conversion helper
 inline void localtime_threadsafe(const std::time_t* time, std::tm* tm) {
@@ -43,6 +130,15 @@ inline void localtime_threadsafe(const std::time_t* time, std::tm* tm) {
 #endif
 }
 
+// Platform-specific UTC time conversion helper
+inline void gmtime_threadsafe(const std::time_t* time, std::tm* tm) {
+#if defined(_MSC_VER) || defined(_WIN32)
+    gmtime_s(tm, time);
+#else
+    gmtime_r(time, tm);
+#endif
+}
+
 /**
  * @brief Core logging utilities for the Interlaced framework
  *
@@ -89,12 +185,22 @@ namespace interlaced {
              * @brief Timestamp format options
              */
             enum class TimestampFormat {
-                STANDARD,     ///< YYYY-MM-DD HH:MM:SS
-                ISO8601,      ///< YYYY-MM-DDTHH:MM:SSZ
+                STANDARD,     ///< YYYY-MM-DD HH:MM:SS (local time)
+                ISO8601,      ///< YYYY-MM-DDTHH:MM:SSZ (UTC)
                 UNIX,         ///< Unix timestamp (seconds since epoch)
                 NONE          ///< No timestamp
             };
 
+            /**
+             * @brief Sub-second precision appended to timestamps
+             */
+            enum class TimestampPrecision {
+                SECONDS,      ///< No fractional part
+                MILLISECONDS, ///< .mmm
+                MICROSECONDS, ///< .uuuuuu
+                NANOSECONDS   ///< .nnnnnnnnn
+            };
+
             /**
              * @brief File rotation strategy
              */
@@ -104,609 +210,9284 @@ namespace interlaced {
             };
 
             /**
-             * @brief File logger with rotation capabilities
+             * @brief Compression applied to rotated log files
              */
-            class RotatingFileLogger {
-            private:
-                std::string base_filename_;
-                std::ofstream current_file_;
-                size_t max_file_size_;
-                int max_files_;
-                RotationStrategy strategy_;
-                std::chrono::steady_clock::time_point last_rotation_;
-                std::chrono::hours rotation_interval_;
-                size_t current_file_size_;
+            enum class LogCompression {
+                NONE,         ///< Keep rotated files as plain text
+                LZ            ///< Compress rotated files in the background to "<file>.N.iclz"
+            };
 
-            public:
-                /**
-                 * @brief Constructor for RotatingFileLogger
-                 *
-                 * @param base_filename The base filename for log files
-                 * @param max_file_size Maximum size of each log file (in bytes)
-                 * @param max_files Maximum number of log files to keep
-                 */
-                RotatingFileLogger(const std::string& base_filename, size_t max_file_size = 10485760, int max_files = 5)
-                    : base_filename_(base_filename), max_file_size_(max_file_size), max_files_(max_files),
-                      strategy_(RotationStrategy::SIZE), last_rotation_(std::chrono::steady_clock::now()),
-                      rotation_interval_(std::chrono::hours(24)), current_file_size_(0) {
-                    open_current_file();
-                }
+            /**
+             * @brief When RotatingFileLogger pushes its user-space buffer to the file
+             *
+             * Messages are collected in a buffer of buffer_capacity bytes and written
+             * with a single write/writev call once any trigger fires. A full buffer is
+             * always written. The default policy flushes after every message.
+             *
+             * Example:
+             * @code
+             * auto policy = FlushPolicy::every_interval(std::chrono::milliseconds(200));
+             * policy.flush_on_level = true; // ...and immediately for LOG_ERROR
+             * Logger::set_file_logging("app.log", 10485760, 5, policy);
+             * @endcode
+             */
+            struct FlushPolicy {
+                size_t buffer_capacity = 64 * 1024;           ///< Size of the user-space write buffer in bytes
+                size_t flush_bytes = 0;                       ///< Flush once this many bytes are buffered (0: after every message)
+                std::chrono::milliseconds flush_interval{0};  ///< Flush once buffered data is this old (0: no time trigger)
+                bool flush_on_level = false;                  ///< Flush immediately for messages at or above flush_level
+                LogLevel flush_level = LOG_ERROR;             ///< Level that triggers an immediate flush
 
                 /**
-                 * @brief Constructor for RotatingFileLogger with time-based rotation
-                 *
-                 * @param base_filename The base filename for log files
-                 * @param rotation_hours Hours between log rotations
-                 * @param max_files Maximum number of log files to keep
+                 * @brief Flush after every message (the default)
                  */
-                RotatingFileLogger(const std::string& base_filename, std::chrono::hours rotation_hours, int max_files = 5)
-                    : base_filename_(base_filename), max_file_size_(0), max_files_(max_files),
-                      strategy_(RotationStrategy::TIME), last_rotation_(std::chrono::steady_clock::now()),
-                      rotation_interval_(rotation_hours), current_file_size_(0) {
-                    open_current_file();
+                static FlushPolicy every_message() {
+                    return FlushPolicy();
                 }
 
                 /**
-                 * @brief Write a message to the log file
+                 * @brief Flush whenever at least bytes bytes are buffered
                  *
-                 * @param message The message to write
+                 * @param bytes Flush threshold in bytes
                  */
-                void write(const std::string& message) {
-                    try {
-                        if (!current_file_.is_open()) {
-                            // Try to reopen the file
-                            open_current_file();
-                            if (!current_file_.is_open()) {
-                                // If we still can't open the file, fall back to cerr
-                                std::cerr << "Failed to open log file: " << base_filename_ << std::endl;
-                                std::cerr << message << std::endl;
-                                return;
-                            }
-                        }
-
-                        // Check if we need to rotate
-                        if (should_rotate()) {
-                            rotate();
-                        }
-
-                        current_file_ << message << std::endl;
-                        current_file_.flush();
-
-                        // Update file size for size-based rotation
-                        if (strategy_ == RotationStrategy::SIZE) {
-                            current_file_size_ += message.length() + 1; // +1 for newline
-                        }
-
-                        // Check if the stream is in a good state
-                        if (!current_file_.good()) {
-                            // If the stream is not good, try to reset it
-                            current_file_.clear();
-                        }
-                    } catch (const std::exception& e) {
-                        // If we can't write to the file, try to write to cerr as a fallback
-                        std::cerr << "File logging error: " << e.what() << std::endl;
-                        std::cerr << message << std::endl;
-                    } catch (...) {
-                        // If we can't write to the file, try to write to cerr as a fallback
-                        std::cerr << "Unknown file logging error occurred" << std::endl;
-                        std::cerr << message << std::endl;
+                static FlushPolicy every_bytes(size_t bytes) {
+                    FlushPolicy policy;
+                    policy.flush_bytes = bytes;
+                    if (policy.buffer_capacity < bytes) {
+                        policy.buffer_capacity = bytes;
                     }
+                    return policy;
                 }
 
-            private:
                 /**
-                 * @brief Open the current log file
+                 * @brief Flush once the oldest buffered message is older than interval
+                 *
+                 * The age is checked when messages are written, on Logger::flush(), and by
+                 * the writer thread whenever the asynchronous queue runs dry.
+                 *
+                 * @param interval Maximum age of buffered data
                  */
-                void open_current_file() {
-                    try {
-                        current_file_.open(base_filename_, std::ios::app);
-                        if (current_file_.is_open() && strategy_ == RotationStrategy::SIZE) {
-                            // Get current file size
-                            current_file_.seekp(0, std::ios::end);
-                            current_file_size_ = current_file_.tellp();
-                        }
-                    } catch (const std::exception& e) {
-                        std::cerr << "Error opening log file: " << e.what() << std::endl;
-                    }
+                static FlushPolicy every_interval(std::chrono::milliseconds interval) {
+                    FlushPolicy policy;
+                    policy.flush_bytes = std::numeric_limits<size_t>::max();
+                    policy.flush_interval = interval;
+                    return policy;
                 }
 
                 /**
-                 * @brief Check if we should rotate the log file
+                 * @brief Flush only for messages at or above level (and when the buffer fills)
                  *
-                 * @return true if we should rotate, false otherwise
+                 * @param level Minimum level that forces a flush
                  */
-                bool should_rotate() {
-                    try {
-                        if (strategy_ == RotationStrategy::SIZE) {
-                            return current_file_size_ >= max_file_size_;
-                        } else { // TIME strategy
-                            auto now = std::chrono::steady_clock::now();
-                            auto elapsed = std::chrono::duration_cast<std::chrono::hours>(now - last_rotation_);
-                            return elapsed >= rotation_interval_;
-                        }
-                    } catch (...) {
-                        // If there's an error checking rotation, default to not rotating
-                        return false;
-                    }
+                static FlushPolicy on_level(LogLevel level = LOG_ERROR) {
+                    FlushPolicy policy;
+                    policy.flush_bytes = std::numeric_limits<size_t>::max();
+                    policy.flush_on_level = true;
+                    policy.flush_level = level;
+                    return policy;
                 }
 
                 /**
-                 * @brief Rotate the log files
+                 * @brief Flush only on explicit flush() calls (and when the buffer fills)
                  */
-                void rotate() {
-                    try {
-                        current_file_.close();
+                static FlushPolicy explicit_only() {
+                    FlushPolicy policy;
+                    policy.flush_bytes = std::numeric_limits<size_t>::max();
+                    return policy;
+                }
+            };
 
-                        // Rename existing files
-                        for (int i = max_files_ - 1; i > 0; --i) {
-                            std::string old_name = base_filename_ + "." + std::to_string(i);
-                            std::string new_name = base_filename_ + "." + std::to_string(i + 1);
+            /**
+             * @brief Settings for writing a log file with asynchronous I/O
+             *
+             * See RotatingFileLogger::enable_async_writes().
+             */
+            struct AsyncWriteOptions {
+                size_t max_in_flight = 8;        ///< Write buffers handed off at once; flushes wait when all are busy
+                size_t buffer_size = 64 * 1024;  ///< Bytes per write buffer
+                bool use_io_uring = true;        ///< Use io_uring where available instead of the writer thread
+            };
 
-                            // Remove the new file if it exists
-                            std::remove(new_name.c_str());
+            /**
+             * @brief Counters of a log file's asynchronous writes
+             */
+            struct AsyncWriteStats {
+                bool io_uring = false;           ///< Writes go through io_uring rather than the writer thread
+                bool registered_buffers = false; ///< The write buffers are registered with the kernel
+                uint64_t submitted = 0;          ///< Write buffers handed off
+                uint64_t completed = 0;          ///< Write buffers fully written
+                uint64_t failed = 0;             ///< Write buffers given up on after an error
+                uint64_t bytes_written = 0;      ///< Bytes in completed write buffers
+                uint64_t backpressure_waits = 0; ///< Times a write waited because every buffer was in flight
+                size_t in_flight = 0;            ///< Write buffers currently handed off
+                size_t max_in_flight = 0;        ///< Highest in_flight seen
+            };
 
-                            // Rename the old file to new name
-                            std::rename(old_name.c_str(), new_name.c_str());
-                        }
+            /**
+             * @brief Distribution of durations in power-of-two nanosecond buckets
+             *
+             * Bucket 0 counts zero durations and bucket i counts durations in
+             * [2^(i-1), 2^i) nanoseconds; the last bucket also takes anything longer.
+             */
+            struct LatencyHistogram {
+                static constexpr size_t kBuckets = 40;
 
-                        // Rename current file to .1
-                        std::string backup_name = base_filename_ + ".1";
-                        std::rename(base_filename_.c_str(), backup_name.c_str());
+                std::array<uint64_t, kBuckets> buckets{};
+                uint64_t count = 0;    ///< Durations recorded
+                uint64_t total_ns = 0; ///< Sum of all durations
+                uint64_t max_ns = 0;   ///< Longest duration
 
-                        // Open new file
-                        open_current_file();
-                        current_file_size_ = 0;
-                        last_rotation_ = std::chrono::steady_clock::now();
-                    } catch (const std::exception& e) {
-                        std::cerr << "Error rotating log files: " << e.what() << std::endl;
-                        // Try to reopen the current file
-                        open_current_file();
+                /**
+                 * @brief Upper bound of the bucket that holds the given percentile
+                 *
+                 * @param percent Percentile between 0 and 100
+                 * @return Nanoseconds, never more than max_ns; 0 when nothing was recorded
+                 */
+                uint64_t percentile(double percent) const {
+                    if (count == 0) {
+                        return 0;
                     }
+                    const double clamped = std::min(100.0, std::max(0.0, percent));
+                    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clamped / 100.0 * count)));
+                    uint64_t seen = 0;
+                    for (size_t i = 0; i < kBuckets; ++i) {
+                        seen += buckets[i];
+                        if (seen >= rank) {
+                            return i == 0 ? 0 : std::min(max_ns, (uint64_t(1) << i) - 1);
+                        }
+                    }
+                    return max_ns;
+                }
+
+                /**
+                 * @brief Average duration in nanoseconds
+                 */
+                double mean_ns() const {
+                    return count == 0 ? 0.0 : static_cast<double>(total_ns) / static_cast<double>(count);
                 }
             };
 
             /**
-             * @brief Log formatter interface
+             * @brief Counters of one registered sink
              */
-            class LogFormatter {
-            public:
-                virtual ~LogFormatter() = default;
-                virtual std::string format(LogLevel level, const std::string& message,
-                                          const std::tm& time_info, const char* file = nullptr, int line = 0) = 0;
+            struct SinkStats {
+                std::string name;
+                uint64_t messages = 0;       ///< Messages handed to the sink
+                uint64_t bytes = 0;          ///< Formatted bytes handed to the sink
+                size_t queue_depth = 0;      ///< Messages waiting in the sink's async queue
+                size_t max_queue_depth = 0;  ///< Deepest the async queue has been seen
+                size_t dropped = 0;          ///< Messages discarded by the queue's overflow policy
             };
 
             /**
-             * @brief Default log formatter implementation
+             * @brief Snapshot of the logging subsystem's own counters, see Logger::stats()
+             *
+             * The per-level arrays are indexed by LogLevel. Counters only grow, so
+             * rates come from the difference of two snapshots.
              */
-            class DefaultLogFormatter : public LogFormatter {
-            private:
-                TimestampFormat timestamp_format_;
-                std::string prefix_;
+            struct LoggerStats {
+                std::array<uint64_t, 4> emitted{};    ///< Messages passed on to the outputs
+                std::array<uint64_t, 4> suppressed{}; ///< Repeats held back by duplicate suppression
+                std::array<uint64_t, 4> throttled{};  ///< Calls skipped by LOG_*_EVERY_N, LOG_*_RATE and LOG_*_SAMPLED
+                std::array<uint64_t, 4> dropped{};    ///< Messages discarded by a full async queue
+                uint64_t file_messages = 0;           ///< Lines written through RotatingFileLogger
+                uint64_t file_bytes = 0;              ///< Bytes written through RotatingFileLogger
+                uint64_t rotations = 0;               ///< Completed RotatingFileLogger::rotate() calls
+                LatencyHistogram file_write;          ///< Time spent in RotatingFileLogger::write()
+                LatencyHistogram file_rotate;         ///< Time spent in RotatingFileLogger::rotate()
+                size_t queue_depth = 0;               ///< Messages waiting in the Logger's async queue
+                size_t max_queue_depth = 0;           ///< Deepest the Logger's async queue has been seen
+                std::vector<SinkStats> sinks;         ///< One entry per registered sink
+            };
 
-            public:
-                DefaultLogFormatter(TimestampFormat format = TimestampFormat::STANDARD,
-                                   const std::string& prefix = "")
-                    : timestamp_format_(format), prefix_(prefix) {}
+            namespace detail {
 
-                std::string format(LogLevel level, const std::string& message,
-                                  const std::tm& time_info, const char* file = nullptr, int line = 0) override {
-                    std::ostringstream oss;
+                /**
+                 * @brief Indices of the counters kept per thread; per-level counters take four slots
+                 */
+                enum StatCounter : size_t {
+                    kStatEmitted = 0,
+                    kStatSuppressed = 4,
+                    kStatThrottled = 8,
+                    kStatDropped = 12,
+                    kStatFileMessages = 16,
+                    kStatFileBytes,
+                    kStatRotations,
+                    kStatCounterCount
+                };
 
-                    // Add prefix if specified
-                    if (!prefix_.empty()) {
-                        oss << prefix_ << " ";
+                enum StatHistogram : size_t {
+                    kStatFileWrite = 0,
+                    kStatFileRotate,
+                    kStatHistogramCount
+                };
+
+                /**
+                 * @brief One thread's counters and histograms
+                 *
+                 * Only the owning thread writes, with plain relaxed loads and stores
+                 * instead of read-modify-write instructions; readers sum every block.
+                 * Blocks are cache-line aligned so threads never share a line, and
+                 * the block of an exited thread is handed to the next new thread, so
+                 * its counts are kept.
+                 */
+                class alignas(64) ThreadStats {
+                private:
+                    struct Histogram {
+                        std::atomic<uint64_t> buckets[LatencyHistogram::kBuckets] = {};
+                        std::atomic<uint64_t> count{0};
+                        std::atomic<uint64_t> total_ns{0};
+                        std::atomic<uint64_t> max_ns{0};
+                    };
+
+                    std::atomic<uint64_t> counters_[kStatCounterCount] = {};
+                    Histogram histograms_[kStatHistogramCount];
+
+                    static void bump(std::atomic<uint64_t>& value, uint64_t amount) {
+                        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
                     }
 
-                    // Add timestamp based on format
-                    switch (timestamp_format_) {
-                        case TimestampFormat::STANDARD: {
-                            oss << "[" << std::put_time(&time_info, "%Y-%m-%d %H:%M:%S") << "] ";
-                            break;
+                    static size_t bucket_of(uint64_t ns) {
+#if defined(__GNUC__) || defined(__clang__)
+                        const size_t width = ns == 0 ? 0 : 64 - static_cast<size_t>(__builtin_clzll(ns));
+#else
+                        size_t width = 0;
+                        for (uint64_t rest = ns; rest != 0; rest >>= 1) {
+                            ++width;
                         }
-                        case TimestampFormat::ISO8601: {
-                            oss << "[" << std::put_time(&time_info, "%Y-%m-%dT%H:%M:%SZ") << "] ";
-                            break;
+#endif
+                        return std::min(width, LatencyHistogram::kBuckets - 1);
+                    }
+
+                public:
+                    void add(size_t counter, uint64_t amount = 1) {
+                        bump(counters_[counter], amount);
+                    }
+
+                    void add(StatCounter first, LogLevel level) {
+                        bump(counters_[first + static_cast<size_t>(level)], 1);
+                    }
+
+                    void record(StatHistogram histogram, uint64_t ns) {
+                        Histogram& target = histograms_[histogram];
+                        bump(target.buckets[bucket_of(ns)], 1);
+                        bump(target.count, 1);
+                        bump(target.total_ns, ns);
+                        if (ns > target.max_ns.load(std::memory_order_relaxed)) {
+                            target.max_ns.store(ns, std::memory_order_relaxed);
                         }
-                        case TimestampFormat::UNIX: {
-                            // This would require getting the time_t value, so we'll skip for now
-                            oss << "[" << std::put_time(&time_info, "%Y-%m-%d %H:%M:%S") << "] ";
-                            break;
+                    }
+
+                    uint64_t counter(size_t index) const {
+                        return counters_[index].load(std::memory_order_relaxed);
+                    }
+
+                    void add_to(StatHistogram histogram, LatencyHistogram& out) const {
+                        const Histogram& source = histograms_[histogram];
+                        for (size_t i = 0; i < LatencyHistogram::kBuckets; ++i) {
+                            out.buckets[i] += source.buckets[i].load(std::memory_order_relaxed);
                         }
-                        case TimestampFormat::NONE:
-                            // No timestamp
-                            break;
+                        out.count += source.count.load(std::memory_order_relaxed);
+                        out.total_ns += source.total_ns.load(std::memory_order_relaxed);
+                        out.max_ns = std::max(out.max_ns, source.max_ns.load(std::memory_order_relaxed));
                     }
+                };
+
+                /**
+                 * @brief Every ThreadStats block ever handed out, plus the ones free for reuse
+                 */
+                class StatsRegistry {
+                private:
+                    std::mutex mutex_;
+                    std::vector<std::unique_ptr<ThreadStats>> blocks_;
+                    std::vector<ThreadStats*> free_;
+                    ThreadStats* exiting_;
 
-                    // Add log level
-                    oss << "[" << log_level_to_string(level) << "] ";
+                    StatsRegistry() {
+                        blocks_.push_back(std::make_unique<ThreadStats>());
+                        exiting_ = blocks_.back().get();
+                    }
 
-                    // Add message
-                    oss << message;
+                public:
+                    /**
+                     * @brief The process-wide registry; never destroyed, so exiting threads can still return blocks
+                     */
+                    static StatsRegistry& instance() {
+                        static StatsRegistry* registry = new StatsRegistry();
+                        return *registry;
+                    }
 
-                    // Add file and line information if provided
-                    if (file && line > 0) {
-                        // Extract just the filename from the full path
-                        const char* filename = file;
-                        for (const char* p = file; *p; ++p) {
-                            if (*p == '/' || *p == '\\') {
-                                filename = p + 1;
+                    ThreadStats* acquire() {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        if (!free_.empty()) {
+                            ThreadStats* block = free_.back();
+                            free_.pop_back();
+                            return block;
+                        }
+                        blocks_.push_back(std::make_unique<ThreadStats>());
+                        return blocks_.back().get();
+                    }
+
+                    void release(ThreadStats* block) {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        free_.push_back(block);
+                    }
+
+                    /**
+                     * @brief Shared block for threads that log after giving theirs back
+                     *
+                     * Only destructors running at thread exit land here; they may
+                     * occasionally lose a count to each other, which is harmless.
+                     */
+                    ThreadStats* exiting() const {
+                        return exiting_;
+                    }
+
+                    /**
+                     * @brief Add every block's counters and histograms to a snapshot
+                     */
+                    void collect(LoggerStats& out) {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        for (const auto& block : blocks_) {
+                            for (size_t level = 0; level < 4; ++level) {
+                                out.emitted[level] += block->counter(kStatEmitted + level);
+                                out.suppressed[level] += block->counter(kStatSuppressed + level);
+                                out.throttled[level] += block->counter(kStatThrottled + level);
+                                out.dropped[level] += block->counter(kStatDropped + level);
                             }
+                            out.file_messages += block->counter(kStatFileMessages);
+                            out.file_bytes += block->counter(kStatFileBytes);
+                            out.rotations += block->counter(kStatRotations);
+                            block->add_to(kStatFileWrite, out.file_write);
+                            block->add_to(kStatFileRotate, out.file_rotate);
                         }
-                        oss << " (" << filename << ":" << line << ")";
                     }
+                };
 
-                    return oss.str();
+                /**
+                 * @brief The calling thread's stats block, acquired on first use
+                 */
+                inline ThreadStats& thread_stats() {
+                    struct Releaser {
+                        ThreadStats** block;
+                        ~Releaser() {
+                            StatsRegistry::instance().release(*block);
+                            *block = StatsRegistry::instance().exiting();
+                        }
+                    };
+                    // A plain pointer stays valid while the thread's other thread_locals are destroyed
+                    thread_local ThreadStats* block = nullptr;
+                    if (!block) {
+                        block = StatsRegistry::instance().acquire();
+                        thread_local Releaser releaser{&block};
+                    }
+                    return *block;
                 }
-            };
-
-            /**
-             * @brief Thread-safe logging utility class
-             *
-             * The Logger class provides methods for logging messages at different
-             * severity levels. All logging operations are thread-safe.
-             *
-             * Example usage:
-             * @code
-             * using namespace interlaced::core::logging;
-             * Logger::set_level(LOG_INFO);
-             * Logger::info("Application started");
-             * Logger::warning("This is a warning message");
-             * Logger::error("An error occurred");
-             * @endcode
-             *
-             * For more detailed logging with file and line information:
-             * @code
-             * LOG_INFO("Application started");
-             * LOG_WARNING("This is a warning message");
-             * LOG_ERROR("An error occurred");
-             * @endcode
-             *
-             * For structured logging with key-value pairs:
-             * @code
-             * Logger::info("User logged in", "user_id", 12345, "ip_address", "192.168.1.1");
-             * @endcode
-             *
-             * For file logging with rotation:
-             * @code
-             * Logger::set_file_logging("app.log", 10485760, 5); // 10MB max size, 5 files
-             * Logger::set_file_logging("app.log", std::chrono::hours(24), 7); // Daily rotation, 7 files
-             * @endcode
-             */
-            class Logger {
-            private:
-                static LogLevel current_level;           ///< Current minimum log level
-                static std::mutex log_mutex;             ///< Mutex for thread safety
-                static std::ostream* output_stream;      ///< Output stream for LOG_INFO and LOG_DEBUG messages
-                static std::ostream* error_stream;       ///< Output stream for LOG_WARNING and LOG_ERROR messages
-                static std::unique_ptr<LogFormatter> formatter; ///< Custom log formatter
-                static std::unique_ptr<RotatingFileLogger> file_logger; ///< File logger with rotation
 
-            public:
                 /**
-                 * @brief Set the minimum log level
+                 * @brief Count one event in the calling thread's stats
                  *
-                 * Messages with a level lower than the current level will not be logged.
+                 * Compiles to nothing when INTERLACED_CORE_DISABLE_STATS is defined.
+                 */
+                inline void count_stat(size_t counter, uint64_t amount = 1) {
+#ifndef INTERLACED_CORE_DISABLE_STATS
+                    thread_stats().add(counter, amount);
+#else
+                    (void)counter;
+                    (void)amount;
+#endif
+                }
+
+                inline void count_stat(StatCounter first, LogLevel level) {
+#ifndef INTERLACED_CORE_DISABLE_STATS
+                    thread_stats().add(first, level);
+#else
+                    (void)first;
+                    (void)level;
+#endif
+                }
+
+                /**
+                 * @brief Count a throttled call when allowed is false, and pass allowed on
+                 */
+                inline bool count_throttle(LogLevel level, bool allowed) {
+                    if (!allowed) {
+                        count_stat(kStatThrottled, level);
+                    }
+                    return allowed;
+                }
+
+                /**
+                 * @brief Records the lifetime of a scope in one of the calling thread's histograms
+                 */
+                class StatsTimer {
+#ifndef INTERLACED_CORE_DISABLE_STATS
+                private:
+                    StatHistogram histogram_;
+                    std::chrono::steady_clock::time_point start_;
+
+                public:
+                    explicit StatsTimer(StatHistogram histogram)
+                        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+
+                    ~StatsTimer() {
+                        const auto elapsed = std::chrono::steady_clock::now() - start_;
+                        thread_stats().record(histogram_, static_cast<uint64_t>(
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+                    }
+#else
+                public:
+                    explicit StatsTimer(StatHistogram) {}
+#endif
+
+                    StatsTimer(const StatsTimer&) = delete;
+                    StatsTimer& operator=(const StatsTimer&) = delete;
+                };
+
+            }
+
+            namespace detail {
+
+                /**
+                 * @brief A contiguous range of bytes to write
+                 */
+                struct ConstBuffer {
+                    const char* data;
+                    size_t size;
+                };
+
+                /**
+                 * @brief Write every byte of the given buffers to a file descriptor, in order
+                 *
+                 * Uses a single writev call when possible and retries on partial writes.
+                 *
+                 * @return true if all bytes were written
+                 */
+                inline bool write_all(int fd, const ConstBuffer* buffers, size_t count) {
+#ifdef _WIN32
+                    for (size_t i = 0; i < count; ++i) {
+                        const char* data = buffers[i].data;
+                        size_t remaining = buffers[i].size;
+                        while (remaining > 0) {
+                            unsigned int chunk = remaining > 0x40000000u ? 0x40000000u : static_cast<unsigned int>(remaining);
+                            int written = _write(fd, data, chunk);
+                            if (written <= 0) {
+                                return false;
+                            }
+                            data += written;
+                            remaining -= static_cast<size_t>(written);
+                        }
+                    }
+                    return true;
+#else
+                    constexpr size_t kMaxBuffers = 16;
+                    struct iovec vectors[kMaxBuffers];
+                    size_t vector_count = 0;
+                    for (size_t i = 0; i < count && vector_count < kMaxBuffers; ++i) {
+                        if (buffers[i].size > 0) {
+                            vectors[vector_count].iov_base = const_cast<char*>(buffers[i].data);
+                            vectors[vector_count].iov_len = buffers[i].size;
+                            ++vector_count;
+                        }
+                    }
+                    if (count > kMaxBuffers) {
+                        return write_all(fd, buffers, kMaxBuffers) && write_all(fd, buffers + kMaxBuffers, count - kMaxBuffers);
+                    }
+
+                    struct iovec* pending = vectors;
+                    while (vector_count > 0) {
+                        ssize_t written = ::writev(fd, pending, static_cast<int>(vector_count));
+                        if (written < 0) {
+                            if (errno == EINTR) {
+                                continue;
+                            }
+                            return false;
+                        }
+                        // Skip the fully written vectors and trim the partially written one
+                        size_t remaining = static_cast<size_t>(written);
+                        while (vector_count > 0 && remaining >= pending->iov_len) {
+                            remaining -= pending->iov_len;
+                            ++pending;
+                            --vector_count;
+                        }
+                        if (vector_count > 0) {
+                            pending->iov_base = static_cast<char*>(pending->iov_base) + remaining;
+                            pending->iov_len -= remaining;
+                        }
+                    }
+                    return true;
+#endif
+                }
+
+                /**
+                 * @brief Minimal append-only file handle over the native file API
+                 *
+                 * Files are opened in binary append mode so the number of bytes written is
+                 * exactly the number of bytes that end up in the file.
+                 */
+                class LogFile {
+                private:
+                    int fd_ = -1;
+
+                public:
+                    LogFile() = default;
+
+                    ~LogFile() {
+                        close();
+                    }
+
+                    LogFile(const LogFile&) = delete;
+                    LogFile& operator=(const LogFile&) = delete;
+
+                    /**
+                     * @brief Open path for appending, creating it if needed
+                     *
+                     * @param path The file to open
+                     * @param truncate Discard any existing contents
+                     * @return true on success
+                     */
+                    bool open(const std::string& path, bool truncate = false) {
+                        close();
+#ifdef _WIN32
+                        fd_ = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY | (truncate ? _O_TRUNC : 0),
+                                    _S_IREAD | _S_IWRITE);
+#else
+                        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC | (truncate ? O_TRUNC : 0), 0644);
+#endif
+                        return fd_ >= 0;
+                    }
+
+                    /**
+                     * @brief Exchange the underlying files of two LogFiles
+                     */
+                    void swap(LogFile& other) noexcept {
+                        std::swap(fd_, other.fd_);
+                    }
+
+                    bool is_open() const {
+                        return fd_ >= 0;
+                    }
+
+                    int native_handle() const {
+                        return fd_;
+                    }
+
+                    /**
+                     * @brief Current size of the file in bytes
+                     */
+                    size_t size() const {
+                        if (fd_ < 0) {
+                            return 0;
+                        }
+#ifdef _WIN32
+                        struct _stat64 info;
+                        return _fstat64(fd_, &info) == 0 ? static_cast<size_t>(info.st_size) : 0;
+#else
+                        struct stat info;
+                        return ::fstat(fd_, &info) == 0 ? static_cast<size_t>(info.st_size) : 0;
+#endif
+                    }
+
+                    void close() {
+                        if (fd_ >= 0) {
+#ifdef _WIN32
+                            _close(fd_);
+#else
+                            ::close(fd_);
+#endif
+                            fd_ = -1;
+                        }
+                    }
+
+                    /**
+                     * @brief Write every byte of the given buffers, in order
+                     *
+                     * @return true if all bytes were written
+                     */
+                    bool write(const ConstBuffer* buffers, size_t count) {
+                        return fd_ >= 0 && write_all(fd_, buffers, count);
+                    }
+                };
+
+                /**
+                 * @brief Background thread for file housekeeping such as renaming rotated files
+                 *
+                 * Tasks run one at a time in submission order. Owners hold a shared_ptr,
+                 * so the thread outlives every file logger even during static destruction.
+                 * The thread is started by the first submitted task.
+                 */
+                class BackgroundWorker {
+                private:
+                    std::mutex mutex_;
+                    std::condition_variable cv_;
+                    std::deque<std::function<void()>> tasks_;
+                    bool stopping_ = false;
+                    std::thread thread_;
+
+                public:
+                    BackgroundWorker() = default;
+
+                    /**
+                     * @brief Destructor runs the remaining tasks and joins the thread
+                     */
+                    ~BackgroundWorker() {
+                        {
+                            std::lock_guard<std::mutex> lock(mutex_);
+                            stopping_ = true;
+                        }
+                        cv_.notify_all();
+                        if (thread_.joinable()) {
+                            thread_.join();
+                        }
+                    }
+
+                    BackgroundWorker(const BackgroundWorker&) = delete;
+                    BackgroundWorker& operator=(const BackgroundWorker&) = delete;
+
+                    /**
+                     * @brief The process-wide worker
+                     */
+                    static std::shared_ptr<BackgroundWorker> instance() {
+                        static std::shared_ptr<BackgroundWorker> worker = std::make_shared<BackgroundWorker>();
+                        return worker;
+                    }
+
+                    void submit(std::function<void()> task) {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        tasks_.push_back(std::move(task));
+                        if (!thread_.joinable()) {
+                            thread_ = std::thread(&BackgroundWorker::run, this);
+                        }
+                        cv_.notify_one();
+                    }
+
+                private:
+                    void run() {
+                        std::unique_lock<std::mutex> lock(mutex_);
+                        for (;;) {
+                            cv_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+                            if (tasks_.empty()) {
+                                return;
+                            }
+                            std::function<void()> task = std::move(tasks_.front());
+                            tasks_.pop_front();
+                            lock.unlock();
+                            try {
+                                task();
+                            } catch (...) {
+                                // Housekeeping is best effort
+                            }
+                            lock.lock();
+                        }
+                    }
+                };
+
+                /**
+                 * @brief State shared between a RotatingFileLogger and its background tasks
+                 */
+                struct RotationState {
+                    std::mutex mutex;               ///< Guards the members below and renames of the spare file
+                    std::condition_variable idle;
+                    size_t pending = 0;             ///< Submitted tasks that have not finished
+                    LogFile spare;                  ///< Pre-opened next file, closed when not ready
+                };
+
+                /**
+                 * @brief Compressed log frame format
+                 *
+                 * A frame starts with the magic "ICLZ" and a version byte, followed by
+                 * independent blocks of at most kCompressedBlockSize input bytes. Each
+                 * block has a header of two little-endian uint32 values: the decoded size
+                 * and the payload size. When kStoredBlockFlag is set in the payload size,
+                 * the payload is stored as is. A decoded size of 0 ends the frame.
+                 *
+                 * Compressed payloads are LZ77 sequences, like LZ4: a token byte holds
+                 * the literal length (high nibble) and the match length minus 4 (low
+                 * nibble). A nibble of 15 continues in the following bytes, each adding
+                 * up to 255. Next come the literals, a 2-byte little-endian offset back
+                 * into the block and the match length bytes. The last sequence of a
+                 * block has only literals.
+                 */
+                constexpr char kCompressedLogMagic[4] = {'I', 'C', 'L', 'Z'};
+                constexpr uint8_t kCompressedLogVersion = 1;
+                constexpr size_t kCompressedBlockSize = 64 * 1024;
+                constexpr uint32_t kStoredBlockFlag = 0x80000000u;
+                constexpr const char* kCompressedLogExtension = ".iclz";
+
+                inline void append_u32_le(std::string& out, uint32_t value) {
+                    for (int i = 0; i < 4; ++i) {
+                        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+                    }
+                }
+
+                inline uint32_t read_u32_le(const unsigned char* data) {
+                    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+                           (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+                }
+
+                inline void append_lz_length(std::string& out, size_t length) {
+                    while (length >= 255) {
+                        out.push_back(static_cast<char>(255));
+                        length -= 255;
+                    }
+                    out.push_back(static_cast<char>(length));
+                }
+
+                /**
+                 * @brief Append one LZ sequence; match_length 0 marks the last sequence
+                 */
+                inline void append_lz_sequence(std::string& out, const unsigned char* literals, size_t literal_length,
+                                               size_t offset, size_t match_length) {
+                    const size_t match_code = match_length ? match_length - 4 : 0;
+                    out.push_back(static_cast<char>(((literal_length < 15 ? literal_length : 15) << 4) |
+                                                    (match_code < 15 ? match_code : 15)));
+                    if (literal_length >= 15) {
+                        append_lz_length(out, literal_length - 15);
+                    }
+                    out.append(reinterpret_cast<const char*>(literals), literal_length);
+                    if (match_length) {
+                        out.push_back(static_cast<char>(offset & 0xFF));
+                        out.push_back(static_cast<char>(offset >> 8));
+                        if (match_code >= 15) {
+                            append_lz_length(out, match_code - 15);
+                        }
+                    }
+                }
+
+                /**
+                 * @brief Compress one block and append the payload to out
+                 *
+                 * @param table Hash table scratch space, reused between blocks
+                 */
+                inline void lz_compress_block(const unsigned char* data, size_t size, std::vector<uint32_t>& table,
+                                              std::string& out) {
+                    constexpr int kHashBits = 14;
+                    constexpr uint32_t kEmpty = 0xFFFFFFFFu;
+                    table.assign(size_t(1) << kHashBits, kEmpty);
+
+                    auto load32 = [data](size_t position) {
+                        uint32_t value;
+                        std::memcpy(&value, data + position, sizeof(value));
+                        return value;
+                    };
+
+                    size_t anchor = 0;
+                    size_t position = 0;
+                    while (position + 4 <= size) {
+                        const uint32_t sequence = load32(position);
+                        const uint32_t hash = (sequence * 2654435761u) >> (32 - kHashBits);
+                        const uint32_t candidate = table[hash];
+                        table[hash] = static_cast<uint32_t>(position);
+                        if (candidate != kEmpty && position - candidate <= 0xFFFF && load32(candidate) == sequence) {
+                            size_t length = 4;
+                            while (position + length < size && data[candidate + length] == data[position + length]) {
+                                ++length;
+                            }
+                            append_lz_sequence(out, data + anchor, position - anchor, position - candidate, length);
+                            position += length;
+                            anchor = position;
+                        } else {
+                            // Skip ahead faster through data that does not compress
+                            position += 1 + ((position - anchor) >> 6);
+                        }
+                    }
+                    append_lz_sequence(out, data + anchor, size - anchor, 0, 0);
+                }
+
+                inline bool read_lz_length(const unsigned char*& in, const unsigned char* end, size_t& length) {
+                    for (;;) {
+                        if (in == end) {
+                            return false;
+                        }
+                        const unsigned char byte = *in++;
+                        length += byte;
+                        if (byte != 255) {
+                            return true;
+                        }
+                    }
+                }
+
+                /**
+                 * @brief Decode one compressed payload, appending exactly decoded_size bytes to out
+                 *
+                 * @return false if the payload is corrupt
+                 */
+                inline bool lz_decompress_block(const unsigned char* in, size_t size, size_t decoded_size,
+                                                std::string& out) {
+                    const unsigned char* end = in + size;
+                    const size_t start = out.size();
+                    out.reserve(start + decoded_size);
+                    while (in < end) {
+                        const unsigned char token = *in++;
+                        size_t literal_length = token >> 4;
+                        if (literal_length == 15 && !read_lz_length(in, end, literal_length)) {
+                            return false;
+                        }
+                        if (literal_length > static_cast<size_t>(end - in) ||
+                            out.size() - start + literal_length > decoded_size) {
+                            return false;
+                        }
+                        out.append(reinterpret_cast<const char*>(in), literal_length);
+                        in += literal_length;
+                        if (in == end) {
+                            break;
+                        }
+                        if (end - in < 2) {
+                            return false;
+                        }
+                        const size_t offset = static_cast<size_t>(in[0]) | (static_cast<size_t>(in[1]) << 8);
+                        in += 2;
+                        size_t match_length = token & 0x0F;
+                        if (match_length == 15 && !read_lz_length(in, end, match_length)) {
+                            return false;
+                        }
+                        match_length += 4;
+                        const size_t produced = out.size() - start;
+                        if (offset == 0 || offset > produced || produced + match_length > decoded_size) {
+                            return false;
+                        }
+                        // Byte by byte, since a match may overlap the bytes it produces
+                        size_t from = out.size() - offset;
+                        for (size_t i = 0; i < match_length; ++i) {
+                            const char byte = out[from + i];
+                            out.push_back(byte);
+                        }
+                    }
+                    return out.size() - start == decoded_size;
+                }
+
+                /**
+                 * @brief Compress a whole file into a compressed log frame
+                 *
+                 * @param on_block Optionally receives the text of each frame block, in order
+                 * @return true if destination was written completely
+                 */
+                inline bool compress_log_file(const std::string& source, const std::string& destination,
+                                              const std::function<void(std::string_view block)>& on_block = nullptr) {
+                    std::ifstream input(source, std::ios::binary);
+                    std::ofstream output(destination, std::ios::binary | std::ios::trunc);
+                    if (!input || !output) {
+                        return false;
+                    }
+                    std::string header(kCompressedLogMagic, sizeof(kCompressedLogMagic));
+                    header.push_back(static_cast<char>(kCompressedLogVersion));
+                    output.write(header.data(), static_cast<std::streamsize>(header.size()));
+
+                    std::vector<char> block(kCompressedBlockSize);
+                    std::vector<uint32_t> table;
+                    std::string payload;
+                    for (;;) {
+                        input.read(block.data(), static_cast<std::streamsize>(block.size()));
+                        const size_t size = static_cast<size_t>(input.gcount());
+                        if (size == 0) {
+                            break;
+                        }
+                        if (on_block) {
+                            on_block(std::string_view(block.data(), size));
+                        }
+                        payload.clear();
+                        append_u32_le(payload, static_cast<uint32_t>(size));
+                        append_u32_le(payload, 0);
+                        lz_compress_block(reinterpret_cast<const unsigned char*>(block.data()), size, table, payload);
+                        size_t payload_size = payload.size() - 8;
+                        if (payload_size >= size) {
+                            payload.resize(8);
+                            payload.append(block.data(), size);
+                            payload_size = size | kStoredBlockFlag;
+                        }
+                        for (int i = 0; i < 4; ++i) {
+                            payload[4 + i] = static_cast<char>((payload_size >> (8 * i)) & 0xFF);
+                        }
+                        output.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+                    }
+                    payload.clear();
+                    append_u32_le(payload, 0);
+                    output.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+                    output.flush();
+                    return !input.bad() && static_cast<bool>(output);
+                }
+
+                /**
+                 * @brief Streaming reader for compressed log frames, one block at a time
+                 */
+                class CompressedLogInput {
+                private:
+                    std::ifstream input_;
+                    std::vector<unsigned char> payload_;
+                    bool failed_ = false;
+                    bool finished_ = false;
+
+                public:
+                    /**
+                     * @brief Open a file and check its frame header
+                     *
+                     * @return false if the file cannot be read or is not a compressed log
+                     */
+                    bool open(const std::string& filename) {
+                        input_.close();
+                        input_.clear();
+                        failed_ = false;
+                        finished_ = false;
+                        input_.open(filename, std::ios::binary);
+                        char header[sizeof(kCompressedLogMagic) + 1];
+                        if (!input_.read(header, sizeof(header)) ||
+                            std::memcmp(header, kCompressedLogMagic, sizeof(kCompressedLogMagic)) != 0 ||
+                            static_cast<uint8_t>(header[sizeof(kCompressedLogMagic)]) != kCompressedLogVersion) {
+                            failed_ = true;
+                        }
+                        return !failed_;
+                    }
+
+                    /**
+                     * @brief Append the next decoded block to out
+                     *
+                     * @return false at the end of the frame or on corrupt input (see failed())
+                     */
+                    bool next_block(std::string& out) {
+                        uint32_t decoded_size;
+                        uint32_t payload_size;
+                        bool stored;
+                        if (!read_block_header(decoded_size, payload_size, stored)) {
+                            return false;
+                        }
+                        payload_.resize(payload_size);
+                        if (!input_.read(reinterpret_cast<char*>(payload_.data()), payload_size)) {
+                            failed_ = true;
+                            return false;
+                        }
+                        if (stored) {
+                            out.append(reinterpret_cast<const char*>(payload_.data()), payload_size);
+                        } else if (!lz_decompress_block(payload_.data(), payload_size, decoded_size, out)) {
+                            failed_ = true;
+                            return false;
+                        }
+                        return true;
+                    }
+
+                    /**
+                     * @brief Move past the next block without decoding it
+                     *
+                     * @param decoded_size Receives the size the block would have decoded to
+                     * @return false at the end of the frame or on corrupt input (see failed())
+                     */
+                    bool skip_block(uint32_t& decoded_size) {
+                        uint32_t payload_size;
+                        bool stored;
+                        if (!read_block_header(decoded_size, payload_size, stored)) {
+                            return false;
+                        }
+                        if (!input_.seekg(payload_size, std::ios::cur)) {
+                            failed_ = true;
+                            return false;
+                        }
+                        return true;
+                    }
+
+                    bool failed() const {
+                        return failed_;
+                    }
+
+                private:
+                    bool read_block_header(uint32_t& decoded_size, uint32_t& payload_size, bool& stored) {
+                        if (failed_ || finished_) {
+                            return false;
+                        }
+                        unsigned char sizes[8];
+                        if (!input_.read(reinterpret_cast<char*>(sizes), 4)) {
+                            failed_ = true; // Truncated frame
+                            return false;
+                        }
+                        decoded_size = read_u32_le(sizes);
+                        if (decoded_size == 0) {
+                            finished_ = true;
+                            return false;
+                        }
+                        if (!input_.read(reinterpret_cast<char*>(sizes + 4), 4)) {
+                            failed_ = true;
+                            return false;
+                        }
+                        const uint32_t payload_field = read_u32_le(sizes + 4);
+                        stored = (payload_field & kStoredBlockFlag) != 0;
+                        payload_size = payload_field & ~kStoredBlockFlag;
+                        if (decoded_size > kCompressedBlockSize || payload_size > kCompressedBlockSize * 2 ||
+                            (stored && payload_size != decoded_size)) {
+                            failed_ = true;
+                            return false;
+                        }
+                        return true;
+                    }
+                };
+
+                /**
+                 * @brief First wall-clock boundary after now for a rotation interval
+                 *
+                 * Intervals shorter than a day fall on local hours that are multiples of
+                 * the interval (restarting at midnight); longer intervals fall on local
+                 * midnight.
+                 */
+                inline std::chrono::system_clock::time_point next_rotation_boundary(
+                        std::chrono::system_clock::time_point now, std::chrono::hours interval) {
+                    const int hours = interval.count() > 0 ? static_cast<int>(interval.count()) : 1;
+                    const std::time_t time = std::chrono::system_clock::to_time_t(now);
+                    std::tm boundary;
+                    localtime_threadsafe(&time, &boundary);
+                    boundary.tm_min = 0;
+                    boundary.tm_sec = 0;
+                    boundary.tm_isdst = -1;
+                    if (hours < 24) {
+                        boundary.tm_hour = std::min((boundary.tm_hour / hours + 1) * hours, 24);
+                    } else {
+                        boundary.tm_hour = 0;
+                        boundary.tm_mday += hours / 24;
+                    }
+                    return std::chrono::system_clock::from_time_t(std::mktime(&boundary));
+                }
+
+#ifdef INTERLACED_CORE_HAS_IO_URING
+                /**
+                 * @brief Minimal io_uring instance driven through the raw system calls
+                 *
+                 * Provides only what AsyncFileWriter needs: single write submissions,
+                 * registered buffers when the kernel accepts them, and reaping
+                 * completions with or without waiting. Not thread-safe.
+                 */
+                class IoUring {
+                private:
+                    int fd_ = -1;
+                    void* sq_ring_ = nullptr;
+                    size_t sq_ring_size_ = 0;
+                    void* cq_ring_ = nullptr;
+                    size_t cq_ring_size_ = 0;
+                    io_uring_sqe* sqes_ = nullptr;
+                    size_t sqes_size_ = 0;
+                    unsigned* sq_head_ = nullptr;
+                    unsigned* sq_tail_ = nullptr;
+                    unsigned* sq_mask_ = nullptr;
+                    unsigned* sq_array_ = nullptr;
+                    unsigned* cq_head_ = nullptr;
+                    unsigned* cq_tail_ = nullptr;
+                    unsigned* cq_mask_ = nullptr;
+                    io_uring_cqe* cqes_ = nullptr;
+                    bool fixed_buffers_ = false;
+
+                public:
+                    IoUring() = default;
+
+                    ~IoUring() {
+                        close();
+                    }
+
+                    IoUring(const IoUring&) = delete;
+                    IoUring& operator=(const IoUring&) = delete;
+
+                    /**
+                     * @brief Create the ring and map its queues
+                     *
+                     * @param entries Submission queue size
+                     * @return false if the kernel does not support io_uring or refuses it
+                     */
+                    bool open(unsigned entries) {
+                        io_uring_params params;
+                        std::memset(&params, 0, sizeof(params));
+                        const long fd = ::syscall(__NR_io_uring_setup, entries, &params);
+                        if (fd < 0) {
+                            return false;
+                        }
+                        fd_ = static_cast<int>(fd);
+
+                        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+                        const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+                        if (single_mmap) {
+                            sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+                        }
+                        sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                                          IORING_OFF_SQ_RING);
+                        if (sq_ring_ == MAP_FAILED) {
+                            sq_ring_ = nullptr;
+                            close();
+                            return false;
+                        }
+                        if (single_mmap) {
+                            cq_ring_ = sq_ring_;
+                        } else {
+                            cq_ring_ = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                                              IORING_OFF_CQ_RING);
+                            if (cq_ring_ == MAP_FAILED) {
+                                cq_ring_ = nullptr;
+                                close();
+                                return false;
+                            }
+                        }
+                        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+                        void* sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                                            IORING_OFF_SQES);
+                        if (sqes == MAP_FAILED) {
+                            close();
+                            return false;
+                        }
+                        sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+                        char* sq = static_cast<char*>(sq_ring_);
+                        sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+                        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+                        sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+                        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+                        char* cq = static_cast<char*>(cq_ring_);
+                        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+                        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+                        cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+                        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+                        return true;
+                    }
+
+                    void close() {
+                        if (sqes_) {
+                            ::munmap(sqes_, sqes_size_);
+                            sqes_ = nullptr;
+                        }
+                        if (cq_ring_ && cq_ring_ != sq_ring_) {
+                            ::munmap(cq_ring_, cq_ring_size_);
+                        }
+                        cq_ring_ = nullptr;
+                        if (sq_ring_) {
+                            ::munmap(sq_ring_, sq_ring_size_);
+                            sq_ring_ = nullptr;
+                        }
+                        if (fd_ >= 0) {
+                            ::close(fd_);
+                            fd_ = -1;
+                        }
+                        fixed_buffers_ = false;
+                    }
+
+                    /**
+                     * @brief Register buffers for IORING_OP_WRITE_FIXED
+                     *
+                     * Fails, for example, when the buffers exceed RLIMIT_MEMLOCK; writes
+                     * then use IORING_OP_WRITEV on the same buffers.
+                     */
+                    bool register_buffers(const struct iovec* buffers, unsigned count) {
+                        fixed_buffers_ = ::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_BUFFERS, buffers, count) == 0;
+                        return fixed_buffers_;
+                    }
+
+                    bool fixed_buffers() const {
+                        return fixed_buffers_;
+                    }
+
+                    /**
+                     * @brief Submit one write of vector's bytes at offset
+                     *
+                     * @param vector The bytes to write; must stay valid until the completion
+                     * @param buffer_index Registered buffer holding the bytes, if fixed_buffers()
+                     * @return false if the kernel did not accept the submission
+                     */
+                    bool submit_write(int fd, const struct iovec* vector, uint64_t offset, unsigned buffer_index,
+                                      uint64_t user_data) {
+                        const unsigned tail = *sq_tail_;
+                        if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) > *sq_mask_) {
+                            return false;
+                        }
+                        const unsigned index = tail & *sq_mask_;
+                        io_uring_sqe& sqe = sqes_[index];
+                        std::memset(&sqe, 0, sizeof(sqe));
+                        sqe.fd = fd;
+                        sqe.off = offset;
+                        sqe.user_data = user_data;
+                        if (fixed_buffers_) {
+                            sqe.opcode = IORING_OP_WRITE_FIXED;
+                            sqe.addr = reinterpret_cast<uintptr_t>(vector->iov_base);
+                            sqe.len = static_cast<uint32_t>(vector->iov_len);
+                            sqe.buf_index = static_cast<uint16_t>(buffer_index);
+                        } else {
+                            sqe.opcode = IORING_OP_WRITEV;
+                            sqe.addr = reinterpret_cast<uintptr_t>(vector);
+                            sqe.len = 1;
+                        }
+                        sq_array_[index] = index;
+                        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+
+                        for (;;) {
+                            if (::syscall(__NR_io_uring_enter, fd_, 1, 0, 0, nullptr, 0) >= 0) {
+                                return true;
+                            }
+                            if (errno != EINTR) {
+                                // Not consumed, so take the entry back
+                                __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+                                return false;
+                            }
+                        }
+                    }
+
+                    /**
+                     * @brief Call handle(user_data, result) for every completion that has arrived
+                     *
+                     * @return Number of completions handled
+                     */
+                    template<typename Handler>
+                    size_t reap(Handler&& handle) {
+                        size_t handled = 0;
+                        unsigned head = *cq_head_;
+                        while (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+                            const io_uring_cqe cqe = cqes_[head & *cq_mask_];
+                            __atomic_store_n(cq_head_, ++head, __ATOMIC_RELEASE);
+                            handle(cqe.user_data, cqe.res);
+                            ++handled;
+                        }
+                        return handled;
+                    }
+
+                    /**
+                     * @brief Wait until a completion is available or timeout_ms has passed
+                     *
+                     * Bounded because another thread may reap the completion being waited for.
+                     */
+                    bool wait_for_completion(int timeout_ms = 10) {
+                        struct pollfd ring = {fd_, POLLIN, 0};
+                        for (;;) {
+                            if (::poll(&ring, 1, timeout_ms) >= 0) {
+                                return true;
+                            }
+                            if (errno != EINTR) {
+                                return false;
+                            }
+                        }
+                    }
+                };
+#endif
+
+                /**
+                 * @brief Writes a log file from a fixed pool of buffers without waiting for the I/O
+                 *
+                 * write() copies into the buffer being filled and hands full buffers,
+                 * plus the partial one at the end of each call, to the kernel through
+                 * io_uring, or where io_uring is unavailable to a writer thread that
+                 * writes everything queued with a single writev. Only when every buffer
+                 * is in flight does write() wait, which AsyncWriteStats reports as
+                 * backpressure.
+                 *
+                 * io_uring writes carry explicit offsets and may complete out of order,
+                 * so the attached file descriptor has O_APPEND cleared until detach().
+                 * Like RotatingFileLogger, the writer is not thread-safe; only the
+                 * statistics and wait_for_file() may be used concurrently.
+                 */
+                class AsyncFileWriter {
+                private:
+                    struct Slot {
+                        std::unique_ptr<char[]> data;
+                        size_t size = 0;        ///< Bytes filled
+                        size_t written = 0;     ///< Bytes confirmed written
+                        uint64_t offset = 0;    ///< File offset of data[0] (io_uring)
+                        int fd = -1;            ///< Set under mutex_ on submission
+                        bool in_flight = false; ///< Guarded by mutex_
+#ifdef INTERLACED_CORE_HAS_IO_URING
+                        struct iovec vector;    ///< Remaining bytes, kept alive for IORING_OP_WRITEV
+#endif
+                    };
+
+                    static constexpr size_t kNoSlot = static_cast<size_t>(-1);
+
+                    const size_t buffer_size_;
+                    std::vector<Slot> slots_;
+                    size_t filling_ = kNoSlot;      ///< Slot currently being filled
+                    int fd_ = -1;
+                    uint64_t offset_ = 0;           ///< File offset of the next byte handed off (io_uring)
+
+                    mutable std::mutex mutex_;      ///< Guards the members below
+                    std::condition_variable cv_;
+                    std::vector<size_t> free_;      ///< Slots neither filling nor in flight
+                    std::deque<size_t> queue_;      ///< Slots waiting for the writer thread
+                    AsyncWriteStats stats_;
+                    bool stopping_ = false;
+                    std::thread thread_;
+#ifdef INTERLACED_CORE_HAS_IO_URING
+                    IoUring ring_;
+                    std::mutex ring_mutex_;         ///< Taken before mutex_; guards submissions and reaping
+                    bool restore_append_ = false;   ///< fd_ had O_APPEND before attach()
+#endif
+
+                public:
+                    explicit AsyncFileWriter(const AsyncWriteOptions& options)
+                        : buffer_size_(std::max<size_t>(4096, options.buffer_size)),
+                          slots_(std::max<size_t>(1, options.max_in_flight)) {
+                        for (size_t i = 0; i < slots_.size(); ++i) {
+                            slots_[i].data.reset(new char[buffer_size_]);
+                            free_.push_back(slots_.size() - 1 - i);
+                        }
+#ifdef INTERLACED_CORE_HAS_IO_URING
+                        if (options.use_io_uring && slots_.size() <= 0xFFFF &&
+                            ring_.open(static_cast<unsigned>(slots_.size()))) {
+                            std::vector<struct iovec> buffers(slots_.size());
+                            for (size_t i = 0; i < slots_.size(); ++i) {
+                                buffers[i].iov_base = slots_[i].data.get();
+                                buffers[i].iov_len = buffer_size_;
+                            }
+                            stats_.io_uring = true;
+                            stats_.registered_buffers = ring_.register_buffers(buffers.data(),
+                                                                               static_cast<unsigned>(buffers.size()));
+                            return;
+                        }
+#endif
+                        thread_ = std::thread([this]() {
+                            run();
+                        });
+                    }
+
+                    /**
+                     * @brief Destructor waits for every write that was handed off
+                     */
+                    ~AsyncFileWriter() {
+                        detach();
+                        if (thread_.joinable()) {
+                            {
+                                std::lock_guard<std::mutex> lock(mutex_);
+                                stopping_ = true;
+                            }
+                            cv_.notify_all();
+                            thread_.join();
+                        }
+                    }
+
+                    AsyncFileWriter(const AsyncFileWriter&) = delete;
+                    AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+                    /**
+                     * @brief Direct subsequent writes to fd, whose current size is offset
+                     */
+                    void attach(int fd, uint64_t offset) {
+                        detach();
+                        fd_ = fd;
+                        offset_ = offset;
+#ifdef INTERLACED_CORE_HAS_IO_URING
+                        if (stats_.io_uring) {
+                            const int flags = ::fcntl(fd_, F_GETFL);
+                            restore_append_ = flags >= 0 && (flags & O_APPEND) != 0 &&
+                                              ::fcntl(fd_, F_SETFL, flags & ~O_APPEND) == 0;
+                        }
+#endif
+                    }
+
+                    /**
+                     * @brief Wait for every write to the attached file, then let go of it
+                     */
+                    void detach() {
+                        if (fd_ < 0) {
+                            return;
+                        }
+                        drain();
+#ifdef INTERLACED_CORE_HAS_IO_URING
+                        if (restore_append_) {
+                            ::fcntl(fd_, F_SETFL, ::fcntl(fd_, F_GETFL) | O_APPEND);
+                            restore_append_ = false;
+                        }
+#endif
+                        fd_ = -1;
+                    }
+
+                    bool attached() const {
+                        return fd_ >= 0;
+                    }
+
+                    /**
+                     * @brief Let go of the attached file without waiting for its writes
+                     *
+                     * For a file that is about to be closed, so O_APPEND is left cleared.
+                     * Pass the returned descriptor to wait_for_file() before closing it.
+                     *
+                     * @return The released descriptor, or -1 if none was attached
+                     */
+                    int release_file() {
+                        if (fd_ < 0) {
+                            return -1;
+                        }
+                        submit_filling();
+                        const int fd = fd_;
+                        fd_ = -1;
+#ifdef INTERLACED_CORE_HAS_IO_URING
+                        restore_append_ = false;
+#endif
+                        return fd;
+                    }
+
+                    /**
+                     * @brief Block until every write handed off for fd has completed
+                     *
+                     * Unlike drain(), this may run on another thread while the writer is in use.
+                     */
+                    void wait_for_file(int fd) {
+                        if (fd < 0) {
+                            return;
+                        }
+#ifdef INTERLACED_CORE_HAS_IO_URING
+                        if (stats_.io_uring) {
+                            // The writing thread may be idle, so reap here too
+                            for (;;) {
+                                reap_completions();
+                                std::unique_lock<std::mutex> lock(mutex_);
+                                if (cv_.wait_for(lock, std::chrono::milliseconds(1),
+                                                 [this, fd]() { return !writes_pending(fd); })) {
+                                    return;
+                                }
+                            }
+                        }
+#endif
+                        std::unique_lock<std::mutex> lock(mutex_);
+                        cv_.wait(lock, [this, fd]() { return !writes_pending(fd); });
+                    }
+
+                    /**
+                     * @brief Copy the buffers into write buffers and hand them to the kernel
+                     */
+                    void write(const ConstBuffer* buffers, size_t count) {
+                        for (size_t i = 0; i < count; ++i) {
+                            const char* data = buffers[i].data;
+                            size_t remaining = buffers[i].size;
+                            while (remaining > 0) {
+                                if (filling_ == kNoSlot) {
+                                    filling_ = acquire_slot();
+                                }
+                                Slot& slot = slots_[filling_];
+                                const size_t chunk = std::min(remaining, buffer_size_ - slot.size);
+                                std::memcpy(slot.data.get() + slot.size, data, chunk);
+                                slot.size += chunk;
+                                data += chunk;
+                                remaining -= chunk;
+                                if (slot.size == buffer_size_) {
+                                    submit_filling();
+                                }
+                            }
+                        }
+                        submit_filling();
+                    }
+
+                    /**
+                     * @brief Block until every write handed off so far has completed
+                     */
+                    void drain() {
+                        submit_filling();
+#ifdef INTERLACED_CORE_HAS_IO_URING
+                        if (stats_.io_uring) {
+                            reap_completions();
+                            while (in_flight() > 0 && ring_.wait_for_completion()) {
+                                reap_completions();
+                            }
+                            return;
+                        }
+#endif
+                        std::unique_lock<std::mutex> lock(mutex_);
+                        cv_.wait(lock, [this]() { return stats_.in_flight == 0; });
+                    }
+
+                    AsyncWriteStats stats() const {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        return stats_;
+                    }
+
+                private:
+                    size_t in_flight() const {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        return stats_.in_flight;
+                    }
+
+                    /**
+                     * @brief Whether a write to fd is in flight; the caller holds mutex_
+                     */
+                    bool writes_pending(int fd) const {
+                        for (const Slot& slot : slots_) {
+                            if (slot.in_flight && slot.fd == fd) {
+                                return true;
+                            }
+                        }
+                        return false;
+                    }
+
+                    /**
+                     * @brief Take a free slot, waiting for a write to complete if there is none
+                     */
+                    size_t acquire_slot() {
+#ifdef INTERLACED_CORE_HAS_IO_URING
+                        if (stats_.io_uring) {
+                            reap_completions();
+                            bool waited = false;
+                            for (;;) {
+                                {
+                                    std::lock_guard<std::mutex> lock(mutex_);
+                                    if (!free_.empty()) {
+                                        const size_t index = free_.back();
+                                        free_.pop_back();
+                                        stats_.backpressure_waits += waited ? 1 : 0;
+                                        return index;
+                                    }
+                                }
+                                waited = true;
+                                if (!ring_.wait_for_completion()) {
+                                    std::this_thread::yield();
+                                }
+                                reap_completions();
+                            }
+                        }
+#endif
+                        std::unique_lock<std::mutex> lock(mutex_);
+                        if (free_.empty()) {
+                            ++stats_.backpressure_waits;
+                            cv_.wait(lock, [this]() { return !free_.empty(); });
+                        }
+                        const size_t index = free_.back();
+                        free_.pop_back();
+                        return index;
+                    }
+
+                    /**
+                     * @brief Hand the slot being filled, if any, to the kernel or the writer thread
+                     */
+                    void submit_filling() {
+                        if (filling_ == kNoSlot) {
+                            return;
+                        }
+                        const size_t index = filling_;
+                        filling_ = kNoSlot;
+                        Slot& slot = slots_[index];
+                        if (slot.size == 0 || fd_ < 0) {
+                            release(index);
+                            return;
+                        }
+                        slot.written = 0;
+                        {
+                            std::lock_guard<std::mutex> lock(mutex_);
+                            slot.fd = fd_;
+                            slot.in_flight = true;
+                            ++stats_.submitted;
+                            stats_.max_in_flight = std::max(stats_.max_in_flight, ++stats_.in_flight);
+                        }
+#ifdef INTERLACED_CORE_HAS_IO_URING
+                        if (stats_.io_uring) {
+                            slot.offset = offset_;
+                            offset_ += slot.size;
+                            std::lock_guard<std::mutex> ring_lock(ring_mutex_);
+                            issue(index);
+                            return;
+                        }
+#endif
+                        {
+                            std::lock_guard<std::mutex> lock(mutex_);
+                            queue_.push_back(index);
+                        }
+                        cv_.notify_all();
+                    }
+
+                    /**
+                     * @brief Return a slot to the free list
+                     */
+                    void release(size_t index) {
+                        slots_[index].size = 0;
+                        {
+                            std::lock_guard<std::mutex> lock(mutex_);
+                            free_.push_back(index);
+                        }
+                        cv_.notify_all();
+                    }
+
+                    void finish(size_t index, bool succeeded) {
+                        const size_t size = slots_[index].size;
+                        {
+                            std::lock_guard<std::mutex> lock(mutex_);
+                            slots_[index].in_flight = false;
+                            --stats_.in_flight;
+                            if (succeeded) {
+                                ++stats_.completed;
+                                stats_.bytes_written += size;
+                            } else {
+                                ++stats_.failed;
+                            }
+                        }
+                        release(index);
+                    }
+
+#ifdef INTERLACED_CORE_HAS_IO_URING
+                    /**
+                     * @brief Submit the unwritten part of a slot, writing it synchronously if the ring refuses
+                     *
+                     * The caller holds ring_mutex_.
+                     */
+                    void issue(size_t index) {
+                        Slot& slot = slots_[index];
+                        slot.vector.iov_base = slot.data.get() + slot.written;
+                        slot.vector.iov_len = slot.size - slot.written;
+                        if (ring_.submit_write(slot.fd, &slot.vector, slot.offset + slot.written,
+                                               static_cast<unsigned>(index), index)) {
+                            return;
+                        }
+                        while (slot.written < slot.size) {
+                            const ssize_t written = ::pwrite(slot.fd, slot.data.get() + slot.written,
+                                                             slot.size - slot.written,
+                                                             static_cast<off_t>(slot.offset + slot.written));
+                            if (written < 0 && errno == EINTR) {
+                                continue;
+                            }
+                            if (written <= 0) {
+                                std::cerr << "File logging error: asynchronous write failed: " << std::strerror(errno)
+                                          << std::endl;
+                                finish(index, false);
+                                return;
+                            }
+                            slot.written += static_cast<size_t>(written);
+                        }
+                        finish(index, true);
+                    }
+
+                    void reap_completions() {
+                        std::lock_guard<std::mutex> ring_lock(ring_mutex_);
+                        ring_.reap([this](uint64_t user_data, int result) {
+                            const size_t index = static_cast<size_t>(user_data);
+                            Slot& slot = slots_[index];
+                            if (result == -EINTR || result == -EAGAIN) {
+                                issue(index);
+                            } else if (result <= 0) {
+                                std::cerr << "File logging error: asynchronous write failed: "
+                                          << std::strerror(result < 0 ? -result : EIO) << std::endl;
+                                finish(index, false);
+                            } else if ((slot.written += static_cast<size_t>(result)) < slot.size) {
+                                issue(index); // Short write
+                            } else {
+                                finish(index, true);
+                            }
+                        });
+                    }
+#endif
+
+                    /**
+                     * @brief Writer thread: write everything queued with one writev per file
+                     */
+                    void run() {
+                        std::vector<size_t> batch;
+                        std::vector<ConstBuffer> buffers;
+                        for (;;) {
+                            {
+                                std::unique_lock<std::mutex> lock(mutex_);
+                                cv_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+                                if (queue_.empty()) {
+                                    return;
+                                }
+                                batch.assign(queue_.begin(), queue_.end());
+                                queue_.clear();
+                            }
+                            for (size_t first = 0; first < batch.size();) {
+                                const int fd = slots_[batch[first]].fd;
+                                size_t last = first;
+                                buffers.clear();
+                                while (last < batch.size() && slots_[batch[last]].fd == fd) {
+                                    const Slot& slot = slots_[batch[last]];
+                                    buffers.push_back({slot.data.get(), slot.size});
+                                    ++last;
+                                }
+                                const bool written = write_all(fd, buffers.data(), buffers.size());
+                                if (!written) {
+                                    std::cerr << "File logging error: asynchronous write failed: " << std::strerror(errno)
+                                              << std::endl;
+                                }
+                                for (size_t i = first; i < last; ++i) {
+                                    finish(batch[i], written);
+                                }
+                                first = last;
+                            }
+                        }
+                    }
+                };
+
+            }
+
+            namespace detail {
+                constexpr char kLogIndexMagic[8] = {'I', 'C', 'L', 'O', 'G', 'I', 'D', 'X'};
+                constexpr uint32_t kLogIndexVersion = 1;
+                constexpr size_t kLogIndexHeaderSize = 8 + 4 + 4; ///< magic, version, byte order
+                constexpr size_t kLogIndexEntrySize = 8 + 4 + 4 + 8 + 8; ///< offset, size, levels, first, last
+                constexpr uint32_t kLogIndexByteOrder = 0x01020304;
+                constexpr const char* kLogIndexExtension = ".idx";
+
+                /**
+                 * @brief One block of a log file as described by its sidecar index
+                 */
+                struct LogIndexEntry {
+                    uint64_t offset = 0;    ///< Offset of the block's first message in the log file
+                    uint32_t size = 0;      ///< Bytes in the block, whole messages only
+                    uint32_t levels = 0;    ///< Bit (1 << level) set for each level in the block
+                    int64_t first_ns = 0;   ///< Earliest record time in the block (system_clock nanoseconds)
+                    int64_t last_ns = 0;    ///< Latest record time in the block
+                };
+
+                inline void encode_index_entry(const LogIndexEntry& entry, char* out) {
+                    std::memcpy(out, &entry.offset, 8);
+                    std::memcpy(out + 8, &entry.size, 4);
+                    std::memcpy(out + 12, &entry.levels, 4);
+                    std::memcpy(out + 16, &entry.first_ns, 8);
+                    std::memcpy(out + 24, &entry.last_ns, 8);
+                }
+
+                inline LogIndexEntry decode_index_entry(const char* in) {
+                    LogIndexEntry entry;
+                    std::memcpy(&entry.offset, in, 8);
+                    std::memcpy(&entry.size, in + 8, 4);
+                    std::memcpy(&entry.levels, in + 12, 4);
+                    std::memcpy(&entry.first_ns, in + 16, 8);
+                    std::memcpy(&entry.last_ns, in + 24, 8);
+                    return entry;
+                }
+
+                /**
+                 * @brief Write an index header into out (kLogIndexHeaderSize bytes)
+                 */
+                inline void encode_index_header(char* out) {
+                    std::memcpy(out, kLogIndexMagic, 8);
+                    std::memcpy(out + 8, &kLogIndexVersion, 4);
+                    std::memcpy(out + 12, &kLogIndexByteOrder, 4);
+                }
+
+                /**
+                 * @brief Level of a line from its "[LEVEL]" or "level":"LEVEL" tag
+                 *
+                 * @return false if the line has no tag
+                 */
+                inline bool line_level(std::string_view line, LogLevel& level) {
+                    static const std::array<std::string, 8> tags = {
+                        "[DEBUG]", "[INFO]", "[WARNING]", "[ERROR]",
+                        "\"level\":\"DEBUG\"", "\"level\":\"INFO\"", "\"level\":\"WARNING\"", "\"level\":\"ERROR\""
+                    };
+                    size_t earliest = std::string_view::npos;
+                    for (size_t i = 0; i < tags.size(); ++i) {
+                        const size_t found = line.find(tags[i]);
+                        if (found < earliest) {
+                            earliest = found;
+                            level = static_cast<LogLevel>(i % 4);
+                        }
+                    }
+                    return earliest != std::string_view::npos;
+                }
+
+                /**
+                 * @brief Days from 1970-01-01 to a date of the proleptic Gregorian calendar
+                 */
+                inline int64_t days_from_civil(int64_t year, int month, int day) {
+                    year -= month <= 2 ? 1 : 0;
+                    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+                    const int64_t year_of_era = year - era * 400;
+                    const int64_t day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+                    const int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+                    return era * 146097 + day_of_era - 719468;
+                }
+
+                /**
+                 * @brief Reads the timestamp a formatter wrote at the start of a line
+                 *
+                 * Understands every TimestampFormat with any TimestampPrecision, either in
+                 * the first "[...]" of the line (DefaultLogFormatter, PatternFormatter) or
+                 * as the "time" member of a JSON line. STANDARD timestamps are local time;
+                 * their UTC offset is only looked up when the minute changes. mktime is
+                 * avoided because it re-reads the time zone on every call.
+                 */
+                class LineTimeParser {
+                private:
+                    char minute_[16] = {};  ///< "YYYY-MM-DD HH:MM" of the cached minute
+                    int64_t minute_seconds_ = 0;
+                    bool has_minute_ = false;
+
+                    static bool read_number(const char* text, size_t count, int& value) {
+                        value = 0;
+                        for (size_t i = 0; i < count; ++i) {
+                            if (text[i] < '0' || text[i] > '9') {
+                                return false;
+                            }
+                            value = value * 10 + (text[i] - '0');
+                        }
+                        return true;
+                    }
+
+                    /**
+                     * @brief Seconds by which local time is ahead of UTC at a moment
+                     */
+                    static int64_t utc_offset(int64_t seconds) {
+                        const std::time_t time = static_cast<std::time_t>(seconds);
+                        std::tm local_tm;
+                        localtime_threadsafe(&time, &local_tm);
+                        const int64_t days = days_from_civil(local_tm.tm_year + 1900, local_tm.tm_mon + 1, local_tm.tm_mday);
+                        const int64_t local = days * 86400 + local_tm.tm_hour * 3600 + local_tm.tm_min * 60 + local_tm.tm_sec;
+                        return local - seconds;
+                    }
+
+                    bool local_minute(const char* text, int64_t& seconds) {
+                        if (has_minute_ && std::memcmp(minute_, text, sizeof(minute_)) == 0) {
+                            seconds = minute_seconds_;
+                            return true;
+                        }
+                        int year, month, day, hour, minute;
+                        if (!read_number(text, 4, year) || !read_number(text + 5, 2, month) ||
+                            !read_number(text + 8, 2, day) || !read_number(text + 11, 2, hour) ||
+                            !read_number(text + 14, 2, minute) || month < 1 || month > 12) {
+                            return false;
+                        }
+                        // The offset looked up at the wrong moment can only miss a DST change; a second lookup catches it
+                        const int64_t local = days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60;
+                        int64_t utc = local - utc_offset(local);
+                        utc = local - utc_offset(utc);
+                        std::memcpy(minute_, text, sizeof(minute_));
+                        minute_seconds_ = utc;
+                        has_minute_ = true;
+                        seconds = minute_seconds_;
+                        return true;
+                    }
+
+                public:
+                    /**
+                     * @brief Find the time span a line's timestamp stands for
+                     *
+                     * A timestamp with fewer fractional digits covers a longer span, e.g.
+                     * "12:00:01" covers the whole second.
+                     *
+                     * @param first_ns Receives the earliest system_clock time, in nanoseconds
+                     * @param last_ns Receives the latest system_clock time, in nanoseconds
+                     * @return false if the line does not start with a timestamp
+                     */
+                    bool parse(std::string_view line, int64_t& first_ns, int64_t& last_ns) {
+                        const size_t open = line.substr(0, std::min<size_t>(line.size(), 256)).find_first_of("[{");
+                        if (open == std::string_view::npos) {
+                            return false;
+                        }
+                        const char* position = line.data() + open + 1;
+                        const char* const end = line.data() + line.size();
+                        char close = ']';
+                        if (line[open] == '{') {
+                            constexpr std::string_view key = "\"time\":";
+                            if (static_cast<size_t>(end - position) < key.size() ||
+                                std::memcmp(position, key.data(), key.size()) != 0) {
+                                return false;
+                            }
+                            position += key.size();
+                            close = ',';
+                            if (position < end && *position == '"') {
+                                ++position;
+                                close = '"';
+                            }
+                        }
+
+                        int64_t seconds = 0;
+                        bool utc = false;
+                        if (end - position >= 19 && position[4] == '-' && position[7] == '-' &&
+                            (position[10] == ' ' || position[10] == 'T') && position[13] == ':' && position[16] == ':') {
+                            int second;
+                            if (!read_number(position + 17, 2, second) || second > 60) {
+                                return false;
+                            }
+                            utc = position[10] == 'T';
+                            if (utc) {
+                                int year, month, day, hour, minute;
+                                if (!read_number(position, 4, year) || !read_number(position + 5, 2, month) ||
+                                    !read_number(position + 8, 2, day) || !read_number(position + 11, 2, hour) ||
+                                    !read_number(position + 14, 2, minute) || month < 1 || month > 12) {
+                                    return false;
+                                }
+                                seconds = days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60;
+                            } else if (!local_minute(position, seconds)) {
+                                return false;
+                            }
+                            seconds += second;
+                            position += 19;
+                        } else {
+                            // TimestampFormat::UNIX; short numbers are more likely part of the message
+                            const char* digits = position;
+                            while (position < end && *position >= '0' && *position <= '9' && position - digits < 12) {
+                                seconds = seconds * 10 + (*position - '0');
+                                ++position;
+                            }
+                            if (position - digits < 9) {
+                                return false;
+                            }
+                        }
+
+                        int64_t fraction = 0;
+                        int64_t resolution = 1000000000;
+                        if (position < end && *position == '.') {
+                            ++position;
+                            while (position < end && *position >= '0' && *position <= '9' && resolution > 1) {
+                                fraction = fraction * 10 + (*position - '0');
+                                resolution /= 10;
+                                ++position;
+                            }
+                            if (resolution == 1000000000) {
+                                return false;
+                            }
+                        }
+                        if (utc) {
+                            if (position >= end || *position != 'Z') {
+                                return false;
+                            }
+                            ++position;
+                        }
+                        if (position >= end || *position != close) {
+                            return false;
+                        }
+                        first_ns = seconds * 1000000000 + fraction * resolution;
+                        last_ns = first_ns + resolution - 1;
+                        return true;
+                    }
+                };
+
+                /**
+                 * @brief Builds the index of a compressed log, one entry per frame block
+                 *
+                 * Offsets are in decoded bytes. An entry describes the lines that start in
+                 * its block, from the first of them to the end of the block; a line that
+                 * runs on into the next blocks still belongs to the block it started in.
+                 * The level and time of each line are read from its text, and a line
+                 * without a level tag or timestamp widens its entry to every level or to
+                 * all of time.
+                 */
+                class FrameIndexBuilder {
+                private:
+                    static constexpr size_t kMaxLineText = 1024; ///< Tags and timestamps come early in a line
+
+                    std::vector<LogIndexEntry> entries_;
+                    LineTimeParser times_;
+                    std::string line_;          ///< Start of the line being read
+                    size_t line_entry_ = 0;     ///< Entry of the block the line started in
+                    bool in_line_ = false;
+                    uint64_t position_ = 0;     ///< Decoded bytes before the next block
+
+                public:
+                    void add_block(std::string_view block) {
+                        LogIndexEntry entry;
+                        entry.offset = position_ + block.size(); // Moved back when a line starts in the block
+                        entry.first_ns = std::numeric_limits<int64_t>::max();
+                        entry.last_ns = std::numeric_limits<int64_t>::min();
+                        entries_.push_back(entry);
+
+                        size_t start = 0;
+                        while (start < block.size()) {
+                            if (!in_line_) {
+                                if (entries_.back().size == 0) {
+                                    entries_.back().offset = position_ + start;
+                                    entries_.back().size = static_cast<uint32_t>(block.size() - start);
+                                }
+                                in_line_ = true;
+                                line_entry_ = entries_.size() - 1;
+                            }
+                            const size_t newline = block.find('\n', start);
+                            const size_t stop = newline == std::string_view::npos ? block.size() : newline;
+                            if (line_.size() < kMaxLineText) {
+                                line_.append(block.data() + start, std::min(stop - start, kMaxLineText - line_.size()));
+                            }
+                            if (newline == std::string_view::npos) {
+                                break;
+                            }
+                            finish_line();
+                            start = newline + 1;
+                        }
+                        position_ += block.size();
+                    }
+
+                    /**
+                     * @brief Finish the last line and take the entries
+                     */
+                    std::vector<LogIndexEntry> finish() {
+                        if (in_line_) {
+                            finish_line();
+                        }
+                        return std::move(entries_);
+                    }
+
+                private:
+                    void finish_line() {
+                        in_line_ = false;
+                        if (line_.empty()) {
+                            return; // Blank lines never match a search
+                        }
+                        LogIndexEntry& entry = entries_[line_entry_];
+                        LogLevel level;
+                        entry.levels |= line_level(line_, level) ? 1u << static_cast<unsigned>(level) : ~0u;
+                        int64_t first_ns;
+                        int64_t last_ns;
+                        if (!times_.parse(line_, first_ns, last_ns)) {
+                            first_ns = std::numeric_limits<int64_t>::min();
+                            last_ns = std::numeric_limits<int64_t>::max();
+                        }
+                        entry.first_ns = std::min(entry.first_ns, first_ns);
+                        entry.last_ns = std::max(entry.last_ns, last_ns);
+                        line_.clear();
+                    }
+                };
+
+                /**
+                 * @brief Write a complete index file
+                 *
+                 * @return true if every entry was written
+                 */
+                inline bool write_index_file(const std::string& filename, const std::vector<LogIndexEntry>& entries) {
+                    std::ofstream output(filename, std::ios::binary | std::ios::trunc);
+                    char header[kLogIndexHeaderSize];
+                    encode_index_header(header);
+                    output.write(header, sizeof(header));
+                    char entry[kLogIndexEntrySize];
+                    for (const LogIndexEntry& item : entries) {
+                        encode_index_entry(item, entry);
+                        output.write(entry, sizeof(entry));
+                    }
+                    output.flush();
+                    return static_cast<bool>(output);
+                }
+
+                /**
+                 * @brief Find needle in [begin, end)
+                 *
+                 * With SSE2, 16 candidate positions are tested at once by comparing the
+                 * needle's first and last bytes; only positions where both match are
+                 * compared in full.
+                 *
+                 * @return The first match, or end
+                 */
+                inline const char* find_substring(const char* begin, const char* end, std::string_view needle) {
+                    const size_t length = needle.size();
+                    if (length == 0) {
+                        return begin;
+                    }
+                    if (static_cast<size_t>(end - begin) < length) {
+                        return end;
+                    }
+                    if (length == 1) {
+                        const void* found = std::memchr(begin, needle[0], static_cast<size_t>(end - begin));
+                        return found ? static_cast<const char*>(found) : end;
+                    }
+                    const char* position = begin;
+                    const char* const last_start = end - length; // Last position a match can start at
+#ifdef INTERLACED_CORE_HAS_SSE2
+                    const __m128i first_byte = _mm_set1_epi8(needle[0]);
+                    const __m128i last_byte = _mm_set1_epi8(needle[length - 1]);
+                    for (; position + 15 <= last_start; position += 16) {
+                        const __m128i firsts = _mm_loadu_si128(reinterpret_cast<const __m128i*>(position));
+                        const __m128i lasts = _mm_loadu_si128(reinterpret_cast<const __m128i*>(position + length - 1));
+                        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+                            _mm_and_si128(_mm_cmpeq_epi8(firsts, first_byte), _mm_cmpeq_epi8(lasts, last_byte))));
+                        while (mask != 0) {
+                            const unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+                            if (std::memcmp(position + bit + 1, needle.data() + 1, length - 2) == 0) {
+                                return position + bit;
+                            }
+                            mask &= mask - 1;
+                        }
+                    }
+#endif
+                    for (; position <= last_start; ++position) {
+                        if (*position == needle[0] && std::memcmp(position + 1, needle.data() + 1, length - 1) == 0) {
+                            return position;
+                        }
+                    }
+                    return end;
+                }
+
+            }
+
+            /**
+             * @brief File logger with rotation capabilities
+             *
+             * Messages are appended to a user-space buffer and written to the file in
+             * batches according to the FlushPolicy. The size used for size-based rotation
+             * counts buffered bytes too, so rotation happens at exactly the same message
+             * regardless of the flush policy.
+             *
+             * Rotation is O(1) for the writing thread. The next file is opened ahead of
+             * time as "<filename>.next", and rotating renames the current file aside
+             * and swaps the two. A shared background thread then closes the old file,
+             * shifts the older generations (".1" becomes ".2", ...) and moves the old
+             * file to ".1". On Windows, where open files cannot be renamed, the next
+             * file is opened during rotation instead of ahead of time. Files a crash
+             * left renamed aside but not yet shifted are shifted in on construction.
+             *
+             * With LogCompression::LZ the background thread also compresses each
+             * rotated file to "<filename>.1.iclz". max_files counts generations
+             * whether they are compressed or not; RotatedLogReader reads both kinds.
+             *
+             * With enable_async_writes() a flush hands the buffered bytes to io_uring
+             * (or a writer thread) instead of calling write, so the logging thread
+             * only waits when every write buffer is still in flight. On rotation the
+             * background thread waits for the old file's writes before closing it.
+             *
+             * Time-based rotation happens at wall-clock boundaries: on the hour for
+             * hourly rotation, at local midnight for daily rotation.
+             *
+             * With enable_index() every file gets a sidecar "<file>.idx" that records,
+             * for each block of about block_size bytes, its offset, the levels in it
+             * and the times of its first and last message. LogSearcher uses it to
+             * skip blocks outside a time range or without the wanted levels. The
+             * index is renamed along with its file on rotation.
+             */
+            class RotatingFileLogger {
+            private:
+                std::string base_filename_;
+                detail::LogFile current_file_;
+                size_t max_file_size_;
+                int max_files_;
+                RotationStrategy strategy_;
+                std::chrono::system_clock::time_point next_rotation_;
+                std::chrono::hours rotation_interval_;
+                size_t current_file_size_;
+                FlushPolicy flush_policy_;
+                std::vector<char> buffer_;
+                size_t buffered_;
+                std::chrono::steady_clock::time_point first_buffered_;
+                std::shared_ptr<detail::BackgroundWorker> worker_;
+                std::shared_ptr<detail::RotationState> rotation_;
+                unsigned long rotation_count_ = 0;
+                LogCompression compression_ = LogCompression::NONE;
+                std::shared_ptr<detail::AsyncFileWriter> async_writer_; ///< Null when writing synchronously
+                size_t index_block_size_ = 0;           ///< 0 when no index is written
+                detail::LogFile index_file_;
+                detail::LogIndexEntry index_block_;     ///< The block being filled; levels is 0 when none is open
+                detail::LineTimeParser index_times_;    ///< Reads record times back from the messages
+
+            public:
+                /**
+                 * @brief Constructor for RotatingFileLogger
+                 *
+                 * @param base_filename The base filename for log files
+                 * @param max_file_size Maximum size of each log file (in bytes)
+                 * @param max_files Maximum number of log files to keep
+                 * @param flush_policy When buffered messages are written to the file
+                 */
+                RotatingFileLogger(const std::string& base_filename, size_t max_file_size = 10485760, int max_files = 5,
+                                   const FlushPolicy& flush_policy = FlushPolicy())
+                    : base_filename_(base_filename), max_file_size_(max_file_size), max_files_(max_files),
+                      strategy_(RotationStrategy::SIZE), rotation_interval_(std::chrono::hours(24)), current_file_size_(0),
+                      flush_policy_(flush_policy), buffered_(0) {
+                    buffer_.resize(flush_policy_.buffer_capacity);
+                    open_current_file();
+                    start_housekeeping();
+                }
+
+                /**
+                 * @brief Constructor for RotatingFileLogger with time-based rotation
+                 *
+                 * @param base_filename The base filename for log files
+                 * @param rotation_hours Hours between log rotations
+                 * @param max_files Maximum number of log files to keep
+                 * @param flush_policy When buffered messages are written to the file
+                 */
+                RotatingFileLogger(const std::string& base_filename, std::chrono::hours rotation_hours, int max_files = 5,
+                                   const FlushPolicy& flush_policy = FlushPolicy())
+                    : base_filename_(base_filename), max_file_size_(0), max_files_(max_files),
+                      strategy_(RotationStrategy::TIME),
+                      next_rotation_(detail::next_rotation_boundary(std::chrono::system_clock::now(), rotation_hours)),
+                      rotation_interval_(rotation_hours), current_file_size_(0),
+                      flush_policy_(flush_policy), buffered_(0) {
+                    buffer_.resize(flush_policy_.buffer_capacity);
+                    open_current_file();
+                    start_housekeeping();
+                }
+
+                /**
+                 * @brief Destructor writes any buffered messages and waits for background renames
+                 */
+                ~RotatingFileLogger() {
+                    flush();
+                    close_index_block();
+                    if (async_writer_) {
+                        async_writer_->detach();
+                    }
+                    wait_for_rotation();
+                    if (rotation_) {
+                        std::lock_guard<std::mutex> lock(rotation_->mutex);
+                        if (rotation_->spare.is_open()) {
+                            rotation_->spare.close();
+                            std::remove(spare_filename().c_str());
+                        }
+                    }
+                }
+
+                RotatingFileLogger(const RotatingFileLogger&) = delete;
+                RotatingFileLogger& operator=(const RotatingFileLogger&) = delete;
+
+                /**
+                 * @brief Write a message to the log file
+                 *
+                 * A newline is appended to the message.
+                 *
+                 * @param message The message to write
+                 * @param level The level of the message, used by FlushPolicy::flush_on_level
+                 */
+                void write(std::string_view message, LogLevel level = LOG_INFO) {
+                    detail::StatsTimer timer(detail::kStatFileWrite);
+                    try {
+                        if (!current_file_.is_open()) {
+                            // Try to reopen the file
+                            open_current_file();
+                            if (!current_file_.is_open()) {
+                                // If we still can't open the file, fall back to cerr
+                                std::cerr << "Failed to open log file: " << base_filename_ << std::endl;
+                                std::cerr << message << std::endl;
+                                return;
+                            }
+                        }
+
+                        // Check if we need to rotate
+                        if (should_rotate()) {
+                            rotate();
+                        }
+
+                        const size_t length = message.size() + 1; // +1 for newline
+                        if (buffered_ + length <= buffer_.size()) {
+                            if (buffered_ == 0) {
+                                first_buffered_ = std::chrono::steady_clock::now();
+                            }
+                            std::memcpy(buffer_.data() + buffered_, message.data(), message.size());
+                            buffer_[buffered_ + message.size()] = '\n';
+                            buffered_ += length;
+                        } else {
+                            // Too big for the remaining space: write buffer and message together
+                            const detail::ConstBuffer buffers[] = {
+                                {buffer_.data(), buffered_},
+                                {message.data(), message.size()},
+                                {"\n", 1}
+                            };
+                            write_buffers(buffers, 3);
+                        }
+
+                        // Track the file size, including bytes that are still buffered
+                        if (index_block_size_ > 0) {
+                            index_message(level, message, length);
+                        }
+                        current_file_size_ += length;
+                        detail::count_stat(detail::kStatFileMessages);
+                        detail::count_stat(detail::kStatFileBytes, length);
+
+                        if (buffered_ > 0 && flush_due(level)) {
+                            flush();
+                        }
+                    } catch (const std::exception& e) {
+                        // If we can't write to the file, try to write to cerr as a fallback
+                        std::cerr << "File logging error: " << e.what() << std::endl;
+                        std::cerr << message << std::endl;
+                    } catch (...) {
+                        // If we can't write to the file, try to write to cerr as a fallback
+                        std::cerr << "Unknown file logging error occurred" << std::endl;
+                        std::cerr << message << std::endl;
+                    }
+                }
+
+                /**
+                 * @brief Write all buffered messages to the file
+                 */
+                void flush() {
+                    if (buffered_ > 0) {
+                        const detail::ConstBuffer buffers[] = {{buffer_.data(), buffered_}};
+                        write_buffers(buffers, 1);
+                    }
+                }
+
+                /**
+                 * @brief Flush if the buffered data is older than the policy's flush interval
+                 */
+                void flush_if_due() {
+                    if (buffered_ > 0 && interval_elapsed()) {
+                        flush();
+                    }
+                }
+
+                /**
+                 * @brief Change the flush policy, flushing anything already buffered
+                 *
+                 * @param flush_policy The new policy
+                 */
+                void set_flush_policy(const FlushPolicy& flush_policy) {
+                    flush();
+                    flush_policy_ = flush_policy;
+                    buffer_.assign(flush_policy_.buffer_capacity, '\0');
+                }
+
+                /**
+                 * @brief Get the active flush policy
+                 */
+                const FlushPolicy& flush_policy() const {
+                    return flush_policy_;
+                }
+
+                /**
+                 * @brief Choose how files are compressed from the next rotation on
+                 *
+                 * Generations rotated earlier keep their current form.
+                 */
+                void set_compression(LogCompression compression) {
+                    compression_ = compression;
+                }
+
+                /**
+                 * @brief Get the compression applied to rotated files
+                 */
+                LogCompression compression() const {
+                    return compression_;
+                }
+
+                /**
+                 * @brief Write through io_uring, or a writer thread where io_uring is unavailable
+                 *
+                 * Anything buffered is written first. Size accounting and rotation are
+                 * unchanged; flush() hands data off without waiting for it, and
+                 * wait_for_writes() waits until it is in the file.
+                 *
+                 * @param options Number and size of the write buffers, and the backend
+                 */
+                void enable_async_writes(const AsyncWriteOptions& options = AsyncWriteOptions()) {
+                    flush();
+                    async_writer_.reset();
+                    async_writer_ = std::make_shared<detail::AsyncFileWriter>(options);
+                    attach_async_writer();
+                }
+
+                /**
+                 * @brief Go back to synchronous writes after the pending ones complete
+                 */
+                void disable_async_writes() {
+                    flush();
+                    async_writer_.reset();
+                }
+
+                /**
+                 * @brief Counters of the asynchronous writes, all zero when writing synchronously
+                 */
+                AsyncWriteStats async_write_stats() const {
+                    return async_writer_ ? async_writer_->stats() : AsyncWriteStats();
+                }
+
+                /**
+                 * @brief Block until every flushed byte is in the file
+                 */
+                void wait_for_writes() {
+                    if (async_writer_) {
+                        async_writer_->drain();
+                    }
+                }
+
+                /**
+                 * @brief Write a sidecar index for LogSearcher next to each file
+                 *
+                 * Only messages written from now on are indexed; LogSearcher scans
+                 * the rest of a file in full. Each entry records the time range of its
+                 * messages as printed by the formatter, so the entries stay correct when
+                 * an asynchronous queue writes records late; messages without a
+                 * timestamp count as written now. With LogCompression::LZ, compressed
+                 * generations get an index of their own.
+                 *
+                 * @param block_size Bytes of messages per index entry
+                 */
+                void enable_index(size_t block_size = 64 * 1024) {
+                    close_index_block();
+                    index_block_size_ = std::min<size_t>(std::max<size_t>(block_size, 1), UINT32_MAX / 2);
+                    open_index_file(false);
+                }
+
+                /**
+                 * @brief Stop writing the index; the existing entries stay valid
+                 */
+                void disable_index() {
+                    close_index_block();
+                    index_file_.close();
+                    index_block_size_ = 0;
+                }
+
+                /**
+                 * @brief Size of the current file including buffered bytes
+                 */
+                size_t current_file_size() const {
+                    return current_file_size_;
+                }
+
+                /**
+                 * @brief Number of bytes waiting in the user-space buffer
+                 */
+                size_t buffered_bytes() const {
+                    return buffered_;
+                }
+
+                /**
+                 * @brief Block until the background work of earlier rotations has finished
+                 *
+                 * Afterwards every rotated generation has its final ".N" name.
+                 */
+                void wait_for_rotation() {
+                    if (!rotation_) {
+                        return;
+                    }
+                    std::unique_lock<std::mutex> lock(rotation_->mutex);
+                    rotation_->idle.wait(lock, [this]() { return rotation_->pending == 0; });
+                }
+
+            private:
+                bool interval_elapsed() const {
+                    return flush_policy_.flush_interval.count() > 0 &&
+                           std::chrono::steady_clock::now() - first_buffered_ >= flush_policy_.flush_interval;
+                }
+
+                bool flush_due(LogLevel level) const {
+                    return buffered_ >= flush_policy_.flush_bytes ||
+                           (flush_policy_.flush_on_level && level >= flush_policy_.flush_level) ||
+                           interval_elapsed();
+                }
+
+                /**
+                 * @brief Write buffers to the file and empty the user-space buffer
+                 */
+                void write_buffers(const detail::ConstBuffer* buffers, size_t count) {
+                    if (async_writer_ && async_writer_->attached()) {
+                        async_writer_->write(buffers, count);
+                    } else if (!current_file_.write(buffers, count)) {
+                        std::cerr << "File logging error: failed to write to " << base_filename_ << std::endl;
+                        for (size_t i = 0; i < count; ++i) {
+                            std::cerr.write(buffers[i].data, static_cast<std::streamsize>(buffers[i].size));
+                        }
+                    }
+                    buffered_ = 0;
+                }
+
+                /**
+                 * @brief Open the current log file
+                 */
+                void open_current_file() {
+                    if (current_file_.open(base_filename_)) {
+                        current_file_size_ = current_file_.size();
+                        attach_async_writer();
+                    } else if (!base_filename_.empty()) {
+                        std::cerr << "Error opening log file: " << base_filename_ << std::endl;
+                    }
+                }
+
+                /**
+                 * @brief Point the asynchronous writer at the current file
+                 */
+                void attach_async_writer() {
+                    if (async_writer_ && current_file_.is_open()) {
+                        async_writer_->attach(current_file_.native_handle(), current_file_.size());
+                    }
+                }
+
+                /**
+                 * @brief Open the current file's index, writing the header into a new one
+                 */
+                void open_index_file(bool truncate) {
+                    const std::string filename = base_filename_ + detail::kLogIndexExtension;
+                    if (!index_file_.open(filename, truncate)) {
+                        std::cerr << "Error opening log index file: " << filename << std::endl;
+                        return;
+                    }
+                    if (index_file_.size() == 0) {
+                        char header[detail::kLogIndexHeaderSize];
+                        detail::encode_index_header(header);
+                        const detail::ConstBuffer buffer = {header, sizeof(header)};
+                        index_file_.write(&buffer, 1);
+                    }
+                }
+
+                /**
+                 * @brief Add a message that starts at current_file_size_ to the open index block
+                 */
+                void index_message(LogLevel level, std::string_view message, size_t length) {
+                    int64_t first_ns;
+                    int64_t last_ns;
+                    if (!index_times_.parse(message, first_ns, last_ns)) {
+                        first_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::system_clock::now().time_since_epoch()).count();
+                        last_ns = first_ns;
+                    }
+                    if (index_block_.levels == 0) {
+                        index_block_.offset = current_file_size_;
+                        index_block_.first_ns = first_ns;
+                        index_block_.last_ns = last_ns;
+                    }
+                    index_block_.levels |= 1u << static_cast<unsigned>(level);
+                    index_block_.first_ns = std::min(index_block_.first_ns, first_ns);
+                    index_block_.last_ns = std::max(index_block_.last_ns, last_ns);
+                    index_block_.size = static_cast<uint32_t>(current_file_size_ + length - index_block_.offset);
+                    if (index_block_.size >= index_block_size_) {
+                        close_index_block();
+                    }
+                }
+
+                /**
+                 * @brief Append the open block's entry to the index
+                 */
+                void close_index_block() {
+                    if (index_block_.levels == 0) {
+                        return;
+                    }
+                    char entry[detail::kLogIndexEntrySize];
+                    detail::encode_index_entry(index_block_, entry);
+                    const detail::ConstBuffer buffer = {entry, sizeof(entry)};
+                    if (index_file_.is_open() && !index_file_.write(&buffer, 1)) {
+                        std::cerr << "Error writing log index for " << base_filename_ << std::endl;
+                    }
+                    index_block_ = detail::LogIndexEntry();
+                }
+
+                std::string spare_filename() const {
+                    return base_filename_ + ".next";
+                }
+
+                /**
+                 * @brief Attach the background worker and open the first spare file
+                 *
+                 * Nothing is prepared when the current file could not be opened, so an
+                 * unusable filename does not leave stray files behind.
+                 */
+                void start_housekeeping() {
+                    if (!current_file_.is_open()) {
+                        return;
+                    }
+                    recover_rotated_files(base_filename_, max_files_);
+                    worker_ = detail::BackgroundWorker::instance();
+                    rotation_ = std::make_shared<detail::RotationState>();
+#ifndef _WIN32
+                    rotation_->spare.open(spare_filename(), true);
+#endif
+                }
+
+                /**
+                 * @brief Move rotated files left behind by a crash into the generations
+                 *
+                 * rotate() renames the current file to "<base>.rotating.N" and leaves
+                 * shifting it to ".1" to the background worker. Files whose shift never
+                 * ran are newer than every generation, so they are shifted in now,
+                 * oldest rotation first.
+                 */
+                static void recover_rotated_files(const std::string& base_filename, int max_files) {
+                    const std::filesystem::path base(base_filename);
+                    const std::string prefix = base.filename().string() + ".rotating.";
+                    const std::filesystem::path directory = base.has_parent_path() ? base.parent_path() : ".";
+                    std::vector<std::pair<unsigned long, std::string>> leftovers;
+                    std::error_code error;
+                    for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end;
+                         it.increment(error)) {
+                        const std::string name = it->path().filename().string();
+                        if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0) {
+                            continue;
+                        }
+                        // Only "<base>.rotating.N" itself; its index moves along with it
+                        const char* const number_begin = name.data() + prefix.size();
+                        const char* const number_end = name.data() + name.size();
+                        unsigned long number = 0;
+                        const auto result = std::from_chars(number_begin, number_end, number);
+                        if (result.ec == std::errc() && result.ptr == number_end) {
+                            leftovers.emplace_back(number, base_filename + ".rotating." + std::to_string(number));
+                        }
+                    }
+                    std::sort(leftovers.begin(), leftovers.end());
+                    for (const auto& leftover : leftovers) {
+                        shift_generations(base_filename, max_files, leftover.second);
+                    }
+                }
+
+                /**
+                 * @brief Shift older generations up by one and remove the oldest
+                 *
+                 * Each generation is either "<base>.N" or "<base>.N.iclz", optionally
+                 * with a "<base>.N.idx" or "<base>.N.iclz.idx" index.
+                 *
+                 * @param rotated The file that becomes generation ".1"
+                 */
+                static void shift_generations(const std::string& base_filename, int max_files, const std::string& rotated) {
+                    const std::string extension = detail::kCompressedLogExtension;
+                    const std::string index = detail::kLogIndexExtension;
+                    for (int i = max_files - 1; i > 0; --i) {
+                        std::string old_name = base_filename + "." + std::to_string(i);
+                        std::string new_name = base_filename + "." + std::to_string(i + 1);
+
+                        // Remove the new file if it exists
+                        std::remove(new_name.c_str());
+                        std::remove((new_name + extension).c_str());
+                        std::remove((new_name + index).c_str());
+                        std::remove((new_name + extension + index).c_str());
+
+                        // Rename the old file to new name
+                        std::rename(old_name.c_str(), new_name.c_str());
+                        std::rename((old_name + extension).c_str(), (new_name + extension).c_str());
+                        std::rename((old_name + index).c_str(), (new_name + index).c_str());
+                        std::rename((old_name + extension + index).c_str(), (new_name + extension + index).c_str());
+                    }
+
+                    // Rename the rotated file to .1
+                    std::string backup_name = base_filename + ".1";
+                    std::remove((backup_name + extension).c_str());
+                    std::remove((backup_name + index).c_str());
+                    std::remove((backup_name + extension + index).c_str());
+                    std::rename(rotated.c_str(), backup_name.c_str());
+                    std::rename((rotated + index).c_str(), (backup_name + index).c_str());
+                }
+
+                /**
+                 * @brief Replace generation ".1" with its compressed form
+                 *
+                 * The plain file is kept if compression fails. With index set, the
+                 * plain file's index is replaced by one with an entry per frame block.
+                 */
+                static void compress_generation(const std::string& base_filename, bool index) {
+                    const std::string plain = base_filename + ".1";
+                    const std::string compressed = plain + detail::kCompressedLogExtension;
+                    const std::string partial = compressed + ".tmp";
+                    const std::string compressed_index = compressed + detail::kLogIndexExtension;
+                    detail::FrameIndexBuilder builder;
+                    std::function<void(std::string_view)> on_block;
+                    if (index) {
+                        on_block = [&builder](std::string_view block) { builder.add_block(block); };
+                    }
+                    if (detail::compress_log_file(plain, partial, on_block)) {
+                        // The index goes first so that the compressed file never appears without it
+                        if (index && !detail::write_index_file(compressed_index, builder.finish())) {
+                            std::remove(compressed_index.c_str());
+                            std::cerr << "Error writing log index: " << compressed_index << std::endl;
+                        }
+                        if (std::rename(partial.c_str(), compressed.c_str()) != 0) {
+                            std::remove(compressed_index.c_str());
+                            std::remove(partial.c_str());
+                            std::cerr << "Error compressing log file: " << plain << std::endl;
+                            return;
+                        }
+                        std::remove(plain.c_str());
+                        std::remove((plain + detail::kLogIndexExtension).c_str()); // Offsets of the plain file
+                    } else {
+                        std::remove(partial.c_str());
+                        std::cerr << "Error compressing log file: " << plain << std::endl;
+                    }
+                }
+
+                /**
+                 * @brief Check if we should rotate the log file
+                 *
+                 * @return true if we should rotate, false otherwise
+                 */
+                bool should_rotate() {
+                    try {
+                        if (strategy_ == RotationStrategy::SIZE) {
+                            return current_file_size_ >= max_file_size_;
+                        } else { // TIME strategy
+                            return std::chrono::system_clock::now() >= next_rotation_;
+                        }
+                    } catch (...) {
+                        // If there's an error checking rotation, default to not rotating
+                        return false;
+                    }
+                }
+
+                /**
+                 * @brief Rotate the log files
+                 *
+                 * Swaps in the pre-opened spare file and leaves the renaming of older
+                 * generations to the background worker. Falls back to doing everything
+                 * here when no spare is available.
+                 */
+                void rotate() {
+                    detail::StatsTimer timer(detail::kStatFileRotate);
+                    try {
+                        flush();
+                        close_index_block();
+                        index_file_.close();
+                        if (strategy_ == RotationStrategy::TIME) {
+                            next_rotation_ = detail::next_rotation_boundary(std::chrono::system_clock::now(),
+                                                                            rotation_interval_);
+                        }
+
+                        if (!rotation_) {
+                            if (async_writer_) {
+                                async_writer_->detach(); // The old file must be complete before it is closed
+                            }
+                            current_file_.close();
+                            shift_generations(base_filename_, max_files_, base_filename_);
+                            open_current_file();
+                            current_file_size_ = 0;
+                            if (index_block_size_ > 0) {
+                                open_index_file(true);
+                            }
+                            detail::count_stat(detail::kStatRotations);
+                            return;
+                        }
+
+                        std::string rotated = base_filename_ + ".rotating." + std::to_string(++rotation_count_);
+                        auto old_file = std::make_shared<detail::LogFile>();
+                        // Writes still in flight to the old file are waited for by the background task
+                        std::shared_ptr<detail::AsyncFileWriter> old_writer;
+                        int old_fd = -1;
+                        if (async_writer_) {
+#ifdef _WIN32
+                            async_writer_->detach();
+#else
+                            old_fd = async_writer_->release_file();
+                            old_writer = async_writer_;
+#endif
+                        }
+                        {
+                            std::lock_guard<std::mutex> lock(rotation_->mutex);
+#ifdef _WIN32
+                            current_file_.close(); // Open files cannot be renamed
+#endif
+                            std::rename(base_filename_.c_str(), rotated.c_str());
+                            if (index_block_size_ > 0) {
+                                std::rename((base_filename_ + detail::kLogIndexExtension).c_str(),
+                                            (rotated + detail::kLogIndexExtension).c_str());
+                            }
+                            old_file->swap(current_file_);
+                            if (rotation_->spare.is_open() &&
+                                std::rename(spare_filename().c_str(), base_filename_.c_str()) == 0) {
+                                current_file_.swap(rotation_->spare);
+                                attach_async_writer();
+                            } else {
+                                rotation_->spare.close();
+                                open_current_file();
+                            }
+                            ++rotation_->pending;
+                        }
+                        current_file_size_ = 0;
+                        if (index_block_size_ > 0) {
+                            open_index_file(true);
+                        }
+                        detail::count_stat(detail::kStatRotations);
+
+                        std::shared_ptr<detail::RotationState> state = rotation_;
+                        std::string base_filename = base_filename_;
+                        std::string spare_filename = this->spare_filename();
+                        int max_files = max_files_;
+                        bool compress = compression_ == LogCompression::LZ;
+                        bool index = index_block_size_ > 0;
+                        worker_->submit([state, old_file, old_writer, old_fd, base_filename, spare_filename, max_files,
+                                         rotated, compress, index]() {
+                            if (old_writer) {
+                                old_writer->wait_for_file(old_fd);
+                            }
+                            old_file->close();
+                            shift_generations(base_filename, max_files, rotated);
+#ifndef _WIN32
+                            {
+                                std::lock_guard<std::mutex> lock(state->mutex);
+                                if (!state->spare.is_open()) {
+                                    state->spare.open(spare_filename, true);
+                                }
+                            }
+#endif
+                            if (compress) {
+                                compress_generation(base_filename, index);
+                            }
+
+                            std::lock_guard<std::mutex> lock(state->mutex);
+                            --state->pending;
+                            state->idle.notify_all();
+                        });
+                    } catch (const std::exception& e) {
+                        std::cerr << "Error rotating log files: " << e.what() << std::endl;
+                        // Try to reopen the current file
+                        if (!current_file_.is_open()) {
+                            open_current_file();
+                        }
+                    }
+                }
+            };
+
+            /**
+             * @brief Reads the lines of a RotatingFileLogger's files, oldest generation first
+             *
+             * Generations "<filename>.N" down to "<filename>.1" are read before the
+             * current file. Compressed generations ("<filename>.N.iclz") are decoded
+             * block by block while reading, so they are never held in memory whole.
+             *
+             * Example:
+             * @code
+             * RotatedLogReader reader("app.log", 5);
+             * std::string line;
+             * while (reader.next_line(line)) {
+             *     std::cout << line << std::endl;
+             * }
+             * @endcode
+             */
+            class RotatedLogReader {
+            private:
+                struct Generation {
+                    std::string filename;
+                    bool compressed;
+                };
+
+                std::vector<Generation> files_;      ///< Oldest first
+                size_t next_file_ = 0;
+                bool reading_ = false;
+                std::ifstream plain_;
+                detail::CompressedLogInput compressed_;
+                std::vector<char> chunk_;
+                std::string buffer_;                 ///< Data read but not yet returned
+                size_t offset_ = 0;
+                bool failed_ = false;
+
+            public:
+                /**
+                 * @brief Find the files of a rotating log
+                 *
+                 * @param base_filename The base filename the logger was created with
+                 * @param max_files The logger's max_files, i.e. how many generations to look for
+                 */
+                explicit RotatedLogReader(const std::string& base_filename, int max_files = 5) {
+                    for (int i = max_files; i > 0; --i) {
+                        const std::string generation = base_filename + "." + std::to_string(i);
+                        if (exists(generation)) {
+                            files_.push_back({generation, false});
+                        } else if (exists(generation + detail::kCompressedLogExtension)) {
+                            files_.push_back({generation + detail::kCompressedLogExtension, true});
+                        }
+                    }
+                    if (exists(base_filename)) {
+                        files_.push_back({base_filename, false});
+                    }
+                }
+
+                /**
+                 * @brief Number of files found, including the current one
+                 */
+                size_t file_count() const {
+                    return files_.size();
+                }
+
+                /**
+                 * @brief Read the next line, without its newline
+                 *
+                 * @param line Receives the line
+                 * @return false when every file has been read
+                 */
+                bool next_line(std::string& line) {
+                    for (;;) {
+                        const size_t newline = buffer_.find('\n', offset_);
+                        if (newline != std::string::npos) {
+                            line.assign(buffer_, offset_, newline - offset_);
+                            offset_ = newline + 1;
+                            return true;
+                        }
+                        buffer_.erase(0, offset_);
+                        offset_ = 0;
+                        if (read_more()) {
+                            continue;
+                        }
+                        if (!buffer_.empty()) {
+                            // Last line of a file without a trailing newline
+                            line = std::move(buffer_);
+                            buffer_.clear();
+                            return true;
+                        }
+                        if (!open_next()) {
+                            return false;
+                        }
+                    }
+                }
+
+                /**
+                 * @brief Whether a compressed generation was corrupt or truncated
+                 *
+                 * Reading continues with the next file after such an error.
+                 */
+                bool failed() const {
+                    return failed_;
+                }
+
+            private:
+                static bool exists(const std::string& filename) {
+                    std::ifstream probe(filename, std::ios::binary);
+                    return static_cast<bool>(probe);
+                }
+
+                /**
+                 * @brief Append more of the current file to the buffer
+                 *
+                 * @return false at the end of the current file
+                 */
+                bool read_more() {
+                    if (!reading_) {
+                        return false;
+                    }
+                    if (files_[next_file_ - 1].compressed) {
+                        if (compressed_.next_block(buffer_)) {
+                            return true;
+                        }
+                        failed_ = failed_ || compressed_.failed();
+                    } else {
+                        chunk_.resize(detail::kCompressedBlockSize);
+                        plain_.read(chunk_.data(), static_cast<std::streamsize>(chunk_.size()));
+                        const size_t size = static_cast<size_t>(plain_.gcount());
+                        if (size > 0) {
+                            buffer_.append(chunk_.data(), size);
+                            return true;
+                        }
+                    }
+                    reading_ = false;
+                    return false;
+                }
+
+                bool open_next() {
+                    if (next_file_ >= files_.size()) {
+                        return false;
+                    }
+                    const Generation& file = files_[next_file_++];
+                    if (file.compressed) {
+                        if (!compressed_.open(file.filename)) {
+                            failed_ = true;
+                        }
+                    } else {
+                        plain_.close();
+                        plain_.clear();
+                        plain_.open(file.filename, std::ios::binary);
+                    }
+                    reading_ = true;
+                    return true;
+                }
+            };
+
+            /**
+             * @brief What LogSearcher::search() looks for
+             */
+            struct LogQuery {
+                std::chrono::system_clock::time_point from = std::chrono::system_clock::time_point::min();
+                std::chrono::system_clock::time_point to = std::chrono::system_clock::time_point::max();
+                LogLevel min_level = LOG_DEBUG;
+                std::string contains;   ///< Text every returned line contains; empty matches every line
+            };
+
+            /**
+             * @brief How much a LogSearcher::search() call had to read
+             */
+            struct LogSearchStats {
+                size_t files = 0;            ///< Files searched
+                size_t indexed_blocks = 0;   ///< Blocks listed in the indexes
+                size_t skipped_blocks = 0;   ///< Indexed blocks ruled out without reading them
+                uint64_t bytes_scanned = 0;  ///< Bytes of log text scanned
+                size_t matches = 0;          ///< Lines passed to the callback
+            };
+
+            /**
+             * @brief Searches the files of a RotatingFileLogger by time, level and text
+             *
+             * Plain files are memory-mapped and compressed generations are decoded
+             * block by block. Where a file has an index (see
+             * RotatingFileLogger::enable_index()), blocks outside the time range or
+             * without a wanted level are skipped unread; compressed blocks are not
+             * even decoded. Elsewhere, and in blocks only partly inside the range,
+             * each line's timestamp is read back from its text. The level of a line
+             * is taken from its "[LEVEL]" or "level":"LEVEL" tag. Lines without a
+             * timestamp or level tag are kept.
+             *
+             * Example:
+             * @code
+             * LogQuery query;
+             * query.from = std::chrono::system_clock::now() - std::chrono::hours(1);
+             * query.min_level = LOG_WARNING;
+             * query.contains = "timeout";
+             * LogSearcher("app.log", 5).search(query, [](std::string_view line) {
+             *     std::cout << line << '\n';
+             * });
+             * @endcode
+             */
+            class LogSearcher {
+            public:
+                using Callback = std::function<void(std::string_view line)>;
+
+            private:
+                struct Generation {
+                    std::string filename;
+                    bool compressed;
+                };
+
+                /**
+                 * @brief A read-only view of a whole file
+                 */
+                class MappedLog {
+                private:
+                    const char* data_ = nullptr;
+                    size_t size_ = 0;
+#ifdef _WIN32
+                    std::vector<char> contents_;
+#endif
+
+                public:
+                    explicit MappedLog(const std::string& filename) {
+#ifdef _WIN32
+                        std::ifstream input(filename, std::ios::binary);
+                        contents_.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+                        data_ = contents_.data();
+                        size_ = contents_.size();
+#else
+                        const int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+                        if (fd < 0) {
+                            return;
+                        }
+                        struct stat info;
+                        if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+                            void* mapped = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                            if (mapped != MAP_FAILED) {
+                                data_ = static_cast<const char*>(mapped);
+                                size_ = static_cast<size_t>(info.st_size);
+                            }
+                        }
+                        ::close(fd);
+#endif
+                    }
+
+                    ~MappedLog() {
+#ifndef _WIN32
+                        if (data_) {
+                            ::munmap(const_cast<char*>(data_), size_);
+                        }
+#endif
+                    }
+
+                    MappedLog(const MappedLog&) = delete;
+                    MappedLog& operator=(const MappedLog&) = delete;
+
+                    const char* data() const {
+                        return data_;
+                    }
+
+                    size_t size() const {
+                        return size_;
+                    }
+                };
+
+                /**
+                 * @brief What still has to be checked for each line of a stretch of text
+                 */
+                struct LineChecks {
+                    bool levels;    ///< Lines may be below query.min_level
+                    bool times;     ///< Lines may be outside the time range
+                };
+
+                std::vector<Generation> files_;      ///< Oldest first
+                LogSearchStats stats_;
+                detail::LineTimeParser times_;
+
+            public:
+                /**
+                 * @brief Find the files of a rotating log
+                 *
+                 * @param base_filename The base filename the logger was created with
+                 * @param max_files The logger's max_files, i.e. how many generations to look for
+                 */
+                explicit LogSearcher(const std::string& base_filename, int max_files = 5) {
+                    for (int i = max_files; i > 0; --i) {
+                        const std::string generation = base_filename + "." + std::to_string(i);
+                        if (exists(generation)) {
+                            files_.push_back({generation, false});
+                        } else if (exists(generation + detail::kCompressedLogExtension)) {
+                            files_.push_back({generation + detail::kCompressedLogExtension, true});
+                        }
+                    }
+                    if (exists(base_filename)) {
+                        files_.push_back({base_filename, false});
+                    }
+                }
+
+                /**
+                 * @brief Number of files found, including the current one
+                 */
+                size_t file_count() const {
+                    return files_.size();
+                }
+
+                /**
+                 * @brief Pass every matching line to callback, oldest file first
+                 *
+                 * @param query Time range, minimum level and text to look for
+                 * @param callback Receives each line without its newline; the view is only valid during the call
+                 * @return Number of matching lines
+                 */
+                size_t search(const LogQuery& query, const Callback& callback) {
+                    stats_ = LogSearchStats();
+                    for (const Generation& file : files_) {
+                        ++stats_.files;
+                        if (file.compressed) {
+                            search_compressed(file.filename, query, callback);
+                        } else {
+                            search_plain(file.filename, query, callback);
+                        }
+                    }
+                    return stats_.matches;
+                }
+
+                /**
+                 * @brief What the last search() read and skipped
+                 */
+                const LogSearchStats& last_stats() const {
+                    return stats_;
+                }
+
+            private:
+                static bool exists(const std::string& filename) {
+                    std::ifstream probe(filename, std::ios::binary);
+                    return static_cast<bool>(probe);
+                }
+
+                static int64_t to_nanoseconds(std::chrono::system_clock::time_point time) {
+                    if (time == std::chrono::system_clock::time_point::min()) {
+                        return std::numeric_limits<int64_t>::min();
+                    }
+                    if (time == std::chrono::system_clock::time_point::max()) {
+                        return std::numeric_limits<int64_t>::max();
+                    }
+                    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+                }
+
+                /**
+                 * @brief Read a file's index; empty if it is missing or not an index
+                 */
+                static std::vector<detail::LogIndexEntry> read_index(const std::string& filename) {
+                    std::vector<detail::LogIndexEntry> entries;
+                    std::ifstream input(filename + detail::kLogIndexExtension, std::ios::binary);
+                    std::string contents((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+                    if (contents.size() < detail::kLogIndexHeaderSize ||
+                        std::memcmp(contents.data(), detail::kLogIndexMagic, 8) != 0 ||
+                        std::memcmp(contents.data() + 8, &detail::kLogIndexVersion, 4) != 0 ||
+                        std::memcmp(contents.data() + 12, &detail::kLogIndexByteOrder, 4) != 0) {
+                        return entries;
+                    }
+                    // A torn last entry from a crash is ignored
+                    const size_t count = (contents.size() - detail::kLogIndexHeaderSize) / detail::kLogIndexEntrySize;
+                    entries.reserve(count);
+                    for (size_t i = 0; i < count; ++i) {
+                        entries.push_back(detail::decode_index_entry(
+                            contents.data() + detail::kLogIndexHeaderSize + i * detail::kLogIndexEntrySize));
+                    }
+                    return entries;
+                }
+
+                /**
+                 * @brief Whether an indexed block can hold matching lines, and what its lines need checked
+                 */
+                static bool select_block(const detail::LogIndexEntry& entry, uint32_t wanted, int64_t from, int64_t to,
+                                         LineChecks& checks) {
+                    checks.levels = (entry.levels & ~wanted) != 0;
+                    checks.times = entry.first_ns < from || entry.last_ns > to;
+                    return (entry.levels & wanted) != 0 && entry.first_ns <= to && entry.last_ns >= from;
+                }
+
+                /**
+                 * @brief Pass the matching lines of [begin, end) to callback
+                 */
+                void scan(const char* begin, const char* end, const LogQuery& query, LineChecks checks,
+                          const Callback& callback) {
+                    stats_.bytes_scanned += static_cast<uint64_t>(end - begin);
+                    const std::string_view needle = query.contains;
+                    const int64_t from = to_nanoseconds(query.from);
+                    const int64_t to = to_nanoseconds(query.to);
+                    const char* position = begin;
+                    while (position < end) {
+                        // With a needle, jump straight to the next occurrence and widen it to its line
+                        const char* hit = detail::find_substring(position, end, needle);
+                        if (hit == end) {
+                            return;
+                        }
+                        const char* line_start = hit;
+                        while (line_start > position && line_start[-1] != '\n') {
+                            --line_start;
+                        }
+                        const void* newline = std::memchr(hit, '\n', static_cast<size_t>(end - hit));
+                        const char* line_end = newline ? static_cast<const char*>(newline) : end;
+                        position = line_end + 1;
+
+                        const std::string_view line(line_start, static_cast<size_t>(line_end - line_start));
+                        if (line.empty() && needle.empty()) {
+                            continue;
+                        }
+                        LogLevel level;
+                        if (checks.levels && detail::line_level(line, level) && level < query.min_level) {
+                            continue;
+                        }
+                        int64_t first_ns;
+                        int64_t last_ns;
+                        if (checks.times && times_.parse(line, first_ns, last_ns) && (last_ns < from || first_ns > to)) {
+                            continue;
+                        }
+                        ++stats_.matches;
+                        callback(line);
+                    }
+                }
+
+                void search_plain(const std::string& filename, const LogQuery& query, const Callback& callback) {
+                    MappedLog log(filename);
+                    if (!log.data()) {
+                        return;
+                    }
+                    const std::vector<detail::LogIndexEntry> entries = read_index(filename);
+                    stats_.indexed_blocks += entries.size();
+                    const uint32_t wanted = ~((1u << static_cast<unsigned>(query.min_level)) - 1);
+                    const int64_t from = to_nanoseconds(query.from);
+                    const int64_t to = to_nanoseconds(query.to);
+                    // Written before indexing started: nothing is known about it
+                    const LineChecks unindexed = {query.min_level != LOG_DEBUG,
+                                                  from != std::numeric_limits<int64_t>::min() ||
+                                                  to != std::numeric_limits<int64_t>::max()};
+
+                    const uint64_t size = log.size();
+                    uint64_t covered = 0;
+                    for (const detail::LogIndexEntry& entry : entries) {
+                        const uint64_t block_begin = std::min<uint64_t>(entry.offset, size);
+                        const uint64_t block_end = std::min<uint64_t>(entry.offset + entry.size, size);
+                        if (block_begin > covered) {
+                            scan(log.data() + covered, log.data() + block_begin, query, unindexed, callback);
+                        }
+                        LineChecks checks;
+                        if (select_block(entry, wanted, from, to, checks) && block_end > block_begin) {
+                            scan(log.data() + block_begin, log.data() + block_end, query, checks, callback);
+                        } else {
+                            ++stats_.skipped_blocks;
+                        }
+                        covered = std::max(covered, block_end);
+                    }
+                    if (covered < size) {
+                        scan(log.data() + covered, log.data() + size, query, unindexed, callback);
+                    }
+                }
+
+                void search_compressed(const std::string& filename, const LogQuery& query, const Callback& callback) {
+                    detail::CompressedLogInput input;
+                    if (!input.open(filename)) {
+                        return;
+                    }
+                    // One entry per frame block, see detail::FrameIndexBuilder
+                    const std::vector<detail::LogIndexEntry> entries = read_index(filename);
+                    stats_.indexed_blocks += entries.size();
+                    const uint32_t wanted = ~((1u << static_cast<unsigned>(query.min_level)) - 1);
+                    const int64_t from = to_nanoseconds(query.from);
+                    const int64_t to = to_nanoseconds(query.to);
+                    const LineChecks unindexed = {query.min_level != LOG_DEBUG,
+                                                  from != std::numeric_limits<int64_t>::min() ||
+                                                  to != std::numeric_limits<int64_t>::max()};
+
+                    // Blocks split lines anywhere. buffer holds decoded text that starts at a
+                    // line start and has not been scanned yet; its first line belongs to an
+                    // earlier block, checked with carried_checks.
+                    std::string buffer;
+                    LineChecks carried_checks = unindexed;
+                    uint64_t position = 0; // Decoded offset of the next block
+                    for (size_t block = 0;; ++block) {
+                        const bool indexed = block < entries.size();
+                        LineChecks checks = unindexed;
+                        const bool selected = !indexed || select_block(entries[block], wanted, from, to, checks);
+                        if (!selected && buffer.empty()) {
+                            uint32_t decoded_size;
+                            if (!input.skip_block(decoded_size)) {
+                                break;
+                            }
+                            position += decoded_size;
+                            ++stats_.skipped_blocks;
+                            continue;
+                        }
+
+                        const size_t carried = buffer.size();
+                        if (!input.next_block(buffer)) {
+                            break;
+                        }
+                        const uint64_t block_start = position;
+                        const size_t block_size = buffer.size() - carried;
+                        position += block_size;
+
+                        // Where the lines that start in this block begin; before that is the
+                        // end of a line from an earlier block, which may have been skipped
+                        size_t lines_begin = carried;
+                        if (indexed) {
+                            const uint64_t offset = entries[block].offset;
+                            lines_begin += offset > block_start
+                                ? static_cast<size_t>(std::min<uint64_t>(offset - block_start, block_size)) : 0;
+                        } else if (carried > 0) {
+                            const size_t newline = buffer.find('\n', carried);
+                            lines_begin = newline == std::string::npos ? buffer.size() : newline + 1;
+                        }
+                        if (carried > 0) {
+                            if (lines_begin == buffer.size()) {
+                                continue; // No line starts here; the carried line may go on
+                            }
+                            scan(buffer.data(), buffer.data() + lines_begin, query, carried_checks, callback);
+                        }
+                        if (!selected) {
+                            buffer.clear();
+                            continue;
+                        }
+
+                        carried_checks = checks;
+                        const size_t complete = buffer.rfind('\n');
+                        if (complete == std::string::npos || complete < lines_begin) {
+                            buffer.erase(0, lines_begin);
+                            continue;
+                        }
+                        scan(buffer.data() + lines_begin, buffer.data() + complete + 1, query, checks, callback);
+                        buffer.erase(0, complete + 1);
+                    }
+                    if (!buffer.empty()) {
+                        scan(buffer.data(), buffer.data() + buffer.size(), query, carried_checks, callback);
+                    }
+                }
+            };
+
+            namespace detail {
+
+                /**
+                 * @brief Stream buffer that appends everything written to it to a std::string
+                 */
+                class StringAppendBuf : public std::streambuf {
+                private:
+                    std::string* out_ = nullptr;
+
+                public:
+                    std::string* target(std::string* out) {
+                        std::string* previous = out_;
+                        out_ = out;
+                        return previous;
+                    }
+
+                protected:
+                    int_type overflow(int_type ch) override {
+                        if (out_ && !traits_type::eq_int_type(ch, traits_type::eof())) {
+                            out_->push_back(traits_type::to_char_type(ch));
+                        }
+                        return traits_type::not_eof(ch);
+                    }
+
+                    std::streamsize xsputn(const char* s, std::streamsize n) override {
+                        if (out_) {
+                            out_->append(s, static_cast<size_t>(n));
+                        }
+                        return n;
+                    }
+                };
+
+                /**
+                 * @brief Reusable per-thread string buffers for building log lines
+                 *
+                 * Each thread owns a small stack of strings whose capacity survives
+                 * between log calls, so steady-state formatting does not allocate.
+                 * Nested log calls (e.g. from an operator<< that logs) take the next
+                 * buffer; when the stack is exhausted a local string is used instead.
+                 */
+                class ScratchBuffer {
+                private:
+                    static constexpr int kThreadBuffers = 4;
+
+                    struct ThreadBuffers {
+                        std::string buffers[kThreadBuffers];
+                        int in_use = 0;
+                    };
+
+                    static ThreadBuffers& thread_buffers() {
+                        thread_local ThreadBuffers buffers;
+                        return buffers;
+                    }
+
+                    std::string* buffer_;
+                    std::string local_;
+                    bool pooled_;
+
+                public:
+                    ScratchBuffer() {
+                        ThreadBuffers& buffers = thread_buffers();
+                        pooled_ = buffers.in_use < kThreadBuffers;
+                        if (pooled_) {
+                            buffer_ = &buffers.buffers[buffers.in_use++];
+                            buffer_->clear();
+                        } else {
+                            buffer_ = &local_;
+                        }
+                    }
+
+                    ~ScratchBuffer() {
+                        if (pooled_) {
+                            --thread_buffers().in_use;
+                        }
+                    }
+
+                    ScratchBuffer(const ScratchBuffer&) = delete;
+                    ScratchBuffer& operator=(const ScratchBuffer&) = delete;
+
+                    std::string& str() {
+                        return *buffer_;
+                    }
+                };
+
+                /**
+                 * @brief Append an integer in decimal without going through a stream
+                 */
+                template<typename T>
+                inline void append_integer(std::string& out, T value) {
+                    char digits[24];
+                    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+                    out.append(digits, static_cast<size_t>(result.ptr - digits));
+                }
+
+                /**
+                 * @brief Append a value exactly as `std::ostream << value` would print it
+                 *
+                 * Strings, characters, booleans, integers, floating point numbers and
+                 * pointers are written directly; any other type falls back to its
+                 * operator<< through a per-thread stream that appends into out.
+                 */
+                template<typename T>
+                inline void append_value(std::string& out, const T& value) {
+                    using Type = std::decay_t<T>;
+                    if constexpr (std::is_same_v<Type, std::string> || std::is_same_v<Type, std::string_view>) {
+                        out.append(value.data(), value.size());
+                    } else if constexpr (std::is_same_v<Type, const char*> || std::is_same_v<Type, char*>) {
+                        const char* text = value; // Arrays decay here
+                        if (text) {
+                            out.append(text);
+                        }
+                    } else if constexpr (std::is_same_v<Type, char> || std::is_same_v<Type, signed char> ||
+                                         std::is_same_v<Type, unsigned char>) {
+                        out.push_back(static_cast<char>(value));
+                    } else if constexpr (std::is_same_v<Type, bool>) {
+                        out.push_back(value ? '1' : '0');
+                    } else if constexpr (std::is_integral_v<Type>) {
+                        append_integer(out, value);
+                    } else if constexpr (std::is_floating_point_v<Type>) {
+                        // Matches the default stream formatting (%g with precision 6)
+                        char digits[64];
+                        int length = std::is_same_v<Type, long double>
+                            ? std::snprintf(digits, sizeof(digits), "%Lg", static_cast<long double>(value))
+                            : std::snprintf(digits, sizeof(digits), "%g", static_cast<double>(value));
+                        if (length > 0) {
+                            out.append(digits, static_cast<size_t>(length) < sizeof(digits) ? static_cast<size_t>(length) : sizeof(digits) - 1);
+                        }
+                    } else {
+                        struct ThreadStream {
+                            StringAppendBuf buffer;
+                            std::ostream stream{&buffer};
+                        };
+                        thread_local ThreadStream thread_stream;
+                        std::string* previous = thread_stream.buffer.target(&out);
+                        thread_stream.stream.clear();
+                        thread_stream.stream << value;
+                        thread_stream.buffer.target(previous);
+                    }
+                }
+
+                /**
+                 * @brief Append value as exactly width decimal digits, zero padded
+                 */
+                inline void append_zero_padded(std::string& out, unsigned long long value, int width) {
+                    char digits[20];
+                    for (int i = width - 1; i >= 0; --i) {
+                        digits[i] = static_cast<char>('0' + value % 10);
+                        value /= 10;
+                    }
+                    out.append(digits, static_cast<size_t>(width));
+                }
+
+                /**
+                 * @brief Per-thread cache of the whole-second part of a timestamp
+                 *
+                 * The calendar conversion and strftime only run when the second changes;
+                 * every other message in the same second reuses the cached text.
+                 */
+                class TimestampCache {
+                private:
+                    TimestampFormat format_;
+                    long long second_;
+                    char text_[48];
+                    size_t length_;
+
+                public:
+                    explicit TimestampCache(TimestampFormat format)
+                        : format_(format), second_(std::numeric_limits<long long>::min()), length_(0) {}
+
+                    /**
+                     * @brief Get the formatted text for a second since the epoch
+                     */
+                    std::string_view text(long long epoch_second) {
+                        if (epoch_second != second_) {
+                            refresh(epoch_second);
+                        }
+                        return std::string_view(text_, length_);
+                    }
+
+                private:
+                    void refresh(long long epoch_second) {
+                        second_ = epoch_second;
+                        if (format_ == TimestampFormat::UNIX) {
+                            auto result = std::to_chars(text_, text_ + sizeof(text_), epoch_second);
+                            length_ = static_cast<size_t>(result.ptr - text_);
+                            return;
+                        }
+
+                        const std::time_t time = static_cast<std::time_t>(epoch_second);
+                        std::tm time_info;
+                        if (format_ == TimestampFormat::ISO8601) {
+                            gmtime_threadsafe(&time, &time_info);
+                            length_ = std::strftime(text_, sizeof(text_), "%Y-%m-%dT%H:%M:%S", &time_info);
+                        } else {
+                            localtime_threadsafe(&time, &time_info);
+                            length_ = std::strftime(text_, sizeof(text_), "%Y-%m-%d %H:%M:%S", &time_info);
+                        }
+                    }
+                };
+
+                /**
+                 * @brief Append a timestamp (without brackets) using the per-thread caches
+                 *
+                 * @param out The string to append to
+                 * @param format Which timestamp layout to use
+                 * @param precision How many fractional digits to append
+                 * @param time The time to format
+                 */
+                inline void append_timestamp(std::string& out, TimestampFormat format, TimestampPrecision precision,
+                                             std::chrono::system_clock::time_point time) {
+                    thread_local TimestampCache standard_cache(TimestampFormat::STANDARD);
+                    thread_local TimestampCache iso8601_cache(TimestampFormat::ISO8601);
+                    thread_local TimestampCache unix_cache(TimestampFormat::UNIX);
+
+                    const long long nanoseconds =
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+                    long long seconds = nanoseconds / 1000000000LL;
+                    long long fraction = nanoseconds % 1000000000LL;
+                    if (fraction < 0) {
+                        fraction += 1000000000LL;
+                        --seconds;
+                    }
+
+                    switch (format) {
+                        case TimestampFormat::STANDARD: out += standard_cache.text(seconds); break;
+                        case TimestampFormat::ISO8601:  out += iso8601_cache.text(seconds); break;
+                        case TimestampFormat::UNIX:     out += unix_cache.text(seconds); break;
+                        case TimestampFormat::NONE:     return;
+                    }
+
+                    switch (precision) {
+                        case TimestampPrecision::SECONDS:
+                            break;
+                        case TimestampPrecision::MILLISECONDS:
+                            out += '.';
+                            append_zero_padded(out, static_cast<unsigned long>(fraction / 1000000), 3);
+                            break;
+                        case TimestampPrecision::MICROSECONDS:
+                            out += '.';
+                            append_zero_padded(out, static_cast<unsigned long>(fraction / 1000), 6);
+                            break;
+                        case TimestampPrecision::NANOSECONDS:
+                            out += '.';
+                            append_zero_padded(out, static_cast<unsigned long>(fraction), 9);
+                            break;
+                    }
+
+                    if (format == TimestampFormat::ISO8601) {
+                        out += 'Z';
+                    }
+                }
+
+                /**
+                 * @brief Return the part of a path after the last '/' or '\\'
+                 */
+                inline const char* path_basename(const char* file) {
+                    const char* filename = file;
+                    for (const char* p = file; *p; ++p) {
+                        if (*p == '/' || *p == '\\') {
+                            filename = p + 1;
+                        }
+                    }
+                    return filename;
+                }
+
+                /**
+                 * @brief Offset of the part of a path after the last '/' or '\\', usable in constant expressions
+                 *
+                 * The LOG_* macros apply this to __FILE__ at compile time and pass the
+                 * result as LogRecord::file_name, so formatters need not scan the path.
+                 */
+                constexpr size_t basename_offset(const char* path) {
+                    size_t offset = 0;
+                    for (size_t i = 0; path[i] != '\0'; ++i) {
+                        if (path[i] == '/' || path[i] == '\\') {
+                            offset = i + 1;
+                        }
+                    }
+                    return offset;
+                }
+
+                inline uint64_t& cached_thread_id() {
+                    thread_local uint64_t id = 0;
+                    return id;
+                }
+
+                inline std::atomic<long>& cached_process_id() {
+                    static std::atomic<long> id{0};
+                    return id;
+                }
+
+                /**
+                 * @brief Make a forked child look its IDs up again instead of reporting its parent's
+                 */
+                inline void watch_fork() {
+#ifndef _WIN32
+                    static const int registered = ::pthread_atfork(nullptr, nullptr, [] {
+                        cached_thread_id() = 0;
+                        cached_process_id().store(0, std::memory_order_relaxed);
+                    });
+                    (void)registered;
+#endif
+                }
+
+                /**
+                 * @brief ID of the calling thread, looked up once per thread
+                 *
+                 * The kernel thread ID on Linux (as shown by ps and top), a hash of
+                 * std::thread::id elsewhere.
+                 */
+                inline uint64_t current_thread_id() {
+                    uint64_t& id = cached_thread_id();
+                    if (id == 0) {
+                        watch_fork();
+#ifdef __linux__
+                        id = static_cast<uint64_t>(::syscall(SYS_gettid));
+#else
+                        id = static_cast<uint64_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+#endif
+                    }
+                    return id;
+                }
+
+                /**
+                 * @brief ID of the process, looked up once (and again after fork())
+                 */
+                inline long current_process_id() {
+                    long id = cached_process_id().load(std::memory_order_relaxed);
+                    if (id == 0) {
+                        watch_fork();
+#ifdef _WIN32
+                        id = static_cast<long>(::_getpid());
+#else
+                        id = static_cast<long>(::getpid());
+#endif
+                        cached_process_id().store(id, std::memory_order_relaxed);
+                    }
+                    return id;
+                }
+
+                /**
+                 * @brief Base class of the format string types created by INTERLACED_FORMAT
+                 *
+                 * Derived types convert to std::string_view in constant expressions, which
+                 * lets the Logger parse the format and check its arguments at compile time.
+                 */
+                struct CompileTimeFormat {};
+
+                template<typename T>
+                constexpr bool is_compile_time_format_v = std::is_base_of_v<CompileTimeFormat, std::decay_t<T>>;
+
+                /**
+                 * @brief Whether a format argument is a C string: a char array or a pointer to char
+                 */
+                template<typename T>
+                constexpr bool is_c_string_format_v = std::is_same_v<std::decay_t<T>, const char*> ||
+                                                      std::is_same_v<std::decay_t<T>, char*>;
+
+                /**
+                 * @brief Whether a C string format is a const char array, i.e. a string literal
+                 *
+                 * Its text cannot change at its address, unlike a pointer into a buffer
+                 * (e.g. std::string::c_str()) that may be refilled with another format.
+                 */
+                template<typename T>
+                constexpr bool is_literal_format_v = std::is_array_v<std::remove_reference_t<T>> &&
+                                                     std::is_const_v<std::remove_extent_t<std::remove_reference_t<T>>>;
+
+                /**
+                 * @brief Count "{}" placeholders, scanning the way append_formatted() does
+                 */
+                constexpr size_t count_placeholders(std::string_view format) {
+                    size_t count = 0;
+                    for (size_t i = 0; i + 1 < format.size(); ++i) {
+                        if (format[i] == '{' && format[i + 1] == '}') {
+                            ++count;
+                            ++i;
+                        }
+                    }
+                    return count;
+                }
+
+                /**
+                 * @brief Literal segments of a format string, split around its placeholders
+                 *
+                 * Segment i is the text before placeholder i; the last segment is the
+                 * text after the final placeholder.
+                 */
+                template<size_t Placeholders>
+                struct ParsedFormat {
+                    size_t offsets[Placeholders + 1];
+                    size_t lengths[Placeholders + 1];
+                };
+
+                template<size_t Placeholders>
+                constexpr ParsedFormat<Placeholders> parse_format(std::string_view format) {
+                    ParsedFormat<Placeholders> parsed{};
+                    size_t segment = 0;
+                    size_t start = 0;
+                    for (size_t i = 0; i + 1 < format.size() && segment < Placeholders; ++i) {
+                        if (format[i] == '{' && format[i + 1] == '}') {
+                            parsed.offsets[segment] = start;
+                            parsed.lengths[segment] = i - start;
+                            ++segment;
+                            start = i + 2;
+                            ++i;
+                        }
+                    }
+                    parsed.offsets[Placeholders] = start;
+                    parsed.lengths[Placeholders] = format.size() - start;
+                    return parsed;
+                }
+
+            }
+
+            /**
+             * @brief A typed key/value pair from structured logging
+             *
+             * Booleans and numbers keep their type so formatters can write them
+             * without going through text. Strings, and values of any other type
+             * (rendered through operator<<), are STRING fields.
+             */
+            struct LogField {
+                enum class Type : uint8_t {
+                    BOOL,
+                    INT,
+                    UINT,
+                    DOUBLE,
+                    STRING
+                };
+
+                union Value {
+                    bool boolean;
+                    int64_t integer;
+                    uint64_t unsigned_integer;
+                    double number;
+                };
+
+                std::string_view key;
+                Type type = Type::STRING;
+                Value value{};
+                std::string_view text;                         ///< The value of a STRING field
+            };
+
+            /**
+             * @brief A single log event as seen by formatters
+             *
+             * The message view, file pointer and fields are only valid for the
+             * duration of the formatting call.
+             */
+            struct LogRecord {
+                LogLevel level;                                ///< Severity of the message
+                std::string_view message;                      ///< Message text (already formatted)
+                std::chrono::system_clock::time_point time;    ///< When the message was logged
+                const char* file = nullptr;                    ///< Source file, or null
+                const char* file_name = nullptr;               ///< Basename within file when known in advance, or null
+                int line = 0;                                  ///< Source line, or 0
+                const LogField* fields = nullptr;              ///< Structured fields, in the order they were logged
+                size_t field_count = 0;
+                std::string_view category;                     ///< Named category of the message, empty for Logger itself
+            };
+
+            namespace detail {
+
+                /**
+                 * @brief The record's source file without its directories; file must not be null
+                 */
+                inline const char* record_basename(const LogRecord& record) {
+                    return record.file_name ? record.file_name : path_basename(record.file);
+                }
+
+                /**
+                 * @brief Where a key or value had to be rendered into the field storage string
+                 */
+                struct StoredText {
+                    size_t offset = 0;
+                    size_t length = std::string::npos;         ///< npos: the view borrows the caller's string
+                };
+
+                /**
+                 * @brief Point a field at a key or string value without copying it, or render it into storage
+                 */
+                template<typename T>
+                inline void set_field_text(std::string_view& view, StoredText& stored, std::string& storage, const T& value) {
+                    using Type = std::decay_t<T>;
+                    if constexpr (std::is_same_v<Type, std::string> || std::is_same_v<Type, std::string_view>) {
+                        view = std::string_view(value.data(), value.size());
+                    } else if constexpr (std::is_same_v<Type, const char*> || std::is_same_v<Type, char*>) {
+                        const char* text = value; // Arrays decay here
+                        view = text ? std::string_view(text) : std::string_view();
+                    } else {
+                        stored.offset = storage.size();
+                        append_value(storage, value);
+                        stored.length = storage.size() - stored.offset;
+                    }
+                }
+
+                /**
+                 * @brief Store a value in a field, keeping booleans and numbers typed
+                 */
+                template<typename T>
+                inline void set_field_value(LogField& field, StoredText& stored, std::string& storage, const T& value) {
+                    using Type = std::decay_t<T>;
+                    if constexpr (std::is_same_v<Type, bool>) {
+                        field.type = LogField::Type::BOOL;
+                        field.value.boolean = value;
+                    } else if constexpr (std::is_integral_v<Type> && !std::is_same_v<Type, char> &&
+                                         !std::is_same_v<Type, signed char> && !std::is_same_v<Type, unsigned char>) {
+                        if constexpr (std::is_signed_v<Type>) {
+                            field.type = LogField::Type::INT;
+                            field.value.integer = static_cast<int64_t>(value);
+                        } else {
+                            field.type = LogField::Type::UINT;
+                            field.value.unsigned_integer = static_cast<uint64_t>(value);
+                        }
+                    } else if constexpr (std::is_floating_point_v<Type>) {
+                        field.type = LogField::Type::DOUBLE;
+                        field.value.number = static_cast<double>(value);
+                    } else {
+                        field.type = LogField::Type::STRING;
+                        set_field_text(field.text, stored, storage, value);
+                    }
+                }
+
+                inline void fill_fields(LogField*, StoredText*, std::string&) {
+                    // Base case - no more key-value pairs
+                }
+
+                template<typename Key, typename Value, typename... Args>
+                inline void fill_fields(LogField* field, StoredText* stored, std::string& storage,
+                                        const Key& key, const Value& value, const Args&... args) {
+                    set_field_text(field->key, stored[0], storage, key);
+                    set_field_value(*field, stored[1], storage, value);
+                    fill_fields(field + 1, stored + 2, storage, args...);
+                }
+
+                /**
+                 * @brief Turn key-value arguments into typed fields
+                 *
+                 * Strings are referenced, not copied. Keys and values that need
+                 * rendering go into storage, which must not change while the fields
+                 * are in use.
+                 *
+                 * @param fields Receives sizeof...(Args) / 2 fields
+                 * @param storage Buffer for rendered keys and values
+                 */
+                template<typename... Args>
+                inline void make_fields(LogField* fields, std::string& storage, const Args&... args) {
+                    static_assert(sizeof...(Args) % 2 == 0, "Structured logging needs key-value pairs");
+                    constexpr size_t count = sizeof...(Args) / 2;
+                    StoredText stored[count * 2 + 1];
+                    fill_fields(fields, stored, storage, args...);
+                    for (size_t i = 0; i < count; ++i) {
+                        if (stored[2 * i].length != std::string::npos) {
+                            fields[i].key = std::string_view(storage.data() + stored[2 * i].offset, stored[2 * i].length);
+                        }
+                        if (stored[2 * i + 1].length != std::string::npos) {
+                            fields[i].text = std::string_view(storage.data() + stored[2 * i + 1].offset,
+                                                              stored[2 * i + 1].length);
+                        }
+                    }
+                }
+
+                /**
+                 * @brief Append a field's value the way operator<< prints the original value
+                 */
+                inline void append_field_value(std::string& out, const LogField& field) {
+                    switch (field.type) {
+                        case LogField::Type::BOOL:   append_value(out, field.value.boolean); break;
+                        case LogField::Type::INT:    append_integer(out, field.value.integer); break;
+                        case LogField::Type::UINT:   append_integer(out, field.value.unsigned_integer); break;
+                        case LogField::Type::DOUBLE: append_value(out, field.value.number); break;
+                        case LogField::Type::STRING: out.append(field.text.data(), field.text.size()); break;
+                    }
+                }
+
+                /**
+                 * @brief Append "[category] " for a named category, nothing otherwise
+                 */
+                inline void append_category(std::string& out, std::string_view category) {
+                    if (!category.empty()) {
+                        out += '[';
+                        out.append(category.data(), category.size());
+                        out += "] ";
+                    }
+                }
+
+                /**
+                 * @brief Append fields as " key=value" pairs
+                 */
+                inline void append_fields(std::string& out, const LogField* fields, size_t count) {
+                    for (size_t i = 0; i < count; ++i) {
+                        out += ' ';
+                        out.append(fields[i].key.data(), fields[i].key.size());
+                        out += '=';
+                        append_field_value(out, fields[i]);
+                    }
+                }
+
+                /**
+                 * @brief Append text as a quoted JSON string, escaping as required by RFC 8259
+                 */
+                inline void append_json_string(std::string& out, std::string_view text) {
+                    static constexpr char kHex[] = "0123456789abcdef";
+                    out += '"';
+                    size_t run = 0;
+                    for (size_t i = 0; i < text.size(); ++i) {
+                        const unsigned char c = static_cast<unsigned char>(text[i]);
+                        if (c >= 0x20 && c != '"' && c != '\\') {
+                            continue;
+                        }
+                        out.append(text.data() + run, i - run);
+                        run = i + 1;
+                        switch (c) {
+                            case '"':  out += "\\\""; break;
+                            case '\\': out += "\\\\"; break;
+                            case '\n': out += "\\n"; break;
+                            case '\r': out += "\\r"; break;
+                            case '\t': out += "\\t"; break;
+                            case '\b': out += "\\b"; break;
+                            case '\f': out += "\\f"; break;
+                            default:
+                                out += "\\u00";
+                                out += kHex[c >> 4];
+                                out += kHex[c & 0x0F];
+                                break;
+                        }
+                    }
+                    out.append(text.data() + run, text.size() - run);
+                    out += '"';
+                }
+
+                /**
+                 * @brief Append a field's value as a JSON value
+                 *
+                 * Doubles use the shortest text that reads back to the same value;
+                 * NaN and infinities, which JSON cannot represent, become null.
+                 */
+                inline void append_json_value(std::string& out, const LogField& field) {
+                    switch (field.type) {
+                        case LogField::Type::BOOL:
+                            out += field.value.boolean ? "true" : "false";
+                            break;
+                        case LogField::Type::INT:
+                            append_integer(out, field.value.integer);
+                            break;
+                        case LogField::Type::UINT:
+                            append_integer(out, field.value.unsigned_integer);
+                            break;
+                        case LogField::Type::DOUBLE:
+                            if (std::isfinite(field.value.number)) {
+                                char digits[32];
+                                auto result = std::to_chars(digits, digits + sizeof(digits), field.value.number);
+                                out.append(digits, static_cast<size_t>(result.ptr - digits));
+                            } else {
+                                out += "null";
+                            }
+                            break;
+                        case LogField::Type::STRING:
+                            append_json_string(out, field.text);
+                            break;
+                    }
+                }
+
+            }
+
+            /**
+             * @brief Log formatter interface
+             *
+             * Implementations override format(). Formatters on the hot path should also
+             * override format_to(), which appends into a caller-provided buffer instead of
+             * returning a new string; the default implementation adapts format().
+             * When adapting, the category prefix and structured fields are folded into the
+             * message text ("[category] message key=value") before format() is called.
+             */
+            class LogFormatter {
+            public:
+                virtual ~LogFormatter() = default;
+                virtual std::string format(LogLevel level, const std::string& message,
+                                          const std::tm& time_info, const char* file = nullptr, int line = 0) = 0;
+
+                /**
+                 * @brief Append the formatted record to out
+                 *
+                 * @param out Buffer to append to; existing contents are preserved
+                 * @param record The log event to format
+                 */
+                virtual void format_to(std::string& out, const LogRecord& record) {
+                    const std::time_t time = std::chrono::system_clock::to_time_t(record.time);
+                    std::tm local_tm;
+                    localtime_threadsafe(&time, &local_tm);
+                    std::string message;
+                    detail::append_category(message, record.category);
+                    message.append(record.message.data(), record.message.size());
+                    detail::append_fields(message, record.fields, record.field_count);
+                    out += format(record.level, message, local_tm, record.file, record.line);
+                }
+            };
+
+            /**
+             * @brief Default log formatter implementation
+             *
+             * Produces "[timestamp] [LEVEL] message (file:line)", optionally preceded by
+             * a prefix. Timestamps come from a per-thread cache that is only refreshed
+             * when the second changes.
+             */
+            class DefaultLogFormatter : public LogFormatter {
+            private:
+                TimestampFormat timestamp_format_;
+                std::string prefix_;
+                TimestampPrecision precision_;
+
+            public:
+                DefaultLogFormatter(TimestampFormat format = TimestampFormat::STANDARD,
+                                   const std::string& prefix = "",
+                                   TimestampPrecision precision = TimestampPrecision::SECONDS)
+                    : timestamp_format_(format), prefix_(prefix), precision_(precision) {}
+
+                std::string format(LogLevel level, const std::string& message,
+                                  const std::tm& time_info, const char* file = nullptr, int line = 0) override {
+                    // time_info is local time; recover the instant it describes
+                    std::tm local_tm = time_info;
+                    const auto time = std::chrono::system_clock::from_time_t(std::mktime(&local_tm));
+
+                    LogRecord record;
+                    record.level = level;
+                    record.message = message;
+                    record.time = time;
+                    record.file = file;
+                    record.line = line;
+
+                    std::string out;
+                    append_line(out, record);
+                    return out;
+                }
+
+                void format_to(std::string& out, const LogRecord& record) override {
+                    append_line(out, record);
+                }
+
+            private:
+                void append_line(std::string& out, const LogRecord& record) const {
+                    // Add prefix if specified
+                    if (!prefix_.empty()) {
+                        out += prefix_;
+                        out += ' ';
+                    }
+
+                    // Add timestamp based on format
+                    if (timestamp_format_ != TimestampFormat::NONE) {
+                        out += '[';
+                        detail::append_timestamp(out, timestamp_format_, precision_, record.time);
+                        out += "] ";
+                    }
+
+                    // Add log level and category
+                    out += '[';
+                    out += log_level_to_string(record.level);
+                    out += "] ";
+                    detail::append_category(out, record.category);
+
+                    // Add message and structured fields
+                    out.append(record.message.data(), record.message.size());
+                    detail::append_fields(out, record.fields, record.field_count);
+
+                    // Add file and line information if provided
+                    if (record.file && record.line > 0) {
+                        out += " (";
+                        out += detail::record_basename(record);
+                        out += ':';
+                        detail::append_integer(out, record.line);
+                        out += ')';
+                    }
+                }
+            };
+
+            /**
+             * @brief Formatter that writes every record as one JSON object (JSON lines)
+             *
+             * Produces e.g.
+             * {"time":"2024-03-10T13:27:00.123456Z","level":"INFO","message":"User logged in",
+             *  "file":"main.cpp","line":42,"fields":{"user_id":12345,"admin":false}}
+             * on a single line. Strings are escaped straight into the output buffer and
+             * typed fields keep their JSON type. "file"/"line" are omitted without
+             * source information, "fields" without structured fields and "category"
+             * for messages that do not come from a LogCategory. UNIX timestamps
+             * are written as numbers, TimestampFormat::NONE omits "time".
+             */
+            class JsonLinesFormatter : public LogFormatter {
+            private:
+                TimestampFormat timestamp_format_;
+                TimestampPrecision precision_;
+
+            public:
+                explicit JsonLinesFormatter(TimestampFormat format = TimestampFormat::ISO8601,
+                                            TimestampPrecision precision = TimestampPrecision::MICROSECONDS)
+                    : timestamp_format_(format), precision_(precision) {}
+
+                std::string format(LogLevel level, const std::string& message,
+                                  const std::tm& time_info, const char* file = nullptr, int line = 0) override {
+                    std::tm local_tm = time_info;
+                    LogRecord record;
+                    record.level = level;
+                    record.message = message;
+                    record.time = std::chrono::system_clock::from_time_t(std::mktime(&local_tm));
+                    record.file = file;
+                    record.line = line;
+
+                    std::string out;
+                    append_object(out, record);
+                    return out;
+                }
+
+                void format_to(std::string& out, const LogRecord& record) override {
+                    append_object(out, record);
+                }
+
+            private:
+                void append_object(std::string& out, const LogRecord& record) const {
+                    out += '{';
+                    if (timestamp_format_ != TimestampFormat::NONE) {
+                        out += "\"time\":";
+                        if (timestamp_format_ == TimestampFormat::UNIX) {
+                            detail::append_timestamp(out, timestamp_format_, precision_, record.time);
+                        } else {
+                            out += '"';
+                            detail::append_timestamp(out, timestamp_format_, precision_, record.time);
+                            out += '"';
+                        }
+                        out += ',';
+                    }
+                    out += "\"level\":\"";
+                    out += log_level_to_string(record.level);
+                    out += '"';
+                    if (!record.category.empty()) {
+                        out += ",\"category\":";
+                        detail::append_json_string(out, record.category);
+                    }
+                    out += ",\"message\":";
+                    detail::append_json_string(out, record.message);
+                    if (record.file && record.line > 0) {
+                        out += ",\"file\":";
+                        detail::append_json_string(out, detail::record_basename(record));
+                        out += ",\"line\":";
+                        detail::append_integer(out, record.line);
+                    }
+                    if (record.field_count > 0) {
+                        out += ",\"fields\":{";
+                        for (size_t i = 0; i < record.field_count; ++i) {
+                            if (i > 0) {
+                                out += ',';
+                            }
+                            detail::append_json_string(out, record.fields[i].key);
+                            out += ':';
+                            detail::append_json_value(out, record.fields[i]);
+                        }
+                        out += '}';
+                    }
+                    out += '}';
+                }
+            };
+
+            /**
+             * @brief Formatter driven by a pattern string, compiled once into a list of append operations
+             *
+             * Flags:
+             * - %Y %m %d %H %M %S: local year, month, day, hour, minute, second (zero-padded)
+             * - %e %f %F: milliseconds, microseconds, nanoseconds of the second
+             * - %E: seconds since the epoch
+             * - %l: level name ("INFO"), %L: its first letter ("I")
+             * - %n: category name (empty for Logger itself)
+             * - %v: message followed by structured fields as " key=value"
+             * - %t: thread ID, %P: process ID
+             * - %s: source file basename, %g: source file as given, %#: source line
+             * - %{ ... %}: everything in between is left out when the record has no source location
+             * - %%: a literal '%'
+             *
+             * Unknown flags are copied as they are. The broken-down local time is
+             * cached per thread and only recomputed when the second changes.
+             *
+             * Example:
+             * @code
+             * Logger::set_formatter(std::make_unique<PatternFormatter>(
+             *     "%Y-%m-%dT%H:%M:%S.%f [%l] [%t] %v%{ (%s:%#)%}"));
+             * // 2024-03-10T14:27:00.123456 [INFO] [4711] User logged in (main.cpp:42)
+             * @endcode
+             */
+            class PatternFormatter : public LogFormatter {
+            private:
+                enum class OpKind : uint8_t {
+                    LITERAL, YEAR, MONTH, DAY, HOUR, MINUTE, SECOND, MILLISECONDS, MICROSECONDS, NANOSECONDS,
+                    EPOCH, LEVEL, LEVEL_LETTER, CATEGORY, MESSAGE, THREAD, PROCESS, BASENAME, PATH, LINE,
+                    SOURCE_BEGIN, SOURCE_END
+                };
+
+                struct Op {
+                    OpKind kind;
+                    uint32_t offset = 0;    ///< LITERAL: start in literals_; SOURCE_BEGIN: index of its SOURCE_END
+                    uint32_t length = 0;    ///< LITERAL: number of characters
+                };
+
+                std::string pattern_;
+                std::string literals_;
+                std::vector<Op> ops_;
+                bool uses_local_time_ = false;
+
+            public:
+                explicit PatternFormatter(std::string_view pattern = "[%Y-%m-%d %H:%M:%S] [%l] %v")
+                    : pattern_(pattern) {
+                    compile();
+                }
+
+                /**
+                 * @brief The pattern this formatter was created with
+                 */
+                const std::string& pattern() const {
+                    return pattern_;
+                }
+
+                std::string format(LogLevel level, const std::string& message,
+                                  const std::tm& time_info, const char* file = nullptr, int line = 0) override {
+                    std::tm local_tm = time_info;
+                    LogRecord record;
+                    record.level = level;
+                    record.message = message;
+                    record.time = std::chrono::system_clock::from_time_t(std::mktime(&local_tm));
+                    record.file = file;
+                    record.line = line;
+
+                    std::string out;
+                    format_to(out, record);
+                    return out;
+                }
+
+                void format_to(std::string& out, const LogRecord& record) override {
+                    const long long nanoseconds =
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(record.time.time_since_epoch()).count();
+                    long long seconds = nanoseconds / 1000000000LL;
+                    long long fraction = nanoseconds % 1000000000LL;
+                    if (fraction < 0) {
+                        fraction += 1000000000LL;
+                        --seconds;
+                    }
+                    const std::tm* time_info = uses_local_time_ ? &local_time(seconds) : nullptr;
+                    const bool has_source = record.file && record.line > 0;
+
+                    for (size_t i = 0; i < ops_.size(); ++i) {
+                        const Op& op = ops_[i];
+                        switch (op.kind) {
+                            case OpKind::LITERAL:      out.append(literals_.data() + op.offset, op.length); break;
+                            case OpKind::YEAR:         detail::append_integer(out, time_info->tm_year + 1900); break;
+                            case OpKind::MONTH:        detail::append_zero_padded(out, static_cast<unsigned>(time_info->tm_mon + 1), 2); break;
+                            case OpKind::DAY:          detail::append_zero_padded(out, static_cast<unsigned>(time_info->tm_mday), 2); break;
+                            case OpKind::HOUR:         detail::append_zero_padded(out, static_cast<unsigned>(time_info->tm_hour), 2); break;
+                            case OpKind::MINUTE:       detail::append_zero_padded(out, static_cast<unsigned>(time_info->tm_min), 2); break;
+                            case OpKind::SECOND:       detail::append_zero_padded(out, static_cast<unsigned>(time_info->tm_sec), 2); break;
+                            case OpKind::MILLISECONDS: detail::append_zero_padded(out, static_cast<unsigned long long>(fraction / 1000000), 3); break;
+                            case OpKind::MICROSECONDS: detail::append_zero_padded(out, static_cast<unsigned long long>(fraction / 1000), 6); break;
+                            case OpKind::NANOSECONDS:  detail::append_zero_padded(out, static_cast<unsigned long long>(fraction), 9); break;
+                            case OpKind::EPOCH:        detail::append_integer(out, seconds); break;
+                            case OpKind::LEVEL:        out += log_level_to_string(record.level); break;
+                            case OpKind::LEVEL_LETTER: out += log_level_to_string(record.level)[0]; break;
+                            case OpKind::CATEGORY:     out.append(record.category.data(), record.category.size()); break;
+                            case OpKind::MESSAGE:
+                                out.append(record.message.data(), record.message.size());
+                                detail::append_fields(out, record.fields, record.field_count);
+                                break;
+                            case OpKind::THREAD:       detail::append_integer(out, detail::current_thread_id()); break;
+                            case OpKind::PROCESS:      detail::append_integer(out, detail::current_process_id()); break;
+                            case OpKind::BASENAME:
+                                if (record.file) {
+                                    out += detail::record_basename(record);
+                                }
+                                break;
+                            case OpKind::PATH:
+                                if (record.file) {
+                                    out += record.file;
+                                }
+                                break;
+                            case OpKind::LINE:         detail::append_integer(out, record.line); break;
+                            case OpKind::SOURCE_BEGIN:
+                                if (!has_source) {
+                                    i = op.offset;
+                                }
+                                break;
+                            case OpKind::SOURCE_END:   break;
+                        }
+                    }
+                }
+
+            private:
+                /**
+                 * @brief Broken-down local time of an epoch second, cached per thread
+                 */
+                static const std::tm& local_time(long long epoch_second) {
+                    thread_local long long cached_second = std::numeric_limits<long long>::min();
+                    thread_local std::tm cached{};
+                    if (epoch_second != cached_second) {
+                        const std::time_t time = static_cast<std::time_t>(epoch_second);
+                        localtime_threadsafe(&time, &cached);
+                        cached_second = epoch_second;
+                    }
+                    return cached;
+                }
+
+                void add_literal(char c) {
+                    if (ops_.empty() || ops_.back().kind != OpKind::LITERAL) {
+                        ops_.push_back({OpKind::LITERAL, static_cast<uint32_t>(literals_.size()), 0});
+                    }
+                    literals_ += c;
+                    ++ops_.back().length;
+                }
+
+                void compile() {
+                    size_t open_source = std::string::npos;
+                    for (size_t i = 0; i < pattern_.size(); ++i) {
+                        if (pattern_[i] != '%' || i + 1 == pattern_.size()) {
+                            add_literal(pattern_[i]);
+                            continue;
+                        }
+                        const char flag = pattern_[++i];
+                        OpKind kind;
+                        switch (flag) {
+                            case 'Y': kind = OpKind::YEAR; break;
+                            case 'm': kind = OpKind::MONTH; break;
+                            case 'd': kind = OpKind::DAY; break;
+                            case 'H': kind = OpKind::HOUR; break;
+                            case 'M': kind = OpKind::MINUTE; break;
+                            case 'S': kind = OpKind::SECOND; break;
+                            case 'e': kind = OpKind::MILLISECONDS; break;
+                            case 'f': kind = OpKind::MICROSECONDS; break;
+                            case 'F': kind = OpKind::NANOSECONDS; break;
+                            case 'E': kind = OpKind::EPOCH; break;
+                            case 'l': kind = OpKind::LEVEL; break;
+                            case 'L': kind = OpKind::LEVEL_LETTER; break;
+                            case 'n': kind = OpKind::CATEGORY; break;
+                            case 'v': kind = OpKind::MESSAGE; break;
+                            case 't': kind = OpKind::THREAD; break;
+                            case 'P': kind = OpKind::PROCESS; break;
+                            case 's': kind = OpKind::BASENAME; break;
+                            case 'g': kind = OpKind::PATH; break;
+                            case '#': kind = OpKind::LINE; break;
+                            case '{':
+                                if (open_source != std::string::npos) {
+                                    add_literal('%');
+                                    add_literal(flag);
+                                    continue;
+                                }
+                                open_source = ops_.size();
+                                kind = OpKind::SOURCE_BEGIN;
+                                break;
+                            case '}':
+                                if (open_source == std::string::npos) {
+                                    add_literal('%');
+                                    add_literal(flag);
+                                    continue;
+                                }
+                                ops_[open_source].offset = static_cast<uint32_t>(ops_.size());
+                                open_source = std::string::npos;
+                                kind = OpKind::SOURCE_END;
+                                break;
+                            case '%':
+                                add_literal('%');
+                                continue;
+                            default:
+                                add_literal('%');
+                                add_literal(flag);
+                                continue;
+                        }
+                        if (kind >= OpKind::YEAR && kind <= OpKind::SECOND) {
+                            uses_local_time_ = true;
+                        }
+                        ops_.push_back({kind});
+                    }
+                    if (open_source != std::string::npos) {
+                        // An unterminated section runs to the end of the pattern
+                        ops_[open_source].offset = static_cast<uint32_t>(ops_.size());
+                        ops_.push_back({OpKind::SOURCE_END});
+                    }
+                }
+            };
+
+            /**
+             * @brief Behaviour of an asynchronous log queue when it is full
+             */
+            enum class OverflowPolicy {
+                BLOCK,        ///< Wait until the writer thread frees a slot
+                DROP,         ///< Discard the new message
+                DROP_OLDEST   ///< Discard the oldest queued message to make room
+            };
+
+            /**
+             * @brief Bounded lock-free multi-producer queue drained by a writer thread
+             *
+             * Producers copy pre-formatted messages into a fixed ring of slots
+             * (a sequence-numbered ring in the style of Vyukov's bounded queue) without
+             * taking any lock. A dedicated thread pops the messages in order and hands
+             * them to the consumer callback. Slot strings are reused, so once the ring
+             * has warmed up pushing a message does not allocate.
+             *
+             * An idle writer sleeps for at most kPollInterval; producers only wake it
+             * early once a quarter of the ring is in use, so a steady trickle of
+             * messages costs no syscalls. flush() always wakes it.
+             */
+            class AsyncLogQueue {
+            public:
+                using Consumer = std::function<void(LogLevel, const std::string&)>;
+                using IdleCallback = std::function<void()>;
+
+                static constexpr std::chrono::milliseconds kPollInterval{10}; ///< Longest a queued message waits for an idle writer
+
+            private:
+                struct alignas(64) Slot {
+                    std::atomic<size_t> sequence{0};
+                    LogLevel level = LOG_INFO;
+                    std::string message;
+                };
+
+                std::vector<Slot> slots_;
+                size_t mask_;
+                size_t wake_threshold_;   ///< Queued messages that justify waking a sleeping writer
+                OverflowPolicy policy_;
+                Consumer consumer_;
+                IdleCallback idle_;
+
+                alignas(64) std::atomic<size_t> enqueue_pos_{0};
+                alignas(64) std::atomic<size_t> dequeue_pos_{0};
+                alignas(64) std::atomic<size_t> consumed_pos_{0};  ///< One past the last position the writer wrote
+                std::atomic<bool> writer_active_{false};
+                std::atomic<bool> writer_sleeping_{false};
+                std::atomic<bool> stopping_{false};
+                std::atomic<size_t> dropped_{0};
+                std::atomic<size_t> max_depth_{0};  ///< Deepest the queue was seen by the writer
+
+                std::mutex wake_mutex_;
+                std::condition_variable wake_cv_;
+                std::mutex done_mutex_;
+                std::condition_variable done_cv_;
+                std::thread writer_;
+
+            public:
+                /**
+                 * @brief Constructor for AsyncLogQueue
+                 *
+                 * @param capacity Number of slots (rounded up to a power of two)
+                 * @param policy What to do when a producer finds the queue full
+                 * @param consumer Callback invoked on the writer thread for every message
+                 * @param idle Optional callback invoked on the writer thread whenever the queue runs dry
+                 */
+                AsyncLogQueue(size_t capacity, OverflowPolicy policy, Consumer consumer, IdleCallback idle = nullptr)
+                    : slots_(round_up_pow2(capacity)), mask_(slots_.size() - 1),
+                      wake_threshold_(slots_.size() / 4), policy_(policy), consumer_(std::move(consumer)), idle_(std::move(idle)) {
+                    for (size_t i = 0; i < slots_.size(); ++i) {
+                        slots_[i].sequence.store(i, std::memory_order_relaxed);
+                    }
+                    writer_ = std::thread(&AsyncLogQueue::run, this);
+                }
+
+                /**
+                 * @brief Destructor drains every queued message before joining the writer
+                 */
+                ~AsyncLogQueue() {
+                    stopping_.store(true);
+                    wake_writer(true);
+                    if (writer_.joinable()) {
+                        writer_.join();
+                    }
+                }
+
+                AsyncLogQueue(const AsyncLogQueue&) = delete;
+                AsyncLogQueue& operator=(const AsyncLogQueue&) = delete;
+
+                /**
+                 * @brief Queue a message, applying the overflow policy if the ring is full
+                 *
+                 * @param level The LogLevel of the message
+                 * @param message The formatted message
+                 * @return true if the message was queued, false if it was dropped
+                 */
+                bool push(LogLevel level, const std::string& message) {
+                    int spins = 0;
+                    while (!try_push(level, message)) {
+                        switch (policy_) {
+                            case OverflowPolicy::DROP:
+                                dropped_.fetch_add(1, std::memory_order_relaxed);
+                                detail::count_stat(detail::kStatDropped, level);
+                                return false;
+                            case OverflowPolicy::DROP_OLDEST:
+                                if (try_pop(nullptr)) {
+                                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                                }
+                                break;
+                            case OverflowPolicy::BLOCK:
+                                wake_writer(false);
+                                backoff(spins);
+                                break;
+                        }
+                    }
+                    // Waking the writer is a syscall; a sleeping writer polls anyway, so only
+                    // wake it early once a batch worth writing has built up
+                    if (writer_sleeping_.load() && pending() >= wake_threshold_) {
+                        wake_writer(false);
+                    }
+                    return true;
+                }
+
+                /**
+                 * @brief Block until every message queued before this call has been written
+                 *
+                 * Must not be called from the consumer callback.
+                 */
+                void flush() {
+                    const size_t target = enqueue_pos_.load();
+                    wake_writer(false);
+                    std::unique_lock<std::mutex> lock(done_mutex_);
+                    while (!completed(target)) {
+                        done_cv_.wait_for(lock, std::chrono::milliseconds(1));
+                    }
+                }
+
+                /**
+                 * @brief Number of messages discarded by the DROP and DROP_OLDEST policies
+                 */
+                size_t dropped() const {
+                    return dropped_.load(std::memory_order_relaxed);
+                }
+
+                /**
+                 * @brief Number of messages waiting to be written
+                 */
+                size_t depth() const {
+                    return pending();
+                }
+
+                /**
+                 * @brief Deepest the queue has been when the writer started a batch
+                 */
+                size_t max_depth() const {
+                    return std::max(max_depth_.load(std::memory_order_relaxed), pending());
+                }
+
+            private:
+                static size_t round_up_pow2(size_t value) {
+                    size_t result = 2;
+                    while (result < value) {
+                        result <<= 1;
+                    }
+                    return result;
+                }
+
+                static void backoff(int& spins) {
+                    if (++spins < 64) {
+                        std::this_thread::yield();
+                    } else {
+                        std::this_thread::sleep_for(std::chrono::microseconds(50));
+                    }
+                }
+
+                size_t pending() const {
+                    const size_t dequeued = dequeue_pos_.load(std::memory_order_relaxed);
+                    const size_t enqueued = enqueue_pos_.load(std::memory_order_relaxed);
+                    return enqueued > dequeued ? enqueued - dequeued : 0; // The loads may pass each other
+                }
+
+                bool try_push(LogLevel level, const std::string& message) {
+                    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+                    Slot* slot;
+                    for (;;) {
+                        slot = &slots_[pos & mask_];
+                        const size_t seq = slot->sequence.load(std::memory_order_acquire);
+                        const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+                        if (diff == 0) {
+                            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                                break;
+                            }
+                        } else if (diff < 0) {
+                            return false; // Full
+                        } else {
+                            pos = enqueue_pos_.load(std::memory_order_relaxed);
+                        }
+                    }
+                    slot->level = level;
+                    slot->message.assign(message);
+                    slot->sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+
+                /**
+                 * @brief Pop the oldest message; a null consumer discards it
+                 *
+                 * @return true if a message was removed
+                 */
+                bool try_pop(const Consumer* consumer) {
+                    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+                    Slot* slot;
+                    for (;;) {
+                        slot = &slots_[pos & mask_];
+                        const size_t seq = slot->sequence.load(std::memory_order_acquire);
+                        const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+                        if (diff == 0) {
+                            if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                                break;
+                            }
+                        } else if (diff < 0) {
+                            return false; // Empty, or the producer has not finished writing yet
+                        } else {
+                            pos = dequeue_pos_.load(std::memory_order_relaxed);
+                        }
+                    }
+                    if (consumer) {
+                        try {
+                            (*consumer)(slot->level, slot->message);
+                        } catch (...) {
+                            // The consumer reports its own errors; never let them kill the writer
+                        }
+                    } else {
+                        detail::count_stat(detail::kStatDropped, slot->level);
+                    }
+                    slot->sequence.store(pos + mask_ + 1, std::memory_order_release);
+                    if (consumer) {
+                        consumed_pos_.store(pos + 1, std::memory_order_release);
+                    }
+                    return true;
+                }
+
+                /**
+                 * @brief Check whether every position below target has been written or dropped
+                 */
+                bool completed(size_t target) const {
+                    if (consumed_pos_.load() >= target) {
+                        return true;
+                    }
+                    // Everything was dequeued (some possibly dropped) and the writer is idle
+                    return dequeue_pos_.load() >= target && !writer_active_.load();
+                }
+
+                void wake_writer(bool always) {
+                    if (always || writer_sleeping_.load()) {
+                        std::lock_guard<std::mutex> lock(wake_mutex_);
+                        wake_cv_.notify_one();
+                    }
+                }
+
+                void notify_done() {
+                    std::lock_guard<std::mutex> lock(done_mutex_);
+                    done_cv_.notify_all();
+                }
+
+                void run() {
+                    for (;;) {
+                        writer_active_.store(true);
+                        // Only the writer stores the maximum, so producers pay nothing for it
+                        const size_t depth = pending();
+                        if (depth > max_depth_.load(std::memory_order_relaxed)) {
+                            max_depth_.store(depth, std::memory_order_relaxed);
+                        }
+                        size_t batch = 0;
+                        while (try_pop(&consumer_)) {
+                            if (++batch % 256 == 0) {
+                                notify_done();
+                            }
+                        }
+                        if (idle_) {
+                            try {
+                                idle_();
+                            } catch (...) {
+                                // Idle work is best effort
+                            }
+                        }
+                        writer_active_.store(false);
+                        notify_done();
+
+                        if (stopping_.load()) {
+                            // Drain anything that raced with the stop request
+                            writer_active_.store(true);
+                            while (try_pop(&consumer_)) {
+                            }
+                            if (dequeue_pos_.load() == enqueue_pos_.load()) {
+                                writer_active_.store(false);
+                                notify_done();
+                                return;
+                            }
+                            writer_active_.store(false);
+                            std::this_thread::yield();
+                            continue;
+                        }
+
+                        std::unique_lock<std::mutex> lock(wake_mutex_);
+                        writer_sleeping_.store(true);
+                        if (dequeue_pos_.load() == enqueue_pos_.load() && !stopping_.load()) {
+                            wake_cv_.wait_for(lock, kPollInterval);
+                        }
+                        writer_sleeping_.store(false);
+                    }
+                }
+            };
+
+            /**
+             * @brief How a single argument is stored in a binary log record
+             *
+             * Values are written in the byte order of the machine that produced the
+             * file; the file header records it so a reader can reject foreign files.
+             */
+            enum class BinaryArgType : uint8_t {
+                BOOL = 1,    ///< One byte, 0 or 1
+                CHAR = 2,    ///< One byte
+                INT64 = 3,   ///< Signed integers, widened to 8 bytes
+                UINT64 = 4,  ///< Unsigned integers, widened to 8 bytes
+                DOUBLE = 5,  ///< float and double, as an 8-byte double
+                STRING = 6   ///< 4-byte length followed by the bytes
+            };
+
+            namespace detail {
+                constexpr char kBinaryLogMagic[8] = {'I', 'C', 'L', 'O', 'G', 'B', 'I', 'N'};
+                constexpr uint32_t kBinaryLogVersion = 1;
+                constexpr uint32_t kBinaryLogByteOrder = 0x01020304;
+                constexpr char kBinaryDictionaryRecord = 'D';
+                constexpr char kBinaryLogRecord = 'R';
+                constexpr size_t kBinaryRecordHeaderSize = 1 + 1 + 4 + 8 + 4; ///< kind, level, id, time, payload size
+
+                /**
+                 * @brief Encoding used for an argument type
+                 *
+                 * Mirrors append_value(): anything that is not a string, character,
+                 * boolean, integer, float or double is formatted to text by the caller
+                 * and stored as STRING, so decoding always reproduces the same text.
+                 */
+                template<typename T>
+                constexpr BinaryArgType binary_arg_type() {
+                    using Type = std::decay_t<T>;
+                    if constexpr (std::is_same_v<Type, bool>) {
+                        return BinaryArgType::BOOL;
+                    } else if constexpr (std::is_same_v<Type, char> || std::is_same_v<Type, signed char> ||
+                                         std::is_same_v<Type, unsigned char>) {
+                        return BinaryArgType::CHAR;
+                    } else if constexpr (std::is_integral_v<Type> && std::is_signed_v<Type>) {
+                        return BinaryArgType::INT64;
+                    } else if constexpr (std::is_integral_v<Type>) {
+                        return BinaryArgType::UINT64;
+                    } else if constexpr (std::is_same_v<Type, float> || std::is_same_v<Type, double>) {
+                        return BinaryArgType::DOUBLE;
+                    } else {
+                        return BinaryArgType::STRING;
+                    }
+                }
+
+                /**
+                 * @brief One static array of argument types per argument pack
+                 *
+                 * The array's address identifies the pack, which lets the per-thread
+                 * call-site cache compare signatures with a single pointer comparison.
+                 */
+                template<typename... Args>
+                struct BinarySignature {
+                    static constexpr uint8_t types[sizeof...(Args) + 1] = {
+                        static_cast<uint8_t>(binary_arg_type<Args>())..., 0};
+                };
+
+                template<typename T>
+                inline void append_raw(std::string& out, T value) {
+                    char bytes[sizeof(T)];
+                    std::memcpy(bytes, &value, sizeof(T));
+                    out.append(bytes, sizeof(T));
+                }
+
+                template<typename T>
+                inline T read_raw(const char* data) {
+                    T value;
+                    std::memcpy(&value, data, sizeof(T));
+                    return value;
+                }
+
+                inline void append_binary_string(std::string& out, const char* data, size_t size) {
+                    append_raw(out, static_cast<uint32_t>(size));
+                    out.append(data, size);
+                }
+
+                /**
+                 * @brief Append one argument in its binary encoding
+                 */
+                template<typename T>
+                inline void append_binary_arg(std::string& out, const T& value) {
+                    using Type = std::decay_t<T>;
+                    constexpr BinaryArgType type = binary_arg_type<T>();
+                    if constexpr (type == BinaryArgType::BOOL) {
+                        out.push_back(value ? 1 : 0);
+                    } else if constexpr (type == BinaryArgType::CHAR) {
+                        out.push_back(static_cast<char>(value));
+                    } else if constexpr (type == BinaryArgType::INT64) {
+                        append_raw(out, static_cast<int64_t>(value));
+                    } else if constexpr (type == BinaryArgType::UINT64) {
+                        append_raw(out, static_cast<uint64_t>(value));
+                    } else if constexpr (type == BinaryArgType::DOUBLE) {
+                        append_raw(out, static_cast<double>(value));
+                    } else if constexpr (std::is_same_v<Type, std::string> || std::is_same_v<Type, std::string_view>) {
+                        append_binary_string(out, value.data(), value.size());
+                    } else if constexpr (std::is_same_v<Type, const char*> || std::is_same_v<Type, char*>) {
+                        const char* text = value; // Arrays decay here
+                        append_binary_string(out, text ? text : "", text ? std::strlen(text) : 0);
+                    } else {
+                        // Formatted now so the decoder does not need to know the type
+                        ScratchBuffer text;
+                        append_value(text.str(), value);
+                        append_binary_string(out, text.str().data(), text.str().size());
+                    }
+                }
+
+                /**
+                 * @brief Substitute decoded arguments for "{}" placeholders
+                 *
+                 * Follows the same rules as Logger::format_message_to(): extra arguments
+                 * are ignored and placeholders without an argument are kept as written.
+                 *
+                 * @param out The string to append to
+                 * @param format The format string from the dictionary
+                 * @param types Argument types from the dictionary
+                 * @param type_count Number of argument types
+                 * @param payload Encoded arguments
+                 * @return false if the payload is shorter than the types require
+                 */
+                inline bool append_decoded(std::string& out, std::string_view format, const uint8_t* types,
+                                           size_t type_count, std::string_view payload) {
+                    size_t literal = 0;
+                    size_t offset = 0;
+                    for (size_t index = 0; index < type_count; ++index) {
+                        const uint8_t type = types[index];
+                        const size_t placeholder = format.find("{}", literal);
+                        if (placeholder == std::string_view::npos) {
+                            break;
+                        }
+                        out.append(format.data() + literal, placeholder - literal);
+                        literal = placeholder + 2;
+
+                        const size_t remaining = payload.size() - offset;
+                        const char* data = payload.data() + offset;
+                        switch (static_cast<BinaryArgType>(type)) {
+                            case BinaryArgType::BOOL:
+                            case BinaryArgType::CHAR:
+                                if (remaining < 1) {
+                                    return false;
+                                }
+                                if (static_cast<BinaryArgType>(type) == BinaryArgType::BOOL) {
+                                    append_value(out, *data != 0);
+                                } else {
+                                    append_value(out, *data);
+                                }
+                                offset += 1;
+                                break;
+                            case BinaryArgType::INT64:
+                                if (remaining < 8) {
+                                    return false;
+                                }
+                                append_value(out, read_raw<int64_t>(data));
+                                offset += 8;
+                                break;
+                            case BinaryArgType::UINT64:
+                                if (remaining < 8) {
+                                    return false;
+                                }
+                                append_value(out, read_raw<uint64_t>(data));
+                                offset += 8;
+                                break;
+                            case BinaryArgType::DOUBLE:
+                                if (remaining < 8) {
+                                    return false;
+                                }
+                                append_value(out, read_raw<double>(data));
+                                offset += 8;
+                                break;
+                            case BinaryArgType::STRING: {
+                                if (remaining < 4) {
+                                    return false;
+                                }
+                                const uint32_t size = read_raw<uint32_t>(data);
+                                if (remaining - 4 < size) {
+                                    return false;
+                                }
+                                out.append(data + 4, size);
+                                offset += 4 + size;
+                                break;
+                            }
+                            default:
+                                return false;
+                        }
+                    }
+                    out.append(format.data() + literal, format.size() - literal);
+                    return true;
+                }
+
+                inline bool append_decoded(std::string& out, std::string_view format, const std::vector<uint8_t>& types,
+                                           std::string_view payload) {
+                    return append_decoded(out, format, types.data(), types.size(), payload);
+                }
+            }
+
+            /**
+             * @brief Binary log sink that defers all text formatting to an offline decoder
+             *
+             * A log call records only a call-site ID, a timestamp and the raw argument
+             * bytes, then pushes the record into an AsyncLogQueue. The writer thread
+             * emits each call site's format string, source location and argument
+             * types once, as a dictionary record ahead of its first use, and batches
+             * records into large writes. BinaryLogReader (and the interlaced_log_decode
+             * tool) turn the file back into the text DefaultLogFormatter produces.
+             *
+             * Call-site IDs are cached per thread keyed by the format pointer, source
+             * location and argument types. log() identifies a call site by address
+             * alone, so its format and file must be string literals (INTERLACED_FORMAT,
+             * __FILE__); log_runtime() also compares the format text on every hit, for
+             * format strings built at runtime.
+             *
+             * File layout (native byte order):
+             *  - header: "ICLOGBIN", u32 version, u32 byte order mark 0x01020304
+             *  - dictionary: 'D', u32 id, u32 line, u8 arg count, u8 types[count],
+             *    u32 format size, format, u32 file size, file
+             *  - record: 'R', u8 level, u32 id, i64 nanoseconds since the epoch,
+             *    u32 payload size, payload
+             * Opening an existing file appends a new header, which starts a new dictionary.
+             */
+            class BinaryLogWriter {
+            private:
+                struct CallSite {
+                    std::string format;
+                    std::string file;
+                    int line;
+                    std::vector<uint8_t> types;
+                };
+
+                struct CachedSite {
+                    const char* format = nullptr;
+                    const char* file = nullptr;
+                    int line = 0;
+                    const uint8_t* types = nullptr;
+                    const CallSite* site = nullptr;
+                    uint32_t id = 0;
+                };
+
+                struct SiteCache {
+                    static constexpr size_t kEntries = 256;
+                    uint64_t generation = 0;
+                    CachedSite entries[kEntries];
+                };
+
+                static constexpr size_t kWriteBufferSize = 64 * 1024;
+
+                const uint64_t generation_;
+                detail::LogFile file_;
+
+                std::mutex sites_mutex_;
+                std::vector<std::unique_ptr<CallSite>> sites_;
+                std::unordered_map<std::string, uint32_t> site_ids_;
+
+                std::mutex write_mutex_;              ///< Guards the members below (writer thread and flush())
+                std::string write_buffer_;
+                std::vector<bool> emitted_;           ///< Call sites already described in this file
+                std::unique_ptr<AsyncLogQueue> queue_;
+
+            public:
+                /**
+                 * @brief Open (or append to) a binary log file and start its writer thread
+                 *
+                 * @param filename Path of the binary log file
+                 * @param queue_capacity Maximum number of queued records (rounded up to a power of two)
+                 * @param policy What to do when the queue is full
+                 */
+                explicit BinaryLogWriter(const std::string& filename, size_t queue_capacity = 65536,
+                                         OverflowPolicy policy = OverflowPolicy::BLOCK)
+                    : generation_(next_generation()) {
+                    if (!file_.open(filename)) {
+                        std::cerr << "Error opening binary log file: " << filename << std::endl;
+                        return;
+                    }
+                    write_buffer_.reserve(kWriteBufferSize);
+                    write_buffer_.append(detail::kBinaryLogMagic, sizeof(detail::kBinaryLogMagic));
+                    detail::append_raw(write_buffer_, detail::kBinaryLogVersion);
+                    detail::append_raw(write_buffer_, detail::kBinaryLogByteOrder);
+                    queue_ = std::make_unique<AsyncLogQueue>(queue_capacity, policy,
+                                                             [this](LogLevel, const std::string& record) {
+                                                                 consume(record);
+                                                             },
+                                                             [this]() {
+                                                                 std::lock_guard<std::mutex> lock(write_mutex_);
+                                                                 write_pending();
+                                                             });
+                }
+
+                /**
+                 * @brief Destructor drains the queue and writes every pending record
+                 */
+                ~BinaryLogWriter() {
+                    queue_.reset();
+                    std::lock_guard<std::mutex> lock(write_mutex_);
+                    write_pending();
+                }
+
+                BinaryLogWriter(const BinaryLogWriter&) = delete;
+                BinaryLogWriter& operator=(const BinaryLogWriter&) = delete;
+
+                /**
+                 * @brief Check whether the file was opened successfully
+                 */
+                bool is_open() const {
+                    return queue_ != nullptr;
+                }
+
+                /**
+                 * @brief Record a "{}" format call without formatting it
+                 *
+                 * @param level The LogLevel of the message
+                 * @param format The format string
+                 * @param file The source file name, or null
+                 * @param line The source line number, or 0
+                 * @param args Arguments to substitute when the file is decoded
+                 */
+                template<typename... Args>
+                void log(LogLevel level, const char* format, const char* file, int line, const Args&... args) {
+                    const uint32_t id = site_id(format, file, line, detail::BinarySignature<Args...>::types,
+                                                sizeof...(Args), false);
+                    write_record(level, id, args...);
+                }
+
+                /**
+                 * @brief Record a "{}" format call whose format string was built at runtime
+                 *
+                 * Like log(), but a cached call site only matches when its format text
+                 * is unchanged, so a buffer reused for another format is not misattributed.
+                 */
+                template<typename... Args>
+                void log_runtime(LogLevel level, const char* format, const char* file, int line, const Args&... args) {
+                    const uint32_t id = site_id(format, file, line, detail::BinarySignature<Args...>::types,
+                                                sizeof...(Args), true);
+                    write_record(level, id, args...);
+                }
+
+                /**
+                 * @brief Record an already formatted message
+                 *
+                 * @param level The LogLevel of the message
+                 * @param message The message text
+                 * @param file The source file name, or null
+                 * @param line The source line number, or 0
+                 */
+                void log_text(LogLevel level, std::string_view message, const char* file, int line) {
+                    log(level, nullptr, file, line, message);
+                }
+
+                /**
+                 * @brief Block until every record logged before this call is in the file
+                 */
+                void flush() {
+                    if (!queue_) {
+                        return;
+                    }
+                    queue_->flush();
+                    std::lock_guard<std::mutex> lock(write_mutex_);
+                    write_pending();
+                }
+
+                /**
+                 * @brief Number of records discarded by the queue's overflow policy
+                 */
+                size_t dropped() const {
+                    return queue_ ? queue_->dropped() : 0;
+                }
+
+            private:
+                static uint64_t next_generation() {
+                    static std::atomic<uint64_t> generation{0};
+                    return ++generation;
+                }
+
+                static SiteCache& site_cache() {
+                    thread_local SiteCache cache;
+                    return cache;
+                }
+
+                template<typename... Args>
+                void write_record(LogLevel level, uint32_t id, const Args&... args) {
+                    detail::ScratchBuffer record;
+                    std::string& out = record.str();
+                    append_record_header(out, level, id);
+                    (detail::append_binary_arg(out, args), ...);
+                    finish_record(out);
+                    queue_->push(level, out);
+                }
+
+                /**
+                 * @brief Find the ID of a call site, registering it on first use
+                 *
+                 * A null format denotes a pre-formatted message, stored as "{}".
+                 *
+                 * @param compare_text Check the cached format text too, for runtime-built formats
+                 */
+                uint32_t site_id(const char* format, const char* file, int line, const uint8_t* types, size_t arg_count,
+                                 bool compare_text) {
+                    SiteCache& cache = site_cache();
+                    if (cache.generation != generation_) {
+                        cache = SiteCache();
+                        cache.generation = generation_;
+                    }
+
+                    const size_t hash = (reinterpret_cast<uintptr_t>(format) >> 3) ^ (reinterpret_cast<uintptr_t>(file) >> 3) ^
+                                        static_cast<size_t>(line) * 31 ^ (reinterpret_cast<uintptr_t>(types) >> 4);
+                    CachedSite& entry = cache.entries[hash % SiteCache::kEntries];
+                    if (entry.site && entry.format == format && entry.file == file && entry.line == line &&
+                        entry.types == types && (!compare_text || matches(entry.site->format, format))) {
+                        return entry.id;
+                    }
+
+                    const char* format_text = format ? format : "{}";
+                    const char* file_text = file ? file : "";
+                    std::string key;
+                    key.reserve(std::strlen(format_text) + std::strlen(file_text) + arg_count + 16);
+                    key.append(format_text).push_back('\0');
+                    key.append(file_text).push_back('\0');
+                    detail::append_integer(key, line);
+                    key.push_back('\0');
+                    key.append(reinterpret_cast<const char*>(types), arg_count);
+
+                    std::lock_guard<std::mutex> lock(sites_mutex_);
+                    auto found = site_ids_.find(key);
+                    uint32_t id;
+                    if (found != site_ids_.end()) {
+                        id = found->second;
+                    } else {
+                        id = static_cast<uint32_t>(sites_.size());
+                        sites_.push_back(std::make_unique<CallSite>(
+                            CallSite{format_text, file_text, line, std::vector<uint8_t>(types, types + arg_count)}));
+                        site_ids_.emplace(std::move(key), id);
+                    }
+
+                    entry.format = format;
+                    entry.file = file;
+                    entry.line = line;
+                    entry.types = types;
+                    entry.site = sites_[id].get();
+                    entry.id = id;
+                    return id;
+                }
+
+                /**
+                 * @brief Guard against a cached pointer whose contents changed (runtime-built strings)
+                 */
+                static bool matches(const std::string& stored, const char* text) {
+                    return !text || stored == text;
+                }
+
+                static void append_record_header(std::string& out, LogLevel level, uint32_t id) {
+                    const int64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::system_clock::now().time_since_epoch()).count();
+                    out.push_back(detail::kBinaryLogRecord);
+                    out.push_back(static_cast<char>(level));
+                    detail::append_raw(out, id);
+                    detail::append_raw(out, nanoseconds);
+                    detail::append_raw(out, uint32_t(0)); // Payload size, patched by finish_record()
+                }
+
+                static void finish_record(std::string& out) {
+                    const uint32_t payload = static_cast<uint32_t>(out.size() - detail::kBinaryRecordHeaderSize);
+                    std::memcpy(&out[detail::kBinaryRecordHeaderSize - 4], &payload, sizeof(payload));
+                }
+
+                /**
+                 * @brief Writer thread: emit the call site's dictionary record if needed, then the record
+                 */
+                void consume(const std::string& record) {
+                    const uint32_t id = detail::read_raw<uint32_t>(record.data() + 2);
+                    std::lock_guard<std::mutex> lock(write_mutex_);
+                    if (id >= emitted_.size() || !emitted_[id]) {
+                        append_dictionary(id);
+                    }
+                    write_buffer_ += record;
+                    if (write_buffer_.size() >= kWriteBufferSize) {
+                        write_pending();
+                    }
+                }
+
+                void append_dictionary(uint32_t id) {
+                    const CallSite* site;
+                    {
+                        std::lock_guard<std::mutex> lock(sites_mutex_);
+                        site = sites_[id].get();
+                    }
+                    write_buffer_.push_back(detail::kBinaryDictionaryRecord);
+                    detail::append_raw(write_buffer_, id);
+                    detail::append_raw(write_buffer_, static_cast<uint32_t>(site->line));
+                    write_buffer_.push_back(static_cast<char>(site->types.size()));
+                    write_buffer_.append(reinterpret_cast<const char*>(site->types.data()), site->types.size());
+                    detail::append_binary_string(write_buffer_, site->format.data(), site->format.size());
+                    detail::append_binary_string(write_buffer_, site->file.data(), site->file.size());
+
+                    if (id >= emitted_.size()) {
+                        emitted_.resize(id + 1, false);
+                    }
+                    emitted_[id] = true;
+                }
+
+                /**
+                 * @brief Write the pending buffer to the file; write_mutex_ must be held
+                 */
+                void write_pending() {
+                    if (write_buffer_.empty()) {
+                        return;
+                    }
+                    detail::ConstBuffer buffer{write_buffer_.data(), write_buffer_.size()};
+                    if (!file_.write(&buffer, 1)) {
+                        std::cerr << "Error writing binary log file" << std::endl;
+                    }
+                    write_buffer_.clear();
+                }
+            };
+
+            /**
+             * @brief A decoded binary log record
+             */
+            struct BinaryLogEntry {
+                LogLevel level = LOG_INFO;                     ///< Severity of the message
+                std::chrono::system_clock::time_point time;    ///< When the message was logged
+                std::string message;                           ///< Message with arguments substituted
+                std::string file;                              ///< Source file, empty if none was recorded
+                int line = 0;                                  ///< Source line, or 0
+
+                /**
+                 * @brief View this entry as a LogRecord for a LogFormatter
+                 */
+                LogRecord record() const {
+                    LogRecord result;
+                    result.level = level;
+                    result.message = message;
+                    result.time = time;
+                    result.file = file.empty() ? nullptr : file.c_str();
+                    result.line = line;
+                    return result;
+                }
+            };
+
+            /**
+             * @brief Sequential reader for files written by BinaryLogWriter
+             *
+             * Example usage:
+             * @code
+             * BinaryLogReader reader("app.binlog");
+             * DefaultLogFormatter formatter;
+             * BinaryLogEntry entry;
+             * while (reader.next(entry)) {
+             *     std::string line;
+             *     formatter.format_to(line, entry.record());
+             *     std::cout << line << '\n';
+             * }
+             * @endcode
+             */
+            class BinaryLogReader {
+            private:
+                struct CallSite {
+                    std::string format;
+                    std::string file;
+                    int line = 0;
+                    std::vector<uint8_t> types;
+                };
+
+                std::ifstream input_;
+                std::vector<CallSite> sites_;
+                std::string payload_;
+                std::string error_;
+
+            public:
+                /**
+                 * @brief Open a binary log file and validate its header
+                 *
+                 * @param filename Path of the binary log file
+                 */
+                explicit BinaryLogReader(const std::string& filename)
+                    : input_(filename, std::ios::binary) {
+                    if (!input_) {
+                        error_ = "cannot open " + filename;
+                        return;
+                    }
+                    char kind;
+                    if (!input_.get(kind) || !read_header(kind)) {
+                        if (error_.empty()) {
+                            error_ = "not a binary log file: " + filename;
+                        }
+                    }
+                }
+
+                /**
+                 * @brief Check whether the file was opened and its header is valid
+                 */
+                bool is_open() const {
+                    return error_.empty();
+                }
+
+                /**
+                 * @brief Description of the last error, empty if none occurred
+                 */
+                const std::string& error() const {
+                    return error_;
+                }
+
+                /**
+                 * @brief Decode the next log record
+                 *
+                 * @param entry Receives the decoded record
+                 * @return false at the end of the file or when the file is malformed (see error())
+                 */
+                bool next(BinaryLogEntry& entry) {
+                    if (!error_.empty()) {
+                        return false;
+                    }
+                    char kind;
+                    while (input_.get(kind)) {
+                        if (kind == detail::kBinaryLogRecord) {
+                            return read_record(entry);
+                        }
+                        const bool ok = kind == detail::kBinaryDictionaryRecord ? read_dictionary()
+                                      : kind == detail::kBinaryLogMagic[0] ? read_header(kind)
+                                      : fail("unknown record type");
+                        if (!ok) {
+                            return false;
+                        }
+                    }
+                    return false;
+                }
+
+            private:
+                bool fail(const char* message) {
+                    if (error_.empty()) {
+                        error_ = message;
+                    }
+                    return false;
+                }
+
+                bool read_bytes(void* data, size_t size) {
+                    return static_cast<bool>(input_.read(static_cast<char*>(data), static_cast<std::streamsize>(size))) ||
+                           fail("truncated file");
+                }
+
+                template<typename T>
+                bool read_value(T& value) {
+                    return read_bytes(&value, sizeof(T));
+                }
+
+                bool read_string(std::string& value) {
+                    uint32_t size;
+                    if (!read_value(size)) {
+                        return false;
+                    }
+                    value.resize(size);
+                    return size == 0 || read_bytes(&value[0], size);
+                }
+
+                /**
+                 * @brief Read the rest of a header whose first byte was already consumed; resets the dictionary
+                 */
+                bool read_header(char first) {
+                    char magic[sizeof(detail::kBinaryLogMagic)];
+                    magic[0] = first;
+                    uint32_t version;
+                    uint32_t byte_order;
+                    if (!read_bytes(magic + 1, sizeof(magic) - 1) || !read_value(version) || !read_value(byte_order)) {
+                        return false;
+                    }
+                    if (std::memcmp(magic, detail::kBinaryLogMagic, sizeof(magic)) != 0) {
+                        return fail("bad header");
+                    }
+                    if (version != detail::kBinaryLogVersion) {
+                        return fail("unsupported binary log version");
+                    }
+                    if (byte_order != detail::kBinaryLogByteOrder) {
+                        return fail("binary log was written with a different byte order");
+                    }
+                    sites_.clear();
+                    return true;
+                }
+
+                bool read_dictionary() {
+                    uint32_t id;
+                    uint32_t line;
+                    uint8_t count;
+                    if (!read_value(id) || !read_value(line) || !read_value(count)) {
+                        return false;
+                    }
+                    CallSite site;
+                    site.line = static_cast<int>(line);
+                    site.types.resize(count);
+                    if ((count > 0 && !read_bytes(site.types.data(), count)) ||
+                        !read_string(site.format) || !read_string(site.file)) {
+                        return false;
+                    }
+                    if (id >= sites_.size()) {
+                        sites_.resize(id + 1);
+                    }
+                    sites_[id] = std::move(site);
+                    return true;
+                }
+
+                bool read_record(BinaryLogEntry& entry) {
+                    uint8_t level;
+                    uint32_t id;
+                    int64_t nanoseconds;
+                    if (!read_value(level) || !read_value(id) || !read_value(nanoseconds) || !read_string(payload_)) {
+                        return false;
+                    }
+                    if (id >= sites_.size() || level > LOG_ERROR) {
+                        return fail("record refers to an unknown call site");
+                    }
+                    const CallSite& site = sites_[id];
+                    entry.level = static_cast<LogLevel>(level);
+                    entry.time = std::chrono::system_clock::time_point(
+                        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(nanoseconds)));
+                    entry.message.clear();
+                    entry.file = site.file;
+                    entry.line = site.line;
+                    if (!detail::append_decoded(entry.message, site.format, site.types, payload_)) {
+                        return fail("malformed record payload");
+                    }
+                    return true;
+                }
+            };
+
+            /**
+             * @brief Destination for formatted log messages
+             *
+             * Sinks registered with Logger::add_sink() receive every message that
+             * passes their level, formatted by their formatter. write() may be called
+             * from several threads at once (or only from a writer thread when the sink
+             * is asynchronous), so implementations must be thread-safe.
+             */
+            class LogSink {
+            public:
+                virtual ~LogSink() = default;
+
+                /**
+                 * @brief Write one formatted message (without a trailing newline)
+                 *
+                 * @param level The LogLevel of the message
+                 * @param formatted The formatted message
+                 */
+                virtual void write(LogLevel level, std::string_view formatted) = 0;
+
+                /**
+                 * @brief Push any buffered output to its destination
+                 */
+                virtual void flush() {}
+
+                /**
+                 * @brief Periodic housekeeping, called by an asynchronous sink's writer thread when idle
+                 */
+                virtual void poll() {}
+            };
+
+            /**
+             * @brief Writes to a pair of streams, LOG_ERROR to the second one
+             */
+            class ConsoleSink : public LogSink {
+            private:
+                std::mutex mutex_;
+                std::ostream& output_;
+                std::ostream& error_;
+
+            public:
+                /**
+                 * @brief Constructor for ConsoleSink
+                 *
+                 * @param output The stream for LOG_DEBUG, LOG_INFO and LOG_WARNING messages
+                 * @param error The stream for LOG_ERROR messages
+                 */
+                explicit ConsoleSink(std::ostream& output = std::cout, std::ostream& error = std::cerr)
+                    : output_(output), error_(error) {}
+
+                void write(LogLevel level, std::string_view formatted) override {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    std::ostream& out_stream = (level == LOG_ERROR) ? error_ : output_;
+                    out_stream.write(formatted.data(), static_cast<std::streamsize>(formatted.size()));
+                    out_stream << std::endl;
+                    if (!out_stream.good()) {
+                        out_stream.clear();
+                    }
+                }
+
+                void flush() override {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    output_.flush();
+                    error_.flush();
+                }
+            };
+
+            /**
+             * @brief Writes to a RotatingFileLogger
+             */
+            class RotatingFileSink : public LogSink {
+            private:
+                std::mutex mutex_;
+                RotatingFileLogger file_;
+
+            public:
+                /**
+                 * @brief Constructor for a size-rotated file sink
+                 *
+                 * @param filename The base filename for log files
+                 * @param max_file_size Maximum size of each log file (in bytes)
+                 * @param max_files Maximum number of log files to keep
+                 * @param flush_policy When buffered messages are written to the file
+                 */
+                explicit RotatingFileSink(const std::string& filename, size_t max_file_size = 10485760, int max_files = 5,
+                                          const FlushPolicy& flush_policy = FlushPolicy())
+                    : file_(filename, max_file_size, max_files, flush_policy) {}
+
+                /**
+                 * @brief Constructor for a time-rotated file sink
+                 *
+                 * @param filename The base filename for log files
+                 * @param rotation_hours Hours between log rotations
+                 * @param max_files Maximum number of log files to keep
+                 * @param flush_policy When buffered messages are written to the file
+                 */
+                RotatingFileSink(const std::string& filename, std::chrono::hours rotation_hours, int max_files = 5,
+                                 const FlushPolicy& flush_policy = FlushPolicy())
+                    : file_(filename, rotation_hours, max_files, flush_policy) {}
+
+                void write(LogLevel level, std::string_view formatted) override {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    file_.write(formatted, level);
+                }
+
+                /**
+                 * @brief Write buffered messages and wait until rotated files have their final names
+                 */
+                void flush() override {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    file_.flush();
+                    file_.wait_for_writes();
+                    file_.wait_for_rotation();
+                }
+
+                void poll() override {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    file_.flush_if_due();
+                }
+
+                /**
+                 * @brief Change the flush policy of the underlying file
+                 */
+                void set_flush_policy(const FlushPolicy& flush_policy) {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    file_.set_flush_policy(flush_policy);
+                }
+
+                /**
+                 * @brief Choose how rotated files are compressed
+                 */
+                void set_compression(LogCompression compression) {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    file_.set_compression(compression);
+                }
+
+                /**
+                 * @brief Write the file through io_uring or a writer thread
+                 *
+                 * @see RotatingFileLogger::enable_async_writes()
+                 */
+                void enable_async_writes(const AsyncWriteOptions& options = AsyncWriteOptions()) {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    file_.enable_async_writes(options);
+                }
+
+                /**
+                 * @brief Write a sidecar index of the file for LogSearcher
+                 *
+                 * @see RotatingFileLogger::enable_index()
+                 */
+                void enable_index(size_t block_size = 64 * 1024) {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    file_.enable_index(block_size);
+                }
+
+                /**
+                 * @brief Counters of the asynchronous writes
+                 */
+                AsyncWriteStats async_write_stats() {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    return file_.async_write_stats();
+                }
+            };
+
+            /**
+             * @brief File sink where every thread appends to its own shard file
+             *
+             * Each thread that logs gets its own RotatingFileLogger, named
+             * "<filename>.shard<N>", so threads never wait on each other for file I/O
+             * (shards have a mutex, but only their own thread takes it outside of
+             * flush()). Every line starts with a fixed-width timestamp in nanoseconds
+             * since the epoch, which ShardedLogReader and the interlaced_log_merge tool
+             * use to merge the shards back into one time-ordered stream.
+             *
+             * With max_shards set, threads beyond that number share shards round-robin
+             * (e.g. one shard per core instead of one per thread).
+             */
+            class ShardedFileSink : public LogSink {
+            public:
+                static constexpr int kTimestampDigits = 19; ///< Width of the nanosecond prefix on every line
+
+            private:
+                struct Shard {
+                    std::mutex mutex;
+                    RotatingFileLogger file;
+
+                    Shard(const std::string& filename, size_t max_file_size, int max_files, const FlushPolicy& flush_policy)
+                        : file(filename, max_file_size, max_files, flush_policy) {}
+                };
+
+                // Weak references: shards (their files and fds) are owned by the sink alone,
+                // so destroying the sink closes them even while threads that used it live on
+                struct ThreadShards {
+                    uint64_t last_sink = 0;
+                    Shard* last_shard = nullptr;
+                    std::unordered_map<uint64_t, std::weak_ptr<Shard>> shards;
+                };
+
+                const uint64_t id_;
+                std::string base_filename_;
+                size_t max_file_size_;
+                int max_files_;
+                size_t max_shards_;
+                FlushPolicy flush_policy_;
+
+                mutable std::mutex shards_mutex_;   ///< Only taken when a thread logs for the first time
+                std::vector<std::shared_ptr<Shard>> shards_;
+                size_t next_thread_ = 0;
+
+            public:
+                /**
+                 * @brief Constructor for ShardedFileSink
+                 *
+                 * @param base_filename Shards are named "<base_filename>.shard<N>"
+                 * @param max_file_size Maximum size of each shard file before it rotates (in bytes)
+                 * @param max_files Maximum number of files to keep per shard
+                 * @param max_shards Maximum number of shards, 0 for one per thread
+                 * @param flush_policy When each shard's buffered messages are written
+                 */
+                explicit ShardedFileSink(const std::string& base_filename, size_t max_file_size = 10485760, int max_files = 5,
+                                         size_t max_shards = 0, const FlushPolicy& flush_policy = FlushPolicy())
+                    : id_(next_id()), base_filename_(base_filename), max_file_size_(max_file_size),
+                      max_files_(max_files), max_shards_(max_shards), flush_policy_(flush_policy) {}
+
+                ~ShardedFileSink() override {
+                    flush();
+                }
+
+                ShardedFileSink(const ShardedFileSink&) = delete;
+                ShardedFileSink& operator=(const ShardedFileSink&) = delete;
+
+                void write(LogLevel level, std::string_view formatted) override {
+                    Shard& shard = thread_shard();
+                    std::lock_guard<std::mutex> lock(shard.mutex);
+                    // Taken under the lock so that threads sharing a shard (max_shards) keep it sorted
+                    const long long nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::system_clock::now().time_since_epoch()).count();
+                    detail::ScratchBuffer line;
+                    detail::append_zero_padded(line.str(), static_cast<unsigned long long>(nanoseconds), kTimestampDigits);
+                    line.str() += ' ';
+                    line.str().append(formatted.data(), formatted.size());
+                    shard.file.write(line.str(), level);
+                }
+
+                /**
+                 * @brief Write buffered messages and wait until rotated files have their final names
+                 */
+                void flush() override {
+                    for (const auto& shard : snapshot()) {
+                        std::lock_guard<std::mutex> lock(shard->mutex);
+                        shard->file.flush();
+                        shard->file.wait_for_rotation();
+                    }
+                }
+
+                void poll() override {
+                    for (const auto& shard : snapshot()) {
+                        std::lock_guard<std::mutex> lock(shard->mutex);
+                        shard->file.flush_if_due();
+                    }
+                }
+
+                /**
+                 * @brief Number of shard files created so far
+                 */
+                size_t shard_count() const {
+                    std::lock_guard<std::mutex> lock(shards_mutex_);
+                    return shards_.size();
+                }
+
+                /**
+                 * @brief Name of the current file of a shard
+                 */
+                static std::string shard_filename(const std::string& base_filename, size_t shard) {
+                    return base_filename + ".shard" + std::to_string(shard);
+                }
+
+            private:
+                static uint64_t next_id() {
+                    static std::atomic<uint64_t> id{0};
+                    return ++id;
+                }
+
+                std::vector<std::shared_ptr<Shard>> snapshot() const {
+                    std::lock_guard<std::mutex> lock(shards_mutex_);
+                    return shards_;
+                }
+
+                /**
+                 * @brief The calling thread's shard, created on its first message
+                 */
+                Shard& thread_shard() {
+                    thread_local ThreadShards thread_shards;
+                    if (thread_shards.last_sink == id_) {
+                        return *thread_shards.last_shard;
+                    }
+
+                    // Sink ids are never reused, so an entry is only stale once its sink is gone
+                    std::shared_ptr<Shard> shard = thread_shards.shards[id_].lock();
+                    if (!shard) {
+                        for (auto it = thread_shards.shards.begin(); it != thread_shards.shards.end();) {
+                            it = it->second.expired() ? thread_shards.shards.erase(it) : std::next(it);
+                        }
+                        std::lock_guard<std::mutex> lock(shards_mutex_);
+                        const size_t index = next_thread_++;
+                        if (max_shards_ > 0 && shards_.size() >= max_shards_) {
+                            shard = shards_[index % max_shards_];
+                        } else {
+                            shard = std::make_shared<Shard>(shard_filename(base_filename_, shards_.size()),
+                                                            max_file_size_, max_files_, flush_policy_);
+                            shards_.push_back(shard);
+                        }
+                        thread_shards.shards[id_] = shard;
+                    }
+                    thread_shards.last_sink = id_;
+                    thread_shards.last_shard = shard.get();
+                    return *shard;
+                }
+            };
+
+            /**
+             * @brief A line read back from a ShardedFileSink
+             */
+            struct ShardedLogLine {
+                std::chrono::system_clock::time_point time;  ///< When the line was written
+                std::string text;                            ///< The formatted message, without the timestamp prefix
+                size_t shard = 0;                            ///< Shard the line came from
+            };
+
+            /**
+             * @brief Merges the shards of a ShardedFileSink into one time-ordered stream
+             *
+             * Each shard's files are read oldest first (rotated files, then the current
+             * one) and the shards are combined with a k-way merge on the line
+             * timestamps. Lines without a timestamp prefix (messages containing
+             * newlines) stay attached to the line before them.
+             *
+             * Example usage:
+             * @code
+             * ShardedLogReader reader("app.log");
+             * ShardedLogLine line;
+             * while (reader.next(line)) {
+             *     std::cout << line.text << '\n';
+             * }
+             * @endcode
+             */
+            class ShardedLogReader {
+            private:
+                struct ShardInput {
+                    explicit ShardInput(RotatedLogReader reader) : files(std::move(reader)) {}
+
+                    RotatedLogReader files;
+                    bool has_pending = false;
+                    ShardedLogLine pending;          ///< Next line of this shard, ready to be merged
+                    std::string lookahead;
+                    bool has_lookahead = false;
+                };
+
+                std::vector<std::unique_ptr<ShardInput>> shards_;
+                std::vector<size_t> heap_;           ///< Shards with a pending line, earliest on top
+
+            public:
+                /**
+                 * @brief Open every shard of a ShardedFileSink
+                 *
+                 * @param base_filename The base filename the sink was created with
+                 * @param max_files The sink's max_files, i.e. how many rotated files to look for
+                 */
+                explicit ShardedLogReader(const std::string& base_filename, int max_files = 5) {
+                    for (size_t shard = 0;; ++shard) {
+                        const std::string current = ShardedFileSink::shard_filename(base_filename, shard);
+                        auto input = std::make_unique<ShardInput>(RotatedLogReader(current, max_files));
+                        if (input->files.file_count() == 0) {
+                            break;
+                        }
+                        shards_.push_back(std::move(input));
+                    }
+                    for (size_t shard = 0; shard < shards_.size(); ++shard) {
+                        if (advance(shard)) {
+                            heap_.push_back(shard);
+                        }
+                    }
+                    std::make_heap(heap_.begin(), heap_.end(), later());
+                }
+
+                /**
+                 * @brief Number of shards found
+                 */
+                size_t shard_count() const {
+                    return shards_.size();
+                }
+
+                /**
+                 * @brief Read the next line in timestamp order
+                 *
+                 * Lines with equal timestamps come out in shard order.
+                 *
+                 * @param line Receives the line
+                 * @return false when every shard is exhausted
+                 */
+                bool next(ShardedLogLine& line) {
+                    if (heap_.empty()) {
+                        return false;
+                    }
+                    std::pop_heap(heap_.begin(), heap_.end(), later());
+                    const size_t shard = heap_.back();
+                    line = std::move(shards_[shard]->pending);
+                    if (advance(shard)) {
+                        std::push_heap(heap_.begin(), heap_.end(), later());
+                    } else {
+                        heap_.pop_back();
+                    }
+                    return true;
+                }
+
+            private:
+                /**
+                 * @brief Heap order: the shard whose pending line is earliest goes on top
+                 */
+                struct Later {
+                    const ShardedLogReader* reader;
+                    bool operator()(size_t a, size_t b) const {
+                        const auto& left = reader->shards_[a]->pending.time;
+                        const auto& right = reader->shards_[b]->pending.time;
+                        return left != right ? left > right : a > b;
+                    }
+                };
+
+                Later later() const {
+                    return Later{this};
+                }
+
+                /**
+                 * @brief Read one raw line from a shard, moving on to its next file at end of file
+                 */
+                static bool read_raw_line(ShardInput& input, std::string& line) {
+                    if (input.has_lookahead) {
+                        input.has_lookahead = false;
+                        line = std::move(input.lookahead);
+                        return true;
+                    }
+                    return input.files.next_line(line);
+                }
+
+                /**
+                 * @brief Parse the timestamp prefix of a line
+                 *
+                 * @return true if the line starts with one
+                 */
+                static bool parse_prefix(const std::string& line, long long& nanoseconds) {
+                    constexpr size_t digits = ShardedFileSink::kTimestampDigits;
+                    if (line.size() <= digits || line[digits] != ' ') {
+                        return false;
+                    }
+                    auto result = std::from_chars(line.data(), line.data() + digits, nanoseconds);
+                    return result.ec == std::errc() && result.ptr == line.data() + digits;
+                }
+
+                /**
+                 * @brief Load the next record of a shard into its pending slot
+                 *
+                 * @return false if the shard has no more records
+                 */
+                bool advance(size_t shard) {
+                    ShardInput& input = *shards_[shard];
+                    std::string raw;
+                    long long nanoseconds = 0;
+                    // Skip anything before the first timestamped line
+                    do {
+                        if (!read_raw_line(input, raw)) {
+                            return false;
+                        }
+                    } while (!parse_prefix(raw, nanoseconds));
+
+                    ShardedLogLine& pending = input.pending;
+                    pending.shard = shard;
+                    pending.time = std::chrono::system_clock::time_point(
+                        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(nanoseconds)));
+                    pending.text.assign(raw, ShardedFileSink::kTimestampDigits + 1, std::string::npos);
+
+                    // Continuation lines of a multi-line message
+                    long long ignored;
+                    while (read_raw_line(input, raw)) {
+                        if (parse_prefix(raw, ignored)) {
+                            input.lookahead = std::move(raw);
+                            input.has_lookahead = true;
+                            break;
+                        }
+                        pending.text += '\n';
+                        pending.text += raw;
+                    }
+                    return true;
+                }
+            };
+
+            /**
+             * @brief File sink that writes into memory-mapped, preallocated segments
+             *
+             * Each segment is a file of segment_size bytes, preallocated and mapped
+             * up front. A write reserves space with an atomic add on the tail offset
+             * and copies the message into the mapping: there is no lock and no
+             * syscall per message. When a reservation runs past the end of the
+             * segment, that writer rotates by swapping in the next segment, which a
+             * background thread has already preallocated as "<filename>.next". The
+             * background thread then renames the files the way RotatingFileLogger
+             * does ("<filename>.1", ...), preallocates the following spare, and
+             * truncates retired segments to their real size before unmapping them.
+             * A rotating writer only waits when segments fill faster than they can be
+             * preallocated. If preallocation fails (e.g. the disk is full), messages
+             * are dropped until a retry, once a second, succeeds.
+             *
+             * Until the sink is closed, the current file is segment_size bytes long
+             * and zero-filled after the last message. Reopening a file after a crash
+             * trims those zeros. On Windows the sink writes through a
+             * RotatingFileLogger instead.
+             */
+            class MappedFileSink : public LogSink {
+#ifdef _WIN32
+            private:
+                std::mutex mutex_;
+                RotatingFileLogger file_;
+
+            public:
+                explicit MappedFileSink(const std::string& base_filename, size_t segment_size = 10485760, int max_files = 5)
+                    : file_(base_filename, segment_size, max_files, FlushPolicy::every_message()) {}
+
+                void write(LogLevel level, std::string_view formatted) override {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    file_.write(formatted, level);
+                }
+
+                bool is_open() const {
+                    return true;
+                }
+
+                void sync() {}
+#else
+            private:
+                struct Segment {
+                    int fd = -1;
+                    char* data = nullptr;
+                    size_t capacity = 0;
+                    size_t final_size = 0;                         ///< Bytes written, set when the segment is retired
+                    alignas(64) std::atomic<size_t> tail{0};       ///< Next free offset; may run past capacity
+                    alignas(64) std::atomic<size_t> committed{0};  ///< Bytes whose copy has finished
+                };
+
+                std::string base_filename_;
+                std::string spare_filename_;
+                size_t segment_size_;
+                int max_files_;
+
+                struct PendingRotation {
+                    std::unique_ptr<Segment> full;
+                    bool next_installed;                           ///< The spare ".next" file became the current one
+                };
+
+                struct alignas(64) WriterCount {
+                    std::atomic<size_t> count{0};
+                };
+
+                std::atomic<Segment*> current_{nullptr};
+
+                // Writers count themselves under the parity of epoch_ while they may hold a segment
+                // pointer. A retired segment is freed once the count of the epoch it was retired in
+                // drains; both sides use seq_cst, like Logger's *_users counters.
+                alignas(64) std::atomic<unsigned> epoch_{0};
+                WriterCount writers_[2];
+
+                std::mutex mutex_;                          ///< Guards everything below; never held across file I/O
+                std::condition_variable work_cv_;
+                std::condition_variable spare_cv_;          ///< Signalled when a spare is made or fails
+                std::unique_ptr<Segment> active_;           ///< Owner of current_
+                std::unique_ptr<Segment> spare_;            ///< Preallocated next segment
+                size_t min_spare_size_ = 0;                 ///< Larger spare needed for an oversized message
+                bool spare_failed_ = false;                 ///< The last preallocation failed; retried once a second
+                std::vector<PendingRotation> rotations_;    ///< Waiting for renames and release
+                bool stopping_ = false;
+                std::thread worker_;
+
+                // Background thread only
+                std::vector<std::unique_ptr<Segment>> released_;  ///< Unmapped, not yet covered by a grace period
+                std::vector<std::unique_ptr<Segment>> retired_;   ///< Unmapped, freed when writers_[grace_parity_] drains
+                unsigned grace_parity_ = 0;
+
+            public:
+                /**
+                 * @brief Constructor for MappedFileSink
+                 *
+                 * @param base_filename The file to write; rotated files get ".1", ".2", ...
+                 * @param segment_size Size of each preallocated segment, i.e. the maximum file size (in bytes)
+                 * @param max_files Maximum number of rotated files to keep
+                 */
+                explicit MappedFileSink(const std::string& base_filename, size_t segment_size = 10485760, int max_files = 5)
+                    : base_filename_(base_filename), spare_filename_(base_filename + ".next"),
+                      segment_size_(segment_size > 0 ? segment_size : 1), max_files_(max_files) {
+                    active_ = map_segment(base_filename_, segment_size_, false);
+                    if (!active_) {
+                        std::cerr << "Error opening mapped log file: " << base_filename_ << std::endl;
+                    }
+                    current_.store(active_.get(), std::memory_order_release);
+                    worker_ = std::thread(&MappedFileSink::run, this);
+                }
+
+                /**
+                 * @brief Destructor truncates the current file to its real size
+                 *
+                 * No other thread may write to the sink while it is destroyed.
+                 */
+                ~MappedFileSink() override {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        stopping_ = true;
+                    }
+                    work_cv_.notify_one();
+                    worker_.join();
+
+                    rename_generations(rotations_);
+                    for (auto& rotation : rotations_) {
+                        release(*rotation.full);
+                    }
+                    if (active_) {
+                        active_->final_size = active_->committed.load();
+                        release(*active_);
+                    }
+                    if (spare_) {
+                        spare_->final_size = 0;
+                        release(*spare_);
+                        std::remove(spare_filename_.c_str());
+                    }
+                }
+
+                MappedFileSink(const MappedFileSink&) = delete;
+                MappedFileSink& operator=(const MappedFileSink&) = delete;
+
+                void write(LogLevel, std::string_view formatted) override {
+                    std::atomic<size_t>& writers = writers_[epoch_.load() & 1].count;
+                    writers.fetch_add(1);
+                    append(formatted);
+                    writers.fetch_sub(1, std::memory_order_release);
+                }
+
+                /**
+                 * @brief Ask the kernel to start writing the mapped data back
+                 *
+                 * Written messages are already visible to readers of the file.
+                 */
+                void flush() override {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (active_) {
+                        ::msync(active_->data, active_->capacity, MS_ASYNC);
+                    }
+                }
+
+                /**
+                 * @brief Block until the mapped data of the current segment is on disk
+                 */
+                void sync() {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (active_) {
+                        ::msync(active_->data, active_->capacity, MS_SYNC);
+                    }
+                }
+
+                /**
+                 * @brief Check whether the current segment is mapped
+                 */
+                bool is_open() const {
+                    return current_.load() != nullptr;
+                }
+
+            private:
+                /**
+                 * @brief Copy a message and its newline into the current segment, rotating when it is full
+                 */
+                void append(std::string_view formatted) {
+                    const size_t length = formatted.size() + 1; // +1 for newline
+                    for (;;) {
+                        Segment* segment = current_.load();
+                        if (!segment) {
+                            return;
+                        }
+                        const size_t start = segment->tail.fetch_add(length, std::memory_order_relaxed);
+                        if (start + length <= segment->capacity) {
+                            std::memcpy(segment->data + start, formatted.data(), formatted.size());
+                            segment->data[start + formatted.size()] = '\n';
+                            segment->committed.fetch_add(length, std::memory_order_release);
+                            return;
+                        }
+                        if (start <= segment->capacity) {
+                            // The first reservation past the end rotates; later ones wait for it
+                            rotate(segment, start, length);
+                        } else {
+                            while (current_.load() == segment) {
+                                std::this_thread::yield();
+                            }
+                        }
+                    }
+                }
+
+                /**
+                 * @brief Open (or create), preallocate and map a segment file
+                 *
+                 * @param filename The file to map
+                 * @param capacity Minimum size of the segment
+                 * @param truncate Discard existing contents instead of appending to them
+                 */
+                static std::unique_ptr<Segment> map_segment(const std::string& filename, size_t capacity, bool truncate) {
+                    const int fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : 0), 0644);
+                    if (fd < 0) {
+                        return nullptr;
+                    }
+                    struct stat info;
+                    const size_t existing = ::fstat(fd, &info) == 0 ? static_cast<size_t>(info.st_size) : 0;
+                    if (existing > capacity) {
+                        capacity = existing;
+                    }
+                    if (!preallocate(fd, capacity)) {
+                        ::close(fd);
+                        return nullptr;
+                    }
+                    void* data = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                    if (data == MAP_FAILED) {
+                        ::close(fd);
+                        return nullptr;
+                    }
+                    ::madvise(data, capacity, MADV_SEQUENTIAL);
+
+                    auto segment = std::make_unique<Segment>();
+                    segment->fd = fd;
+                    segment->data = static_cast<char*>(data);
+                    segment->capacity = capacity;
+                    // Continue after the last message; the rest of a preallocated file is zeros
+                    size_t used = existing;
+                    while (used > 0 && segment->data[used - 1] == '\0') {
+                        --used;
+                    }
+                    segment->tail.store(used);
+                    segment->committed.store(used);
+                    return segment;
+                }
+
+                /**
+                 * @brief Reserve disk blocks so stores into the mapping cannot fail with SIGBUS
+                 */
+                static bool preallocate(int fd, size_t size) {
+#if defined(__linux__)
+                    const int result = ::posix_fallocate(fd, 0, static_cast<off_t>(size));
+                    if (result == 0) {
+                        return true;
+                    }
+                    if (result != EOPNOTSUPP && result != EINVAL) {
+                        return false;
+                    }
+                    // The file system cannot preallocate; fall back to a sparse file
+#endif
+                    return ::ftruncate(fd, static_cast<off_t>(size)) == 0;
+                }
+
+                /**
+                 * @brief Unmap a segment and truncate its file to final_size
+                 */
+                static void release(Segment& segment) {
+                    if (segment.data) {
+                        ::munmap(segment.data, segment.capacity);
+                        segment.data = nullptr;
+                    }
+                    if (segment.fd >= 0) {
+                        if (::ftruncate(segment.fd, static_cast<off_t>(segment.final_size)) != 0) {
+                            std::cerr << "Error truncating mapped log file" << std::endl;
+                        }
+                        ::close(segment.fd);
+                        segment.fd = -1;
+                    }
+                }
+
+                /**
+                 * @brief Replace a full segment with the spare one
+                 *
+                 * Renaming and releasing the full segment is left to the background thread.
+                 *
+                 * @param full The segment that ran out of space
+                 * @param used Offset of the first reservation that did not fit
+                 * @param needed Size of that reservation
+                 */
+                void rotate(Segment* full, size_t used, size_t needed) {
+                    // Wait for writers still copying into the full segment
+                    while (full->committed.load(std::memory_order_acquire) != used) {
+                        std::this_thread::yield();
+                    }
+
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    if (spare_ && spare_->capacity < needed) {
+                        // A message longer than a segment: have a larger spare made
+                        std::unique_ptr<Segment> small = std::move(spare_);
+                        lock.unlock();
+                        small->final_size = 0;
+                        release(*small);
+                        lock.lock();
+                    }
+                    if (!spare_) {
+                        // Segments fill faster than they are preallocated, or the last attempt failed
+                        min_spare_size_ = std::max(min_spare_size_, needed);
+                        spare_failed_ = false;
+                        work_cv_.notify_one();
+                        spare_cv_.wait(lock, [this]() { return spare_ || spare_failed_ || stopping_; });
+                    }
+                    std::unique_ptr<Segment> next = std::move(spare_);
+                    if (!next) {
+                        std::cerr << "Error rotating mapped log file: " << base_filename_ << std::endl;
+                    }
+
+                    active_->final_size = used;
+                    rotations_.push_back(PendingRotation{std::move(active_), next != nullptr});
+                    active_ = std::move(next);
+                    current_.store(active_.get()); // seq_cst: ordered before the epoch flip that retires full
+                    work_cv_.notify_one();
+                }
+
+                /**
+                 * @brief Shift the file names for each rotation, oldest rotation first
+                 */
+                void rename_generations(const std::vector<PendingRotation>& rotations) const {
+                    for (const auto& rotation : rotations) {
+                        for (int i = max_files_ - 1; i > 0; --i) {
+                            const std::string old_name = base_filename_ + "." + std::to_string(i);
+                            const std::string new_name = base_filename_ + "." + std::to_string(i + 1);
+                            std::remove(new_name.c_str());
+                            std::rename(old_name.c_str(), new_name.c_str());
+                        }
+                        const std::string backup_name = base_filename_ + ".1";
+                        std::rename(base_filename_.c_str(), backup_name.c_str());
+                        if (rotation.next_installed) {
+                            std::rename(spare_filename_.c_str(), base_filename_.c_str());
+                        }
+                    }
+                }
+
+                /**
+                 * @brief Free retired segments that no writer can still reach
+                 *
+                 * Never waits: a writer inside rotate() may be waiting for this
+                 * thread, so a grace period that has not finished is checked again later.
+                 */
+                void reclaim() {
+                    if (!retired_.empty() && writers_[grace_parity_].count.load() == 0) {
+                        retired_.clear();
+                    }
+                    if (retired_.empty() && !released_.empty()) {
+                        // Writers arriving after the flip count under the other parity and load the new current_
+                        grace_parity_ = epoch_.fetch_add(1) & 1;
+                        retired_ = std::move(released_);
+                        released_.clear();
+                        if (writers_[grace_parity_].count.load() == 0) {
+                            retired_.clear();
+                        }
+                    }
+                }
+
+                /**
+                 * @brief Background thread: rename and retire full segments, keep a spare ready
+                 *
+                 * The lock is dropped for all file operations, so writers and
+                 * rotations never wait behind a rename or a preallocation. When the
+                 * current segment is missing (its file could not be created), it is
+                 * recreated before a spare.
+                 */
+                void run() {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    bool failing = !active_; // The constructor has reported it
+                    for (;;) {
+                        if (spare_failed_) {
+                            // Retry once a second, or sooner when a rotation asks for a spare
+                            work_cv_.wait_for(lock, std::chrono::seconds(1), [this]() {
+                                return stopping_ || !spare_failed_ || !rotations_.empty();
+                            });
+                            spare_failed_ = false;
+                        } else {
+                            auto has_work = [this]() { return stopping_ || !rotations_.empty() || !spare_ || !active_; };
+                            if (retired_.empty()) {
+                                work_cv_.wait(lock, has_work);
+                            } else if (!work_cv_.wait_for(lock, std::chrono::milliseconds(10), has_work)) {
+                                reclaim(); // Only a grace period to finish
+                                continue;
+                            }
+                        }
+                        if (stopping_) {
+                            return; // The destructor finishes pending rotations
+                        }
+
+                        std::vector<PendingRotation> rotations = std::move(rotations_);
+                        rotations_.clear();
+                        const bool make_active = !active_;
+                        const bool make_spare = !spare_;
+                        const size_t spare_size = std::max(segment_size_, min_spare_size_);
+                        lock.unlock();
+
+                        // ".next" must have its final name before the next spare takes it
+                        rename_generations(rotations);
+                        std::unique_ptr<Segment> segment;
+                        if (make_active) {
+                            segment = map_segment(base_filename_, segment_size_, false);
+                        } else if (make_spare) {
+                            segment = map_segment(spare_filename_, spare_size, true);
+                        }
+                        for (auto& rotation : rotations) {
+                            ::msync(rotation.full->data, rotation.full->final_size, MS_ASYNC);
+                            release(*rotation.full);
+                        }
+
+                        for (auto& rotation : rotations) {
+                            released_.push_back(std::move(rotation.full));
+                        }
+                        reclaim();
+
+                        lock.lock();
+                        if (!make_active && !make_spare) {
+                            continue;
+                        }
+                        if (!segment) {
+                            if (!failing) {
+                                std::cerr << "Error preallocating mapped log file: "
+                                          << (make_active ? base_filename_ : spare_filename_) << std::endl;
+                            }
+                            failing = true;
+                            spare_failed_ = true;
+                        } else if (make_active) {
+                            failing = false;
+                            active_ = std::move(segment);
+                            current_.store(active_.get());
+                        } else {
+                            failing = false;
+                            spare_ = std::move(segment);
+                            if (spare_->capacity >= min_spare_size_) {
+                                min_spare_size_ = 0;
+                            }
+                        }
+                        spare_cv_.notify_all();
+                    }
+                }
+#endif
+            };
+
+            /**
+             * @brief Keeps formatted messages in memory, optionally only the most recent ones
+             */
+            class MemorySink : public LogSink {
+            private:
+                mutable std::mutex mutex_;
+                std::deque<std::string> lines_;
+                size_t max_lines_;
+
+            public:
+                /**
+                 * @brief Constructor for MemorySink
+                 *
+                 * @param max_lines Number of messages to keep, 0 for no limit
+                 */
+                explicit MemorySink(size_t max_lines = 0) : max_lines_(max_lines) {}
+
+                void write(LogLevel, std::string_view formatted) override {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (max_lines_ > 0 && lines_.size() == max_lines_) {
+                        lines_.pop_front();
+                    }
+                    lines_.emplace_back(formatted);
+                }
+
+                /**
+                 * @brief Copy of the stored messages, oldest first
+                 */
+                std::vector<std::string> lines() const {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    return std::vector<std::string>(lines_.begin(), lines_.end());
+                }
+
+                size_t size() const {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    return lines_.size();
+                }
+
+                void clear() {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    lines_.clear();
+                }
+            };
+
+            /**
+             * @brief Forwards formatted messages to a user callback
+             *
+             * The callback must be thread-safe unless the sink is asynchronous.
+             */
+            class CallbackSink : public LogSink {
+            public:
+                using Callback = std::function<void(LogLevel, std::string_view)>;
+
+            private:
+                Callback callback_;
+
+            public:
+                explicit CallbackSink(Callback callback) : callback_(std::move(callback)) {}
+
+                void write(LogLevel level, std::string_view formatted) override {
+                    callback_(level, formatted);
+                }
+            };
+
+            /**
+             * @brief Where a DatagramSink sends its datagrams
+             */
+            struct DatagramAddress {
+                enum class Kind {
+                    UDP,   ///< A UDP host and port
+                    UNIX   ///< A Unix domain datagram socket path
+                };
+
+                Kind kind = Kind::UDP;
+                std::string host;   ///< Host name or address (UDP)
+                uint16_t port = 0;  ///< Port (UDP)
+                std::string path;   ///< Socket path (UNIX)
+
+                /**
+                 * @brief Send to a UDP receiver, e.g. a syslog daemon on port 514
+                 */
+                static DatagramAddress udp(const std::string& host, uint16_t port) {
+                    DatagramAddress address;
+                    address.kind = Kind::UDP;
+                    address.host = host;
+                    address.port = port;
+                    return address;
+                }
+
+                /**
+                 * @brief Send to a Unix domain datagram socket, e.g. "/dev/log"
+                 */
+                static DatagramAddress unix_socket(const std::string& path) {
+                    DatagramAddress address;
+                    address.kind = Kind::UNIX;
+                    address.path = path;
+                    return address;
+                }
+            };
+
+            /**
+             * @brief How a DatagramSink lays out messages in its datagrams
+             */
+            enum class DatagramFraming {
+                PLAIN,    ///< Newline-terminated messages, as many per datagram as fit
+                RFC5424   ///< One syslog message (RFC 5424) per datagram
+            };
+
+            /**
+             * @brief Settings for DatagramSink
+             */
+            struct DatagramSinkOptions {
+                DatagramFraming framing = DatagramFraming::RFC5424;
+                size_t max_datagram_size = 2048;            ///< Longer messages are truncated
+                size_t batch_size = 64;                     ///< Datagrams handed to the kernel per system call
+                size_t spill_bytes = 4 * 1024 * 1024;       ///< Unsent datagrams kept while the receiver is slow
+                std::chrono::milliseconds batch_delay{20};  ///< Longest a datagram waits for a batch to fill
+                int facility = 1;                           ///< Syslog facility; 1 is user-level messages
+                std::string app_name;                       ///< Syslog APP-NAME; empty sends "-"
+                std::string hostname;                       ///< Syslog HOSTNAME; empty uses gethostname()
+            };
+
+            /**
+             * @brief Sends messages as datagrams over UDP or a Unix domain socket
+             *
+             * write() frames a message and queues it; a sender thread hands the
+             * queue to the kernel in batches, with one sendmmsg() call per batch on
+             * Linux. When the receiver cannot keep up, unsent datagrams stay queued
+             * up to spill_bytes and the oldest are dropped beyond that. A lost
+             * connection is retried with a growing delay while messages keep
+             * queueing. UDP gives no back-pressure: a slow UDP receiver loses
+             * datagrams in its own buffers.
+             *
+             * With RFC 5424 framing the sink writes the syslog header itself
+             * (priority, UTC timestamp, host, app name and process id), so the
+             * formatter should leave out timestamp and level, e.g. a
+             * DefaultLogFormatter with TimestampFormat::NONE. Not available on
+             * Windows, where the sink discards its messages.
+             */
+            class DatagramSink : public LogSink {
+#ifdef _WIN32
+            public:
+                explicit DatagramSink(const DatagramAddress&, const DatagramSinkOptions& = DatagramSinkOptions()) {
+                    std::cerr << "Datagram log sinks are not supported on Windows" << std::endl;
+                }
+
+                void write(LogLevel, std::string_view) override {}
+
+                uint64_t sent() const {
+                    return 0;
+                }
+
+                uint64_t dropped() const {
+                    return 0;
+                }
+
+                size_t pending() const {
+                    return 0;
+                }
+#else
+            private:
+                DatagramAddress address_;
+                DatagramSinkOptions options_;
+                std::string header_tail_;    ///< " HOSTNAME APP-NAME PROCID - - " after the RFC 5424 timestamp
+
+                // Used by the sender thread only
+                int fd_ = -1;
+                bool reported_ = false;      ///< An error was reported for the current outage
+                std::vector<struct mmsghdr> messages_;
+                std::vector<struct iovec> iovecs_;
+
+                mutable std::mutex mutex_;   ///< Guards everything below
+                std::condition_variable work_cv_;
+                std::condition_variable done_cv_;
+                std::deque<std::string> queue_;  ///< Unsent datagrams, oldest first
+                std::vector<std::string> pool_;  ///< Sent datagrams kept for their capacity
+                size_t queued_bytes_ = 0;        ///< Bytes in queue_ and in flight
+                size_t in_flight_ = 0;           ///< Datagrams the sender is handing to the kernel
+                uint64_t sent_ = 0;
+                uint64_t dropped_ = 0;
+                uint64_t attempts_ = 0;          ///< Finished send attempts
+                bool stalled_ = false;           ///< The last attempt could not send everything
+                bool flush_requested_ = false;
+                bool stopping_ = false;
+                std::thread sender_;
+
+            public:
+                /**
+                 * @brief Constructor for DatagramSink
+                 *
+                 * @param address The receiver; it does not have to exist yet
+                 * @param options Framing, batching and spill settings
+                 */
+                explicit DatagramSink(const DatagramAddress& address, const DatagramSinkOptions& options = DatagramSinkOptions())
+                    : address_(address), options_(options) {
+                    options_.max_datagram_size = std::max<size_t>(options_.max_datagram_size, 64);
+                    options_.batch_size = std::max<size_t>(options_.batch_size, 1);
+                    options_.spill_bytes = std::max(options_.spill_bytes, options_.max_datagram_size);
+                    messages_.resize(options_.batch_size);
+                    iovecs_.resize(options_.batch_size);
+
+                    std::string hostname = options_.hostname;
+                    if (hostname.empty()) {
+                        char buffer[256] = {};
+                        if (::gethostname(buffer, sizeof(buffer) - 1) == 0) {
+                            hostname = buffer;
+                        }
+                    }
+                    header_tail_ = " " + header_field(hostname, 255) + " " + header_field(options_.app_name, 48) + " " +
+                                   std::to_string(::getpid()) + " - - ";
+                    sender_ = std::thread(&DatagramSink::run, this);
+                }
+
+                /**
+                 * @brief Destructor sends what it can, then drops the rest
+                 */
+                ~DatagramSink() override {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        stopping_ = true;
+                    }
+                    work_cv_.notify_one();
+                    sender_.join();
+                    if (fd_ >= 0) {
+                        ::close(fd_);
+                    }
+                }
+
+                DatagramSink(const DatagramSink&) = delete;
+                DatagramSink& operator=(const DatagramSink&) = delete;
+
+                void write(LogLevel level, std::string_view formatted) override {
+                    detail::ScratchBuffer record;
+                    std::string& out = record.str();
+                    const size_t limit = options_.max_datagram_size;
+                    if (options_.framing == DatagramFraming::RFC5424) {
+                        out += '<';
+                        detail::append_integer(out, options_.facility * 8 + severity(level));
+                        out += ">1 ";
+                        append_rfc3339(out, std::chrono::system_clock::now());
+                        out += header_tail_;
+                        out.append(formatted.data(), std::min(formatted.size(), limit > out.size() ? limit - out.size() : 0));
+                    } else {
+                        out.append(formatted.data(), std::min(formatted.size(), limit - 1));
+                        out += '\n';
+                    }
+
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (options_.framing == DatagramFraming::PLAIN && !queue_.empty() &&
+                        queue_.back().size() + out.size() <= limit) {
+                        queue_.back() += out; // Queued datagrams are not in flight yet
+                    } else {
+                        std::string datagram;
+                        if (!pool_.empty()) {
+                            datagram = std::move(pool_.back());
+                            pool_.pop_back();
+                        }
+                        datagram.assign(out);
+                        queue_.push_back(std::move(datagram));
+                    }
+                    queued_bytes_ += out.size();
+                    trim();
+                    if (queue_.size() >= options_.batch_size) {
+                        work_cv_.notify_one();
+                    }
+                }
+
+                /**
+                 * @brief Send every queued datagram
+                 *
+                 * Returns early when the receiver is not accepting datagrams; they
+                 * stay queued for later.
+                 */
+                void flush() override {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    if (queue_.empty() && in_flight_ == 0) {
+                        return;
+                    }
+                    const uint64_t attempt = attempts_;
+                    flush_requested_ = true;
+                    work_cv_.notify_one();
+                    done_cv_.wait(lock, [this, attempt]() {
+                        return (queue_.empty() && in_flight_ == 0) || (attempts_ > attempt && stalled_) || stopping_;
+                    });
+                }
+
+                /**
+                 * @brief Number of datagrams handed to the kernel
+                 */
+                uint64_t sent() const {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    return sent_;
+                }
+
+                /**
+                 * @brief Number of datagrams dropped because the spill buffer was full, or too big to send
+                 */
+                uint64_t dropped() const {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    return dropped_;
+                }
+
+                /**
+                 * @brief Number of datagrams waiting to be sent
+                 */
+                size_t pending() const {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    return queue_.size() + in_flight_;
+                }
+
+            private:
+                /**
+                 * @brief Map a LogLevel to a syslog severity
+                 */
+                static int severity(LogLevel level) {
+                    switch (level) {
+                        case LOG_DEBUG: return 7;
+                        case LOG_INFO: return 6;
+                        case LOG_WARNING: return 4;
+                        case LOG_ERROR: return 3;
+                    }
+                    return 6;
+                }
+
+                /**
+                 * @brief An RFC 5424 header field: printable ASCII without spaces, or "-" when empty
+                 */
+                static std::string header_field(const std::string& value, size_t max_length) {
+                    std::string field = value.substr(0, max_length);
+                    for (char& c : field) {
+                        if (c <= ' ' || c > '~') {
+                            c = '_';
+                        }
+                    }
+                    return field.empty() ? "-" : field;
+                }
+
+                /**
+                 * @brief Append "YYYY-MM-DDTHH:MM:SS.ffffffZ"
+                 */
+                static void append_rfc3339(std::string& out, std::chrono::system_clock::time_point time) {
+                    const int64_t micros =
+                        std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+                    const std::time_t seconds = static_cast<std::time_t>(micros / 1000000);
+                    thread_local std::time_t cached_second = -1;
+                    thread_local char cached[32];
+                    if (seconds != cached_second) {
+                        std::tm utc;
+                        gmtime_threadsafe(&seconds, &utc);
+                        std::strftime(cached, sizeof(cached), "%Y-%m-%dT%H:%M:%S", &utc);
+                        cached_second = seconds;
+                    }
+                    out.append(cached);
+                    char fraction[8] = {'.', '0', '0', '0', '0', '0', '0', 'Z'};
+                    int64_t rest = micros % 1000000;
+                    for (int i = 6; i > 0 && rest > 0; --i, rest /= 10) {
+                        fraction[i] = static_cast<char>('0' + rest % 10);
+                    }
+                    out.append(fraction, sizeof(fraction));
+                }
+
+                /**
+                 * @brief Drop the oldest unsent datagrams until the spill limit holds; the caller holds mutex_
+                 */
+                void trim() {
+                    while (queued_bytes_ > options_.spill_bytes && !queue_.empty()) {
+                        queued_bytes_ -= queue_.front().size();
+                        recycle(std::move(queue_.front()));
+                        queue_.pop_front();
+                        ++dropped_;
+                    }
+                }
+
+                void recycle(std::string&& datagram) {
+                    if (pool_.size() < options_.batch_size) {
+                        datagram.clear();
+                        pool_.push_back(std::move(datagram));
+                    }
+                }
+
+                /**
+                 * @brief Open and connect the socket; reports the first failure of an outage
+                 */
+                bool connect_socket() {
+                    int fd = -1;
+                    if (address_.kind == DatagramAddress::Kind::UNIX) {
+                        struct sockaddr_un target = {};
+                        target.sun_family = AF_UNIX;
+                        if (address_.path.size() < sizeof(target.sun_path)) {
+                            std::memcpy(target.sun_path, address_.path.c_str(), address_.path.size() + 1);
+                            fd = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+                            if (fd >= 0 && ::connect(fd, reinterpret_cast<struct sockaddr*>(&target), sizeof(target)) != 0) {
+                                ::close(fd);
+                                fd = -1;
+                            }
+                        }
+                    } else {
+                        struct addrinfo hints = {};
+                        hints.ai_family = AF_UNSPEC;
+                        hints.ai_socktype = SOCK_DGRAM;
+                        struct addrinfo* found = nullptr;
+                        if (::getaddrinfo(address_.host.c_str(), std::to_string(address_.port).c_str(), &hints, &found) == 0) {
+                            for (struct addrinfo* entry = found; entry && fd < 0; entry = entry->ai_next) {
+                                fd = ::socket(entry->ai_family, entry->ai_socktype, entry->ai_protocol);
+                                if (fd >= 0 && ::connect(fd, entry->ai_addr, entry->ai_addrlen) != 0) {
+                                    ::close(fd);
+                                    fd = -1;
+                                }
+                            }
+                            ::freeaddrinfo(found);
+                        }
+                    }
+                    if (fd < 0) {
+                        if (!reported_) {
+                            reported_ = true;
+                            std::cerr << "Error connecting datagram log sink to "
+                                      << (address_.kind == DatagramAddress::Kind::UNIX
+                                              ? address_.path : address_.host + ":" + std::to_string(address_.port))
+                                      << std::endl;
+                        }
+                        return false;
+                    }
+                    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+                    fd_ = fd;
+                    reported_ = false;
+                    return true;
+                }
+
+                /**
+                 * @brief Hand datagrams to the kernel without blocking
+                 *
+                 * @param batch The datagrams, oldest first
+                 * @param oversized Incremented for datagrams the socket rejected as too big
+                 * @return Number of leading datagrams that are done (sent or rejected)
+                 */
+                size_t send_batch(const std::vector<std::string>& batch, uint64_t& oversized) {
+                    if (fd_ < 0 && !connect_socket()) {
+                        return 0;
+                    }
+#ifdef MSG_NOSIGNAL
+                    const int flags = MSG_DONTWAIT | MSG_NOSIGNAL;
+#else
+                    const int flags = MSG_DONTWAIT;
+#endif
+                    size_t done = 0;
+                    while (done < batch.size()) {
+#if defined(__linux__)
+                        const size_t count = batch.size() - done;
+                        for (size_t i = 0; i < count; ++i) {
+                            iovecs_[i].iov_base = const_cast<char*>(batch[done + i].data());
+                            iovecs_[i].iov_len = batch[done + i].size();
+                            messages_[i] = {};
+                            messages_[i].msg_hdr.msg_iov = &iovecs_[i];
+                            messages_[i].msg_hdr.msg_iovlen = 1;
+                        }
+                        const int result = ::sendmmsg(fd_, messages_.data(), static_cast<unsigned int>(count), flags);
+#else
+                        const int result = ::send(fd_, batch[done].data(), batch[done].size(), flags) < 0 ? -1 : 1;
+#endif
+                        if (result > 0) {
+                            done += static_cast<size_t>(result);
+                            continue;
+                        }
+                        if (result < 0 && errno == EINTR) {
+                            continue;
+                        }
+                        if (result < 0 && errno == EMSGSIZE) {
+                            ++oversized; // Would never fit; skip it
+                            ++done;
+                            continue;
+                        }
+                        if (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS) {
+                            // The receiver went away; reconnect on the next attempt
+                            ::close(fd_);
+                            fd_ = -1;
+                        }
+                        break;
+                    }
+                    return done;
+                }
+
+                /**
+                 * @brief Sender thread: send full batches at once and partial ones after batch_delay
+                 */
+                void run() {
+                    std::vector<std::string> batch;
+                    std::chrono::milliseconds retry_delay(0);
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    for (;;) {
+                        if (retry_delay.count() > 0) {
+                            work_cv_.wait_for(lock, retry_delay, [this]() { return stopping_; });
+                        } else {
+                            work_cv_.wait_for(lock, options_.batch_delay, [this]() {
+                                return stopping_ || flush_requested_ || queue_.size() >= options_.batch_size;
+                            });
+                        }
+                        if (queue_.empty()) {
+                            flush_requested_ = false;
+                            done_cv_.notify_all();
+                            if (stopping_) {
+                                return;
+                            }
+                            continue;
+                        }
+
+                        const size_t count = std::min(queue_.size(), options_.batch_size);
+                        batch.clear();
+                        for (size_t i = 0; i < count; ++i) {
+                            batch.push_back(std::move(queue_.front()));
+                            queue_.pop_front();
+                        }
+                        in_flight_ = count;
+                        lock.unlock();
+
+                        uint64_t oversized = 0;
+                        const size_t done = send_batch(batch, oversized);
+
+                        lock.lock();
+                        in_flight_ = 0;
+                        // Unsent datagrams go back to the front, in order
+                        for (size_t i = batch.size(); i > done; --i) {
+                            queue_.push_front(std::move(batch[i - 1]));
+                        }
+                        for (size_t i = 0; i < done; ++i) {
+                            queued_bytes_ -= batch[i].size();
+                            recycle(std::move(batch[i]));
+                        }
+                        sent_ += done - oversized;
+                        dropped_ += oversized;
+                        trim();
+                        ++attempts_;
+                        stalled_ = done < batch.size();
+                        done_cv_.notify_all();
+
+                        if (!stalled_) {
+                            retry_delay = std::chrono::milliseconds(0);
+                        } else if (stopping_) {
+                            // Nobody is left to wait for the receiver
+                            dropped_ += queue_.size();
+                            queue_.clear();
+                            queued_bytes_ = 0;
+                            done_cv_.notify_all();
+                            return;
+                        } else {
+                            // A full receiver is retried quickly, a missing one slowly
+                            const auto limit = std::chrono::milliseconds(fd_ < 0 ? 1000 : 50);
+                            retry_delay = std::min(limit, std::max(std::chrono::milliseconds(1), retry_delay * 2));
+                        }
+                    }
+                }
+#endif
+            };
+
+            /**
+             * @brief Per-sink settings for Logger::add_sink()
+             */
+            struct SinkOptions {
+                LogLevel level = LOG_DEBUG;                 ///< Minimum level this sink receives
+                std::shared_ptr<LogFormatter> formatter;    ///< Null uses the Logger's formatter
+                bool async = false;                         ///< Write from a dedicated background thread
+                size_t queue_capacity = 8192;               ///< Queued messages when async (rounded up to a power of two)
+                OverflowPolicy overflow = OverflowPolicy::BLOCK; ///< What to do when the async queue is full
+            };
+
+            /**
+             * @brief Settings for Logger::enable_flight_recorder()
+             */
+            struct FlightRecorderOptions {
+                size_t buffer_size = 256 * 1024;      ///< Ring size per thread in bytes
+                LogLevel level = LOG_DEBUG;           ///< Lowest level recorded, even below Logger::get_level()
+                LogLevel dump_level = LOG_ERROR;      ///< Messages at or above this level trigger a dump
+                bool install_signal_handlers = false; ///< Also dump on SIGSEGV, SIGABRT, SIGBUS, SIGFPE and SIGILL
+            };
+
+            namespace detail {
+                /**
+                 * @brief A registered sink with its settings and optional writer thread
+                 */
+                struct SinkEntry {
+                    std::string name;
+                    std::shared_ptr<LogSink> sink;
+                    std::shared_ptr<LogFormatter> formatter;
+                    std::atomic<LogLevel> level;
+                    std::unique_ptr<AsyncLogQueue> queue;
+                    std::atomic<uint64_t> messages{0}; ///< Messages handed to the sink
+                    std::atomic<uint64_t> bytes{0};    ///< Formatted bytes handed to the sink
+
+                    SinkEntry(const std::string& sink_name, std::shared_ptr<LogSink> target, const SinkOptions& options)
+                        : name(sink_name), sink(std::move(target)), formatter(options.formatter), level(options.level) {
+                        if (options.async) {
+                            LogSink* raw = sink.get();
+                            queue = std::make_unique<AsyncLogQueue>(options.queue_capacity, options.overflow,
+                                                                    [this, raw](LogLevel message_level, const std::string& message) {
+                                                                        count(message.size());
+                                                                        raw->write(message_level, message);
+                                                                    },
+                                                                    [raw]() {
+                                                                        raw->poll();
+                                                                    });
+                        }
+                    }
+
+                    ~SinkEntry() {
+                        queue.reset(); // Drain before the sink can go away
+                        try {
+                            sink->flush();
+                        } catch (...) {
+                            // Flushing is best effort
+                        }
+                    }
+
+                    /**
+                     * @brief Count a message handed to the sink
+                     *
+                     * Shared counters rather than per-thread ones: the sink serializes its
+                     * writes anyway, and an async sink is only written by its writer thread.
+                     */
+                    void count(size_t size) {
+                        messages.fetch_add(1, std::memory_order_relaxed);
+                        bytes.fetch_add(size, std::memory_order_relaxed);
+                    }
+
+                    /**
+                     * @brief Hand a formatted message to the queue or straight to the sink
+                     */
+                    void write(LogLevel message_level, const std::string& formatted) {
+                        if (queue) {
+                            queue->push(message_level, formatted);
+                            return;
+                        }
+                        count(formatted.size());
+                        try {
+                            sink->write(message_level, formatted);
+                        } catch (const std::exception& e) {
+                            std::cerr << "Log sink '" << name << "' error: " << e.what() << std::endl;
+                        } catch (...) {
+                            std::cerr << "Unknown error in log sink '" << name << "'" << std::endl;
+                        }
+                    }
+
+                    void flush() {
+                        if (queue) {
+                            queue->flush();
+                        }
+                        sink->flush();
+                    }
+                };
+
+                /**
+                 * @brief Immutable snapshot of the registered sinks; replaced on every change
+                 */
+                using SinkList = std::vector<std::shared_ptr<SinkEntry>>;
+            }
+
+            namespace detail {
+
+                /**
+                 * @brief Call-site state for LOG_*_EVERY_N: lets through the 1st, (n+1)th, ... call
+                 */
+                class EveryNLimiter {
+                private:
+                    std::atomic<uint64_t> calls_{0};
+
+                public:
+                    bool allow(uint64_t n) {
+                        const uint64_t call = calls_.fetch_add(1, std::memory_order_relaxed);
+                        return n <= 1 || call % n == 0;
+                    }
+                };
+
+                /**
+                 * @brief Call-site state for LOG_*_RATE: at most per_second messages per second
+                 *
+                 * A lock-free token bucket (the generic cell rate algorithm) holding up
+                 * to one second of messages, so short bursts pass and a steady flood is
+                 * cut down to the rate.
+                 */
+                class RateLimiter {
+                private:
+                    std::atomic<int64_t> next_free_{0}; ///< Theoretical arrival time in steady_clock nanoseconds
+
+                public:
+                    bool allow(double per_second) {
+                        if (!(per_second > 0)) {
+                            return false;
+                        }
+                        constexpr int64_t kSecond = 1000000000;
+                        const int64_t interval = std::max<int64_t>(1, static_cast<int64_t>(kSecond / per_second));
+                        const int64_t tolerance = std::max(kSecond, interval) - interval;
+                        const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now().time_since_epoch()).count();
+                        int64_t next_free = next_free_.load(std::memory_order_relaxed);
+                        for (;;) {
+                            const int64_t start = std::max(next_free, now);
+                            if (start - now > tolerance) {
+                                return false;
+                            }
+                            if (next_free_.compare_exchange_weak(next_free, start + interval, std::memory_order_relaxed)) {
+                                return true;
+                            }
+                        }
+                    }
+                };
+
+                /**
+                 * @brief Random 1-in-n choice for LOG_*_SAMPLED, from a per-thread xorshift generator
+                 */
+                inline bool sample_one_in(uint64_t n) {
+                    if (n <= 1) {
+                        return true;
+                    }
+                    thread_local uint64_t state =
+                        0x9E3779B97F4A7C15ull ^ std::hash<std::thread::id>()(std::this_thread::get_id());
+                    state ^= state << 13;
+                    state ^= state >> 7;
+                    state ^= state << 17;
+                    return state % n == 0;
+                }
+
+                /**
+                 * @brief The last message a thread logged, for duplicate suppression
+                 */
+                struct DuplicateState {
+                    bool has_last = false;
+                    LogLevel level = LOG_INFO;
+                    std::string_view category;                   ///< Names live as long as the process
+                    std::string message;
+                    const char* file = nullptr;
+                    const char* file_name = nullptr;
+                    int line = 0;
+                    uint64_t repeats = 0;                        ///< Suppressed copies not yet summarized
+                    std::chrono::steady_clock::time_point first_repeat;
+                };
+
+            }
+
+            namespace detail {
+
+                /**
+                 * @brief Fixed header in front of every flight recorder record
+                 *
+                 * The file name, the format string (format records only) and the
+                 * message text or encoded arguments follow it, in that order.
+                 */
+                struct FlightRecordHeader {
+                    uint32_t size;          ///< Whole record; the next one starts at the following multiple of 8
+                    uint8_t kind;           ///< kFlightPadding, kFlightText or kFlightFormat
+                    uint8_t level;
+                    uint16_t file_size;     ///< Bytes of the source file's base name
+                    uint32_t format_size;   ///< Bytes of the format string
+                    int32_t line;
+                    int64_t time;           ///< system_clock nanoseconds since the epoch
+                    const uint8_t* types;   ///< Zero-terminated BinarySignature array, format records only
+                };
+
+                constexpr uint8_t kFlightPadding = 0;
+                constexpr uint8_t kFlightText = 1;
+                constexpr uint8_t kFlightFormat = 2;
+
+                /**
+                 * @brief One thread's ring of flight recorder records
+                 *
+                 * Records are variable-sized and never split: one that does not fit
+                 * before the end of the buffer goes to the start, behind a padding
+                 * record. Appending evicts the oldest records. Only the owning thread
+                 * appends; the busy flag keeps a dump from reading a half-written record.
+                 */
+                class FlightRing {
+                private:
+                    std::unique_ptr<char[]> buffer_;
+                    const size_t capacity_;
+                    uint64_t head_ = 0;          ///< Stream position of the oldest record
+                    uint64_t tail_ = 0;          ///< Stream position of the next record
+                    uint64_t overwritten_ = 0;   ///< Records evicted since the last dump
+                    std::atomic<bool> busy_{false};
+
+                public:
+                    std::atomic<bool> exited{false}; ///< The owning thread has ended
+                    uint64_t thread_number = 0;
+
+                    explicit FlightRing(size_t capacity)
+                        : capacity_(std::max<size_t>(1024, (capacity + 7) & ~static_cast<size_t>(7))) {
+                        buffer_.reset(new char[capacity_]);
+                    }
+
+                    size_t capacity() const {
+                        return capacity_;
+                    }
+
+                    void lock() {
+                        while (busy_.exchange(true, std::memory_order_acquire)) {
+                            std::this_thread::yield();
+                        }
+                    }
+
+                    bool try_lock() {
+                        return !busy_.exchange(true, std::memory_order_acquire);
+                    }
+
+                    void unlock() {
+                        busy_.store(false, std::memory_order_release);
+                    }
+
+                    /**
+                     * @brief Append one record, evicting the oldest ones to make room
+                     *
+                     * @param header Every field but size
+                     * @param parts The file name, format and payload bytes, in order
+                     * @param count Number of parts
+                     * @return false if the record is larger than the whole ring
+                     */
+                    bool append(FlightRecordHeader header, const ConstBuffer* parts, size_t count) {
+                        size_t record_size = sizeof(FlightRecordHeader);
+                        for (size_t i = 0; i < count; ++i) {
+                            record_size += parts[i].size;
+                        }
+                        const size_t size = aligned(record_size);
+                        if (size > capacity_) {
+                            return false;
+                        }
+                        header.size = static_cast<uint32_t>(record_size);
+
+                        lock();
+                        size_t offset = static_cast<size_t>(tail_ % capacity_);
+                        const size_t gap = capacity_ - offset;
+                        if (gap < size) {
+                            make_room(gap);
+                            const uint32_t padding = static_cast<uint32_t>(gap);
+                            std::memcpy(buffer_.get() + offset, &padding, sizeof(padding));
+                            buffer_[offset + offsetof(FlightRecordHeader, kind)] = static_cast<char>(kFlightPadding);
+                            tail_ += gap;
+                            offset = 0;
+                        }
+                        make_room(size);
+                        char* out = buffer_.get() + offset;
+                        std::memcpy(out, &header, sizeof(header));
+                        out += sizeof(header);
+                        for (size_t i = 0; i < count; ++i) {
+                            if (parts[i].size > 0) {
+                                std::memcpy(out, parts[i].data, parts[i].size);
+                                out += parts[i].size;
+                            }
+                        }
+                        tail_ += size;
+                        unlock();
+                        return true;
+                    }
+
+                    /**
+                     * @brief Call visit(header, body) for every record, oldest first, then empty the ring
+                     *
+                     * The caller holds the lock.
+                     *
+                     * @return Records evicted since the previous drain
+                     */
+                    template<typename Visitor>
+                    uint64_t drain(Visitor&& visit) {
+                        for (uint64_t position = head_; position < tail_;) {
+                            const char* record = buffer_.get() + position % capacity_;
+                            FlightRecordHeader header;
+                            std::memcpy(&header.size, record, sizeof(header.size));
+                            if (static_cast<uint8_t>(record[offsetof(FlightRecordHeader, kind)]) != kFlightPadding) {
+                                std::memcpy(&header, record, sizeof(header));
+                                visit(header, record + sizeof(header));
+                            }
+                            position += aligned(header.size);
+                        }
+                        head_ = tail_;
+                        const uint64_t overwritten = overwritten_;
+                        overwritten_ = 0;
+                        return overwritten;
+                    }
+
+                private:
+                    void make_room(size_t size) {
+                        while (capacity_ - (tail_ - head_) < size) {
+                            const char* record = buffer_.get() + head_ % capacity_;
+                            uint32_t record_size;
+                            std::memcpy(&record_size, record, sizeof(record_size));
+                            if (static_cast<uint8_t>(record[offsetof(FlightRecordHeader, kind)]) != kFlightPadding) {
+                                ++overwritten_;
+                            }
+                            head_ += aligned(record_size);
+                        }
+                    }
+
+                    static size_t aligned(size_t size) {
+                        return (size + 7) & ~static_cast<size_t>(7);
+                    }
+                };
+
+                /**
+                 * @brief Per-thread in-memory rings of recent messages, written out on demand
+                 *
+                 * Each thread appends to its own ring without taking a shared lock.
+                 * "{}" format calls are stored as the format string plus the binary
+                 * encoding of their arguments, so formatting only happens when the
+                 * rings are dumped. A dump writes every thread's records, oldest first,
+                 * in the DefaultLogFormatter layout with microsecond timestamps, and
+                 * empties the rings.
+                 *
+                 * A thread's ring outlives the thread until a new thread takes it over.
+                 */
+                class FlightRecorder {
+                private:
+                    struct ThreadRing {
+                        uint64_t generation = 0;
+                        std::shared_ptr<FlightRing> ring;
+
+                        ~ThreadRing() {
+                            if (ring) {
+                                ring->exited.store(true, std::memory_order_release);
+                            }
+                        }
+                    };
+
+                    const uint64_t generation_;
+                    const size_t buffer_size_;
+                    const LogLevel level_;
+                    const LogLevel dump_level_;
+                    LogFile file_;
+                    DefaultLogFormatter formatter_{TimestampFormat::STANDARD, "", TimestampPrecision::MICROSECONDS};
+                    std::mutex mutex_;                        ///< Guards the members below
+                    std::vector<std::shared_ptr<FlightRing>> rings_;
+                    uint64_t next_thread_number_ = 1;
+                    std::string dump_buffer_;
+                    std::string file_name_;                   ///< Scratch strings for decoding records
+                    std::string message_;
+
+                public:
+                    /**
+                     * @brief Open (or append to) the dump file
+                     *
+                     * @param filename Path the dumps are appended to
+                     * @param buffer_size Ring size per thread in bytes
+                     * @param level Lowest level recorded
+                     * @param dump_level Messages at or above this level trigger a dump
+                     */
+                    FlightRecorder(const std::string& filename, size_t buffer_size, LogLevel level, LogLevel dump_level)
+                        : generation_(next_generation()), buffer_size_(buffer_size), level_(level), dump_level_(dump_level) {
+                        if (!file_.open(filename)) {
+                            std::cerr << "Error opening flight recorder dump file: " << filename << std::endl;
+                            return;
+                        }
+                        // Reserved up front so a dump from a signal handler rarely allocates
+                        dump_buffer_.reserve(std::max<size_t>(buffer_size, 64 * 1024));
+                    }
+
+                    FlightRecorder(const FlightRecorder&) = delete;
+                    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+                    bool is_open() const {
+                        return file_.is_open();
+                    }
+
+                    LogLevel level() const {
+                        return level_;
+                    }
+
+                    LogLevel dump_level() const {
+                        return dump_level_;
+                    }
+
+                    /**
+                     * @brief Record an already formatted message
+                     *
+                     * A category is kept as a "[category] " prefix of the message text.
+                     */
+                    void record_text(LogLevel level, std::string_view message, const LogField* fields, size_t field_count,
+                                     const char* file, int line, std::string_view category = std::string_view()) {
+                        ScratchBuffer text;
+                        if (field_count > 0 || !category.empty()) {
+                            append_category(text.str(), category);
+                            text.str().append(message.data(), message.size());
+                            append_fields(text.str(), fields, field_count);
+                            message = text.str();
+                        }
+                        FlightRing& target = ring();
+                        // Long messages are cut so one record cannot flush the whole ring
+                        const size_t limit = target.capacity() / 4;
+                        if (message.size() > limit) {
+                            message = message.substr(0, limit);
+                        }
+                        append(target, kFlightText, level, file, line, std::string_view(), nullptr, message);
+                    }
+
+                    /**
+                     * @brief Record a "{}" format call without formatting it
+                     */
+                    template<typename... Args>
+                    void record_format(LogLevel level, const char* format, const char* file, int line, const Args&... args) {
+                        ScratchBuffer payload;
+                        (append_binary_arg(payload.str(), args), ...);
+                        append(ring(), kFlightFormat, level, file, line, format, BinarySignature<Args...>::types,
+                               payload.str());
+                    }
+
+                    /**
+                     * @brief Write every thread's records to the dump file and empty the rings
+                     *
+                     * From a signal handler nothing waits: rings (or the whole recorder)
+                     * that are busy are skipped.
+                     *
+                     * @param reason Text for the dump's header line
+                     * @param from_signal Called from a signal handler
+                     * @return true if the dump was written
+                     */
+                    bool dump(const char* reason, bool from_signal = false) {
+                        std::unique_lock<std::mutex> lock(mutex_, std::defer_lock);
+                        if (from_signal) {
+                            if (!lock.try_lock()) {
+                                return false;
+                            }
+                        } else {
+                            lock.lock();
+                        }
+
+                        dump_buffer_.clear();
+                        dump_buffer_ += "==== Flight recorder dump (";
+                        dump_buffer_ += reason;
+                        dump_buffer_ += ") at ";
+                        append_timestamp(dump_buffer_, TimestampFormat::STANDARD, TimestampPrecision::MICROSECONDS,
+                                         std::chrono::system_clock::now());
+                        dump_buffer_ += " ====\n";
+                        bool written = write_dump_buffer();
+
+                        for (const auto& ring : rings_) {
+                            if (from_signal) {
+                                if (!ring->try_lock()) {
+                                    continue;
+                                }
+                            } else {
+                                ring->lock();
+                            }
+                            dump_buffer_.clear();
+                            dump_buffer_ += "---- Thread ";
+                            append_integer(dump_buffer_, ring->thread_number);
+                            dump_buffer_ += " ----\n";
+                            const size_t section_start = dump_buffer_.size();
+                            const uint64_t overwritten = ring->drain([&](const FlightRecordHeader& header, const char* body) {
+                                append_record(header, body);
+                            });
+                            ring->unlock();
+
+                            if (dump_buffer_.size() == section_start && overwritten == 0) {
+                                continue; // Nothing recorded since the last dump
+                            }
+                            if (overwritten > 0) {
+                                dump_buffer_ += "(";
+                                append_integer(dump_buffer_, overwritten);
+                                dump_buffer_ += " older records overwritten)\n";
+                            }
+                            written = write_dump_buffer() && written;
+                        }
+                        return written;
+                    }
+
+                private:
+                    static uint64_t next_generation() {
+                        static std::atomic<uint64_t> generation{0};
+                        return ++generation;
+                    }
+
+                    /**
+                     * @brief The calling thread's ring, registered on first use
+                     */
+                    FlightRing& ring() {
+                        thread_local ThreadRing current;
+                        if (current.generation == generation_) {
+                            return *current.ring;
+                        }
+
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        std::shared_ptr<FlightRing> ring;
+                        for (const auto& candidate : rings_) {
+                            if (candidate->exited.load(std::memory_order_acquire)) {
+                                ring = candidate; // Take over the ring of a thread that has ended
+                                ring->lock();
+                                ring->drain([](const FlightRecordHeader&, const char*) {});
+                                ring->unlock();
+                                ring->exited.store(false, std::memory_order_relaxed);
+                                break;
+                            }
+                        }
+                        if (!ring) {
+                            ring = std::make_shared<FlightRing>(buffer_size_);
+                            rings_.push_back(ring);
+                        }
+                        ring->thread_number = next_thread_number_++;
+                        current.ring = ring;
+                        current.generation = generation_;
+                        return *ring;
+                    }
+
+                    void append(FlightRing& target, uint8_t kind, LogLevel level, const char* file, int line,
+                                std::string_view format, const uint8_t* types, std::string_view payload) {
+                        FlightRecordHeader header{};
+                        header.kind = kind;
+                        header.level = static_cast<uint8_t>(level);
+                        header.line = line;
+                        header.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::system_clock::now().time_since_epoch()).count();
+                        header.types = types;
+
+                        // Copied rather than referenced: the strings need not outlive the call
+                        std::string_view file_name = file ? path_basename(file) : "";
+                        file_name = file_name.substr(0, std::numeric_limits<uint16_t>::max());
+                        header.file_size = static_cast<uint16_t>(file_name.size());
+                        header.format_size = static_cast<uint32_t>(format.size());
+
+                        const ConstBuffer parts[] = {{file_name.data(), file_name.size()},
+                                                     {format.data(), format.size()},
+                                                     {payload.data(), payload.size()}};
+                        target.append(header, parts, 3);
+                    }
+
+                    /**
+                     * @brief Format one record into dump_buffer_, decoding format records
+                     */
+                    void append_record(const FlightRecordHeader& header, const char* body) {
+                        file_name_.assign(body, header.file_size);
+                        body += header.file_size;
+                        const std::string_view format(body, header.format_size);
+                        body += header.format_size;
+                        const size_t payload_size = header.size - sizeof(FlightRecordHeader) - header.file_size -
+                                                    header.format_size;
+                        const std::string_view payload(body, payload_size);
+
+                        LogRecord record;
+                        record.level = static_cast<LogLevel>(header.level);
+                        record.time = std::chrono::system_clock::time_point(
+                            std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                                std::chrono::nanoseconds(header.time)));
+                        record.file = file_name_.empty() ? nullptr : file_name_.c_str();
+                        record.line = header.line;
+                        if (header.kind == kFlightFormat) {
+                            size_t type_count = 0;
+                            while (header.types[type_count] != 0) {
+                                ++type_count;
+                            }
+                            message_.clear();
+                            append_decoded(message_, format, header.types, type_count, payload);
+                            record.message = message_;
+                        } else {
+                            record.message = payload;
+                        }
+                        formatter_.format_to(dump_buffer_, record);
+                        dump_buffer_ += '\n';
+                    }
+
+                    bool write_dump_buffer() {
+                        const ConstBuffer buffer{dump_buffer_.data(), dump_buffer_.size()};
+                        return file_.write(&buffer, 1);
+                    }
+                };
+
+            }
+
+            class Logger;
+
+            /**
+             * @brief A named logging category with its own level
+             *
+             * Categories form a hierarchy by their dotted names: "net.http" is a
+             * child of "net". A category without a level of its own uses its
+             * nearest ancestor's, and top-level categories use Logger::get_level().
+             * Categories are created by Logger::category() and live until the
+             * process exits.
+             *
+             * Example:
+             * @code
+             * Logger::set_category_level("net", LOG_DEBUG);   // net, net.http, net.dns, ...
+             * LOG_CATEGORY_DEBUG("net.http", "Sending " + request.summary());
+             * @endcode
+             */
+            class LogCategory {
+            private:
+                friend class Logger;
+
+                std::string name_;
+                LogCategory* parent_;
+                bool has_level_ = false;                   ///< Level set explicitly (guarded by Logger's level mutex)
+                LogLevel own_level_ = LOG_INFO;
+                std::atomic<LogLevel> level_{LOG_INFO};    ///< Level after inheritance
+                std::atomic<LogLevel> enabled_level_{LOG_INFO}; ///< Lower of level_ and the flight recorder's level
+
+                LogCategory(const std::string& name, LogCategory* parent) : name_(name), parent_(parent) {}
+
+            public:
+                LogCategory(const LogCategory&) = delete;
+                LogCategory& operator=(const LogCategory&) = delete;
+
+                /**
+                 * @brief Full dotted name of the category
+                 */
+                const std::string& name() const {
+                    return name_;
+                }
+
+                /**
+                 * @brief The enclosing category, or null for a top-level category
+                 */
+                const LogCategory* parent() const {
+                    return parent_;
+                }
+
+                /**
+                 * @brief Minimum level written for this category, after inheritance
+                 */
+                LogLevel level() const {
+                    return level_.load(std::memory_order_relaxed);
+                }
+
+                /**
+                 * @brief Check whether a message at the given level would be logged or recorded
+                 *
+                 * @param level The LogLevel to check
+                 * @return true if messages at this level are emitted or kept by the flight recorder
+                 */
+                bool is_enabled(LogLevel level) const {
+                    return static_cast<int>(level) >= INTERLACED_CORE_MIN_LOG_LEVEL &&
+                           level >= enabled_level_.load(std::memory_order_relaxed);
+                }
+            };
+
+            namespace detail {
+
+                /**
+                 * @brief Per-call-site cache behind the LOG_CATEGORY_* macros
+                 *
+                 * Holds "enabled", "disabled" or "unknown". Every configuration change
+                 * bumps Logger's generation counter and resets all registered sites to
+                 * "unknown", so a call site whose category is disabled costs a single
+                 * relaxed load. The constructor is constexpr, so a function-local
+                 * static site needs no initialization guard.
+                 */
+                class CategorySite {
+                private:
+                    friend class interlaced::core::logging::Logger;
+
+                    static constexpr uint8_t kUnknown = 0;
+                    static constexpr uint8_t kDisabled = 1;
+                    static constexpr uint8_t kEnabled = 2;
+
+                    const char* name_;
+                    LogLevel level_;
+                    std::atomic<uint8_t> state_{kUnknown};
+                    std::atomic<LogCategory*> category_{nullptr};
+                    CategorySite* next_ = nullptr;     ///< Next registered site (guarded by Logger's level mutex)
+                    bool registered_ = false;
+
+                public:
+                    constexpr CategorySite(const char* name, LogLevel level) noexcept : name_(name), level_(level) {}
+
+                    CategorySite(const CategorySite&) = delete;
+                    CategorySite& operator=(const CategorySite&) = delete;
+
+                    bool enabled() {
+                        const uint8_t state = state_.load(std::memory_order_relaxed);
+                        if (state == kDisabled) {
+                            return false;
+                        }
+                        if (state == kEnabled) {
+                            return true;
+                        }
+                        return evaluate();
+                    }
+
+                    /**
+                     * @brief The site's category; valid once enabled() has returned true
+                     */
+                    const LogCategory& category() const {
+                        return *category_.load(std::memory_order_acquire); // Pairs with the store in Logger
+                    }
+
+                private:
+                    bool evaluate();
+                };
+
+            }
+
+            /**
+             * @brief Thread-safe logging utility class
+             *
+             * The Logger class provides methods for logging messages at different
+             * severity levels. All logging operations are thread-safe.
+             *
+             * Example usage:
+             * @code
+             * using namespace interlaced::core::logging;
+             * Logger::set_level(LOG_INFO);
+             * Logger::info("Application started");
+             * Logger::warning("This is a warning message");
+             * Logger::error("An error occurred");
+             * @endcode
+             *
+             * For more detailed logging with file and line information:
+             * @code
+             * LOG_INFO("Application started");
+             * LOG_WARNING("This is a warning message");
+             * LOG_ERROR("An error occurred");
+             * @endcode
+             *
+             * For structured logging with key-value pairs:
+             * @code
+             * Logger::info("User logged in", "user_id", 12345, "ip_address", "192.168.1.1");
+             * @endcode
+             *
+             * For file logging with rotation:
+             * @code
+             * Logger::set_file_logging("app.log", 10485760, 5); // 10MB max size, 5 files
+             * Logger::set_file_logging("app.log", std::chrono::hours(24), 7); // Daily rotation, 7 files
+             * @endcode
+             *
+             * For asynchronous logging on a background writer thread:
+             * @code
+             * Logger::set_async(8192, OverflowPolicy::DROP); // 8192 queued messages, drop when full
+             * Logger::flush();                               // Wait for queued messages to be written
+             * Logger::set_sync();                            // Drain and stop the writer thread
+             * @endcode
+             *
+             * For several destinations, each with its own level and formatter:
+             * @code
+             * SinkOptions console;
+             * console.level = LOG_WARNING;
+             * Logger::add_sink("console", std::make_shared<ConsoleSink>(), console);
+             * SinkOptions file;
+             * file.async = true;
+             * Logger::add_sink("file", std::make_shared<RotatingFileSink>("app.log"), file);
+             * @endcode
+             *
+             * For format strings parsed and checked at compile time:
+             * @code
+             * Logger::info(INTERLACED_FORMAT("User {} logged in from {}"), user, ip);
+             * @endcode
+             *
+             * For noisy call sites:
+             * @code
+             * LOG_WARNING_EVERY_N(100, "Retrying connection");   // 1st, 101st, 201st, ... call
+             * LOG_WARNING_RATE(5, "Downstream unavailable");     // At most 5 per second
+             * LOG_DEBUG_SAMPLED(1000, "Cache lookup");           // Randomly 1 in 1000
+             * Logger::set_duplicate_suppression(std::chrono::seconds(10));
+             * @endcode
+             *
+             * For binary logging with formatting deferred to the offline decoder:
+             * @code
+             * Logger::set_binary_logging("app.binlog");
+             * Logger::info("x={} y={}", x, y);               // Stores an ID, a timestamp and x, y
+             * Logger::disable_binary_logging();
+             * // interlaced_log_decode app.binlog > app.log
+             * @endcode
+             *
+             * For recent DEBUG context written out only when something goes wrong:
+             * @code
+             * Logger::enable_flight_recorder("app.flight");  // Records DEBUG, dumps on LOG_ERROR
+             * Logger::dump_flight_recorder();                // Or whenever the application asks
+             * @endcode
+             *
+             * For named categories whose levels are inherited from their parents:
+             * @code
+             * Logger::set_category_level("net", LOG_DEBUG);    // Also "net.http", "net.dns", ...
+             * LOG_CATEGORY_DEBUG("net.http", "Request sent");
+             * LOG_CATEGORY_DEBUG("fs", "Opened file");         // Follows the global level
+             * @endcode
+             *
+             * For the logger's own counters, queue depths and file write latencies:
+             * @code
+             * LoggerStats stats = Logger::stats();
+             * uint64_t dropped = stats.dropped[LOG_ERROR];
+             * uint64_t p99_ns = stats.file_write.percentile(99);
+             * @endcode
+             */
+            class Logger {
+            private:
+                static std::atomic<LogLevel> current_level; ///< Current minimum log level
+                static std::mutex log_mutex;             ///< Mutex for thread safety
+                static std::ostream* output_stream;      ///< Output stream for LOG_INFO and LOG_DEBUG messages
+                static std::ostream* error_stream;       ///< Output stream for LOG_WARNING and LOG_ERROR messages
+                static std::unique_ptr<LogFormatter> formatter; ///< Custom log formatter
+                static std::unique_ptr<RotatingFileLogger> file_logger; ///< File logger with rotation
+                // Producers increment a *_users counter and then load its pointer; retirers exchange the pointer and
+                // then wait for the counter to reach zero. Both sides must be seq_cst (store-load ordering).
+                static std::atomic<AsyncLogQueue*> async_queue; ///< Queue drained by the writer thread, null when synchronous
+                static std::atomic<int> async_users;     ///< Producers currently pushing into async_queue
+                static std::atomic<BinaryLogWriter*> binary_writer; ///< Binary sink, null when logging text
+                static std::atomic<int> binary_users;    ///< Producers currently using binary_writer
+                static std::mutex sink_config_mutex;     ///< Serializes changes to the sink list
+                static std::atomic<detail::SinkList*> sink_list; ///< Registered sinks, null when none are registered
+                static std::atomic<int> sink_users;      ///< Producers currently reading sink_list
+                static std::atomic<int64_t> duplicate_interval; ///< Summary interval in nanoseconds, negative when off
+                static std::atomic<LogLevel> enabled_level; ///< Lowest level written or recorded, checked by is_enabled()
+                static std::mutex level_mutex;           ///< Serializes changes to the levels and the flight recorder
+                static std::atomic<detail::FlightRecorder*> flight_recorder; ///< Flight recorder, null when off
+                static std::atomic<int> flight_users;    ///< Producers currently using flight_recorder
+                static std::unordered_map<std::string, std::unique_ptr<LogCategory>> categories; ///< Guarded by level_mutex
+                static detail::CategorySite* category_sites; ///< Call sites to reset on reconfiguration, guarded by level_mutex
+                static std::atomic<uint64_t> config_generation; ///< Bumped whenever a level or the flight recorder changes
+
+                friend class detail::CategorySite;
+
+            public:
+                /**
+                 * @brief Set the minimum log level
+                 *
+                 * Messages with a level lower than the current level will not be logged.
+                 *
+                 * @param level The minimum LogLevel to display
+                 */
+                static void set_level(LogLevel level) {
+                    std::lock_guard<std::mutex> lock(level_mutex);
+                    current_level.store(level, std::memory_order_relaxed);
+                    apply_levels();
+                }
+
+                /**
+                 * @brief Get the current minimum log level
+                 *
+                 * @return LogLevel The runtime minimum level
+                 */
+                static LogLevel get_level() {
+                    return current_level.load(std::memory_order_relaxed);
+                }
+
+                /**
+                 * @brief Get a named category, creating it and its ancestors on first use
+                 *
+                 * @param name Dotted category name such as "net.http"
+                 * @return The category; it lives until the process exits
+                 */
+                static LogCategory& category(const std::string& name) {
+                    std::lock_guard<std::mutex> lock(level_mutex);
+                    return find_category(name);
+                }
+
+                /**
+                 * @brief Set the minimum level of a category
+                 *
+                 * Descendants without a level of their own inherit it.
+                 *
+                 * @param name Dotted category name
+                 * @param level The minimum LogLevel to display
+                 */
+                static void set_category_level(const std::string& name, LogLevel level) {
+                    std::lock_guard<std::mutex> lock(level_mutex);
+                    LogCategory& category = find_category(name);
+                    category.has_level_ = true;
+                    category.own_level_ = level;
+                    apply_levels();
+                }
+
+                /**
+                 * @brief Make a category inherit its level again
+                 *
+                 * @param name Dotted category name
+                 */
+                static void clear_category_level(const std::string& name) {
+                    std::lock_guard<std::mutex> lock(level_mutex);
+                    find_category(name).has_level_ = false;
+                    apply_levels();
+                }
+
+                /**
+                 * @brief Suppress consecutive identical messages from the same thread
+                 *
+                 * The first message is written and its repeats are counted instead. A
+                 * "Last message repeated N times" line at the same level follows when
+                 * the thread logs a different message or calls flush(), and at least
+                 * every summary_interval while the repeats go on.
+                 *
+                 * @param summary_interval Longest time repeats go unreported
+                 */
+                static void set_duplicate_suppression(std::chrono::milliseconds summary_interval) {
+                    duplicate_interval.store(std::chrono::duration_cast<std::chrono::nanoseconds>(summary_interval).count(),
+                                             std::memory_order_relaxed);
+                }
+
+                /**
+                 * @brief Turn duplicate suppression off
+                 *
+                 * Repeats already counted are still reported by their thread.
+                 */
+                static void disable_duplicate_suppression() {
+                    duplicate_interval.store(-1, std::memory_order_relaxed);
+                }
+
+                /**
+                 * @brief Check whether a level survives the compile-time minimum level
+                 *
+                 * @param level The LogLevel to check
+                 * @return true if messages at this level are compiled in
+                 */
+                static constexpr bool compiled_in(LogLevel level) {
+                    return static_cast<int>(level) >= INTERLACED_CORE_MIN_LOG_LEVEL;
+                }
+
+                /**
+                 * @brief Check whether a message at the given level would be logged
+                 *
+                 * This is a single relaxed atomic load and never takes a lock.
+                 *
+                 * @param level The LogLevel to check
+                 * @return true if messages at this level are currently emitted or kept by the flight recorder
+                 */
+                static bool is_enabled(LogLevel level) {
+                    return compiled_in(level) && level >= enabled_level.load(std::memory_order_relaxed);
+                }
+
+                /**
+                 * @brief Set custom output streams for logging
+                 *
+                 * Allows redirection of log output to custom streams (e.g., files).
+                 *
+                 * @param output The output stream for LOG_INFO and LOG_DEBUG messages
+                 * @param error The output stream for LOG_WARNING and LOG_ERROR messages
+                 */
+                static void set_output_streams(std::ostream& output, std::ostream& error) {
+                    std::lock_guard<std::mutex> lock(log_mutex);
+                    output_stream = &output;
+                    error_stream = &error;
+                }
+
+                /**
+                 * @brief Set up file logging with size-based rotation
+                 *
+                 * @param filename The base filename for log files
+                 * @param max_file_size Maximum size of each log file (in bytes)
+                 * @param max_files Maximum number of log files to keep
+                 * @param flush_policy When buffered messages are written to the file
+                 */
+                static void set_file_logging(const std::string& filename, size_t max_file_size = 10485760, int max_files = 5,
+                                             const FlushPolicy& flush_policy = FlushPolicy()) {
+                    std::lock_guard<std::mutex> lock(log_mutex);
+                    file_logger.reset();
+                    file_logger = std::make_unique<RotatingFileLogger>(filename, max_file_size, max_files, flush_policy);
+                }
+
+                /**
+                 * @brief Set up file logging with time-based rotation
+                 *
+                 * @param filename The base filename for log files
+                 * @param rotation_hours Hours between log rotations
+                 * @param max_files Maximum number of log files to keep
+                 * @param flush_policy When buffered messages are written to the file
+                 */
+                static void set_file_logging(const std::string& filename, std::chrono::hours rotation_hours, int max_files = 5,
+                                             const FlushPolicy& flush_policy = FlushPolicy()) {
+                    std::lock_guard<std::mutex> lock(log_mutex);
+                    file_logger.reset();
+                    file_logger = std::make_unique<RotatingFileLogger>(filename, rotation_hours, max_files, flush_policy);
+                }
+
+                /**
+                 * @brief Change the flush policy of the current file logger
+                 *
+                 * @param flush_policy When buffered messages are written to the file
+                 */
+                static void set_flush_policy(const FlushPolicy& flush_policy) {
+                    std::lock_guard<std::mutex> lock(log_mutex);
+                    if (file_logger) {
+                        file_logger->set_flush_policy(flush_policy);
+                    }
+                }
+
+                /**
+                 * @brief Choose how the current file logger compresses rotated files
+                 *
+                 * @param compression LogCompression::LZ to compress rotated files in the background
+                 */
+                static void set_file_compression(LogCompression compression) {
+                    std::lock_guard<std::mutex> lock(log_mutex);
+                    if (file_logger) {
+                        file_logger->set_compression(compression);
+                    }
+                }
+
+                /**
+                 * @brief Let the current file logger write through io_uring or a writer thread
+                 *
+                 * @param options Number and size of the write buffers, and the backend
+                 */
+                static void enable_file_async_writes(const AsyncWriteOptions& options = AsyncWriteOptions()) {
+                    std::lock_guard<std::mutex> lock(log_mutex);
+                    if (file_logger) {
+                        file_logger->enable_async_writes(options);
+                    }
+                }
+
+                /**
+                 * @brief Let the current file logger write a sidecar index for LogSearcher
+                 *
+                 * @param block_size Bytes of log text per index entry
+                 */
+                static void enable_file_index(size_t block_size = 64 * 1024) {
+                    std::lock_guard<std::mutex> lock(log_mutex);
+                    if (file_logger) {
+                        file_logger->enable_index(block_size);
+                    }
+                }
+
+                /**
+                 * @brief Set a custom log formatter
+                 *
+                 * @param custom_formatter The custom formatter to use
+                 */
+                static void set_formatter(std::unique_ptr<LogFormatter> custom_formatter) {
+                    std::lock_guard<std::mutex> lock(log_mutex);
+                    formatter = std::move(custom_formatter);
+                }
+
+                /**
+                 * @brief Enable asynchronous logging
+                 *
+                 * Formatted messages are pushed into a bounded lock-free queue and written
+                 * by a dedicated background thread, so callers never wait on stream or file I/O.
+                 * Calling this again replaces the current queue after draining it.
+                 *
+                 * @param queue_capacity Maximum number of queued messages (rounded up to a power of two)
+                 * @param policy What to do when the queue is full
+                 */
+                static void set_async(size_t queue_capacity = 8192, OverflowPolicy policy = OverflowPolicy::BLOCK) {
+                    auto* queue = new AsyncLogQueue(queue_capacity, policy,
+                                                    [](LogLevel level, const std::string& message) {
+                                                        write_output(level, message);
+                                                    },
+                                                    []() {
+                                                        std::lock_guard<std::mutex> lock(log_mutex);
+                                                        if (file_logger) {
+                                                            file_logger->flush_if_due();
+                                                        }
+                                                    });
+                    retire_async_queue(async_queue.exchange(queue));
+                }
+
+                /**
+                 * @brief Disable asynchronous logging
+                 *
+                 * Drains every queued message and stops the writer thread. Subsequent
+                 * messages are written synchronously on the calling thread.
+                 */
+                static void set_sync() {
+                    retire_async_queue(async_queue.exchange(nullptr));
+                }
+
+                /**
+                 * @brief Check whether asynchronous logging is enabled
+                 *
+                 * @return true if messages are written by the background thread
+                 */
+                static bool is_async() {
+                    return async_queue.load() != nullptr;
+                }
+
+                /**
+                 * @brief Register a sink, replacing any sink with the same name
+                 *
+                 * While at least one sink is registered, messages go to the sinks instead
+                 * of the output streams and file logger. Each message is formatted once
+                 * per distinct formatter among the sinks that accept its level. Sinks
+                 * still only see messages that pass the Logger's own level.
+                 *
+                 * @param name Name used to look up, reconfigure or remove the sink
+                 * @param sink The sink
+                 * @param options Level, formatter and async settings for this sink
+                 */
+                static void add_sink(const std::string& name, std::shared_ptr<LogSink> sink,
+                                     const SinkOptions& options = SinkOptions()) {
+                    auto entry = std::make_shared<detail::SinkEntry>(name, std::move(sink), options);
+                    std::lock_guard<std::mutex> lock(sink_config_mutex);
+                    auto list = std::make_unique<detail::SinkList>();
+                    if (const detail::SinkList* current = sink_list.load()) {
+                        for (const auto& existing : *current) {
+                            if (existing->name != name) {
+                                list->push_back(existing);
+                            }
+                        }
+                    }
+                    list->push_back(std::move(entry));
+                    retire_sink_list(sink_list.exchange(list.release()));
+                }
+
+                /**
+                 * @brief Unregister a sink after writing its queued messages
+                 *
+                 * @param name The name the sink was registered under
+                 * @return true if a sink was removed
+                 */
+                static bool remove_sink(const std::string& name) {
+                    std::lock_guard<std::mutex> lock(sink_config_mutex);
+                    const detail::SinkList* current = sink_list.load();
+                    if (!current) {
+                        return false;
+                    }
+                    auto list = std::make_unique<detail::SinkList>();
+                    for (const auto& existing : *current) {
+                        if (existing->name != name) {
+                            list->push_back(existing);
+                        }
+                    }
+                    if (list->size() == current->size()) {
+                        return false;
+                    }
+                    retire_sink_list(sink_list.exchange(list->empty() ? nullptr : list.release()));
+                    return true;
+                }
+
+                /**
+                 * @brief Unregister every sink; messages go to the output streams or file logger again
+                 */
+                static void clear_sinks() {
+                    std::lock_guard<std::mutex> lock(sink_config_mutex);
+                    retire_sink_list(sink_list.exchange(nullptr));
+                }
+
+                /**
+                 * @brief Change the minimum level of a registered sink
+                 *
+                 * @param name The name the sink was registered under
+                 * @param level The new minimum level
+                 * @return true if the sink exists
+                 */
+                static bool set_sink_level(const std::string& name, LogLevel level) {
+                    std::lock_guard<std::mutex> lock(sink_config_mutex);
+                    if (const detail::SinkList* current = sink_list.load()) {
+                        for (const auto& entry : *current) {
+                            if (entry->name == name) {
+                                entry->level.store(level, std::memory_order_relaxed);
+                                return true;
+                            }
+                        }
+                    }
+                    return false;
+                }
+
+                /**
+                 * @brief Look up a registered sink
+                 *
+                 * @param name The name the sink was registered under
+                 * @return The sink, or null if no sink has that name
+                 */
+                static std::shared_ptr<LogSink> get_sink(const std::string& name) {
+                    std::lock_guard<std::mutex> lock(sink_config_mutex);
+                    if (const detail::SinkList* current = sink_list.load()) {
+                        for (const auto& entry : *current) {
+                            if (entry->name == name) {
+                                return entry->sink;
+                            }
+                        }
+                    }
+                    return nullptr;
+                }
+
+                /**
+                 * @brief Send every message to a binary log file instead of the text outputs
+                 *
+                 * "{}" format calls store the call-site ID, a timestamp and the raw
+                 * arguments; formatting happens later in BinaryLogReader or the
+                 * interlaced_log_decode tool. Other messages are stored as their text.
+                 * Calling this again replaces the current binary file after draining it.
+                 *
+                 * @param filename Path of the binary log file (appended to if it exists)
+                 * @param queue_capacity Maximum number of queued records (rounded up to a power of two)
+                 * @param policy What to do when the queue is full
+                 */
+                static void set_binary_logging(const std::string& filename, size_t queue_capacity = 65536,
+                                               OverflowPolicy policy = OverflowPolicy::BLOCK) {
+                    auto writer = std::make_unique<BinaryLogWriter>(filename, queue_capacity, policy);
+                    if (!writer->is_open()) {
+                        return;
+                    }
+                    retire_binary_writer(binary_writer.exchange(writer.release()));
+                }
+
+                /**
+                 * @brief Stop binary logging after writing every queued record
+                 *
+                 * Subsequent messages go to the file logger or output streams again.
+                 */
+                static void disable_binary_logging() {
+                    retire_binary_writer(binary_writer.exchange(nullptr));
+                }
+
+                /**
+                 * @brief Check whether messages are written to a binary log file
+                 *
+                 * @return true if binary logging is enabled
+                 */
+                static bool is_binary() {
+                    return binary_writer.load() != nullptr;
+                }
+
+                /**
+                 * @brief Keep every thread's recent messages in memory and write them out when needed
+                 *
+                 * Messages down to options.level are recorded even when get_level()
+                 * discards them; the outputs still only receive messages at get_level()
+                 * or above. "{}" format calls are recorded unformatted. The rings are
+                 * dumped to dump_file when a message at options.dump_level or above is
+                 * logged, on dump_flight_recorder() and, with
+                 * options.install_signal_handlers, on a fatal signal. Calling this again
+                 * replaces the current recorder and discards its records.
+                 *
+                 * @param dump_file Path the dumps are appended to
+                 * @param options Ring size, levels and signal handling
+                 */
+                static void enable_flight_recorder(const std::string& dump_file,
+                                                   const FlightRecorderOptions& options = FlightRecorderOptions()) {
+                    auto recorder = std::make_unique<detail::FlightRecorder>(dump_file, options.buffer_size, options.level,
+                                                                             options.dump_level);
+                    if (!recorder->is_open()) {
+                        return;
+                    }
+                    std::lock_guard<std::mutex> lock(level_mutex);
+                    retire_flight_recorder(flight_recorder.exchange(recorder.release()));
+                    apply_levels();
+                    if (options.install_signal_handlers) {
+                        install_flight_signal_handlers();
+                    }
+                }
+
+                /**
+                 * @brief Stop recording and discard the records that were not dumped
+                 */
+                static void disable_flight_recorder() {
+                    std::lock_guard<std::mutex> lock(level_mutex);
+                    retire_flight_recorder(flight_recorder.exchange(nullptr));
+                    apply_levels();
+                }
+
+                /**
+                 * @brief Write the flight recorder's records to its dump file now
+                 *
+                 * @param reason Text for the dump's header line
+                 * @return true if the recorder is enabled and the dump was written
+                 */
+                static bool dump_flight_recorder(const char* reason = "requested") {
+                    flight_users.fetch_add(1);
+                    detail::FlightRecorder* recorder = flight_recorder.load();
+                    const bool written = recorder && recorder->dump(reason);
+                    flight_users.fetch_sub(1);
+                    return written;
+                }
+
+                /**
+                 * @brief Wait until every message logged before this call has been written
+                 *
+                 * In asynchronous mode this is a barrier on the writer thread; the binary
+                 * file, the file logger's buffer and the output streams are flushed in all modes.
+                 */
+                static void flush() {
+                    detail::DuplicateState& duplicates = duplicate_state();
+                    if (duplicates.repeats > 0) {
+                        summarize_duplicates(duplicates);
+                    }
+
+                    async_users.fetch_add(1);
+                    if (AsyncLogQueue* queue = async_queue.load()) {
+                        queue->flush();
+                    }
+                    async_users.fetch_sub(1);
+
+                    binary_users.fetch_add(1);
+                    if (BinaryLogWriter* writer = binary_writer.load()) {
+                        writer->flush();
+                    }
+                    binary_users.fetch_sub(1);
+
+                    sink_users.fetch_add(1);
+                    if (const detail::SinkList* sinks = sink_list.load()) {
+                        for (const auto& entry : *sinks) {
+                            entry->flush();
+                        }
+                    }
+                    sink_users.fetch_sub(1);
+
+                    std::lock_guard<std::mutex> lock(log_mutex);
+                    if (file_logger) {
+                        file_logger->flush();
+                        file_logger->wait_for_writes();
+                    }
+                    try {
+                        output_stream->flush();
+                        error_stream->flush();
+                    } catch (...) {
+                        // Flushing is best effort
+                    }
+                }
+
+                /**
+                 * @brief Number of messages discarded by the current overflow policies
+                 *
+                 * @return Dropped message count across the async queue, the binary writer and async sinks
+                 */
+                static size_t dropped_messages() {
+                    async_users.fetch_add(1);
+                    AsyncLogQueue* queue = async_queue.load();
+                    size_t dropped = queue ? queue->dropped() : 0;
+                    async_users.fetch_sub(1);
+
+                    binary_users.fetch_add(1);
+                    if (BinaryLogWriter* writer = binary_writer.load()) {
+                        dropped += writer->dropped();
+                    }
+                    binary_users.fetch_sub(1);
+
+                    sink_users.fetch_add(1);
+                    if (const detail::SinkList* sinks = sink_list.load()) {
+                        for (const auto& entry : *sinks) {
+                            dropped += entry->queue ? entry->queue->dropped() : 0;
+                        }
+                    }
+                    sink_users.fetch_sub(1);
+                    return dropped;
+                }
+
+                /**
+                 * @brief Snapshot of the logger's own counters, histograms and queue depths
+                 *
+                 * Counting is per thread and costs a few plain stores per message; the
+                 * counts are summed here. Define INTERLACED_CORE_DISABLE_STATS to
+                 * compile the counting out.
+                 *
+                 * @return Counters since the process started, and the current sinks
+                 */
+                static LoggerStats stats() {
+                    LoggerStats result;
+                    detail::StatsRegistry::instance().collect(result);
+
+                    async_users.fetch_add(1);
+                    if (AsyncLogQueue* queue = async_queue.load()) {
+                        result.queue_depth = queue->depth();
+                        result.max_queue_depth = queue->max_depth();
+                    }
+                    async_users.fetch_sub(1);
+
+                    sink_users.fetch_add(1);
+                    if (const detail::SinkList* sinks = sink_list.load()) {
+                        for (const auto& entry : *sinks) {
+                            SinkStats sink;
+                            sink.name = entry->name;
+                            sink.messages = entry->messages.load(std::memory_order_relaxed);
+                            sink.bytes = entry->bytes.load(std::memory_order_relaxed);
+                            if (entry->queue) {
+                                sink.queue_depth = entry->queue->depth();
+                                sink.max_queue_depth = entry->queue->max_depth();
+                                sink.dropped = entry->queue->dropped();
+                            }
+                            result.sinks.push_back(std::move(sink));
+                        }
+                    }
+                    sink_users.fetch_sub(1);
+                    return result;
+                }
+
+                /**
+                 * @brief Log a message at the specified level
+                 *
+                 * @param level The LogLevel for this message
+                 * @param message The message to log
+                 */
+                static void log(LogLevel level, const std::string& message) {
+                    // Early exit if the message won't be logged
+                    if (!is_enabled(level)) {
+                        return;
+                    }
+
+                    write_record(level, message, nullptr, 0);
+                }
+
+                /**
+                 * @brief Log a message with file and line information
+                 *
+                 * @param level The LogLevel for this message
+                 * @param message The message to log
+                 * @param file The source file name (typically __FILE__)
+                 * @param line The source line number (typically __LINE__)
+                 */
+                static void log(LogLevel level, const std::string& message, const char* file, int line) {
+                    // Early exit if the message won't be logged
+                    if (!is_enabled(level)) {
+                        return;
+                    }
+
+                    write_record(level, message, file, line);
+                }
+
+                /**
+                 * @brief Write a message whose level the caller has already checked
+                 *
+                 * The LOG_* macros call this after Logger::is_enabled(), so the level
+                 * is not checked a second time.
+                 *
+                 * @param level The LogLevel for this message
+                 * @param message The message to write
+                 * @param file The source file name, or null
+                 * @param line The source line number, or 0
+                 * @param file_name The basename within file if already known, or null
+                 */
+                static void write(LogLevel level, std::string_view message, const char* file = nullptr, int line = 0,
+                                  const char* file_name = nullptr) {
+                    write_record(level, message, file, line, nullptr, 0, file_name);
+                }
+
+                /**
+                 * @brief Write a category's message whose level the caller has already checked
+                 *
+                 * The LOG_CATEGORY_* macros call this after the call site's cached check.
+                 *
+                 * @param category The category the message belongs to
+                 * @param level The LogLevel for this message
+                 * @param message The message to write
+                 * @param file The source file name, or null
+                 * @param line The source line number, or 0
+                 * @param file_name The basename within file if already known, or null
+                 */
+                static void write(const LogCategory& category, LogLevel level, std::string_view message,
+                                  const char* file = nullptr, int line = 0, const char* file_name = nullptr) {
+                    if (flight_recorder.load(std::memory_order_relaxed)) {
+                        record_flight_text(level, message, file, line, nullptr, 0, category.name());
+                    }
+                    if (level < category.level()) {
+                        return; // Only enabled for the flight recorder
+                    }
+                    deliver_record(level, message, file, line, nullptr, 0, category.name(), file_name);
+                }
+
+                /**
+                 * @brief Log a debug message
+                 *
+                 * @param message The debug message to log
+                 */
+                static void debug(const std::string& message) {
+                    if constexpr (compiled_in(LOG_DEBUG)) {
+                        log(LOG_DEBUG, message);
+                    }
+                }
+
+                /**
+                 * @brief Log a debug message with file and line information
+                 *
+                 * @param message The debug message to log
+                 * @param file The source file name (typically __FILE__)
+                 * @param line The source line number (typically __LINE__)
+                 */
+                static void debug(const std::string& message, const char* file, int line) {
+                    if constexpr (compiled_in(LOG_DEBUG)) {
+                        log(LOG_DEBUG, message, file, line);
+                    }
+                }
+
+                /**
+                 * @brief Log an informational message
+                 *
+                 * @param message The informational message to log
+                 */
+                static void info(const std::string& message) {
+                    if constexpr (compiled_in(LOG_INFO)) {
+                        log(LOG_INFO, message);
+                    }
+                }
+
+                /**
+                 * @brief Log an informational message with file and line information
+                 *
+                 * @param message The informational message to log
+                 * @param file The source file name (typically __FILE__)
+                 * @param line The source line number (typically __LINE__)
+                 */
+                static void info(const std::string& message, const char* file, int line) {
+                    if constexpr (compiled_in(LOG_INFO)) {
+                        log(LOG_INFO, message, file, line);
+                    }
+                }
+
+                /**
+                 * @brief Log a warning message
+                 *
+                 * @param message The warning message to log
+                 */
+                static void warning(const std::string& message) {
+                    if constexpr (compiled_in(LOG_WARNING)) {
+                        log(LOG_WARNING, message);
+                    }
+                }
+
+                /**
+                 * @brief Log a warning message with file and line information
+                 *
+                 * @param message The warning message to log
+                 * @param file The source file name (typically __FILE__)
+                 * @param line The source line number (typically __LINE__)
+                 */
+                static void warning(const std::string& message, const char* file, int line) {
+                    if constexpr (compiled_in(LOG_WARNING)) {
+                        log(LOG_WARNING, message, file, line);
+                    }
+                }
+
+                /**
+                 * @brief Log an error message
+                 *
+                 * @param message The error message to log
+                 */
+                static void error(const std::string& message) {
+                    if constexpr (compiled_in(LOG_ERROR)) {
+                        log(LOG_ERROR, message);
+                    }
+                }
+
+                /**
+                 * @brief Log an error message with file and line information
+                 *
+                 * @param message The error message to log
+                 * @param file The source file name (typically __FILE__)
+                 * @param line The source line number (typically __LINE__)
+                 */
+                static void error(const std::string& message, const char* file, int line) {
+                    if constexpr (compiled_in(LOG_ERROR)) {
+                        log(LOG_ERROR, message, file, line);
+                    }
+                }
+
+                // Structured logging with key-value pairs
+                /**
+                 * @brief Log a message with structured key-value pairs
+                 *
+                 * @tparam Args Variadic template arguments for key-value pairs
+                 * @param level The LogLevel for this message
+                 * @param message The message to log
+                 * @param args Key-value pairs to include in the log
+                 */
+                template<typename... Args>
+                static void log(LogLevel level, const std::string& message, Args&&... args) {
+                    // Early exit if the message won't be logged
+                    if (!is_enabled(level)) {
+                        return;
+                    }
+
+                    // Typed fields on the stack; only values without a native type are rendered
+                    LogField fields[sizeof...(Args) / 2];
+                    detail::ScratchBuffer storage;
+                    detail::make_fields(fields, storage.str(), args...);
+                    write_record(level, message, nullptr, 0, fields, sizeof...(Args) / 2);
+                }
+
+                /**
+                 * @brief Log a debug message with structured key-value pairs
+                 *
+                 * @tparam Args Variadic template arguments for key-value pairs
+                 * @param message The message to log
+                 * @param args Key-value pairs to include in the log
+                 */
+                template<typename... Args>
+                static void debug(const std::string& message, Args&&... args) {
+                    if constexpr (compiled_in(LOG_DEBUG)) {
+                        log(LOG_DEBUG, message, std::forward<Args>(args)...);
+                    }
+                }
+
+                /**
+                 * @brief Log an info message with structured key-value pairs
+                 *
+                 * @tparam Args Variadic template arguments for key-value pairs
+                 * @param message The message to log
+                 * @param args Key-value pairs to include in the log
+                 */
+                template<typename... Args>
+                static void info(const std::string& message, Args&&... args) {
+                    if constexpr (compiled_in(LOG_INFO)) {
+                        log(LOG_INFO, message, std::forward<Args>(args)...);
+                    }
+                }
+
+                /**
+                 * @brief Log a warning message with structured key-value pairs
+                 *
+                 * @tparam Args Variadic template arguments for key-value pairs
+                 * @param message The message to log
+                 * @param args Key-value pairs to include in the log
+                 */
+                template<typename... Args>
+                static void warning(const std::string& message, Args&&... args) {
+                    if constexpr (compiled_in(LOG_WARNING)) {
+                        log(LOG_WARNING, message, std::forward<Args>(args)...);
+                    }
+                }
+
+                /**
+                 * @brief Log an error message with structured key-value pairs
+                 *
+                 * @tparam Args Variadic template arguments for key-value pairs
+                 * @param message The message to log
+                 * @param args Key-value pairs to include in the log
+                 */
+                template<typename... Args>
+                static void error(const std::string& message, Args&&... args) {
+                    if constexpr (compiled_in(LOG_ERROR)) {
+                        log(LOG_ERROR, message, std::forward<Args>(args)...);
+                    }
+                }
+
+                // Variadic template functions for type-safe logging
+                /**
+                 * @brief Log a debug message with type-safe formatting
+                 *
+                 * String literals are identified by address in the binary log; other
+                 * C strings, such as std::string::c_str(), by their text.
+                 *
+                 * @tparam Format A string literal, char array or char pointer
+                 * @tparam Args Variadic template arguments
+                 * @param format The format string
+                 * @param args Arguments to format
+                 */
+                template<typename Format, typename... Args,
+                         typename = std::enable_if_t<detail::is_c_string_format_v<Format>>>
+                static void debug(Format&& format, Args&&... args) {
+                    if constexpr (compiled_in(LOG_DEBUG)) {
+                        if (!is_enabled(LOG_DEBUG)) {
+                            return;
+                        }
+                        const char* const text = format;
+                        if (flight_recorder.load(std::memory_order_relaxed) && record_flight(LOG_DEBUG, text, args...)) {
+                            return;
+                        }
+                        if (log_binary<!detail::is_literal_format_v<Format>>(LOG_DEBUG, text, args...)) {
+                            return;
+                        }
+                        detail::ScratchBuffer buffer;
+                        format_message_to(buffer.str(), text, std::forward<Args>(args)...);
+                        deliver_record(LOG_DEBUG, buffer.str(), nullptr, 0);
+                    }
+                }
+
+                /**
+                 * @brief Log an info message with type-safe formatting
                  *
-                 * @param level The minimum LogLevel to display
+                 * String literals are identified by address in the binary log; other
+                 * C strings, such as std::string::c_str(), by their text.
+                 *
+                 * @tparam Format A string literal, char array or char pointer
+                 * @tparam Args Variadic template arguments
+                 * @param format The format string
+                 * @param args Arguments to format
                  */
-                static void set_level(LogLevel level) {
-                    std::lock_guard<std::mutex> lock(log_mutex);
-                    current_level = level;
+                template<typename Format, typename... Args,
+                         typename = std::enable_if_t<detail::is_c_string_format_v<Format>>>
+                static void info(Format&& format, Args&&... args) {
+                    if constexpr (compiled_in(LOG_INFO)) {
+                        if (!is_enabled(LOG_INFO)) {
+                            return;
+                        }
+                        const char* const text = format;
+                        if (flight_recorder.load(std::memory_order_relaxed) && record_flight(LOG_INFO, text, args...)) {
+                            return;
+                        }
+                        if (log_binary<!detail::is_literal_format_v<Format>>(LOG_INFO, text, args...)) {
+                            return;
+                        }
+                        detail::ScratchBuffer buffer;
+                        format_message_to(buffer.str(), text, std::forward<Args>(args)...);
+                        deliver_record(LOG_INFO, buffer.str(), nullptr, 0);
+                    }
                 }
 
                 /**
-                 * @brief Set custom output streams for logging
+                 * @brief Log a warning message with type-safe formatting
                  *
-                 * Allows redirection of log output to custom streams (e.g., files).
+                 * String literals are identified by address in the binary log; other
+                 * C strings, such as std::string::c_str(), by their text.
                  *
-                 * @param output The output stream for LOG_INFO and LOG_DEBUG messages
-                 * @param error The output stream for LOG_WARNING and LOG_ERROR messages
+                 * @tparam Format A string literal, char array or char pointer
+                 * @tparam Args Variadic template arguments
+                 * @param format The format string
+                 * @param args Arguments to format
                  */
-                static void set_output_streams(std::ostream& output, std::ostream& error) {
-                    std::lock_guard<std::mutex> lock(log_mutex);
-                    output_stream = &output;
-                    error_stream = &error;
+                template<typename Format, typename... Args,
+                         typename = std::enable_if_t<detail::is_c_string_format_v<Format>>>
+                static void warning(Format&& format, Args&&... args) {
+                    if constexpr (compiled_in(LOG_WARNING)) {
+                        if (!is_enabled(LOG_WARNING)) {
+                            return;
+                        }
+                        const char* const text = format;
+                        if (flight_recorder.load(std::memory_order_relaxed) && record_flight(LOG_WARNING, text, args...)) {
+                            return;
+                        }
+                        if (log_binary<!detail::is_literal_format_v<Format>>(LOG_WARNING, text, args...)) {
+                            return;
+                        }
+                        detail::ScratchBuffer buffer;
+                        format_message_to(buffer.str(), text, std::forward<Args>(args)...);
+                        deliver_record(LOG_WARNING, buffer.str(), nullptr, 0);
+                    }
                 }
 
                 /**
-                 * @brief Set up file logging with size-based rotation
+                 * @brief Log an error message with type-safe formatting
                  *
-                 * @param filename The base filename for log files
-                 * @param max_file_size Maximum size of each log file (in bytes)
-                 * @param max_files Maximum number of log files to keep
+                 * String literals are identified by address in the binary log; other
+                 * C strings, such as std::string::c_str(), by their text.
+                 *
+                 * @tparam Format A string literal, char array or char pointer
+                 * @tparam Args Variadic template arguments
+                 * @param format The format string
+                 * @param args Arguments to format
                  */
-                static void set_file_logging(const std::string& filename, size_t max_file_size = 10485760, int max_files = 5) {
-                    std::lock_guard<std::mutex> lock(log_mutex);
-                    file_logger = std::make_unique<RotatingFileLogger>(filename, max_file_size, max_files);
+                template<typename Format, typename... Args,
+                         typename = std::enable_if_t<detail::is_c_string_format_v<Format>>>
+                static void error(Format&& format, Args&&... args) {
+                    if constexpr (compiled_in(LOG_ERROR)) {
+                        if (!is_enabled(LOG_ERROR)) {
+                            return;
+                        }
+                        const char* const text = format;
+                        if (flight_recorder.load(std::memory_order_relaxed) && record_flight(LOG_ERROR, text, args...)) {
+                            return;
+                        }
+                        if (log_binary<!detail::is_literal_format_v<Format>>(LOG_ERROR, text, args...)) {
+                            return;
+                        }
+                        detail::ScratchBuffer buffer;
+                        format_message_to(buffer.str(), text, std::forward<Args>(args)...);
+                        deliver_record(LOG_ERROR, buffer.str(), nullptr, 0);
+                    }
                 }
 
                 /**
-                 * @brief Set up file logging with time-based rotation
+                 * @brief Log a debug message with a format string checked at compile time
                  *
-                 * @param filename The base filename for log files
-                 * @param rotation_hours Hours between log rotations
-                 * @param max_files Maximum number of log files to keep
+                 * @tparam Format Format string type created by INTERLACED_FORMAT
+                 * @tparam Args Variadic template arguments, one per "{}" placeholder
+                 * @param format The format string
+                 * @param args Arguments to format
                  */
-                static void set_file_logging(const std::string& filename, std::chrono::hours rotation_hours, int max_files = 5) {
-                    std::lock_guard<std::mutex> lock(log_mutex);
-                    file_logger = std::make_unique<RotatingFileLogger>(filename, rotation_hours, max_files);
+                template<typename Format, typename... Args,
+                         typename = std::enable_if_t<detail::is_compile_time_format_v<Format>>>
+                static void debug(Format format, Args&&... args) {
+                    if constexpr (compiled_in(LOG_DEBUG)) {
+                        log_compiled(LOG_DEBUG, format, std::forward<Args>(args)...);
+                    }
                 }
 
                 /**
-                 * @brief Set a custom log formatter
+                 * @brief Log an info message with a format string checked at compile time
                  *
-                 * @param custom_formatter The custom formatter to use
+                 * @tparam Format Format string type created by INTERLACED_FORMAT
+                 * @tparam Args Variadic template arguments, one per "{}" placeholder
+                 * @param format The format string
+                 * @param args Arguments to format
                  */
-                static void set_formatter(std::unique_ptr<LogFormatter> custom_formatter) {
-                    std::lock_guard<std::mutex> lock(log_mutex);
-                    formatter = std::move(custom_formatter);
+                template<typename Format, typename... Args,
+                         typename = std::enable_if_t<detail::is_compile_time_format_v<Format>>>
+                static void info(Format format, Args&&... args) {
+                    if constexpr (compiled_in(LOG_INFO)) {
+                        log_compiled(LOG_INFO, format, std::forward<Args>(args)...);
+                    }
                 }
 
                 /**
-                 * @brief Log a message at the specified level
+                 * @brief Log a warning message with a format string checked at compile time
                  *
-                 * @param level The LogLevel for this message
-                 * @param message The message to log
+                 * @tparam Format Format string type created by INTERLACED_FORMAT
+                 * @tparam Args Variadic template arguments, one per "{}" placeholder
+                 * @param format The format string
+                 * @param args Arguments to format
                  */
-                static void log(LogLevel level, const std::string& message) {
-                    // Early exit if the message won't be logged
-                    {
-                        std::lock_guard<std::mutex> lock(log_mutex);
-                        if (level < current_level) {
-                            return;
-                        }
+                template<typename Format, typename... Args,
+                         typename = std::enable_if_t<detail::is_compile_time_format_v<Format>>>
+                static void warning(Format format, Args&&... args) {
+                    if constexpr (compiled_in(LOG_WARNING)) {
+                        log_compiled(LOG_WARNING, format, std::forward<Args>(args)...);
                     }
+                }
 
-                    // Format the message outside the critical section
-                    const auto now = std::chrono::system_clock::now();
-                    const std::time_t now_time_t = std::chrono::system_clock::to_time_t(now);
+                /**
+                 * @brief Log an error message with a format string checked at compile time
+                 *
+                 * @tparam Format Format string type created by INTERLACED_FORMAT
+                 * @tparam Args Variadic template arguments, one per "{}" placeholder
+                 * @param format The format string
+                 * @param args Arguments to format
+                 */
+                template<typename Format, typename... Args,
+                         typename = std::enable_if_t<detail::is_compile_time_format_v<Format>>>
+                static void error(Format format, Args&&... args) {
+                    if constexpr (compiled_in(LOG_ERROR)) {
+                        log_compiled(LOG_ERROR, format, std::forward<Args>(args)...);
+                    }
+                }
 
-                    // Convert to tm struct in a thread-safe way
-                    std::tm local_tm;
-                    localtime_threadsafe(&now_time_t, &local_tm);
+                /**
+                 * @brief Format a message with variadic arguments
+                 *
+                 * @tparam Args Variadic template arguments
+                 * @param oss The output string stream
+                 * @param format The format string
+                 * @param args Arguments to format
+                 */
+                template<typename... Args>
+                static void format_message(std::ostringstream& oss, const char* format, Args&&... args) {
+                    format_helper(oss, format, std::forward<Args>(args)...);
+                }
 
-                    std::string formatted_message;
+                /**
+                 * @brief Format a message with variadic arguments by appending to a string
+                 *
+                 * Produces the same text as format_message() without a string stream,
+                 * so no allocation happens once out has enough capacity.
+                 *
+                 * @tparam Args Variadic template arguments
+                 * @param out The string to append to
+                 * @param format The format string
+                 * @param args Arguments to format
+                 */
+                template<typename... Args>
+                static void format_message_to(std::string& out, const char* format, Args&&... args) {
+                    append_formatted(out, format, std::forward<Args>(args)...);
+                }
 
-                    // Use custom formatter if available
-                    if (formatter) {
-                        formatted_message = formatter->format(level, message, local_tm);
-                    } else {
-                        std::ostringstream oss;
-                        oss << "[" << std::put_time(&local_tm, "%Y-%m-%d %H:%M:%S")
-                            << "] [" << log_level_to_string(level) << "] "
-                            << message;
-                        formatted_message = oss.str();
-                    }
+                /**
+                 * @brief Format a message using a format string parsed at compile time
+                 *
+                 * The literal segments and placeholder positions are computed during
+                 * compilation, and a placeholder/argument count mismatch is a compile
+                 * error. Each literal segment is appended in a single call.
+                 *
+                 * @tparam Format Format string type created by INTERLACED_FORMAT
+                 * @tparam Args Variadic template arguments, one per "{}" placeholder
+                 * @param out The string to append to
+                 * @param format The format string
+                 * @param args Arguments to format
+                 */
+                template<typename Format, typename... Args,
+                         typename = std::enable_if_t<detail::is_compile_time_format_v<Format>>>
+                static void format_message_to(std::string& out, Format format, Args&&... args) {
+                    (void)format;
+                    constexpr std::string_view text = Format{};
+                    constexpr size_t placeholders = detail::count_placeholders(text);
+                    static_assert(placeholders == sizeof...(Args),
+                                  "Number of arguments does not match the number of {} placeholders in the format string");
+                    constexpr detail::ParsedFormat<placeholders> parsed = detail::parse_format<placeholders>(text);
 
-                    // Output the message (critical section only for output)
-                    std::lock_guard<std::mutex> lock(log_mutex);
-                    if (file_logger) {
-                        file_logger->write(formatted_message);
-                    } else {
-                        try {
-                            // Choose output stream based on log level
-                            std::ostream& out_stream = (level == LOG_ERROR) ? *error_stream : *output_stream;
-                            out_stream << formatted_message << std::endl;
+                    size_t segment = 0;
+                    ((out.append(text.data() + parsed.offsets[segment], parsed.lengths[segment]),
+                      detail::append_value(out, args),
+                      ++segment), ...);
+                    (void)segment;
+                    out.append(text.data() + parsed.offsets[placeholders], parsed.lengths[placeholders]);
+                }
 
-                            // Check if the stream is in a good state
-                            if (!out_stream.good()) {
-                                // If the stream is not good, try to reset it
-                                out_stream.clear();
-                            }
-                        } catch (const std::exception& e) {
-                            // If we can't write to the stream, try to write to cerr as a fallback
-                            std::cerr << "Logging error: " << e.what() << std::endl;
-                            std::cerr << formatted_message << std::endl;
-                        } catch (...) {
-                            // If we can't write to the stream, try to write to cerr as a fallback
-                            std::cerr << "Unknown logging error occurred" << std::endl;
-                            std::cerr << formatted_message << std::endl;
-                        }
-                    }
+            private:
+                /**
+                 * @brief Formatter used when no custom formatter is set
+                 */
+                static LogFormatter& default_formatter() {
+                    static DefaultLogFormatter instance;
+                    return instance;
                 }
 
                 /**
-                 * @brief Log a message with file and line information
+                 * @brief Format a message into a reusable per-thread buffer and dispatch it
                  *
                  * @param level The LogLevel for this message
-                 * @param message The message to log
-                 * @param file The source file name (typically __FILE__)
-                 * @param line The source line number (typically __LINE__)
+                 * @param message The message text
+                 * @param file The source file name, or null
+                 * @param line The source line number, or 0
+                 * @param fields Structured fields, or null
+                 * @param field_count Number of fields
+                 * @param file_name The basename within file if already known, or null
                  */
-                static void log(LogLevel level, const std::string& message, const char* file, int line) {
-                    // Early exit if the message won't be logged
-                    {
-                        std::lock_guard<std::mutex> lock(log_mutex);
-                        if (level < current_level) {
+                static void write_record(LogLevel level, std::string_view message, const char* file, int line,
+                                         const LogField* fields = nullptr, size_t field_count = 0,
+                                         const char* file_name = nullptr) {
+                    if (flight_recorder.load(std::memory_order_relaxed) &&
+                        record_flight_text(level, message, file, line, fields, field_count)) {
+                        return;
+                    }
+                    deliver_record(level, message, file, line, fields, field_count, std::string_view(), file_name);
+                }
+
+                /**
+                 * @brief Apply duplicate suppression, then emit the message
+                 */
+                static void deliver_record(LogLevel level, std::string_view message, const char* file, int line,
+                                           const LogField* fields = nullptr, size_t field_count = 0,
+                                           std::string_view category = std::string_view(),
+                                           const char* file_name = nullptr) {
+                    const int64_t interval = duplicate_interval.load(std::memory_order_relaxed);
+                    if (interval >= 0) {
+                        // Fields are part of what makes a message a repeat
+                        detail::ScratchBuffer text;
+                        if (field_count > 0) {
+                            text.str().append(message.data(), message.size());
+                            detail::append_fields(text.str(), fields, field_count);
+                        }
+                        if (suppress_duplicate(level, field_count > 0 ? std::string_view(text.str()) : message, file, line,
+                                               file_name, category, std::chrono::nanoseconds(interval))) {
                             return;
                         }
                     }
+                    emit_record(level, message, file, line, fields, field_count, category, file_name);
+                }
 
-                    // Format the message outside the critical section
-                    const auto now = std::chrono::system_clock::now();
-                    const std::time_t now_time_t = std::chrono::system_clock::to_time_t(now);
+                /**
+                 * @brief Give a message to the flight recorder, dumping it for severe messages
+                 *
+                 * @return true if the message is below the output level and needs nothing else
+                 */
+                static bool record_flight_text(LogLevel level, std::string_view message, const char* file, int line,
+                                               const LogField* fields, size_t field_count,
+                                               std::string_view category = std::string_view()) {
+                    flight_users.fetch_add(1);
+                    if (detail::FlightRecorder* recorder = flight_recorder.load()) {
+                        if (level >= recorder->level()) {
+                            recorder->record_text(level, message, fields, field_count, file, line, category);
+                        }
+                        if (level >= recorder->dump_level()) {
+                            recorder->dump(log_level_to_string(level));
+                        }
+                    }
+                    flight_users.fetch_sub(1, std::memory_order_release);
+                    return level < current_level.load(std::memory_order_relaxed);
+                }
 
-                    // Convert to tm struct in a thread-safe way
-                    std::tm local_tm;
-                    localtime_threadsafe(&now_time_t, &local_tm);
+                /**
+                 * @brief Give a "{}" format call to the flight recorder without formatting it
+                 *
+                 * @return true if the message is below the output level and needs nothing else
+                 */
+                template<typename... Args>
+                static bool record_flight(LogLevel level, const char* format, const Args&... args) {
+                    flight_users.fetch_add(1);
+                    if (detail::FlightRecorder* recorder = flight_recorder.load()) {
+                        if (level >= recorder->level()) {
+                            recorder->record_format(level, format, nullptr, 0, args...);
+                        }
+                        if (level >= recorder->dump_level()) {
+                            recorder->dump(log_level_to_string(level));
+                        }
+                    }
+                    flight_users.fetch_sub(1, std::memory_order_release);
+                    return level < current_level.load(std::memory_order_relaxed);
+                }
 
-                    std::string formatted_message;
+                /**
+                 * @brief Recompute enabled_level and every category's levels; the caller holds level_mutex
+                 *
+                 * Afterwards the call-site caches are invalidated: the generation is
+                 * bumped first, so a site evaluated concurrently notices the change.
+                 */
+                static void apply_levels() {
+                    const LogLevel global = current_level.load(std::memory_order_relaxed);
+                    const detail::FlightRecorder* recorder = flight_recorder.load();
+                    const LogLevel recorded = recorder ? recorder->level() : global;
+                    enabled_level.store(std::min(global, recorded), std::memory_order_relaxed);
 
-                    // Use custom formatter if available
-                    if (formatter) {
-                        formatted_message = formatter->format(level, message, local_tm, file, line);
-                    } else {
-                        // Extract just the filename from the full path
-                        const char* filename = file;
-                        for (const char* p = file; *p; ++p) {
-                            if (*p == '/' || *p == '\\') {
-                                filename = p + 1;
-                            }
+                    for (const auto& entry : categories) {
+                        LogCategory& category = *entry.second;
+                        const LogCategory* source = &category;
+                        while (source && !source->has_level_) {
+                            source = source->parent_;
                         }
+                        const LogLevel level = source ? source->own_level_ : global;
+                        category.level_.store(level, std::memory_order_relaxed);
+                        category.enabled_level_.store(recorder ? std::min(level, recorded) : level,
+                                                      std::memory_order_relaxed);
+                    }
 
-                        // Format the message with file and line information
-                        std::ostringstream oss;
-                        oss << "[" << std::put_time(&local_tm, "%Y-%m-%d %H:%M:%S")
-                            << "] [" << log_level_to_string(level) << "] "
-                            << message << " (" << filename << ":" << line << ")";
-                        formatted_message = oss.str();
+                    config_generation.fetch_add(1);
+                    for (detail::CategorySite* site = category_sites; site; site = site->next_) {
+                        site->state_.store(detail::CategorySite::kUnknown);
                     }
+                }
 
-                    // Output the message (critical section only for output)
-                    std::lock_guard<std::mutex> lock(log_mutex);
-                    if (file_logger) {
-                        file_logger->write(formatted_message);
-                    } else {
-                        try {
-                            // Choose output stream based on log level
-                            std::ostream& out_stream = (level == LOG_ERROR) ? *error_stream : *output_stream;
-                            out_stream << formatted_message << std::endl;
+                /**
+                 * @brief Look up a category, creating it and its ancestors; the caller holds level_mutex
+                 */
+                static LogCategory& find_category(const std::string& name) {
+                    auto found = categories.find(name);
+                    if (found != categories.end()) {
+                        return *found->second;
+                    }
+                    const size_t dot = name.rfind('.');
+                    LogCategory* parent = dot == std::string::npos ? nullptr : &find_category(name.substr(0, dot));
+                    std::unique_ptr<LogCategory> category(new LogCategory(name, parent));
+                    LogCategory& created = *category;
+                    // A new category has no level of its own, so it starts out like its parent
+                    created.level_.store(parent ? parent->level() : current_level.load(std::memory_order_relaxed),
+                                         std::memory_order_relaxed);
+                    created.enabled_level_.store(parent ? parent->enabled_level_.load(std::memory_order_relaxed)
+                                                        : enabled_level.load(std::memory_order_relaxed),
+                                                 std::memory_order_relaxed);
+                    categories.emplace(name, std::move(category));
+                    return created;
+                }
 
-                            // Check if the stream is in a good state
-                            if (!out_stream.good()) {
-                                // If the stream is not good, try to reset it
-                                out_stream.clear();
-                            }
-                        } catch (const std::exception& e) {
-                            // If we can't write to the stream, try to write to cerr as a fallback
-                            std::cerr << "Logging error: " << e.what() << std::endl;
-                            std::cerr << formatted_message << std::endl;
-                        } catch (...) {
-                            // If we can't write to the stream, try to write to cerr as a fallback
-                            std::cerr << "Unknown logging error occurred" << std::endl;
-                            std::cerr << formatted_message << std::endl;
+                /**
+                 * @brief Resolve a call site's category and cache whether its level is enabled
+                 */
+                static bool evaluate_site(detail::CategorySite& site) {
+                    const uint64_t generation = config_generation.load();
+                    LogCategory* category = site.category_.load(std::memory_order_acquire);
+                    if (!category) {
+                        std::lock_guard<std::mutex> lock(level_mutex);
+                        LogCategory& found = find_category(site.name_);
+                        if (!site.registered_) {
+                            site.registered_ = true;
+                            site.next_ = category_sites;
+                            category_sites = &site;
                         }
+                        category = &found;
+                        site.category_.store(category, std::memory_order_release);
                     }
+                    const bool enabled = category->is_enabled(site.level_);
+                    site.state_.store(enabled ? detail::CategorySite::kEnabled : detail::CategorySite::kDisabled);
+                    if (config_generation.load() != generation) {
+                        site.state_.store(detail::CategorySite::kUnknown); // Reconfigured meanwhile; evaluate again next time
+                    }
+                    return enabled;
                 }
 
                 /**
-                 * @brief Log a debug message
+                 * @brief Dump the flight recorder on fatal signals, then hand the signal on
                  *
-                 * @param message The debug message to log
+                 * Installed once; the previous handlers are restored before the signal
+                 * is raised again, so core dumps and other handlers still happen.
                  */
-                static void debug(const std::string& message) {
-                    log(LOG_DEBUG, message);
+                static void install_flight_signal_handlers() {
+                    static bool installed = false;
+                    if (installed) {
+                        return;
+                    }
+                    installed = true;
+                    for (int signal_number : fatal_signals()) {
+                        if (signal_number != 0) {
+                            previous_signal_handler(signal_number) = std::signal(signal_number, &flight_signal_handler);
+                        }
+                    }
+                }
+
+                static const std::array<int, 5>& fatal_signals() {
+#ifdef SIGBUS
+                    static const std::array<int, 5> signals = {SIGSEGV, SIGABRT, SIGBUS, SIGFPE, SIGILL};
+#else
+                    static const std::array<int, 5> signals = {SIGSEGV, SIGABRT, 0, SIGFPE, SIGILL};
+#endif
+                    return signals;
+                }
+
+                using SignalHandler = void (*)(int);
+
+                static SignalHandler& previous_signal_handler(int signal_number) {
+                    static SignalHandler handlers[5] = {SIG_DFL, SIG_DFL, SIG_DFL, SIG_DFL, SIG_DFL};
+                    const auto& signals = fatal_signals();
+                    const size_t index = static_cast<size_t>(std::find(signals.begin(), signals.end(), signal_number) -
+                                                             signals.begin());
+                    return handlers[index < signals.size() ? index : 0];
+                }
+
+                static void flight_signal_handler(int signal_number) {
+                    flight_users.fetch_add(1);
+                    if (detail::FlightRecorder* recorder = flight_recorder.load()) {
+                        recorder->dump("fatal signal", true);
+                    }
+                    flight_users.fetch_sub(1);
+
+                    SignalHandler previous = previous_signal_handler(signal_number);
+                    std::signal(signal_number, previous == SIG_ERR ? SIG_DFL : previous);
+                    std::raise(signal_number);
+                }
+
+                static detail::DuplicateState& duplicate_state() {
+                    thread_local detail::DuplicateState state;
+                    return state;
                 }
 
                 /**
-                 * @brief Log a debug message with file and line information
+                 * @brief Count a message if it repeats the thread's previous one
                  *
-                 * @param message The debug message to log
-                 * @param file The source file name (typically __FILE__)
-                 * @param line The source line number (typically __LINE__)
+                 * @return true if the message was suppressed
                  */
-                static void debug(const std::string& message, const char* file, int line) {
-                    log(LOG_DEBUG, message, file, line);
+                static bool suppress_duplicate(LogLevel level, std::string_view message, const char* file, int line,
+                                               const char* file_name, std::string_view category,
+                                               std::chrono::nanoseconds summary_interval) {
+                    detail::DuplicateState& state = duplicate_state();
+                    if (state.has_last && state.level == level && state.category.data() == category.data() &&
+                        state.message == message) {
+                        const auto now = std::chrono::steady_clock::now();
+                        detail::count_stat(detail::kStatSuppressed, level);
+                        if (state.repeats++ == 0) {
+                            state.first_repeat = now;
+                        } else if (now - state.first_repeat >= summary_interval) {
+                            summarize_duplicates(state);
+                        }
+                        return true;
+                    }
+                    if (state.repeats > 0) {
+                        summarize_duplicates(state);
+                    }
+                    state.has_last = true;
+                    state.level = level;
+                    state.category = category;
+                    state.message.assign(message.data(), message.size());
+                    state.file = file;
+                    state.file_name = file_name;
+                    state.line = line;
+                    return false;
                 }
 
                 /**
-                 * @brief Log an informational message
-                 *
-                 * @param message The informational message to log
+                 * @brief Write the "repeated N times" line for the suppressed copies of a message
                  */
-                static void info(const std::string& message) {
-                    log(LOG_INFO, message);
+                static void summarize_duplicates(detail::DuplicateState& state) {
+                    detail::ScratchBuffer summary;
+                    summary.str().append("Last message repeated ");
+                    detail::append_value(summary.str(), state.repeats);
+                    summary.str().append(state.repeats == 1 ? " time" : " times");
+                    state.repeats = 0;
+                    emit_record(state.level, summary.str(), state.file, state.line, nullptr, 0, state.category,
+                                state.file_name);
                 }
 
                 /**
-                 * @brief Log an informational message with file and line information
-                 *
-                 * @param message The informational message to log
-                 * @param file The source file name (typically __FILE__)
-                 * @param line The source line number (typically __LINE__)
+                 * @brief Route a message to the binary writer, the sinks or the legacy outputs
                  */
-                static void info(const std::string& message, const char* file, int line) {
-                    log(LOG_INFO, message, file, line);
-                }
+                static void emit_record(LogLevel level, std::string_view message, const char* file, int line,
+                                        const LogField* fields = nullptr, size_t field_count = 0,
+                                        std::string_view category = std::string_view(),
+                                        const char* file_name = nullptr) {
+                    detail::count_stat(detail::kStatEmitted, level);
+                    if (binary_writer.load(std::memory_order_relaxed)) {
+                        binary_users.fetch_add(1);
+                        BinaryLogWriter* writer = binary_writer.load();
+                        if (writer && (field_count > 0 || !category.empty())) {
+                            // Binary records carry text only
+                            detail::ScratchBuffer text;
+                            detail::append_category(text.str(), category);
+                            text.str().append(message.data(), message.size());
+                            detail::append_fields(text.str(), fields, field_count);
+                            writer->log_text(level, text.str(), file, line);
+                        } else if (writer) {
+                            writer->log_text(level, message, file, line);
+                        }
+                        binary_users.fetch_sub(1, std::memory_order_release);
+                        if (writer) {
+                            return;
+                        }
+                    }
+
+                    LogRecord record;
+                    record.level = level;
+                    record.message = message;
+                    record.time = std::chrono::system_clock::now();
+                    record.file = file;
+                    record.file_name = file ? file_name : nullptr;
+                    record.line = line;
+                    record.fields = fields;
+                    record.field_count = field_count;
+                    record.category = category;
+
+                    if (sink_list.load(std::memory_order_relaxed)) {
+                        sink_users.fetch_add(1);
+                        const detail::SinkList* sinks = sink_list.load();
+                        if (sinks) {
+                            fan_out(*sinks, record);
+                        }
+                        sink_users.fetch_sub(1, std::memory_order_release);
+                        if (sinks) {
+                            return;
+                        }
+                    }
 
-                /**
-                 * @brief Log a warning message
-                 *
-                 * @param message The warning message to log
-                 */
-                static void warning(const std::string& message) {
-                    log(LOG_WARNING, message);
+                    detail::ScratchBuffer formatted;
+                    LogFormatter& active = formatter ? *formatter : default_formatter();
+                    active.format_to(formatted.str(), record);
+                    dispatch(level, formatted.str());
                 }
 
                 /**
-                 * @brief Log a warning message with file and line information
+                 * @brief Format a record once per distinct formatter and hand it to every interested sink
                  *
-                 * @param message The warning message to log
-                 * @param file The source file name (typically __FILE__)
-                 * @param line The source line number (typically __LINE__)
+                 * @param sinks The registered sinks
+                 * @param record The log event
                  */
-                static void warning(const std::string& message, const char* file, int line) {
-                    log(LOG_WARNING, message, file, line);
+                static void fan_out(const detail::SinkList& sinks, const LogRecord& record) {
+                    struct Formatted {
+                        const LogFormatter* formatter = nullptr;
+                        std::optional<detail::ScratchBuffer> buffer;
+                    };
+                    constexpr size_t kCachedFormats = 4;
+                    Formatted cache[kCachedFormats];
+                    size_t cached = 0;
+                    LogFormatter& fallback = formatter ? *formatter : default_formatter();
+
+                    for (const auto& entry : sinks) {
+                        if (record.level < entry->level.load(std::memory_order_relaxed)) {
+                            continue;
+                        }
+                        LogFormatter& active = entry->formatter ? *entry->formatter : fallback;
+
+                        const std::string* text = nullptr;
+                        for (size_t i = 0; i < cached; ++i) {
+                            if (cache[i].formatter == &active) {
+                                text = &cache[i].buffer->str();
+                                break;
+                            }
+                        }
+                        if (text) {
+                            entry->write(record.level, *text);
+                        } else if (cached < kCachedFormats) {
+                            Formatted& slot = cache[cached++];
+                            slot.formatter = &active;
+                            slot.buffer.emplace();
+                            active.format_to(slot.buffer->str(), record);
+                            entry->write(record.level, slot.buffer->str());
+                        } else {
+                            // More distinct formatters than cache slots: format for this sink alone
+                            detail::ScratchBuffer buffer;
+                            active.format_to(buffer.str(), record);
+                            entry->write(record.level, buffer.str());
+                        }
+                    }
                 }
 
                 /**
-                 * @brief Log an error message
-                 *
-                 * @param message The error message to log
+                 * @brief Shared body of the INTERLACED_FORMAT overloads of debug/info/warning/error
                  */
-                static void error(const std::string& message) {
-                    log(LOG_ERROR, message);
+                template<typename Format, typename... Args>
+                static void log_compiled(LogLevel level, Format format, Args&&... args) {
+                    if (!is_enabled(level)) {
+                        return;
+                    }
+                    constexpr std::string_view text = Format{};
+                    // The macro's string literal is null terminated and has static storage
+                    if (flight_recorder.load(std::memory_order_relaxed) && record_flight(level, text.data(), args...)) {
+                        return;
+                    }
+                    if (log_binary(level, text.data(), args...)) {
+                        return;
+                    }
+                    detail::ScratchBuffer buffer;
+                    format_message_to(buffer.str(), format, std::forward<Args>(args)...);
+                    deliver_record(level, buffer.str(), nullptr, 0);
                 }
 
                 /**
-                 * @brief Log an error message with file and line information
+                 * @brief Record a format call in the binary log, if binary logging is enabled
                  *
-                 * @param message The error message to log
-                 * @param file The source file name (typically __FILE__)
-                 * @param line The source line number (typically __LINE__)
+                 * @tparam Runtime The format may not be a string literal; its text is compared on cache hits
+                 * @return true if the binary writer took the message
                  */
-                static void error(const std::string& message, const char* file, int line) {
-                    log(LOG_ERROR, message, file, line);
+                template<bool Runtime = false, typename... Args>
+                static bool log_binary(LogLevel level, const char* format, const Args&... args) {
+                    // Plain load first so text logging pays nothing for the binary sink
+                    if (!binary_writer.load(std::memory_order_relaxed)) {
+                        return false;
+                    }
+                    binary_users.fetch_add(1);
+                    BinaryLogWriter* writer = binary_writer.load();
+                    if (writer) {
+                        if constexpr (Runtime) {
+                            writer->log_runtime(level, format, nullptr, 0, args...);
+                        } else {
+                            writer->log(level, format, nullptr, 0, args...);
+                        }
+                        detail::count_stat(detail::kStatEmitted, level);
+                    }
+                    binary_users.fetch_sub(1, std::memory_order_release);
+                    return writer != nullptr;
                 }
 
-                // Structured logging with key-value pairs
                 /**
-                 * @brief Log a message with structured key-value pairs
+                 * @brief Hand a formatted message to the writer thread or write it directly
                  *
-                 * @tparam Args Variadic template arguments for key-value pairs
-                 * @param level The LogLevel for this message
-                 * @param message The message to log
-                 * @param args Key-value pairs to include in the log
+                 * @param level The LogLevel of the message
+                 * @param formatted_message The fully formatted message
                  */
-                template<typename... Args>
-                static void log(LogLevel level, const std::string& message, Args&&... args) {
-                    // Early exit if the message won't be logged
-                    {
-                        std::lock_guard<std::mutex> lock(log_mutex);
-                        if (level < current_level) {
-                            return;
+                static void dispatch(LogLevel level, const std::string& formatted_message) {
+                    // Plain load first so synchronous logging does not touch the shared counter
+                    AsyncLogQueue* queue = nullptr;
+                    if (async_queue.load(std::memory_order_relaxed)) {
+                        // Both seq_cst: the retirer exchanges the pointer, then reads the counter,
+                        // so it either sees this producer or this producer sees the new pointer
+                        async_users.fetch_add(1);
+                        queue = async_queue.load();
+                        if (queue) {
+                            queue->push(level, formatted_message);
                         }
+                        async_users.fetch_sub(1, std::memory_order_release);
                     }
 
-                    // Format the message outside the critical section
-                    const auto now = std::chrono::system_clock::now();
-                    const std::time_t now_time_t = std::chrono::system_clock::to_time_t(now);
-
-                    // Convert to tm struct in a thread-safe way
-                    std::tm local_tm;
-                    localtime_threadsafe(&now_time_t, &local_tm);
-
-                    std::string formatted_message;
-
-                    // Use custom formatter if available
-                    if (formatter) {
-                        formatted_message = formatter->format(level, message, local_tm);
-                    } else {
-                        // Format the message with key-value pairs
-                        std::ostringstream oss;
-                        oss << "[" << std::put_time(&local_tm, "%Y-%m-%d %H:%M:%S")
-                            << "] [" << log_level_to_string(level) << "] "
-                            << message;
-
-                        // Add key-value pairs
-                        format_key_value_pairs(oss, std::forward<Args>(args)...);
-                        formatted_message = oss.str();
+                    if (!queue) {
+                        write_output(level, formatted_message);
                     }
+                }
 
-                    // Output the message (critical section only for output)
+                /**
+                 * @brief Write a formatted message to the file logger or output streams
+                 *
+                 * @param level The LogLevel of the message
+                 * @param formatted_message The fully formatted message
+                 */
+                static void write_output(LogLevel level, const std::string& formatted_message) {
                     std::lock_guard<std::mutex> lock(log_mutex);
                     if (file_logger) {
-                        file_logger->write(formatted_message);
+                        file_logger->write(formatted_message, level);
                     } else {
                         try {
                             // Choose output stream based on log level
@@ -731,124 +9512,67 @@ namespace interlaced {
                 }
 
                 /**
-                 * @brief Log a debug message with structured key-value pairs
-                 *
-                 * @tparam Args Variadic template arguments for key-value pairs
-                 * @param message The message to log
-                 * @param args Key-value pairs to include in the log
-                 */
-                template<typename... Args>
-                static void debug(const std::string& message, Args&&... args) {
-                    log(LOG_DEBUG, message, std::forward<Args>(args)...);
-                }
-
-                /**
-                 * @brief Log an info message with structured key-value pairs
-                 *
-                 * @tparam Args Variadic template arguments for key-value pairs
-                 * @param message The message to log
-                 * @param args Key-value pairs to include in the log
-                 */
-                template<typename... Args>
-                static void info(const std::string& message, Args&&... args) {
-                    log(LOG_INFO, message, std::forward<Args>(args)...);
-                }
-
-                /**
-                 * @brief Log a warning message with structured key-value pairs
-                 *
-                 * @tparam Args Variadic template arguments for key-value pairs
-                 * @param message The message to log
-                 * @param args Key-value pairs to include in the log
-                 */
-                template<typename... Args>
-                static void warning(const std::string& message, Args&&... args) {
-                    log(LOG_WARNING, message, std::forward<Args>(args)...);
-                }
-
-                /**
-                 * @brief Log an error message with structured key-value pairs
-                 *
-                 * @tparam Args Variadic template arguments for key-value pairs
-                 * @param message The message to log
-                 * @param args Key-value pairs to include in the log
-                 */
-                template<typename... Args>
-                static void error(const std::string& message, Args&&... args) {
-                    log(LOG_ERROR, message, std::forward<Args>(args)...);
-                }
-
-                // Variadic template functions for type-safe logging
-                /**
-                 * @brief Log a debug message with type-safe formatting
+                 * @brief Wait for in-flight producers to leave a detached queue, then drain and destroy it
                  *
-                 * @tparam Args Variadic template arguments
-                 * @param format The format string
-                 * @param args Arguments to format
+                 * @param queue The queue previously published in async_queue (may be null)
                  */
-                template<typename... Args>
-                static void debug(const char* format, Args&&... args) {
-                    std::ostringstream oss;
-                    format_message(oss, format, std::forward<Args>(args)...);
-                    debug(oss.str());
+                static void retire_async_queue(AsyncLogQueue* queue) {
+                    if (!queue) {
+                        return;
+                    }
+                    while (async_users.load() != 0) {
+                        std::this_thread::yield();
+                    }
+                    delete queue; // Drains and joins the writer thread
                 }
 
                 /**
-                 * @brief Log an info message with type-safe formatting
+                 * @brief Wait for in-flight producers to leave a detached binary writer, then destroy it
                  *
-                 * @tparam Args Variadic template arguments
-                 * @param format The format string
-                 * @param args Arguments to format
+                 * @param writer The writer previously published in binary_writer (may be null)
                  */
-                template<typename... Args>
-                static void info(const char* format, Args&&... args) {
-                    std::ostringstream oss;
-                    format_message(oss, format, std::forward<Args>(args)...);
-                    info(oss.str());
+                static void retire_binary_writer(BinaryLogWriter* writer) {
+                    if (!writer) {
+                        return;
+                    }
+                    while (binary_users.load() != 0) {
+                        std::this_thread::yield();
+                    }
+                    delete writer; // Drains its queue and writes the remaining records
                 }
 
                 /**
-                 * @brief Log a warning message with type-safe formatting
+                 * @brief Wait for in-flight producers to leave a detached flight recorder, then destroy it
                  *
-                 * @tparam Args Variadic template arguments
-                 * @param format The format string
-                 * @param args Arguments to format
+                 * @param recorder The recorder previously published in flight_recorder (may be null)
                  */
-                template<typename... Args>
-                static void warning(const char* format, Args&&... args) {
-                    std::ostringstream oss;
-                    format_message(oss, format, std::forward<Args>(args)...);
-                    warning(oss.str());
+                static void retire_flight_recorder(detail::FlightRecorder* recorder) {
+                    if (!recorder) {
+                        return;
+                    }
+                    while (flight_users.load() != 0) {
+                        std::this_thread::yield();
+                    }
+                    delete recorder;
                 }
 
                 /**
-                 * @brief Log an error message with type-safe formatting
+                 * @brief Wait for in-flight producers to leave a detached sink list, then destroy it
                  *
-                 * @tparam Args Variadic template arguments
-                 * @param format The format string
-                 * @param args Arguments to format
-                 */
-                template<typename... Args>
-                static void error(const char* format, Args&&... args) {
-                    std::ostringstream oss;
-                    format_message(oss, format, std::forward<Args>(args)...);
-                    error(oss.str());
-                }
-
-                /**
-                 * @brief Format a message with variadic arguments
+                 * Sinks that are no longer in any list drain their queues and flush.
                  *
-                 * @tparam Args Variadic template arguments
-                 * @param oss The output string stream
-                 * @param format The format string
-                 * @param args Arguments to format
+                 * @param list The list previously published in sink_list (may be null)
                  */
-                template<typename... Args>
-                static void format_message(std::ostringstream& oss, const char* format, Args&&... args) {
-                    format_helper(oss, format, std::forward<Args>(args)...);
+                static void retire_sink_list(detail::SinkList* list) {
+                    if (!list) {
+                        return;
+                    }
+                    while (sink_users.load() != 0) {
+                        std::this_thread::yield();
+                    }
+                    delete list;
                 }
 
-            private:
                 /**
                  * @brief Format key-value pairs for structured logging
                  *
@@ -887,17 +9611,17 @@ namespace interlaced {
                  */
                 template<typename T, typename... Args>
                 static void format_helper(std::ostringstream& oss, const char* format, T&& value, Args&&... args) {
+                    const char* literal = format;
                     while (*format) {
                         if (*format == '{' && *(format + 1) == '}') {
+                            oss.write(literal, format - literal);
                             oss << value;
-                            format += 2;
-                            format_helper(oss, format, std::forward<Args>(args)...);
+                            format_helper(oss, format + 2, std::forward<Args>(args)...);
                             return;
-                        } else {
-                            oss << *format;
-                            ++format;
                         }
+                        ++format;
                     }
+                    oss.write(literal, format - literal);
                 }
 
                 /**
@@ -907,28 +9631,179 @@ namespace interlaced {
                  * @param format The format string
                  */
                 static void format_helper(std::ostringstream& oss, const char* format) {
+                    oss << format;
+                }
+
+                /**
+                 * @brief Append a format string, substituting the first argument for the next "{}"
+                 *
+                 * Literal text between placeholders is appended in a single call.
+                 *
+                 * @tparam T Type of the first argument
+                 * @tparam Args Variadic template arguments
+                 * @param out The string to append to
+                 * @param format The format string
+                 * @param value The first argument
+                 * @param args Remaining arguments
+                 */
+                template<typename T, typename... Args>
+                static void append_formatted(std::string& out, const char* format, T&& value, Args&&... args) {
+                    const char* literal = format;
                     while (*format) {
-                        oss << *format;
+                        if (*format == '{' && *(format + 1) == '}') {
+                            out.append(literal, static_cast<size_t>(format - literal));
+                            detail::append_value(out, value);
+                            append_formatted(out, format + 2, std::forward<Args>(args)...);
+                            return;
+                        }
                         ++format;
                     }
+                    out.append(literal, static_cast<size_t>(format - literal));
+                }
+
+                /**
+                 * @brief Append the rest of a format string (base case)
+                 *
+                 * @param out The string to append to
+                 * @param format The format string
+                 */
+                static void append_formatted(std::string& out, const char* format) {
+                    out.append(format);
                 }
             };
 
             // Static member definitions
-            inline LogLevel Logger::current_level = LOG_INFO;
+            inline std::atomic<LogLevel> Logger::current_level{LOG_INFO};
             inline std::mutex Logger::log_mutex;
             inline std::ostream* Logger::output_stream = &std::cout;
             inline std::ostream* Logger::error_stream = &std::cerr;
             inline std::unique_ptr<LogFormatter> Logger::formatter = nullptr;
             inline std::unique_ptr<RotatingFileLogger> Logger::file_logger = nullptr;
+            inline std::atomic<AsyncLogQueue*> Logger::async_queue{nullptr};
+            inline std::atomic<int> Logger::async_users{0};
+            inline std::atomic<BinaryLogWriter*> Logger::binary_writer{nullptr};
+            inline std::atomic<int> Logger::binary_users{0};
+            inline std::mutex Logger::sink_config_mutex;
+            inline std::atomic<detail::SinkList*> Logger::sink_list{nullptr};
+            inline std::atomic<int> Logger::sink_users{0};
+            inline std::atomic<int64_t> Logger::duplicate_interval{-1};
+            inline std::atomic<LogLevel> Logger::enabled_level{LOG_INFO};
+            inline std::mutex Logger::level_mutex;
+            inline std::atomic<detail::FlightRecorder*> Logger::flight_recorder{nullptr};
+            inline std::atomic<int> Logger::flight_users{0};
+            inline std::unordered_map<std::string, std::unique_ptr<LogCategory>> Logger::categories;
+            inline detail::CategorySite* Logger::category_sites = nullptr;
+            inline std::atomic<uint64_t> Logger::config_generation{0};
+
+            inline bool detail::CategorySite::evaluate() {
+                return Logger::evaluate_site(*this);
+            }
+
+            namespace detail {
+                /**
+                 * @brief Drains the asynchronous queue, binary writer and sinks at static destruction time
+                 *
+                 * Defined after Logger's static members so it is destroyed before them,
+                 * while the output streams and file logger are still alive.
+                 */
+                struct AsyncLoggerShutdown {
+                    ~AsyncLoggerShutdown() {
+                        Logger::disable_flight_recorder();
+                        Logger::disable_binary_logging();
+                        Logger::clear_sinks();
+                        Logger::set_sync();
+                    }
+                };
+
+                inline AsyncLoggerShutdown async_logger_shutdown;
+
+                /**
+                 * @brief Temporary behind the LOG_*_S macros; writes its line when destroyed
+                 *
+                 * Values are appended with append_value(), so stream manipulators such
+                 * as std::hex or std::endl are not supported.
+                 */
+                class LogStream {
+                private:
+                    LogLevel level_;
+                    const char* file_;
+                    int line_;
+                    const char* file_name_;
+                    ScratchBuffer buffer_;
+
+                public:
+                    LogStream(LogLevel level, const char* file, int line, const char* file_name = nullptr)
+                        : level_(level), file_(file), line_(line), file_name_(file_name) {}
+
+                    ~LogStream() {
+                        try {
+                            Logger::write(level_, buffer_.str(), file_, line_, file_name_);
+                        } catch (...) {
+                            // Logging must not throw from a destructor
+                        }
+                    }
+
+                    LogStream(const LogStream&) = delete;
+                    LogStream& operator=(const LogStream&) = delete;
+
+                    template<typename T>
+                    LogStream& operator<<(const T& value) {
+                        append_value(buffer_.str(), value);
+                        return *this;
+                    }
+                };
+
+                /**
+                 * @brief Turns a LogStream expression into void so it fits the conditional in LOG_*_S
+                 */
+                struct LogStreamVoidify {
+                    void operator&(const LogStream&) {}
+                };
+            }
+
+            /**
+             * @brief Basename of the current source file, computed at compile time
+             *
+             * Passed alongside the full __FILE__, which is what LogRecord::file holds.
+             */
+            #define INTERLACED_SOURCE_FILE_NAME_ \
+                (__FILE__ + std::integral_constant<size_t, interlaced::core::logging::detail::basename_offset(__FILE__)>::value)
+
+            /**
+             * @brief Check the level, then evaluate msg and write it with the call site's file and line
+             */
+            #define INTERLACED_LOG_LAZY_(level, msg) \
+                (interlaced::core::logging::Logger::is_enabled(level) \
+                     ? interlaced::core::logging::Logger::write(level, msg, __FILE__, __LINE__, INTERLACED_SOURCE_FILE_NAME_) \
+                     : (void)0)
+
+            /**
+             * @brief Wrap a string literal as a format string checked at compile time
+             *
+             * Passing the result to Logger::debug/info/warning/error or
+             * Logger::format_message_to() splits the literal at its "{}" placeholders
+             * during compilation and makes a wrong number of arguments a compile error.
+             *
+             * Usage: Logger::info(INTERLACED_FORMAT("User {} logged in from {}"), user, ip);
+             */
+            #define INTERLACED_FORMAT(str) \
+                [] { \
+                    struct interlaced_format_string : interlaced::core::logging::detail::CompileTimeFormat { \
+                        constexpr operator std::string_view() const { return str; } \
+                    }; \
+                    return interlaced_format_string{}; \
+                }()
 
             /**
              * @brief Convenience macro for logging debug messages with file and line information
              *
+             * The level is checked first; the message expression is only evaluated
+             * when the message will be written.
+             *
              * Usage: LOG_DEBUG("Message");
              */
-            #ifndef INTERLACED_CORE_DISABLE_DEBUG_LOGS
-            #define LOG_DEBUG(msg) interlaced::core::logging::Logger::debug(msg, __FILE__, __LINE__)
+            #if INTERLACED_CORE_MIN_LOG_LEVEL <= INTERLACED_CORE_LOG_LEVEL_DEBUG
+            #define LOG_DEBUG(msg) INTERLACED_LOG_LAZY_(interlaced::core::logging::LOG_DEBUG, msg)
             #else
             #define LOG_DEBUG(msg) (void)0
             #endif
@@ -936,23 +9811,174 @@ namespace interlaced {
             /**
              * @brief Convenience macro for logging informational messages with file and line information
              *
+             * The level is checked first; the message expression is only evaluated
+             * when the message will be written.
+             *
              * Usage: LOG_INFO("Message");
              */
-            #define LOG_INFO(msg) interlaced::core::logging::Logger::info(msg, __FILE__, __LINE__)
+            #if INTERLACED_CORE_MIN_LOG_LEVEL <= INTERLACED_CORE_LOG_LEVEL_INFO
+            #define LOG_INFO(msg) INTERLACED_LOG_LAZY_(interlaced::core::logging::LOG_INFO, msg)
+            #else
+            #define LOG_INFO(msg) (void)0
+            #endif
 
             /**
              * @brief Convenience macro for logging warning messages with file and line information
              *
+             * The level is checked first; the message expression is only evaluated
+             * when the message will be written.
+             *
              * Usage: LOG_WARNING("Message");
              */
-            #define LOG_WARNING(msg) interlaced::core::logging::Logger::warning(msg, __FILE__, __LINE__)
+            #if INTERLACED_CORE_MIN_LOG_LEVEL <= INTERLACED_CORE_LOG_LEVEL_WARNING
+            #define LOG_WARNING(msg) INTERLACED_LOG_LAZY_(interlaced::core::logging::LOG_WARNING, msg)
+            #else
+            #define LOG_WARNING(msg) (void)0
+            #endif
 
             /**
              * @brief Convenience macro for logging error messages with file and line information
              *
+             * The level is checked first; the message expression is only evaluated
+             * when the message will be written.
+             *
              * Usage: LOG_ERROR("Message");
              */
-            #define LOG_ERROR(msg) interlaced::core::logging::Logger::error(msg, __FILE__, __LINE__)
+            #if INTERLACED_CORE_MIN_LOG_LEVEL <= INTERLACED_CORE_LOG_LEVEL_ERROR
+            #define LOG_ERROR(msg) INTERLACED_LOG_LAZY_(interlaced::core::logging::LOG_ERROR, msg)
+            #else
+            #define LOG_ERROR(msg) (void)0
+            #endif
+
+            /**
+             * @brief Stream-style logging with file and line information
+             *
+             * Values are appended to a per-thread buffer as operator<< would print
+             * them with default stream settings, and the line is written at the end
+             * of the statement. Nothing to the right of the macro is evaluated when
+             * the level is disabled.
+             *
+             * Usage: LOG_INFO_S << "Loaded " << count << " items in " << ms << "ms";
+             */
+            #define INTERLACED_LOG_STREAM_(level) \
+                !interlaced::core::logging::Logger::is_enabled(level) \
+                    ? (void)0 \
+                    : interlaced::core::logging::detail::LogStreamVoidify() & \
+                      interlaced::core::logging::detail::LogStream(level, __FILE__, __LINE__, INTERLACED_SOURCE_FILE_NAME_)
+
+            #define LOG_DEBUG_S INTERLACED_LOG_STREAM_(interlaced::core::logging::LOG_DEBUG)
+            #define LOG_INFO_S INTERLACED_LOG_STREAM_(interlaced::core::logging::LOG_INFO)
+            #define LOG_WARNING_S INTERLACED_LOG_STREAM_(interlaced::core::logging::LOG_WARNING)
+            #define LOG_ERROR_S INTERLACED_LOG_STREAM_(interlaced::core::logging::LOG_ERROR)
+
+            /**
+             * @brief Category logging with a cached per-call-site level check
+             *
+             * Each expansion owns a function-local static CategorySite. Once the site
+             * knows its category is disabled, the check is a single relaxed load; it
+             * is evaluated again after any level change. The message expression is
+             * only evaluated when the message will be written or recorded.
+             *
+             * Usage: LOG_CATEGORY_DEBUG("net.http", "Sent " + std::to_string(bytes) + " bytes");
+             */
+            #define INTERLACED_LOG_CATEGORY_(name, level, msg) \
+                do { \
+                    static interlaced::core::logging::detail::CategorySite interlaced_category_site_(name, level); \
+                    if (interlaced_category_site_.enabled()) { \
+                        interlaced::core::logging::Logger::write(interlaced_category_site_.category(), level, msg, \
+                                                                 __FILE__, __LINE__, INTERLACED_SOURCE_FILE_NAME_); \
+                    } \
+                } while (0)
+
+            #if INTERLACED_CORE_MIN_LOG_LEVEL <= INTERLACED_CORE_LOG_LEVEL_DEBUG
+            #define LOG_CATEGORY_DEBUG(name, msg) INTERLACED_LOG_CATEGORY_(name, interlaced::core::logging::LOG_DEBUG, msg)
+            #else
+            #define LOG_CATEGORY_DEBUG(name, msg) (void)0
+            #endif
+
+            #if INTERLACED_CORE_MIN_LOG_LEVEL <= INTERLACED_CORE_LOG_LEVEL_INFO
+            #define LOG_CATEGORY_INFO(name, msg) INTERLACED_LOG_CATEGORY_(name, interlaced::core::logging::LOG_INFO, msg)
+            #else
+            #define LOG_CATEGORY_INFO(name, msg) (void)0
+            #endif
+
+            #if INTERLACED_CORE_MIN_LOG_LEVEL <= INTERLACED_CORE_LOG_LEVEL_WARNING
+            #define LOG_CATEGORY_WARNING(name, msg) INTERLACED_LOG_CATEGORY_(name, interlaced::core::logging::LOG_WARNING, msg)
+            #else
+            #define LOG_CATEGORY_WARNING(name, msg) (void)0
+            #endif
+
+            #if INTERLACED_CORE_MIN_LOG_LEVEL <= INTERLACED_CORE_LOG_LEVEL_ERROR
+            #define LOG_CATEGORY_ERROR(name, msg) INTERLACED_LOG_CATEGORY_(name, interlaced::core::logging::LOG_ERROR, msg)
+            #else
+            #define LOG_CATEGORY_ERROR(name, msg) (void)0
+            #endif
+
+            /**
+             * @brief Call-site throttling behind the LOG_*_EVERY_N, LOG_*_RATE and LOG_*_SAMPLED macros
+             *
+             * Each expansion owns a function-local static, so every call site is
+             * throttled on its own. The level is checked first, and the statement
+             * (including its message expression) only runs for calls that are logged.
+             */
+            #define INTERLACED_LOG_EVERY_N_(level, n, statement) \
+                do { \
+                    static interlaced::core::logging::detail::EveryNLimiter interlaced_limiter_; \
+                    if (interlaced::core::logging::Logger::is_enabled(level) && \
+                        interlaced::core::logging::detail::count_throttle(level, interlaced_limiter_.allow(n))) { \
+                        statement; \
+                    } \
+                } while (0)
+
+            #define INTERLACED_LOG_RATE_(level, per_second, statement) \
+                do { \
+                    static interlaced::core::logging::detail::RateLimiter interlaced_limiter_; \
+                    if (interlaced::core::logging::Logger::is_enabled(level) && \
+                        interlaced::core::logging::detail::count_throttle(level, interlaced_limiter_.allow(per_second))) { \
+                        statement; \
+                    } \
+                } while (0)
+
+            #define INTERLACED_LOG_SAMPLED_(level, n, statement) \
+                do { \
+                    if (interlaced::core::logging::Logger::is_enabled(level) && \
+                        interlaced::core::logging::detail::count_throttle(level, \
+                            interlaced::core::logging::detail::sample_one_in(n))) { \
+                        statement; \
+                    } \
+                } while (0)
+
+            /**
+             * @brief Log the 1st, (n+1)th, (2n+1)th, ... call of this call site
+             *
+             * Usage: LOG_WARNING_EVERY_N(100, "Retrying connection");
+             */
+            #define LOG_DEBUG_EVERY_N(n, msg) INTERLACED_LOG_EVERY_N_(interlaced::core::logging::LOG_DEBUG, n, LOG_DEBUG(msg))
+            #define LOG_INFO_EVERY_N(n, msg) INTERLACED_LOG_EVERY_N_(interlaced::core::logging::LOG_INFO, n, LOG_INFO(msg))
+            #define LOG_WARNING_EVERY_N(n, msg) INTERLACED_LOG_EVERY_N_(interlaced::core::logging::LOG_WARNING, n, LOG_WARNING(msg))
+            #define LOG_ERROR_EVERY_N(n, msg) INTERLACED_LOG_EVERY_N_(interlaced::core::logging::LOG_ERROR, n, LOG_ERROR(msg))
+
+            /**
+             * @brief Log at most per_second messages per second from this call site
+             *
+             * Bursts of up to one second's worth of messages pass at once.
+             *
+             * Usage: LOG_WARNING_RATE(5, "Downstream unavailable");
+             */
+            #define LOG_DEBUG_RATE(per_second, msg) INTERLACED_LOG_RATE_(interlaced::core::logging::LOG_DEBUG, per_second, LOG_DEBUG(msg))
+            #define LOG_INFO_RATE(per_second, msg) INTERLACED_LOG_RATE_(interlaced::core::logging::LOG_INFO, per_second, LOG_INFO(msg))
+            #define LOG_WARNING_RATE(per_second, msg) INTERLACED_LOG_RATE_(interlaced::core::logging::LOG_WARNING, per_second, LOG_WARNING(msg))
+            #define LOG_ERROR_RATE(per_second, msg) INTERLACED_LOG_RATE_(interlaced::core::logging::LOG_ERROR, per_second, LOG_ERROR(msg))
+
+            /**
+             * @brief Log a random 1 in n calls of this call site
+             *
+             * Usage: LOG_DEBUG_SAMPLED(1000, "Cache lookup for " + key);
+             */
+            #define LOG_DEBUG_SAMPLED(n, msg) INTERLACED_LOG_SAMPLED_(interlaced::core::logging::LOG_DEBUG, n, LOG_DEBUG(msg))
+            #define LOG_INFO_SAMPLED(n, msg) INTERLACED_LOG_SAMPLED_(interlaced::core::logging::LOG_INFO, n, LOG_INFO(msg))
+            #define LOG_WARNING_SAMPLED(n, msg) INTERLACED_LOG_SAMPLED_(interlaced::core::logging::LOG_WARNING, n, LOG_WARNING(msg))
+            #define LOG_ERROR_SAMPLED(n, msg) INTERLACED_LOG_SAMPLED_(interlaced::core::logging::LOG_ERROR, n, LOG_ERROR(msg))
 
         }
 
@@ -30,6 +30,15 @@
 #include <sstream>
 #include <ctime>
 #include <cstdlib>
+#include <cctype>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <atomic>
+#include <utility>
+#include <functional>
+#include <cstdint>
 
 // Platform-specific includes for network operations
 #ifdef _WIN32
@@ -39,6 +48,7 @@
 #else
     #include <sys/socket.h>
     #include <netinet/in.h>
+    #include <netinet/tcp.h>
     #include <arpa/inet.h>
     #include <netdb.h>
     #include <unistd.h>
@@ -107,21 +117,14 @@ namespace interlaced {
                 NetworkResult(bool s, int ec, const std::string& m) : success(s), error_code(ec), message(m) {}
             };
 
-            /**
-             * @brief Network utility functions
-             *
-             * This class provides basic network functionality such as
-             * checking host reachability, downloading files, and performing HTTP GET requests.
-             * Note: This is a simplified implementation for demonstration purposes.
-             */
-            class Network {
-            private:
+            namespace detail {
+
                 /**
                  * @brief Initialize Windows Sockets API (Windows only)
                  *
                  * @return true if initialization successful or not needed, false on error
                  */
-                static bool initialize_winsock() {
+                inline bool initialize_winsock() {
         #ifdef _WIN32
                     WSADATA wsaData;
                     return WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
@@ -133,19 +136,19 @@ namespace interlaced {
                 /**
                  * @brief Cleanup Windows Sockets API (Windows only)
                  */
-                static void cleanup_winsock() {
+                inline void cleanup_winsock() {
         #ifdef _WIN32
                     WSACleanup();
         #endif
                 }
 
                 /**
-                 * @brief Set socket timeout values
+                 * @brief Set socket send and receive timeouts
                  *
                  * @param sockfd Socket file descriptor
                  * @param timeout_seconds Timeout in seconds
                  */
-                static void set_socket_timeout(int sockfd, int timeout_seconds) {
+                inline void set_socket_timeout(int sockfd, int timeout_seconds) {
         #ifdef _WIN32
                     DWORD timeout = timeout_seconds * 1000;
                     setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
@@ -164,7 +167,7 @@ namespace interlaced {
                  *
                  * @param sockfd Socket file descriptor
                  */
-                static void close_socket(int sockfd) {
+                inline void close_socket(int sockfd) {
         #ifdef _WIN32
                     closesocket(sockfd);
         #else
@@ -172,6 +175,1006 @@ namespace interlaced {
         #endif
                 }
 
+                /**
+                 * @brief Send all of data, without raising SIGPIPE if the peer has gone
+                 *
+                 * @return true if every byte was sent
+                 */
+                inline bool send_all(int sockfd, const char* data, size_t size) {
+        #ifdef MSG_NOSIGNAL
+                    const int flags = MSG_NOSIGNAL;
+        #else
+                    const int flags = 0;
+        #endif
+                    while (size > 0) {
+                        const int chunk = size > 1024 * 1024 ? 1024 * 1024 : static_cast<int>(size);
+                        const int sent = static_cast<int>(send(sockfd, data, chunk, flags));
+                        if (sent <= 0) {
+                            return false;
+                        }
+                        data += sent;
+                        size -= static_cast<size_t>(sent);
+                    }
+                    return true;
+                }
+
+                /**
+                 * @brief Whether the last socket call failed because the peer closed or reset the connection
+                 */
+                inline bool connection_reset() {
+        #ifdef _WIN32
+                    const int error = WSAGetLastError();
+                    return error == WSAECONNRESET || error == WSAECONNABORTED;
+        #else
+                    return errno == ECONNRESET || errno == EPIPE;
+        #endif
+                }
+
+                /**
+                 * @brief The parts of an http:// or https:// URL
+                 */
+                struct HttpUrl {
+                    std::string protocol;
+                    std::string host;
+                    int port = 80;
+                    std::string path = "/";
+                };
+
+                /**
+                 * @brief Split a URL into protocol, host, port and path
+                 *
+                 * @return false if the URL does not start with http:// or https:// or has no host
+                 */
+                inline bool parse_http_url(const std::string& url, HttpUrl& parts) {
+                    const size_t protocol_end = url.find("://");
+                    if (protocol_end == std::string::npos) {
+                        return false;
+                    }
+                    parts.protocol = url.substr(0, protocol_end);
+                    if (parts.protocol == "https") {
+                        parts.port = 443;
+                    } else if (parts.protocol != "http") {
+                        return false;
+                    }
+
+                    const size_t host_start = protocol_end + 3;
+                    const size_t host_end = url.find('/', host_start);
+                    if (host_end == std::string::npos) {
+                        parts.host = url.substr(host_start);
+                        parts.path = "/";
+                    } else {
+                        parts.host = url.substr(host_start, host_end - host_start);
+                        parts.path = url.substr(host_end);
+                    }
+
+                    // Check if host contains port
+                    const size_t port_pos = parts.host.find(':');
+                    if (port_pos != std::string::npos) {
+                        parts.port = atoi(parts.host.c_str() + port_pos + 1);
+                        parts.host.erase(port_pos);
+                    }
+                    return !parts.host.empty() && parts.port > 0 && parts.port <= 65535;
+                }
+
+                /**
+                 * @brief Compare two header names, ignoring case
+                 */
+                inline bool header_name_equals(const std::string& a, const char* b) {
+                    const size_t length = strlen(b);
+                    if (a.size() != length) {
+                        return false;
+                    }
+                    for (size_t i = 0; i < length; ++i) {
+                        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+
+                /**
+                 * @brief Whether a comma-separated header value lists token, ignoring case
+                 */
+                inline bool header_has_token(const std::string& value, const char* token) {
+                    size_t start = 0;
+                    while (start <= value.size()) {
+                        size_t end = value.find(',', start);
+                        if (end == std::string::npos) {
+                            end = value.size();
+                        }
+                        size_t first = start;
+                        size_t last = end;
+                        while (first < last && (value[first] == ' ' || value[first] == '\t')) {
+                            ++first;
+                        }
+                        while (last > first && (value[last - 1] == ' ' || value[last - 1] == '\t')) {
+                            --last;
+                        }
+                        if (header_name_equals(value.substr(first, last - first), token)) {
+                            return true;
+                        }
+                        start = end + 1;
+                    }
+                    return false;
+                }
+            }
+
+            /**
+             * @brief Incremental decoder for HTTP/1.1 message bodies
+             *
+             * Bytes are pushed in as they arrive from the socket. Body bytes are
+             * handed to the sink as spans of the caller's buffer, without being
+             * copied or collected first, and chunk framing is stripped on the way.
+             * The decoder stops at the end of the body, so bytes that belong to
+             * the next message on a keep-alive connection are left unconsumed.
+             *
+             * Example:
+             * @code
+             * HttpBodyDecoder decoder(HttpBodyDecoder::Framing::CHUNKED);
+             * auto sink = [&](const char* data, size_t size) { return fwrite(data, 1, size, file) == size; };
+             * while (!decoder.done() && !decoder.failed()) {
+             *     int received = recv(sockfd, buffer, sizeof(buffer), 0);
+             *     if (received <= 0) {
+             *         decoder.finish();
+             *         break;
+             *     }
+             *     decoder.feed(buffer, received, sink);
+             * }
+             * @endcode
+             */
+            class HttpBodyDecoder {
+            public:
+                /**
+                 * @brief How the end of the body is found
+                 */
+                enum class Framing {
+                    EMPTY,          ///< No body (HEAD, 1xx, 204, 304)
+                    LENGTH,         ///< Content-Length bytes
+                    CHUNKED,        ///< Transfer-Encoding: chunked
+                    UNTIL_CLOSE     ///< Everything until the connection closes
+                };
+
+                /**
+                 * @brief Receives body bytes; returns false to stop the transfer
+                 */
+                using Sink = std::function<bool(const char* data, size_t size)>;
+
+            private:
+                enum class State {
+                    CHUNK_SIZE,     ///< Hex digits and extensions of a chunk-size line
+                    DATA,           ///< Body bytes (remaining_ of them, except for UNTIL_CLOSE)
+                    DATA_END,       ///< CRLF after a chunk's data
+                    TRAILER,        ///< Trailer fields after the last chunk
+                    DONE,
+                    FAILED
+                };
+
+                Framing framing_;
+                State state_;
+                uint64_t remaining_ = 0;    ///< Bytes left in the body or chunk, or the chunk size being parsed
+                uint64_t expected_ = 0;     ///< Content-Length for LENGTH framing
+                uint64_t body_bytes_ = 0;
+                int size_digits_ = 0;
+                bool in_extension_ = false;
+                bool saw_cr_ = false;
+                size_t line_length_ = 0;
+                bool aborted_ = false;
+                std::string error_;
+
+            public:
+                /**
+                 * @param framing How the body is delimited
+                 * @param length The Content-Length, for Framing::LENGTH
+                 */
+                explicit HttpBodyDecoder(Framing framing = Framing::UNTIL_CLOSE, uint64_t length = 0)
+                    : framing_(framing), state_(State::DATA), remaining_(length), expected_(length) {
+                    if (framing == Framing::EMPTY || (framing == Framing::LENGTH && length == 0)) {
+                        state_ = State::DONE;
+                    } else if (framing == Framing::CHUNKED) {
+                        state_ = State::CHUNK_SIZE;
+                        remaining_ = 0;
+                    }
+                }
+
+                /**
+                 * @brief Decode received bytes, passing body bytes to sink
+                 *
+                 * @return Number of bytes consumed; fewer than size once the body has
+                 *         ended (the rest belongs to the next message) or on failure
+                 */
+                size_t feed(const char* data, size_t size, const Sink& sink) {
+                    size_t position = 0;
+                    while (position < size && state_ != State::DONE && state_ != State::FAILED) {
+                        if (state_ == State::DATA) {
+                            size_t count = size - position;
+                            if (framing_ != Framing::UNTIL_CLOSE && count > remaining_) {
+                                count = static_cast<size_t>(remaining_);
+                            }
+                            if (!sink(data + position, count)) {
+                                aborted_ = true;
+                                fail("The body sink stopped the transfer");
+                                return position;
+                            }
+                            position += count;
+                            body_bytes_ += count;
+                            if (framing_ != Framing::UNTIL_CLOSE) {
+                                remaining_ -= count;
+                                if (remaining_ == 0) {
+                                    state_ = framing_ == Framing::CHUNKED ? State::DATA_END : State::DONE;
+                                }
+                            }
+                            continue;
+                        }
+
+                        // Framing is parsed a byte at a time; it is a few bytes per chunk
+                        const char c = data[position++];
+                        switch (state_) {
+                            case State::CHUNK_SIZE:
+                                parse_chunk_size(c);
+                                break;
+                            case State::DATA_END:
+                                if (c == '\r' && !saw_cr_) {
+                                    saw_cr_ = true;
+                                } else if (c == '\n') {
+                                    saw_cr_ = false;
+                                    state_ = State::CHUNK_SIZE;
+                                } else {
+                                    fail("Missing CRLF after chunk data");
+                                }
+                                break;
+                            case State::TRAILER:
+                                if (c == '\n') {
+                                    if (line_length_ == 0) {
+                                        state_ = State::DONE;
+                                    }
+                                    line_length_ = 0;
+                                } else if (c != '\r') {
+                                    ++line_length_;
+                                }
+                                break;
+                            default:
+                                break;
+                        }
+                    }
+                    return position;
+                }
+
+                /**
+                 * @brief Tell the decoder that the connection has closed
+                 *
+                 * @return true if the body was complete: always for Framing::UNTIL_CLOSE,
+                 *         otherwise only if every announced byte arrived
+                 */
+                bool finish() {
+                    if (state_ == State::DATA && framing_ == Framing::UNTIL_CLOSE) {
+                        state_ = State::DONE;
+                    } else if (state_ != State::DONE && state_ != State::FAILED) {
+                        if (framing_ == Framing::LENGTH) {
+                            fail("Connection closed after " + std::to_string(body_bytes_) + " of " +
+                                 std::to_string(expected_) + " body bytes");
+                        } else {
+                            fail("Connection closed inside the chunked body");
+                        }
+                    }
+                    return state_ == State::DONE;
+                }
+
+                bool done() const {
+                    return state_ == State::DONE;
+                }
+
+                bool failed() const {
+                    return state_ == State::FAILED;
+                }
+
+                /**
+                 * @brief Whether the failure came from the sink returning false
+                 */
+                bool aborted() const {
+                    return aborted_;
+                }
+
+                const std::string& error() const {
+                    return error_;
+                }
+
+                Framing framing() const {
+                    return framing_;
+                }
+
+                /**
+                 * @brief Body bytes passed to the sink so far
+                 */
+                uint64_t body_bytes() const {
+                    return body_bytes_;
+                }
+
+            private:
+                void fail(const std::string& message) {
+                    state_ = State::FAILED;
+                    error_ = message;
+                }
+
+                void parse_chunk_size(char c) {
+                    int digit = -1;
+                    if (c >= '0' && c <= '9') {
+                        digit = c - '0';
+                    } else if (c >= 'a' && c <= 'f') {
+                        digit = c - 'a' + 10;
+                    } else if (c >= 'A' && c <= 'F') {
+                        digit = c - 'A' + 10;
+                    }
+
+                    if (in_extension_) {
+                        if (c == '\n') {
+                            end_chunk_size();
+                        }
+                    } else if (digit >= 0) {
+                        if (++size_digits_ > 15) {
+                            fail("Chunk size too large");
+                            return;
+                        }
+                        remaining_ = remaining_ * 16 + static_cast<uint64_t>(digit);
+                    } else if (c == ';' || c == ' ' || c == '\t') {
+                        in_extension_ = true;
+                    } else if (c == '\r') {
+                        // Skipped; the line ends at '\n'
+                    } else if (c == '\n') {
+                        end_chunk_size();
+                    } else {
+                        fail("Invalid chunk size");
+                    }
+                }
+
+                void end_chunk_size() {
+                    if (size_digits_ == 0) {
+                        fail("Invalid chunk size");
+                        return;
+                    }
+                    size_digits_ = 0;
+                    in_extension_ = false;
+                    if (remaining_ == 0) {
+                        state_ = State::TRAILER;
+                        line_length_ = 0;
+                    } else {
+                        state_ = State::DATA;
+                    }
+                }
+            };
+
+            /**
+             * @brief Result of an HTTP request
+             *
+             * success, error_code and message have the same meaning as in NetworkResult:
+             * success is true when a complete response was received, whatever its status.
+             *
+             * Error codes:
+             * - 0: Response received
+             * - 1: URL is empty
+             * - 6: Invalid URL format
+             * - 8: Network error (resolve, connect, send or receive)
+             * - 10: Malformed HTTP response
+             * - 11: HTTPS is not supported
+             * - 12: Timed out waiting for a free connection to the host
+             * - 13: The body sink stopped the transfer
+             */
+            struct HttpResponse {
+                bool success = false;
+                int error_code = 0;
+                std::string message;
+
+                int status_code = 0;                                       ///< e.g. 200, or 0 without a response
+                std::string reason;                                        ///< e.g. "OK"
+                std::vector<std::pair<std::string, std::string>> headers;  ///< In the order received
+                std::string body;                                          ///< Decoded body (no chunk framing)
+
+                /**
+                 * @brief Value of the first header with this name (case-insensitive), or ""
+                 */
+                std::string header(const char* name) const {
+                    for (const auto& entry : headers) {
+                        if (detail::header_name_equals(entry.first, name)) {
+                            return entry.second;
+                        }
+                    }
+                    return std::string();
+                }
+            };
+
+            /**
+             * @brief Limits of an HttpConnectionPool
+             */
+            struct HttpPoolOptions {
+                size_t max_idle_per_host = 8;                               ///< Idle connections kept per host:port
+                size_t max_per_host = 32;                                   ///< Open connections (idle + in use) per host:port
+                std::chrono::milliseconds idle_timeout{30000};              ///< Idle connections older than this are closed
+                int timeout_seconds = 30;                                   ///< Send/receive timeout (on Linux also connect), and the wait for a free connection
+            };
+
+            /**
+             * @brief HTTP/1.1 client that keeps connections open between requests
+             *
+             * After a response whose length is known (Content-Length or chunked) the
+             * connection goes back to an idle list for its host and port, and the
+             * next request to the same place reuses it instead of opening a new TCP
+             * connection. An idle connection the server has closed is noticed before
+             * reuse. A GET, HEAD, PUT, DELETE or OPTIONS request is retried once on a
+             * new connection when the server closes or resets a reused one before any
+             * response byte arrives; other methods, and timeouts, are never retried,
+             * since the server may already have acted on the request. When max_per_host
+             * connections are busy, request() waits for one to come back.
+             *
+             * The pool is thread-safe. Only plain http:// URLs are supported.
+             *
+             * Example:
+             * @code
+             * HttpConnectionPool pool;
+             * HttpResponse response = pool.request("GET", "http://localhost:8080/status");
+             * if (response.success && Network::is_http_success(response.status_code)) {
+             *     std::cout << response.body << std::endl;
+             * }
+             * @endcode
+             */
+            class HttpConnectionPool {
+            public:
+                using HeaderList = std::vector<std::pair<std::string, std::string>>;
+
+                /**
+                 * @brief Receives the response head and a piece of the body; returns false to stop
+                 */
+                using BodySink = std::function<bool(const HttpResponse& head, const char* data, size_t size)>;
+
+            private:
+                struct IdleConnection {
+                    int sockfd;
+                    std::chrono::steady_clock::time_point since;
+                };
+
+                struct HostConnections {
+                    std::vector<IdleConnection> idle;   ///< Most recently used last
+                    size_t open = 0;                    ///< Idle and in-use connections
+                };
+
+                HttpPoolOptions options_;
+                bool winsock_ready_;
+                std::mutex mutex_;
+                std::condition_variable returned_;
+                std::unordered_map<std::string, HostConnections> hosts_;
+                std::atomic<size_t> connections_opened_{0};
+
+            public:
+                explicit HttpConnectionPool(const HttpPoolOptions& options = HttpPoolOptions())
+                    : options_(options), winsock_ready_(detail::initialize_winsock()) {
+                    if (options_.max_per_host == 0) {
+                        options_.max_per_host = 1;
+                    }
+                }
+
+                /**
+                 * @brief Close the idle connections; requests must not be running any more
+                 */
+                ~HttpConnectionPool() {
+                    clear();
+                    if (winsock_ready_) {
+                        detail::cleanup_winsock();
+                    }
+                }
+
+                HttpConnectionPool(const HttpConnectionPool&) = delete;
+                HttpConnectionPool& operator=(const HttpConnectionPool&) = delete;
+
+                /**
+                 * @brief The pool behind Network::http_get() and Network::http_post()
+                 */
+                static HttpConnectionPool& shared() {
+                    // Leaked so requests made from other static destructors still work
+                    static HttpConnectionPool* pool = new HttpConnectionPool();
+                    return *pool;
+                }
+
+                /**
+                 * @brief Send a request and read the whole response
+                 *
+                 * @param method Request method, e.g. "GET" or "POST"
+                 * @param url An http:// URL
+                 * @param body Request body; sent with a Content-Length unless empty on a GET or HEAD
+                 * @param headers Extra request headers; Host, Content-Length and Connection are added
+                 * @return The response, or success == false and an error code
+                 */
+                HttpResponse request(const std::string& method, const std::string& url,
+                                     const std::string& body = "", const HeaderList& headers = HeaderList()) {
+                    std::string received;
+                    HttpResponse response = stream(method, url, [&received](const HttpResponse&, const char* data, size_t size) {
+                        received.append(data, size);
+                        return true;
+                    }, body, headers);
+                    response.body.swap(received);
+                    return response;
+                }
+
+                /**
+                 * @brief Send a request and pass the response body to sink as it arrives
+                 *
+                 * The sink sees the status and headers of the response with every
+                 * piece of the body, and HttpResponse::body stays empty. Returning
+                 * false from the sink stops the transfer (error 13) and closes the
+                 * connection.
+                 *
+                 * @param method Request method, e.g. "GET" or "POST"
+                 * @param url An http:// URL
+                 * @param sink Receives the response head and each piece of the decoded body
+                 * @param body Request body
+                 * @param headers Extra request headers
+                 * @return The status and headers, or success == false and an error code
+                 */
+                HttpResponse stream(const std::string& method, const std::string& url, const BodySink& sink,
+                                    const std::string& body = "", const HeaderList& headers = HeaderList()) {
+                    HttpResponse response;
+                    if (url.empty()) {
+                        return fail(response, 1, "URL is empty");
+                    }
+                    detail::HttpUrl parts;
+                    if (!detail::parse_http_url(url, parts)) {
+                        return fail(response, 6, "Invalid URL format");
+                    }
+                    if (parts.protocol == "https") {
+                        return fail(response, 11, "HTTPS is not supported");
+                    }
+                    if (!winsock_ready_) {
+                        return fail(response, 8, "Failed to initialize Winsock");
+                    }
+
+                    const std::string request_text = build_request(method, parts, body, headers);
+                    const std::string key = parts.host + ":" + std::to_string(parts.port);
+                    for (int attempt = 0; ; ++attempt) {
+                        bool reused = false;
+                        const int sockfd = acquire(key, parts, reused, response);
+                        if (sockfd < 0) {
+                            return response;
+                        }
+
+                        // The server may close an idle connection while the request is on its way
+                        const bool may_retry = reused && attempt == 0 && idempotent(method);
+                        bool closed_early = false;
+                        bool reusable = false;
+                        if (!detail::send_all(sockfd, request_text.data(), request_text.size())) {
+                            const bool reset = detail::connection_reset();
+                            release(key, sockfd, false);
+                            if (may_retry && reset) {
+                                continue;
+                            }
+                            return fail(response, 8, "Failed to send HTTP request");
+                        }
+                        if (!read_response(sockfd, method, response, sink, reusable, closed_early)) {
+                            release(key, sockfd, false);
+                            if (may_retry && closed_early) {
+                                response = HttpResponse();
+                                continue;
+                            }
+                            return response;
+                        }
+                        release(key, sockfd, reusable);
+                        response.success = true;
+                        response.error_code = 0;
+                        response.message = "Response received";
+                        return response;
+                    }
+                }
+
+                /**
+                 * @brief Number of TCP connections this pool has opened so far
+                 */
+                size_t connections_opened() const {
+                    return connections_opened_.load(std::memory_order_relaxed);
+                }
+
+                /**
+                 * @brief Number of connections waiting for reuse, over all hosts
+                 */
+                size_t idle_connections() {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    size_t count = 0;
+                    for (const auto& host : hosts_) {
+                        count += host.second.idle.size();
+                    }
+                    return count;
+                }
+
+                /**
+                 * @brief Close every idle connection
+                 */
+                void clear() {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    for (auto& host : hosts_) {
+                        for (const IdleConnection& connection : host.second.idle) {
+                            detail::close_socket(connection.sockfd);
+                        }
+                        host.second.open -= host.second.idle.size();
+                        host.second.idle.clear();
+                    }
+                    returned_.notify_all();
+                }
+
+            private:
+                static HttpResponse& fail(HttpResponse& response, int error_code, const std::string& message) {
+                    response.success = false;
+                    response.error_code = error_code;
+                    response.message = message;
+                    return response;
+                }
+
+                /**
+                 * @brief Whether sending the request twice has the same effect as sending it once
+                 */
+                static bool idempotent(const std::string& method) {
+                    return method == "GET" || method == "HEAD" || method == "PUT" || method == "DELETE" ||
+                           method == "OPTIONS";
+                }
+
+                static std::string build_request(const std::string& method, const detail::HttpUrl& parts,
+                                                 const std::string& body, const HeaderList& headers) {
+                    std::string text;
+                    text.reserve(128 + parts.path.size() + body.size());
+                    text += method;
+                    text += ' ';
+                    text += parts.path;
+                    text += " HTTP/1.1\r\nHost: ";
+                    text += parts.host;
+                    if (parts.port != 80) {
+                        text += ':';
+                        text += std::to_string(parts.port);
+                    }
+                    text += "\r\nConnection: keep-alive\r\n";
+                    if (!body.empty() || (method != "GET" && method != "HEAD")) {
+                        text += "Content-Length: ";
+                        text += std::to_string(body.size());
+                        text += "\r\n";
+                    }
+                    for (const auto& header : headers) {
+                        text += header.first;
+                        text += ": ";
+                        text += header.second;
+                        text += "\r\n";
+                    }
+                    text += "\r\n";
+                    text += body;
+                    return text;
+                }
+
+                /**
+                 * @brief Whether an idle connection is still usable: open, and with nothing unread
+                 */
+                static bool still_open(int sockfd) {
+        #ifdef _WIN32
+                    (void)sockfd;
+                    return true; // Stale connections are caught by the retry in request()
+        #else
+                    char byte;
+                    const ssize_t result = recv(sockfd, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+                    return result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        #endif
+                }
+
+                /**
+                 * @brief Take an idle connection for key, or open a new one when below the limit
+                 *
+                 * @return The socket, or -1 with the error in response
+                 */
+                int acquire(const std::string& key, const detail::HttpUrl& parts, bool& reused, HttpResponse& response) {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    HostConnections& host = hosts_[key];
+                    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(options_.timeout_seconds);
+                    for (;;) {
+                        const auto now = std::chrono::steady_clock::now();
+                        while (!host.idle.empty()) {
+                            const IdleConnection connection = host.idle.back();
+                            host.idle.pop_back();
+                            if (now - connection.since < options_.idle_timeout && still_open(connection.sockfd)) {
+                                reused = true;
+                                return connection.sockfd;
+                            }
+                            detail::close_socket(connection.sockfd);
+                            --host.open;
+                        }
+                        if (host.open < options_.max_per_host) {
+                            break;
+                        }
+                        if (returned_.wait_until(lock, deadline) == std::cv_status::timeout &&
+                            host.idle.empty() && host.open >= options_.max_per_host) {
+                            fail(response, 12, "Timed out waiting for a free connection");
+                            return -1;
+                        }
+                    }
+                    ++host.open;
+                    lock.unlock();
+
+                    const int sockfd = connect_to(parts);
+                    if (sockfd < 0) {
+                        release(key, -1, false);
+                        fail(response, 8, "Failed to connect to host");
+                        return -1;
+                    }
+                    connections_opened_.fetch_add(1, std::memory_order_relaxed);
+                    return sockfd;
+                }
+
+                /**
+                 * @brief Return a connection to the pool, or close it
+                 *
+                 * @param sockfd The connection, or -1 for a slot whose connect failed
+                 */
+                void release(const std::string& key, int sockfd, bool reusable) {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    HostConnections& host = hosts_[key];
+                    if (reusable && host.idle.size() < options_.max_idle_per_host) {
+                        host.idle.push_back({sockfd, std::chrono::steady_clock::now()});
+                    } else {
+                        if (sockfd >= 0) {
+                            detail::close_socket(sockfd);
+                        }
+                        --host.open;
+                    }
+                    returned_.notify_one();
+                }
+
+                int connect_to(const detail::HttpUrl& parts) const {
+                    struct addrinfo hints, *result = nullptr;
+                    memset(&hints, 0, sizeof(hints));
+                    hints.ai_family = AF_UNSPEC;
+                    hints.ai_socktype = SOCK_STREAM;
+
+                    const std::string port_str = std::to_string(parts.port);
+                    if (getaddrinfo(parts.host.c_str(), port_str.c_str(), &hints, &result) != 0) {
+                        return -1;
+                    }
+                    int sockfd = -1;
+                    for (struct addrinfo* address = result; address; address = address->ai_next) {
+                        sockfd = static_cast<int>(socket(address->ai_family, address->ai_socktype, address->ai_protocol));
+                        if (sockfd < 0) {
+                            continue;
+                        }
+                        // Set first: on Linux SO_SNDTIMEO also bounds connect()
+                        detail::set_socket_timeout(sockfd, options_.timeout_seconds);
+                        if (connect(sockfd, address->ai_addr, static_cast<int>(address->ai_addrlen)) == 0) {
+                            break;
+                        }
+                        detail::close_socket(sockfd);
+                        sockfd = -1;
+                    }
+                    freeaddrinfo(result);
+                    if (sockfd < 0) {
+                        return -1;
+                    }
+
+                    // Requests are small and written in one go; do not hold them back
+                    int enable = 1;
+                    setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, (const char*)&enable, sizeof(enable));
+        #ifdef SO_NOSIGPIPE
+                    setsockopt(sockfd, SOL_SOCKET, SO_NOSIGPIPE, (const char*)&enable, sizeof(enable));
+        #endif
+                    return sockfd;
+                }
+
+                /**
+                 * @brief Read one response, skipping interim 1xx responses
+                 *
+                 * Headers are collected in a string; body bytes go from the receive
+                 * buffer through an HttpBodyDecoder straight to sink.
+                 *
+                 * @param reusable Set to whether the connection can carry another request
+                 * @param closed_early Set if the peer closed or reset the connection before sending any byte
+                 * @return false with the error in response
+                 */
+                static bool read_response(int sockfd, const std::string& method, HttpResponse& response,
+                                          const BodySink& sink, bool& reusable, bool& closed_early) {
+                    static const size_t kMaxHeadSize = 64 * 1024;
+                    char buffer[16384];
+                    std::string head;
+                    size_t body_begin = 0;      // Start of the bytes after the head in buffer
+                    size_t received = 0;        // Bytes in buffer
+                    size_t leftover_begin = 0;  // Where head starts in buffer after an interim response
+                    bool http_1_0 = false;
+                    bool received_any = false;
+                    for (;;) {
+                        size_t head_end = head.find("\r\n\r\n");
+                        if (head_end != std::string::npos) {
+                            body_begin = leftover_begin + head_end + 4;
+                        }
+                        while (head_end == std::string::npos) {
+                            if (head.size() > kMaxHeadSize) {
+                                fail(response, 10, "HTTP response headers too large");
+                                return false;
+                            }
+                            const int count = static_cast<int>(recv(sockfd, buffer, sizeof(buffer), 0));
+                            if (count <= 0) {
+                                // A timeout (-1 with EAGAIN) is not a close: the server may still be working
+                                closed_early = !received_any && (count == 0 || detail::connection_reset());
+                                fail(response, 8, "Connection closed before the response headers");
+                                return false;
+                            }
+                            received_any = true;
+                            received = static_cast<size_t>(count);
+                            // Look for the blank line only in the bytes that could complete it
+                            const size_t searched = head.size() < 3 ? 0 : head.size() - 3;
+                            const size_t old_size = head.size();
+                            head.append(buffer, received);
+                            head_end = head.find("\r\n\r\n", searched);
+                            body_begin = head_end == std::string::npos ? received : head_end + 4 - old_size;
+                        }
+                        if (!parse_head(head.substr(0, head_end), response, http_1_0)) {
+                            fail(response, 10, "Malformed HTTP response headers");
+                            return false;
+                        }
+                        if (response.status_code >= 200 || response.status_code == 101) {
+                            break;
+                        }
+                        // An interim response; what follows it is the next head
+                        response.headers.clear();
+                        head.erase(0, head_end + 4);
+                        leftover_begin = body_begin;
+                    }
+
+                    const std::string connection = response.header("Connection");
+                    bool keep_alive = http_1_0 ? detail::header_has_token(connection, "keep-alive")
+                                               : !detail::header_has_token(connection, "close");
+
+                    HttpBodyDecoder decoder;
+                    if (!select_framing(method, response, decoder)) {
+                        fail(response, 10, "Invalid Content-Length");
+                        return false;
+                    }
+                    const auto body_sink = [&sink, &response](const char* data, size_t size) {
+                        return sink(response, data, size);
+                    };
+
+                    bool extra = false;         // Bytes after the end of the body
+                    const size_t pending = received - body_begin;
+                    if (pending > 0) {
+                        extra = decoder.feed(buffer + body_begin, pending, body_sink) < pending;
+                    }
+                    bool closed = false;
+                    while (!decoder.done() && !decoder.failed()) {
+                        const int count = static_cast<int>(recv(sockfd, buffer, sizeof(buffer), 0));
+                        if (count < 0) {
+                            fail(response, 8, "Network error while reading the body");
+                            return false;
+                        }
+                        if (count == 0) {
+                            closed = true;
+                            decoder.finish();
+                            break;
+                        }
+                        extra = decoder.feed(buffer, static_cast<size_t>(count), body_sink) < static_cast<size_t>(count);
+                    }
+                    if (decoder.failed()) {
+                        fail(response, decoder.aborted() ? 13 : closed ? 8 : 10, decoder.error());
+                        return false;
+                    }
+                    // Anything left over is not ours to interpret; do not reuse the connection
+                    reusable = keep_alive && !closed && !extra && decoder.framing() != HttpBodyDecoder::Framing::UNTIL_CLOSE &&
+                               response.status_code != 101;
+                    return true;
+                }
+
+                /**
+                 * @brief Set up decoder for the body framing of a response
+                 *
+                 * @return false if Content-Length is not a number
+                 */
+                static bool select_framing(const std::string& method, const HttpResponse& response, HttpBodyDecoder& decoder) {
+                    if (method == "HEAD" || response.status_code == 204 || response.status_code == 304 ||
+                        response.status_code == 101) {
+                        decoder = HttpBodyDecoder(HttpBodyDecoder::Framing::EMPTY);
+                        return true;
+                    }
+                    const std::string transfer_encoding = response.header("Transfer-Encoding");
+                    if (!transfer_encoding.empty() && detail::header_has_token(transfer_encoding, "chunked")) {
+                        decoder = HttpBodyDecoder(HttpBodyDecoder::Framing::CHUNKED);
+                        return true;
+                    }
+                    const std::string content_length = response.header("Content-Length");
+                    if (!content_length.empty()) {
+                        char* end = nullptr;
+                        const unsigned long long length = strtoull(content_length.c_str(), &end, 10);
+                        if (end == content_length.c_str() || *end != '\0') {
+                            return false;
+                        }
+                        decoder = HttpBodyDecoder(HttpBodyDecoder::Framing::LENGTH, length);
+                        return true;
+                    }
+                    decoder = HttpBodyDecoder(HttpBodyDecoder::Framing::UNTIL_CLOSE);
+                    return true;
+                }
+
+                /**
+                 * @brief Parse the status line and headers
+                 *
+                 * @param http_1_0 Set to whether the server answered with HTTP/1.0
+                 */
+                static bool parse_head(const std::string& head, HttpResponse& response, bool& http_1_0) {
+                    size_t line_end = head.find("\r\n");
+                    const std::string status_line = head.substr(0, line_end);
+                    if (status_line.compare(0, 5, "HTTP/") != 0) {
+                        return false;
+                    }
+                    const size_t code_start = status_line.find(' ');
+                    if (code_start == std::string::npos) {
+                        return false;
+                    }
+                    http_1_0 = status_line.compare(0, code_start, "HTTP/1.0") == 0;
+                    response.status_code = atoi(status_line.c_str() + code_start + 1);
+                    const size_t reason_start = status_line.find(' ', code_start + 1);
+                    response.reason = reason_start == std::string::npos ? std::string() : status_line.substr(reason_start + 1);
+                    if (response.status_code < 100 || response.status_code > 999) {
+                        return false;
+                    }
+
+                    while (line_end != std::string::npos) {
+                        const size_t start = line_end + 2;
+                        line_end = head.find("\r\n", start);
+                        const std::string line = head.substr(start, line_end == std::string::npos ? std::string::npos : line_end - start);
+                        const size_t colon = line.find(':');
+                        if (colon == std::string::npos || colon == 0) {
+                            return false;
+                        }
+                        size_t value_start = colon + 1;
+                        size_t value_end = line.size();
+                        while (value_start < value_end && (line[value_start] == ' ' || line[value_start] == '\t')) {
+                            ++value_start;
+                        }
+                        while (value_end > value_start && (line[value_end - 1] == ' ' || line[value_end - 1] == '\t')) {
+                            --value_end;
+                        }
+                        response.headers.emplace_back(line.substr(0, colon), line.substr(value_start, value_end - value_start));
+                    }
+                    return true;
+                }
+            };
+
+            /**
+             * @brief Network utility functions
+             *
+             * This class provides basic network functionality such as
+             * checking host reachability, downloading files, and performing HTTP GET requests.
+             * Note: This is a simplified implementation for demonstration purposes.
+             */
+            class Network {
+            private:
+                /**
+                 * @brief Initialize Windows Sockets API (Windows only)
+                 *
+                 * @return true if initialization successful or not needed, false on error
+                 */
+                static bool initialize_winsock() {
+                    return detail::initialize_winsock();
+                }
+
+                /**
+                 * @brief Cleanup Windows Sockets API (Windows only)
+                 */
+                static void cleanup_winsock() {
+                    detail::cleanup_winsock();
+                }
+
+                /**
+                 * @brief Set socket timeout values
+                 *
+                 * @param sockfd Socket file descriptor
+                 * @param timeout_seconds Timeout in seconds
+                 */
+                static void set_socket_timeout(int sockfd, int timeout_seconds) {
+                    detail::set_socket_timeout(sockfd, timeout_seconds);
+                }
+
+                /**
+                 * @brief Close socket connection
+                 *
+                 * @param sockfd Socket file descriptor
+                 */
+                static void close_socket(int sockfd) {
+                    detail::close_socket(sockfd);
+                }
+
                 /**
                  * @brief Get connection error details
                  *
@@ -390,7 +1393,11 @@ namespace interlaced {
                  * @brief Download file from URL
                  *
                  * Downloads a file from the specified URL and saves it to the destination path.
-                 * This implementation performs an HTTP GET request to retrieve the file content.
+                 * The request goes through HttpConnectionPool::shared(), so repeated downloads
+                 * from one host reuse its connection. The body is decoded as it arrives
+                 * (Content-Length, chunked, or until the server closes) and written straight
+                 * to the file; a body that ends early is reported as an error. The
+                 * destination is removed when the download fails.
                  *
                  * @param url The URL to download from
                  * @param destination The destination file path
@@ -401,8 +1408,8 @@ namespace interlaced {
                  * - 1: URL is empty
                  * - 2: Destination path is empty
                  * - 6: Invalid URL format
-                 * - 7: Failed to create output file
-                 * - 8: Network error during download
+                 * - 7: Failed to create or write the output file
+                 * - 8: Network error during download, including a truncated body
                  * - 9: HTTP error response
                  */
                 static NetworkResult download_file(const std::string& url, const std::string& destination) {
@@ -414,185 +1421,75 @@ namespace interlaced {
                         return NetworkResult(false, 2, "Destination path is empty");
                     }
 
-                    // Simple URL validation (check if it starts with http:// or https://)
-                    if (url.find("http://") != 0 && url.find("https://") != 0) {
+                    detail::HttpUrl parts;
+                    if (!detail::parse_http_url(url, parts)) {
                         return NetworkResult(false, 6, "Invalid URL format");
                     }
-
-                    // Parse URL to extract protocol, host, port, and path
-                    std::string protocol, host, path;
-                    int port = 80;
-
-                    size_t protocol_end = url.find("://");
-                    if (protocol_end != std::string::npos) {
-                        protocol = url.substr(0, protocol_end);
-                        if (protocol == "https") {
-                            // Note: This implementation doesn't actually handle HTTPS,
-                            // it would require additional libraries like OpenSSL
-                            port = 443;
-                        }
-
-                        size_t host_start = protocol_end + 3;
-                        size_t host_end = url.find("/", host_start);
-
-                        if (host_end == std::string::npos) {
-                            host = url.substr(host_start);
-                            path = "/";
-                        } else {
-                            host = url.substr(host_start, host_end - host_start);
-                            path = url.substr(host_end);
-                        }
-
-                        // Check if host contains port
-                        size_t port_pos = host.find(":");
-                        if (port_pos != std::string::npos) {
-                            std::string port_str = host.substr(port_pos + 1);
-                            host = host.substr(0, port_pos);
-                            port = atoi(port_str.c_str());
-                        }
-                    } else {
-                        return NetworkResult(false, 6, "Invalid URL format");
-                    }
-
-                    // Convert port to string
-                    std::string port_str = std::to_string(port);
-
-                    // Platform-specific socket initialization
-                    if (!initialize_winsock()) {
-                        return NetworkResult(false, 8, "Failed to initialize Winsock");
-                    }
-
-                    // Resolve hostname to IP address
-                    struct addrinfo hints, *result = nullptr;
-                    memset(&hints, 0, sizeof(hints));
-                    hints.ai_family = AF_UNSPEC;
-                    hints.ai_socktype = SOCK_STREAM;
-
-                    int status = getaddrinfo(host.c_str(), port_str.c_str(), &hints, &result);
-                    if (status != 0) {
-                        cleanup_winsock();
-                        return NetworkResult(false, 8, "Hostname resolution failed: " + std::string(gai_strerror(status)));
-                    }
-
-                    // Create socket
-                    int sockfd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
-                    if (sockfd < 0) {
-                        freeaddrinfo(result);
-                        cleanup_winsock();
-                        return NetworkResult(false, 8, "Failed to create socket");
-                    }
-
-                    // Set socket timeout (30 seconds)
-                    set_socket_timeout(sockfd, 30);
-
-                    // Attempt to connect
-                    status = connect(sockfd, result->ai_addr, result->ai_addrlen);
-                    if (status < 0) {
-                        freeaddrinfo(result);
-                        close_socket(sockfd);
-                        cleanup_winsock();
-                        return NetworkResult(false, 8, "Failed to connect to host");
-                    }
-
-                    // Send HTTP GET request
-                    std::string request = "GET " + path + " HTTP/1.1\r\n";
-                    request += "Host: " + host + "\r\n";
-                    request += "Connection: close\r\n\r\n";
-
-                    status = send(sockfd, request.c_str(), request.length(), 0);
-                    if (status < 0) {
-                        freeaddrinfo(result);
-                        close_socket(sockfd);
-                        cleanup_winsock();
-                        return NetworkResult(false, 8, "Failed to send HTTP request");
+                    if (parts.protocol == "https") {
+                        // This would require additional libraries like OpenSSL
+                        return NetworkResult(false, 8, "HTTPS is not supported");
                     }
 
                     // Open output file
                     FILE* file = fopen(destination.c_str(), "wb");
                     if (!file) {
-                        freeaddrinfo(result);
-                        close_socket(sockfd);
-                        cleanup_winsock();
                         return NetworkResult(false, 7, "Failed to create output file");
                     }
 
-                    // Receive HTTP response and write to file
-                    char buffer[4096];
-                    bool headers_parsed = false;
-                    std::string headers;
-
-                    while ((status = recv(sockfd, buffer, sizeof(buffer) - 1, 0)) > 0) {
-                        buffer[status] = '\0';
-
-                        if (!headers_parsed) {
-                            headers += buffer;
-                            size_t header_end = headers.find("\r\n\r\n");
-                            if (header_end != std::string::npos) {
-                                headers_parsed = true;
-                                std::string header_part = headers.substr(0, header_end);
-                                std::string body_part = headers.substr(header_end + 4);
-
-                                // Check HTTP status code
-                                size_t status_pos = header_part.find(" ");
-                                if (status_pos != std::string::npos) {
-                                    size_t status_end = header_part.find(" ", status_pos + 1);
-                                    if (status_end != std::string::npos) {
-                                        std::string status_code = header_part.substr(status_pos + 1, status_end - status_pos - 1);
-                                        int code = atoi(status_code.c_str());
-                                        if (code >= 400) {
-                                            fclose(file);
-                                            freeaddrinfo(result);
-                                            close_socket(sockfd);
-                                            cleanup_winsock();
-                                            return NetworkResult(false, 9, "HTTP error: " + status_code);
-                                        }
-                                    }
-                                }
-
-                                // Write body part to file
-                                fwrite(body_part.c_str(), 1, body_part.length(), file);
+                    // Body bytes go from the receive buffer to the file; error pages are read but not saved
+                    bool write_failed = false;
+                    HttpResponse response = HttpConnectionPool::shared().stream(
+                        "GET", url, [file, &write_failed](const HttpResponse& head, const char* data, size_t size) {
+                            if (head.status_code >= 400) {
+                                return true;
                             }
-                        } else {
-                            fwrite(buffer, 1, status, file);
-                        }
+                            if (fwrite(data, 1, size, file) != size) {
+                                write_failed = true;
+                                return false;
+                            }
+                            return true;
+                        });
+                    const bool closed = fclose(file) == 0;
+
+                    NetworkResult result(true, 0, "File downloaded successfully");
+                    if (write_failed || (!closed && response.success)) {
+                        result = NetworkResult(false, 7, "Failed to write output file");
+                    } else if (!response.success) {
+                        result = NetworkResult(false, 8, "Network error during download: " + response.message);
+                    } else if (response.status_code >= 400) {
+                        result = NetworkResult(false, 9, "HTTP error: " + std::to_string(response.status_code));
                     }
-
-                    // Clean up
-                    fclose(file);
-                    freeaddrinfo(result);
-                    close_socket(sockfd);
-                    cleanup_winsock();
-
-                    if (status < 0) {
-                        return NetworkResult(false, 8, "Network error during download");
+                    if (!result.success) {
+                        std::remove(destination.c_str());
                     }
-
-                    return NetworkResult(true, 0, "File downloaded successfully");
+                    return result;
                 }
 
                 /**
                  * @brief Perform an HTTP GET request
                  *
-                 * @param url The URL to request
-                 * @return std::string The HTTP response
+                 * Connections are kept open and reused through HttpConnectionPool::shared().
+                 *
+                 * @param url The http:// URL to request
+                 * @return HttpResponse with the status, headers and body, or an error
                  */
-                static std::string http_get(const std::string& url) {
-                    // Simplified implementation
-                    // In a real implementation, this would perform an HTTP GET request
-                    return "HTTP response from " + url;
+                static HttpResponse http_get(const std::string& url) {
+                    return HttpConnectionPool::shared().request("GET", url);
                 }
 
                 /**
                  * @brief Perform an HTTP POST request
                  *
-                 * @param url The URL to request
+                 * Connections are kept open and reused through HttpConnectionPool::shared().
+                 *
+                 * @param url The http:// URL to request
                  * @param payload The data to send in the POST request
-                 * @return std::string The HTTP response
+                 * @param content_type Value of the Content-Type header
+                 * @return HttpResponse with the status, headers and body, or an error
                  */
-                static std::string http_post(const std::string& url, const std::string& payload) {
-                    // Simplified implementation
-                    // In a real implementation, this would perform an HTTP POST request
-                    return "HTTP POST response from " + url + " with payload: " + payload;
+                static HttpResponse http_post(const std::string& url, const std::string& payload,
+                                              const std::string& content_type = "application/octet-stream") {
+                    return HttpConnectionPool::shared().request("POST", url, payload, {{"Content-Type", content_type}});
                 }
 
                 /**
@@ -29,6 +29,110 @@
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <atomic>
+#include <cstdlib>
+#include <cstdio>
+#include <new>
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#endif
+
+// Count heap allocations so the formatting pipeline can be checked for steady-state allocations.
+// Every form of operator new/delete is replaced so allocation and release always pair up.
+static std::atomic<size_t> g_allocation_count{0};
+
+static void* counted_allocate(std::size_t size) {
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+static void* counted_allocate(std::size_t size, std::align_val_t alignment) {
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    const std::size_t align = static_cast<std::size_t>(alignment);
+    // aligned_alloc requires the size to be a multiple of the alignment
+    const std::size_t rounded = ((size ? size : 1) + align - 1) / align * align;
+#ifdef _WIN32
+    void* ptr = _aligned_malloc(rounded, align);
+#else
+    void* ptr = std::aligned_alloc(align, rounded);
+#endif
+    if (ptr) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+static void counted_release_aligned(void* ptr) noexcept {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+void* operator new(std::size_t size) { return counted_allocate(size); }
+void* operator new[](std::size_t size) { return counted_allocate(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try { return counted_allocate(size); } catch (...) { return nullptr; }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try { return counted_allocate(size); } catch (...) { return nullptr; }
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return counted_allocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return counted_allocate(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try { return counted_allocate(size, alignment); } catch (...) { return nullptr; }
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try { return counted_allocate(size, alignment); } catch (...) { return nullptr; }
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::align_val_t) noexcept { counted_release_aligned(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { counted_release_aligned(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { counted_release_aligned(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { counted_release_aligned(ptr); }
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    counted_release_aligned(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    counted_release_aligned(ptr);
+}
+
+// Stream buffer that discards everything, so stream growth does not count as an allocation
+class NullBuffer : public std::streambuf {
+protected:
+    int_type overflow(int_type ch) override {
+        return traits_type::not_eof(ch);
+    }
+    
+    std::streamsize xsputn(const char*, std::streamsize n) override {
+        return n;
+    }
+};
 
 // Custom formatter example
 class CustomFormatter : public interlaced::core::logging::LogFormatter {
@@ -198,50 +302,2383 @@ void test_file_logging() {
     Logger::set_file_logging("", 0, 0); // This won't actually work, but we're just testing
 }
 
-int main() {
+// Test function for lock-free level filtering
+void test_level_filtering() {
     using namespace interlaced::core::logging;
     
-    std::cout << "=== Starting Comprehensive Logging Tests ===" << std::endl;
+    std::cout << "Testing level filtering..." << std::endl;
     
-    // Test log level to string conversion
-    test_log_level_to_string();
+    std::ostringstream output_stream, error_stream;
+    Logger::set_output_streams(output_stream, error_stream);
+    Logger::set_level(LOG_WARNING);
     
-    // Test basic logging
-    Logger::info("Starting comprehensive logging tests");
+    if (Logger::get_level() != LOG_WARNING) {
+        std::cerr << "ERROR: get_level did not return the level that was set" << std::endl;
+    }
     
-    // Test different log levels
-    Logger::debug("This is a debug message");
-    Logger::info("This is an info message");
-    Logger::warning("This is a warning message");
-    Logger::error("This is an error message");
+    if (Logger::is_enabled(LOG_INFO) || !Logger::is_enabled(LOG_WARNING) || !Logger::is_enabled(LOG_ERROR)) {
+        std::cerr << "ERROR: is_enabled does not match the current level" << std::endl;
+    }
     
-    // Test log level filtering
-    Logger::set_level(LOG_WARNING);
-    Logger::info("This info message should NOT appear");
-    Logger::warning("This warning message SHOULD appear");
-    Logger::error("This error message SHOULD appear");
+    Logger::info("Filtered info {}", 1);
+    Logger::info("Filtered info", "key", 1);
+    Logger::warning("Visible warning {}", 2);
+    
+    if (output_stream.str().find("Filtered info") != std::string::npos) {
+        std::cerr << "ERROR: Filtered message was written" << std::endl;
+    } else if (output_stream.str().find("Visible warning 2") == std::string::npos) {
+        std::cerr << "ERROR: Warning message was not written" << std::endl;
+    } else if (!Logger::compiled_in(LOG_ERROR)) {
+        std::cerr << "ERROR: ERROR level should always be compiled in" << std::endl;
+    } else {
+        std::cout << "Level filtering tests passed!" << std::endl;
+    }
     
+    // Reset to default streams and level
     Logger::set_level(LOG_DEBUG);
+    Logger::set_output_streams(std::cout, std::cerr);
+}
+
+// Test function for allocation-free formatting
+void test_allocation_free_formatting() {
+    using namespace interlaced::core::logging;
     
-    // Test file/line information
-    LOG_INFO("This message includes file and line info");
-    LOG_ERROR("This error includes file and line info");
+    std::cout << "Testing allocation-free formatting..." << std::endl;
     
-    // Test structured logging
-    Logger::info("User login", "user_id", 12345, "ip_address", "192.168.1.1");
-    Logger::warning("High memory usage", "used_mb", 850, "limit_mb", 1000);
-    Logger::error("Database connection failed", "error_code", 500, "server", "db01.prod");
+    NullBuffer null_buffer;
+    std::ostream null_stream(&null_buffer);
+    Logger::set_output_streams(null_stream, null_stream);
+    Logger::set_level(LOG_DEBUG);
     
-    // Test variadic template logging
-    Logger::info("User {} logged in from IP {}", "john_doe", "192.168.1.100");
-    Logger::warning("Disk usage is at {}%", 95);
-    Logger::error("Database connection failed with code {} for user {}", 500, "admin");
+    const std::string long_message(200, 'x');
+    const std::string key = "request_id";
+    auto log_batch = [&]() {
+        Logger::info("Value {} and {} and {} and {}", 42, 3.5, "text", long_message);
+        Logger::info(long_message);
+        Logger::warning(long_message, __FILE__, __LINE__);
+        Logger::log(LOG_ERROR, long_message, key, 12345, "ok", true);
+    };
     
-    // Test custom streams
-    test_custom_streams();
+    // Warm up the per-thread buffers
+    for (int i = 0; i < 10; ++i) {
+        log_batch();
+    }
     
-    // Test custom formatter
-    test_custom_formatter();
+    size_t before = g_allocation_count.load();
+    for (int i = 0; i < 1000; ++i) {
+        log_batch();
+    }
+    size_t allocations = g_allocation_count.load() - before;
+    
+    // The formatted text must be unchanged by the new pipeline
+    std::string expected_values = "Value 42 and 3.5 and text and " + long_message;
+    std::string formatted;
+    Logger::format_message_to(formatted, "Value {} and {} and {} and {}", 42, 3.5, "text", long_message);
+    
+    if (allocations != 0) {
+        std::cerr << "ERROR: Steady-state logging performed " << allocations << " heap allocations" << std::endl;
+    } else if (formatted != expected_values) {
+        std::cerr << "ERROR: format_message_to produced '" << formatted << "'" << std::endl;
+    } else {
+        std::cout << "Allocation-free formatting tests passed!" << std::endl;
+    }
+    
+    // Reset to default streams
+    Logger::set_output_streams(std::cout, std::cerr);
+}
+
+// Test function for timestamp formats and precision
+void test_timestamp_formats() {
+    using namespace interlaced::core::logging;
+    
+    std::cout << "Testing timestamp formats..." << std::endl;
+    
+    // 2023-11-14 22:13:20 UTC plus 123456789 nanoseconds
+    const auto base = std::chrono::system_clock::from_time_t(1700000000);
+    const auto time = base + std::chrono::duration_cast<std::chrono::system_clock::duration>(
+        std::chrono::nanoseconds(123456789));
+    
+    auto format_at = [](DefaultLogFormatter& formatter, std::chrono::system_clock::time_point when) {
+        LogRecord record;
+        record.level = LOG_INFO;
+        record.message = "Timestamp test";
+        record.time = when;
+        std::string out;
+        formatter.format_to(out, record);
+        return out;
+    };
+    
+    DefaultLogFormatter iso(TimestampFormat::ISO8601, "", TimestampPrecision::MILLISECONDS);
+    DefaultLogFormatter unix_seconds(TimestampFormat::UNIX);
+    DefaultLogFormatter unix_micro(TimestampFormat::UNIX, "", TimestampPrecision::MICROSECONDS);
+    DefaultLogFormatter standard(TimestampFormat::STANDARD, "app", TimestampPrecision::MILLISECONDS);
+    DefaultLogFormatter none(TimestampFormat::NONE);
+    
+    // Local time rendering of the same instant for the STANDARD format
+    std::time_t seconds = 1700000000;
+    std::tm local_tm;
+    localtime_threadsafe(&seconds, &local_tm);
+    char local_text[32];
+    std::strftime(local_text, sizeof(local_text), "%Y-%m-%d %H:%M:%S", &local_tm);
+    
+    struct Case {
+        std::string actual;
+        std::string expected;
+    } cases[] = {
+        {format_at(iso, time), "[2023-11-14T22:13:20.123Z] [INFO] Timestamp test"},
+        {format_at(unix_seconds, time), "[1700000000] [INFO] Timestamp test"},
+        {format_at(unix_micro, time), "[1700000000.123456] [INFO] Timestamp test"},
+        {format_at(standard, time), "app [" + std::string(local_text) + ".123] [INFO] Timestamp test"},
+        {format_at(none, time), "[INFO] Timestamp test"},
+        // The next second must refresh the cached prefix
+        {format_at(iso, time + std::chrono::seconds(1)), "[2023-11-14T22:13:21.123Z] [INFO] Timestamp test"},
+        {format_at(iso, time), "[2023-11-14T22:13:20.123Z] [INFO] Timestamp test"},
+    };
+    
+    for (const auto& test_case : cases) {
+        if (test_case.actual != test_case.expected) {
+            std::cerr << "ERROR: Expected '" << test_case.expected << "', got '" << test_case.actual << "'" << std::endl;
+            return;
+        }
+    }
+    
+    // The std::tm overload must agree with the record overload
+    std::string legacy = iso.format(LOG_INFO, "Timestamp test", local_tm);
+    if (legacy != "[2023-11-14T22:13:20.000Z] [INFO] Timestamp test") {
+        std::cerr << "ERROR: format() with std::tm produced '" << legacy << "'" << std::endl;
+        return;
+    }
+    
+    std::cout << "Timestamp format tests passed!" << std::endl;
+}
+
+// Test function for file flush policies
+void test_flush_policies() {
+    using namespace interlaced::core::logging;
+    
+    std::cout << "Testing file flush policies..." << std::endl;
+    
+    const std::string test_file = "flush_policy_test.log";
+    const std::string message(99, 'm'); // 100 bytes per line including the newline
+    
+    auto remove_generations = [&test_file]() {
+        std::filesystem::remove(test_file);
+        for (int i = 1; i <= 3; ++i) {
+            std::filesystem::remove(test_file + "." + std::to_string(i));
+        }
+    };
+    remove_generations();
+    
+    {
+        // Explicit-only: nothing reaches the file until flush()
+        RotatingFileLogger file_logger(test_file, 1000000, 3, FlushPolicy::explicit_only());
+        for (int i = 0; i < 5; ++i) {
+            file_logger.write(message, LOG_ERROR);
+        }
+        if (std::filesystem::file_size(test_file) != 0 || file_logger.current_file_size() != 500) {
+            std::cerr << "ERROR: Explicit-only policy wrote before flush()" << std::endl;
+            return;
+        }
+        file_logger.flush();
+        if (std::filesystem::file_size(test_file) != 500 || file_logger.buffered_bytes() != 0) {
+            std::cerr << "ERROR: flush() did not write the buffered messages" << std::endl;
+            return;
+        }
+        
+        // Level trigger: INFO stays buffered, ERROR flushes
+        file_logger.set_flush_policy(FlushPolicy::on_level(LOG_ERROR));
+        file_logger.write(message, LOG_INFO);
+        if (std::filesystem::file_size(test_file) != 500) {
+            std::cerr << "ERROR: INFO message was flushed by the level policy" << std::endl;
+            return;
+        }
+        file_logger.write(message, LOG_ERROR);
+        if (std::filesystem::file_size(test_file) != 700) {
+            std::cerr << "ERROR: ERROR message did not trigger a flush" << std::endl;
+            return;
+        }
+        
+        // Byte trigger: flush once 300 bytes are buffered
+        file_logger.set_flush_policy(FlushPolicy::every_bytes(300));
+        file_logger.write(message);
+        file_logger.write(message);
+        if (std::filesystem::file_size(test_file) != 700) {
+            std::cerr << "ERROR: Byte policy flushed too early" << std::endl;
+            return;
+        }
+        file_logger.write(message);
+        if (std::filesystem::file_size(test_file) != 1000) {
+            std::cerr << "ERROR: Byte policy did not flush at the threshold" << std::endl;
+            return;
+        }
+        
+        // Buffered data is written on destruction
+        file_logger.set_flush_policy(FlushPolicy::explicit_only());
+        file_logger.write(message);
+    }
+    if (std::filesystem::file_size(test_file) != 1100) {
+        std::cerr << "ERROR: Buffered data was not written on destruction" << std::endl;
+        return;
+    }
+    remove_generations();
+    
+    {
+        // Size-based rotation must be exact even while messages are buffered
+        RotatingFileLogger file_logger(test_file, 1000, 3, FlushPolicy::explicit_only());
+        for (int i = 0; i < 25; ++i) {
+            file_logger.write(message);
+        }
+    }
+    if (std::filesystem::file_size(test_file + ".2") != 1000 ||
+        std::filesystem::file_size(test_file + ".1") != 1000 ||
+        std::filesystem::file_size(test_file) != 500) {
+        std::cerr << "ERROR: Buffered rotation produced unexpected file sizes" << std::endl;
+        return;
+    }
+    remove_generations();
+    
+    std::cout << "File flush policy tests passed!" << std::endl;
+}
+
+// Test function for rotation with a pre-opened next file and wall-clock boundaries
+void test_background_rotation() {
+    using namespace interlaced::core::logging;
+    
+    std::cout << "Testing background rotation..." << std::endl;
+    
+    const std::string test_file = "background_rotation_test.log";
+    const std::string message(99, 'r'); // 100 bytes per line including the newline
+    
+    auto remove_generations = [&test_file]() {
+        std::filesystem::remove(test_file);
+        std::filesystem::remove(test_file + ".next");
+        for (int i = 1; i <= 4; ++i) {
+            std::filesystem::remove(test_file + "." + std::to_string(i));
+        }
+    };
+    remove_generations();
+    
+    {
+        RotatingFileLogger file_logger(test_file, 1000, 3, FlushPolicy::every_message());
+        for (int i = 0; i < 45; ++i) {
+            file_logger.write(message);
+        }
+        file_logger.wait_for_rotation();
+        
+        // Generations have their final names while the logger is still writing
+        if (std::filesystem::file_size(test_file + ".3") != 1000 ||
+            std::filesystem::file_size(test_file + ".2") != 1000 ||
+            std::filesystem::file_size(test_file + ".1") != 1000 ||
+            std::filesystem::file_size(test_file) != 500 ||
+            std::filesystem::exists(test_file + ".4")) {
+            std::cerr << "ERROR: Background rotation produced unexpected generations" << std::endl;
+            return;
+        }
+#ifndef _WIN32
+        if (!std::filesystem::exists(test_file + ".next")) {
+            std::cerr << "ERROR: Next log file was not prepared ahead of rotation" << std::endl;
+            return;
+        }
+#endif
+    }
+    if (std::filesystem::exists(test_file + ".next")) {
+        std::cerr << "ERROR: Unused next log file was not removed" << std::endl;
+        return;
+    }
+    remove_generations();
+    
+    // Files a crash left between the rename and the background shift become generations
+    {
+        auto write_file = [](const std::string& name, const std::string& text) {
+            std::ofstream(name) << text;
+        };
+        write_file(test_file + ".1", "finished\n");
+        write_file(test_file + ".rotating.3", "older\n");
+        write_file(test_file + ".rotating.5", "newer\n");
+        RotatingFileLogger file_logger(test_file, 1000, 3, FlushPolicy::every_message());
+        auto read_file = [](const std::string& name) {
+            std::ifstream input(name);
+            return std::string((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+        };
+        if (read_file(test_file + ".1") != "newer\n" || read_file(test_file + ".2") != "older\n" ||
+            read_file(test_file + ".3") != "finished\n" || std::filesystem::exists(test_file + ".rotating.3") ||
+            std::filesystem::exists(test_file + ".rotating.5")) {
+            std::cerr << "ERROR: Leftover rotated files were not moved into the generations" << std::endl;
+            return;
+        }
+    }
+    remove_generations();
+    
+    // Time-based rotation falls on wall-clock boundaries
+    std::tm date = {};
+    date.tm_year = 2024 - 1900;
+    date.tm_mon = 2;
+    date.tm_mday = 10;
+    date.tm_hour = 13;
+    date.tm_min = 27;
+    date.tm_isdst = -1;
+    auto now = std::chrono::system_clock::from_time_t(std::mktime(&date));
+    
+    auto boundary_of = [now](int hours) {
+        std::time_t time = std::chrono::system_clock::to_time_t(
+            detail::next_rotation_boundary(now, std::chrono::hours(hours)));
+        std::tm result;
+        localtime_threadsafe(&time, &result);
+        return result;
+    };
+    std::tm hourly = boundary_of(1);
+    std::tm six_hourly = boundary_of(6);
+    std::tm daily = boundary_of(24);
+    if (hourly.tm_mday != 10 || hourly.tm_hour != 14 || hourly.tm_min != 0 ||
+        six_hourly.tm_mday != 10 || six_hourly.tm_hour != 18 ||
+        daily.tm_mday != 11 || daily.tm_hour != 0 || daily.tm_min != 0) {
+        std::cerr << "ERROR: Rotation boundaries are not aligned to the wall clock" << std::endl;
+        return;
+    }
+    
+    std::cout << "Background rotation tests passed!" << std::endl;
+}
+
+// Test function for compressed rotated generations
+void test_compressed_rotation() {
+    using namespace interlaced::core::logging;
+    
+    std::cout << "Testing compressed rotation..." << std::endl;
+    
+    // Round trip through the frame format: repetitive, random and empty input
+    const std::string plain_file = "compression_test.txt";
+    const std::string packed_file = "compression_test.txt.iclz";
+    std::string original;
+    for (int i = 0; i < 20000; ++i) {
+        original += "[INFO] request " + std::to_string(i % 97) + " served in " + std::to_string(i % 13) + "ms\n";
+    }
+    unsigned int seed = 12345;
+    for (int i = 0; i < 100000; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        original.push_back(static_cast<char>(seed >> 16));
+    }
+    for (const std::string& input : {original, std::string()}) {
+        {
+            std::ofstream out(plain_file, std::ios::binary | std::ios::trunc);
+            out << input;
+        }
+        if (!detail::compress_log_file(plain_file, packed_file)) {
+            std::cerr << "ERROR: Failed to compress a log file" << std::endl;
+            return;
+        }
+        detail::CompressedLogInput packed;
+        std::string decoded;
+        if (!packed.open(packed_file)) {
+            std::cerr << "ERROR: Failed to open a compressed log file" << std::endl;
+            return;
+        }
+        while (packed.next_block(decoded)) {
+        }
+        if (packed.failed() || decoded != input) {
+            std::cerr << "ERROR: Compressed log did not round trip" << std::endl;
+            return;
+        }
+    }
+    if (std::filesystem::file_size(packed_file) > 20) {
+        // The empty input above should produce only the header and end marker
+        std::cerr << "ERROR: Empty compressed log has unexpected size" << std::endl;
+        return;
+    }
+    
+    // A truncated frame is reported instead of returning garbage
+    {
+        std::ofstream out(plain_file, std::ios::binary | std::ios::trunc);
+        out << original.substr(0, 200000);
+    }
+    detail::compress_log_file(plain_file, packed_file);
+    std::filesystem::resize_file(packed_file, std::filesystem::file_size(packed_file) / 2);
+    {
+        detail::CompressedLogInput packed;
+        std::string decoded;
+        packed.open(packed_file);
+        while (packed.next_block(decoded)) {
+        }
+        if (!packed.failed()) {
+            std::cerr << "ERROR: Truncated compressed log was not detected" << std::endl;
+            return;
+        }
+    }
+    std::filesystem::remove(plain_file);
+    std::filesystem::remove(packed_file);
+    
+    // Rotated generations are compressed and read back transparently
+    const std::string test_file = "compressed_rotation_test.log";
+    auto remove_generations = [&test_file]() {
+        std::filesystem::remove(test_file);
+        for (int i = 1; i <= 4; ++i) {
+            std::filesystem::remove(test_file + "." + std::to_string(i));
+            std::filesystem::remove(test_file + "." + std::to_string(i) + ".iclz");
+        }
+    };
+    remove_generations();
+    
+    const int total = 2000;
+    {
+        RotatingFileLogger file_logger(test_file, 10000, 3, FlushPolicy::explicit_only());
+        for (int i = 0; i < 500; ++i) {
+            file_logger.write("message number " + std::to_string(i) + " with some repeated padding text");
+        }
+        file_logger.wait_for_rotation();
+        file_logger.set_compression(LogCompression::LZ);
+        for (int i = 500; i < total; ++i) {
+            file_logger.write("message number " + std::to_string(i) + " with some repeated padding text");
+        }
+        file_logger.wait_for_rotation();
+        
+        if (!std::filesystem::exists(test_file + ".1.iclz") || std::filesystem::exists(test_file + ".1") ||
+            std::filesystem::exists(test_file + ".4") || std::filesystem::exists(test_file + ".4.iclz")) {
+            std::cerr << "ERROR: Rotated generations were not compressed as expected" << std::endl;
+            return;
+        }
+        if (std::filesystem::file_size(test_file + ".1.iclz") >= 10000 / 2) {
+            std::cerr << "ERROR: Compressed generation is not smaller" << std::endl;
+            return;
+        }
+    }
+    
+    // The reader returns the newest lines in order, ending with the last one written
+    RotatedLogReader reader(test_file, 3);
+    std::vector<std::string> lines;
+    std::string line;
+    while (reader.next_line(line)) {
+        lines.push_back(line);
+    }
+    if (reader.file_count() != 4 || reader.failed() || lines.empty()) {
+        std::cerr << "ERROR: Rotated log reader found unexpected files" << std::endl;
+        return;
+    }
+    const int first = total - static_cast<int>(lines.size());
+    for (size_t i = 0; i < lines.size(); ++i) {
+        if (lines[i] != "message number " + std::to_string(first + static_cast<int>(i)) + " with some repeated padding text") {
+            std::cerr << "ERROR: Rotated log reader returned unexpected line: " << lines[i] << std::endl;
+            return;
+        }
+    }
+    remove_generations();
+    
+    std::cout << "Compressed rotation tests passed!" << std::endl;
+}
+
+// Count the lines written to a string stream
+size_t count_lines(const std::string& text) {
+    size_t lines = 0;
+    for (char c : text) {
+        if (c == '\n') {
+            ++lines;
+        }
+    }
+    return lines;
+}
+
+// Test function for asynchronous logging
+void test_async_file_writes() {
+    using namespace interlaced::core::logging;
+    
+    std::cout << "Testing asynchronous file writes..." << std::endl;
+    
+    bool ok = true;
+    for (bool use_io_uring : {true, false}) {
+        const std::string test_file = use_io_uring ? "async_uring_test.log" : "async_thread_test.log";
+        auto remove_generations = [&test_file]() {
+            std::filesystem::remove(test_file);
+            for (int i = 1; i <= 4; ++i) {
+                std::filesystem::remove(test_file + "." + std::to_string(i));
+            }
+            std::filesystem::remove(test_file + ".next");
+        };
+        remove_generations();
+        
+        AsyncWriteOptions options;
+        options.max_in_flight = 2;
+        options.buffer_size = 4096;
+        options.use_io_uring = use_io_uring;
+        uint64_t bytes = 0;
+        AsyncWriteStats stats;
+        {
+            // Flushes larger than the write buffers, with only two in flight
+            RotatingFileLogger logger(test_file, 64 * 1024, 4, FlushPolicy::every_bytes(10000));
+            logger.enable_async_writes(options);
+            for (int i = 0; i < 3000; ++i) {
+                const std::string line = "Async line " + std::to_string(i) + " " + std::string(static_cast<size_t>(i % 50), 'x');
+                logger.write(line);
+                bytes += line.size() + 1;
+            }
+            logger.flush();
+            logger.wait_for_writes();
+            logger.wait_for_rotation();
+            stats = logger.async_write_stats();
+        }
+        
+        if (stats.completed != stats.submitted || stats.failed != 0 || stats.in_flight != 0 ||
+            stats.bytes_written != bytes || stats.max_in_flight > 2 || stats.submitted == 0) {
+            std::cerr << "ERROR: Unexpected asynchronous write stats (submitted " << stats.submitted
+                      << ", completed " << stats.completed << ", bytes " << stats.bytes_written << " of " << bytes
+                      << ")" << std::endl;
+            ok = false;
+        }
+        if (!use_io_uring && stats.io_uring) {
+            std::cerr << "ERROR: io_uring was used although it was turned off" << std::endl;
+            ok = false;
+        }
+        
+        // Every generation holds whole lines in order, ending with the last one
+        RotatedLogReader reader(test_file, 4);
+        std::string line;
+        int expected = -1;
+        int lines = 0;
+        while (reader.next_line(line)) {
+            int number = -1;
+            if (std::sscanf(line.c_str(), "Async line %d", &number) != 1 || (expected >= 0 && number != expected) ||
+                line.size() != line.find(' ', 11) + 1 + static_cast<size_t>(number % 50)) {
+                std::cerr << "ERROR: Corrupt or reordered asynchronous line '" << line << "'" << std::endl;
+                ok = false;
+                break;
+            }
+            expected = number + 1;
+            ++lines;
+        }
+        if (expected != 3000 || lines < 1000 || reader.file_count() < 2) {
+            std::cerr << "ERROR: Asynchronous writes lost lines (last " << expected - 1 << ")" << std::endl;
+            ok = false;
+        }
+        remove_generations();
+    }
+    
+    if (ok) {
+        std::cout << "Asynchronous file write tests passed!" << std::endl;
+    }
+}
+
+void test_async_logging() {
+    using namespace interlaced::core::logging;
+    
+    std::cout << "Testing asynchronous logging..." << std::endl;
+    
+    std::ostringstream output_stream, error_stream;
+    Logger::set_output_streams(output_stream, error_stream);
+    Logger::set_level(LOG_DEBUG);
+    
+    // Blocking policy: every message from every thread must arrive
+    Logger::set_async(64, OverflowPolicy::BLOCK);
+    if (!Logger::is_async()) {
+        std::cerr << "ERROR: Logger did not switch to asynchronous mode" << std::endl;
+        Logger::set_sync();
+        Logger::set_output_streams(std::cout, std::cerr);
+        return;
+    }
+    
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 4; ++t) {
+        producers.emplace_back([t]() {
+            for (int i = 0; i < 250; ++i) {
+                Logger::info("Async thread {} message {}", t, i);
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    Logger::flush();
+    
+    if (count_lines(output_stream.str()) != 1000) {
+        std::cerr << "ERROR: Expected 1000 async messages after flush, got "
+                  << count_lines(output_stream.str()) << std::endl;
+    }
+    
+    // Dropping policies: every message is either written or counted as dropped
+    const OverflowPolicy dropping[] = {OverflowPolicy::DROP, OverflowPolicy::DROP_OLDEST};
+    for (OverflowPolicy policy : dropping) {
+        output_stream.str("");
+        Logger::set_async(4, policy);
+        for (int i = 0; i < 1000; ++i) {
+            Logger::info("Dropping policy message {}", i);
+        }
+        Logger::flush();
+        size_t written = count_lines(output_stream.str());
+        if (written + Logger::dropped_messages() != 1000) {
+            std::cerr << "ERROR: Written (" << written << ") plus dropped (" << Logger::dropped_messages()
+                      << ") messages should equal 1000" << std::endl;
+        }
+    }
+    
+    // Switching back to synchronous mode drains the queue
+    output_stream.str("");
+    Logger::set_async(1024, OverflowPolicy::BLOCK);
+    for (int i = 0; i < 100; ++i) {
+        Logger::info("Message drained on shutdown {}", i);
+    }
+    Logger::set_sync();
+    
+    if (Logger::is_async() || count_lines(output_stream.str()) != 100) {
+        std::cerr << "ERROR: Switching to synchronous mode did not drain the queue" << std::endl;
+    } else {
+        std::cout << "Asynchronous logging tests passed!" << std::endl;
+    }
+    
+    // Reset to default streams
+    Logger::set_output_streams(std::cout, std::cerr);
+}
+
+void test_compile_time_format() {
+    using namespace interlaced::core::logging;
+    
+    std::cout << "Testing compile-time format strings..." << std::endl;
+    
+    // The placeholder scan is usable in constant expressions
+    static_assert(detail::count_placeholders("a {} b {}{} c") == 3, "placeholder count");
+    static_assert(detail::parse_format<2>("x={} y={}!").lengths[2] == 1, "trailing segment");
+    
+    bool ok = true;
+    std::string compiled;
+    Logger::format_message_to(compiled, INTERLACED_FORMAT("User {} from {} ({}%, ok={}) {}{}"),
+                              "john_doe", std::string("10.0.0.1"), 99.5, true, 'A', 7);
+    std::string runtime;
+    Logger::format_message_to(runtime, "User {} from {} ({}%, ok={}) {}{}",
+                              "john_doe", std::string("10.0.0.1"), 99.5, true, 'A', 7);
+    if (compiled != runtime || compiled != "User john_doe from 10.0.0.1 (99.5%, ok=1) A7") {
+        std::cerr << "ERROR: Compile-time format produced '" << compiled << "'" << std::endl;
+        ok = false;
+    }
+    
+    compiled.clear();
+    Logger::format_message_to(compiled, INTERLACED_FORMAT("No placeholders"));
+    if (compiled != "No placeholders") {
+        std::cerr << "ERROR: Compile-time format without placeholders produced '" << compiled << "'" << std::endl;
+        ok = false;
+    }
+    
+    // The legacy stream helper writes literal runs in bulk with the same result
+    std::ostringstream oss;
+    Logger::format_message(oss, "a {} b {} c", 1, "two");
+    if (oss.str() != "a 1 b two c") {
+        std::cerr << "ERROR: format_message produced '" << oss.str() << "'" << std::endl;
+        ok = false;
+    }
+    
+    std::ostringstream output_stream, error_stream;
+    Logger::set_output_streams(output_stream, error_stream);
+    Logger::set_level(LOG_DEBUG);
+    Logger::info(INTERLACED_FORMAT("Compiled {} of {}"), 1, 2);
+    Logger::error(INTERLACED_FORMAT("Compiled error {}"), "E42");
+    Logger::set_level(LOG_WARNING);
+    Logger::debug(INTERLACED_FORMAT("Filtered {}"), 3);
+    Logger::set_level(LOG_DEBUG);
+    if (output_stream.str().find("[INFO] Compiled 1 of 2") == std::string::npos ||
+        error_stream.str().find("[ERROR] Compiled error E42") == std::string::npos ||
+        output_stream.str().find("Filtered") != std::string::npos) {
+        std::cerr << "ERROR: Compile-time format logging output is wrong" << std::endl;
+        ok = false;
+    }
+    
+    if (ok) {
+        std::cout << "Compile-time format tests passed!" << std::endl;
+    }
+    
+    Logger::set_output_streams(std::cout, std::cerr);
+}
+
+void test_binary_logging() {
+    using namespace interlaced::core::logging;
+    
+    std::cout << "Testing binary logging..." << std::endl;
+    
+    const std::string filename = "binary_test.binlog";
+    std::filesystem::remove(filename);
+    
+    std::ostringstream output_stream, error_stream;
+    Logger::set_output_streams(output_stream, error_stream);
+    Logger::set_level(LOG_DEBUG);
+    
+    Logger::set_binary_logging(filename);
+    if (!Logger::is_binary()) {
+        std::cerr << "ERROR: Logger did not switch to binary logging" << std::endl;
+        Logger::set_output_streams(std::cout, std::cerr);
+        return;
+    }
+    
+    std::string runtime_format = "Runtime format {}";
+    std::vector<std::string> expected;
+    Logger::info("User {} logged in from {} after {} attempts ({}%, ok={}, grade {})",
+                 std::string("john_doe"), "10.0.0.1", 3u, 99.5, true, 'A');
+    expected.push_back("User john_doe logged in from 10.0.0.1 after 3 attempts (99.5%, ok=1, grade A)");
+    Logger::warning("Negative {} and extra args", -42, "ignored");
+    expected.push_back("Negative -42 and extra args");
+    Logger::error("Missing {} and {}", 1);
+    expected.push_back("Missing 1 and {}");
+    Logger::debug("Pointer-free custom type {}", std::chrono::seconds(5).count());
+    expected.push_back("Pointer-free custom type 5");
+    Logger::info(runtime_format.c_str(), 1);
+    expected.push_back("Runtime format 1");
+    runtime_format = "Changed format {}"; // Same buffer, new contents
+    Logger::info(runtime_format.c_str(), 2);
+    expected.push_back("Changed format 2");
+    Logger::info(std::string("Plain message"));
+    expected.push_back("Plain message");
+    Logger::info(std::string("Structured"), "user_id", 7, "role", "admin");
+    expected.push_back("Structured user_id=7 role=admin");
+    Logger::warning(std::string("With location"), "logging_test.cpp", 42);
+    expected.push_back("With location");
+    
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 4; ++t) {
+        producers.emplace_back([t]() {
+            for (int i = 0; i < 250; ++i) {
+                Logger::info("Binary thread {} message {}", t, i);
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    Logger::flush();
+    Logger::disable_binary_logging();
+    
+    if (Logger::is_binary() || !output_stream.str().empty() || !error_stream.str().empty()) {
+        std::cerr << "ERROR: Binary logging wrote text output or did not switch off" << std::endl;
+    }
+    
+    BinaryLogReader reader(filename);
+    if (!reader.is_open()) {
+        std::cerr << "ERROR: Could not open binary log: " << reader.error() << std::endl;
+        Logger::set_output_streams(std::cout, std::cerr);
+        return;
+    }
+    
+    bool ok = true;
+    BinaryLogEntry entry;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (!reader.next(entry) || entry.message != expected[i]) {
+            std::cerr << "ERROR: Decoded message '" << entry.message << "' does not match '" << expected[i] << "'" << std::endl;
+            ok = false;
+        }
+    }
+    if (entry.file != "logging_test.cpp" || entry.line != 42 || entry.level != LOG_WARNING) {
+        std::cerr << "ERROR: Decoded record lost its level or source location" << std::endl;
+        ok = false;
+    }
+    
+    // Decoded records go through the regular formatters
+    DefaultLogFormatter formatter(TimestampFormat::ISO8601, "", TimestampPrecision::NANOSECONDS);
+    std::string decoded_line;
+    formatter.format_to(decoded_line, entry.record());
+    if (decoded_line.find("Z] [WARNING] With location (logging_test.cpp:42)") == std::string::npos) {
+        std::cerr << "ERROR: Decoded record formatted as '" << decoded_line << "'" << std::endl;
+        ok = false;
+    }
+    
+    int thread_messages = 0;
+    while (reader.next(entry)) {
+        if (entry.message.rfind("Binary thread ", 0) == 0) {
+            ++thread_messages;
+        }
+    }
+    if (thread_messages != 1000 || !reader.error().empty()) {
+        std::cerr << "ERROR: Expected 1000 threaded binary records, decoded " << thread_messages
+                  << " (" << reader.error() << ")" << std::endl;
+        ok = false;
+    }
+    
+    // Appending a second session restarts the dictionary
+    Logger::set_binary_logging(filename);
+    Logger::info("Second session {}", 2);
+    Logger::disable_binary_logging();
+    BinaryLogReader appended(filename);
+    std::string last;
+    while (appended.next(entry)) {
+        last = entry.message;
+    }
+    if (last != "Second session 2" || !appended.error().empty()) {
+        std::cerr << "ERROR: Appended binary session decoded as '" << last << "'" << std::endl;
+        ok = false;
+    }
+    
+    if (ok) {
+        std::cout << "Binary logging tests passed!" << std::endl;
+    }
+    
+    std::filesystem::remove(filename);
+    Logger::set_output_streams(std::cout, std::cerr);
+}
+
+// Formatter that counts how often it runs, to check sinks share formatted text
+class CountingFormatter : public interlaced::core::logging::LogFormatter {
+public:
+    std::atomic<int> calls{0};
+    
+    std::string format(interlaced::core::logging::LogLevel level, const std::string& message,
+                      const std::tm& time_info, const char* file = nullptr, int line = 0) override {
+        ++calls;
+        return std::string("<") + interlaced::core::logging::log_level_to_string(level) + "> " + message;
+    }
+};
+
+void test_sinks() {
+    using namespace interlaced::core::logging;
+    
+    std::cout << "Testing multi-sink fan-out..." << std::endl;
+    
+    std::ostringstream legacy_output, legacy_error;
+    Logger::set_output_streams(legacy_output, legacy_error);
+    Logger::set_level(LOG_DEBUG);
+    
+    auto shared_formatter = std::make_shared<CountingFormatter>();
+    auto debug_sink = std::make_shared<MemorySink>();
+    auto warning_sink = std::make_shared<MemorySink>();
+    auto plain_sink = std::make_shared<MemorySink>();
+    std::ostringstream console_output, console_error;
+    
+    SinkOptions debug_options;
+    debug_options.formatter = shared_formatter;
+    SinkOptions warning_options;
+    warning_options.level = LOG_WARNING;
+    warning_options.formatter = shared_formatter;
+    SinkOptions console_options;
+    console_options.level = LOG_WARNING;
+    console_options.formatter = std::make_shared<DefaultLogFormatter>(TimestampFormat::NONE);
+    
+    Logger::add_sink("debug", debug_sink, debug_options);
+    Logger::add_sink("warning", warning_sink, warning_options);
+    Logger::add_sink("plain", plain_sink);
+    Logger::add_sink("console", std::make_shared<ConsoleSink>(console_output, console_error), console_options);
+    
+    Logger::debug("Sink debug {}", 1);
+    Logger::warning("Sink warning {}", 2);
+    Logger::error(std::string("Sink error"));
+    
+    bool ok = true;
+    if (debug_sink->size() != 3 || warning_sink->size() != 2 || plain_sink->size() != 3) {
+        std::cerr << "ERROR: Sink levels not applied (" << debug_sink->size() << ", " << warning_sink->size()
+                  << ", " << plain_sink->size() << ")" << std::endl;
+        ok = false;
+    }
+    if (shared_formatter->calls != 3) {
+        std::cerr << "ERROR: Shared formatter ran " << shared_formatter->calls << " times for 3 messages" << std::endl;
+        ok = false;
+    }
+    if (debug_sink->size() == 3 && debug_sink->lines()[1] != "<WARNING> Sink warning 2") {
+        std::cerr << "ERROR: Sink formatter output was '" << debug_sink->lines()[1] << "'" << std::endl;
+        ok = false;
+    }
+    if (console_output.str() != "[WARNING] Sink warning 2\n" || console_error.str() != "[ERROR] Sink error\n") {
+        std::cerr << "ERROR: Console sink wrote '" << console_output.str() << "' / '" << console_error.str() << "'" << std::endl;
+        ok = false;
+    }
+    if (!legacy_output.str().empty() || !legacy_error.str().empty()) {
+        std::cerr << "ERROR: Output streams were used while sinks are registered" << std::endl;
+        ok = false;
+    }
+    
+    // Per-sink level changes and asynchronous sinks
+    Logger::set_sink_level("plain", LOG_ERROR);
+    auto async_sink = std::make_shared<MemorySink>();
+    SinkOptions async_options;
+    async_options.async = true;
+    async_options.queue_capacity = 64;
+    Logger::add_sink("async", async_sink, async_options);
+    
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 4; ++t) {
+        producers.emplace_back([t]() {
+            for (int i = 0; i < 100; ++i) {
+                Logger::info("Sink thread {} message {}", t, i);
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    Logger::flush();
+    
+    if (async_sink->size() != 400 || plain_sink->size() != 3 || Logger::get_sink("async") != async_sink) {
+        std::cerr << "ERROR: Async sink received " << async_sink->size() << " of 400 messages" << std::endl;
+        ok = false;
+    }
+    
+    // Removing every sink restores the output streams
+    if (!Logger::remove_sink("async") || Logger::remove_sink("missing")) {
+        std::cerr << "ERROR: remove_sink returned the wrong result" << std::endl;
+        ok = false;
+    }
+    Logger::clear_sinks();
+    Logger::info("Back to streams");
+    if (legacy_output.str().find("Back to streams") == std::string::npos) {
+        std::cerr << "ERROR: Clearing sinks did not restore the output streams" << std::endl;
+        ok = false;
+    }
+    
+    if (ok) {
+        std::cout << "Multi-sink tests passed!" << std::endl;
+    }
+    
+    Logger::set_output_streams(std::cout, std::cerr);
+}
+
+void test_sharded_files() {
+    using namespace interlaced::core::logging;
+    
+    std::cout << "Testing sharded file logging..." << std::endl;
+    
+    const std::string base = "sharded_test.log";
+    auto remove_shards = [&base]() {
+        for (size_t shard = 0; shard < 8; ++shard) {
+            const std::string name = ShardedFileSink::shard_filename(base, shard);
+            std::filesystem::remove(name);
+            for (int i = 1; i <= 3; ++i) {
+                std::filesystem::remove(name + "." + std::to_string(i));
+            }
+        }
+    };
+    remove_shards();
+    
+    Logger::set_level(LOG_DEBUG);
+    SinkOptions options;
+    options.formatter = std::make_shared<DefaultLogFormatter>(TimestampFormat::NONE);
+    // Small files so every shard rotates
+    auto sink = std::make_shared<ShardedFileSink>(base, 1024, 3);
+    Logger::add_sink("sharded", sink, options);
+    
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 4; ++t) {
+        producers.emplace_back([t]() {
+            for (int i = 0; i < 50; ++i) {
+                Logger::info("Shard thread {} message {}", t, i);
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    Logger::warning(std::string("Two\nlines"));
+    Logger::remove_sink("sharded");
+    
+    bool ok = true;
+    if (sink->shard_count() != 5) {
+        std::cerr << "ERROR: Expected 5 shards (4 threads + main), got " << sink->shard_count() << std::endl;
+        ok = false;
+    }
+    
+    ShardedLogReader reader(base, 3);
+    ShardedLogLine line;
+    std::chrono::system_clock::time_point previous;
+    int next_message[4] = {0, 0, 0, 0};
+    int lines = 0;
+    std::string last;
+    while (reader.next(line)) {
+        ++lines;
+        if (line.time < previous) {
+            std::cerr << "ERROR: Merged lines are out of timestamp order" << std::endl;
+            ok = false;
+        }
+        previous = line.time;
+        int thread = 0;
+        int message = 0;
+        if (std::sscanf(line.text.c_str(), "[INFO] Shard thread %d message %d", &thread, &message) == 2) {
+            // Every thread's messages must come out complete and in order
+            if (thread < 0 || thread > 3 || message != next_message[thread]++) {
+                std::cerr << "ERROR: Unexpected merged line '" << line.text << "'" << std::endl;
+                ok = false;
+            }
+        }
+        last = line.text;
+    }
+    if (lines != 201 || last != "[WARNING] Two\nlines") {
+        std::cerr << "ERROR: Merged " << lines << " of 201 lines, last was '" << last << "'" << std::endl;
+        ok = false;
+    }
+    
+    // Threads sharing one shard still write it in timestamp order
+    remove_shards();
+    {
+        ShardedFileSink shared(base, 1 << 20, 3, 1);
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 4; ++t) {
+            writers.emplace_back([&shared]() {
+                for (int i = 0; i < 500; ++i) {
+                    shared.write(LOG_INFO, "Shared shard message");
+                }
+            });
+        }
+        for (auto& writer : writers) {
+            writer.join();
+        }
+    }
+    std::ifstream shard_file(ShardedFileSink::shard_filename(base, 0));
+    std::string shard_line;
+    std::string previous_stamp;
+    int shared_lines = 0;
+    while (std::getline(shard_file, shard_line)) {
+        const std::string stamp = shard_line.substr(0, shard_line.find(' '));
+        if (stamp < previous_stamp) {
+            std::cerr << "ERROR: Shared shard has line " << shared_lines << " out of timestamp order" << std::endl;
+            ok = false;
+            break;
+        }
+        previous_stamp = stamp;
+        ++shared_lines;
+    }
+    if (ok && shared_lines != 2000) {
+        std::cerr << "ERROR: Shared shard has " << shared_lines << " of 2000 lines" << std::endl;
+        ok = false;
+    }
+    
+    // Destroying a sink closes its shard files even though this thread still caches it
+    auto open_fds = []() {
+        size_t count = 0;
+        for (auto it = std::filesystem::directory_iterator("/proc/self/fd");
+             it != std::filesystem::directory_iterator(); ++it) {
+            ++count;
+        }
+        return count;
+    };
+    sink.reset();
+    const size_t fds_before = open_fds();
+    auto reconfigured = std::make_shared<ShardedFileSink>(base, 1024, 3);
+    reconfigured->write(LOG_INFO, "Reconfigured");
+    reconfigured.reset();
+    if (open_fds() != fds_before) {
+        std::cerr << "ERROR: Destroyed sharded sink left " << open_fds() - fds_before << " files open" << std::endl;
+        ok = false;
+    }
+    
+    if (ok) {
+        std::cout << "Sharded file tests passed!" << std::endl;
+    }
+    
+    remove_shards();
+}
+
+void test_mapped_file_sink() {
+    using namespace interlaced::core::logging;
+    
+    std::cout << "Testing memory-mapped file sink..." << std::endl;
+    
+    const std::string base = "mapped_test.log";
+    auto remove_files = [&base]() {
+        std::filesystem::remove(base);
+        std::filesystem::remove(base + ".next");
+        for (int i = 1; i <= 20; ++i) {
+            std::filesystem::remove(base + "." + std::to_string(i));
+        }
+    };
+    remove_files();
+    
+    Logger::set_level(LOG_DEBUG);
+    SinkOptions options;
+    options.formatter = std::make_shared<DefaultLogFormatter>(TimestampFormat::NONE);
+    {
+        // Small segments so the writers rotate several times
+        auto sink = std::make_shared<MappedFileSink>(base, 4096, 20);
+        if (!sink->is_open()) {
+            std::cerr << "ERROR: Could not map " << base << std::endl;
+            return;
+        }
+        Logger::add_sink("mapped", sink, options);
+        
+        std::vector<std::thread> producers;
+        for (int t = 0; t < 4; ++t) {
+            producers.emplace_back([t]() {
+                for (int i = 0; i < 100; ++i) {
+                    Logger::info("Mapped thread {} message {}", t, i);
+                }
+            });
+        }
+        for (auto& producer : producers) {
+            producer.join();
+        }
+        Logger::remove_sink("mapped");
+    }
+    
+    bool ok = true;
+    int counts[4] = {0, 0, 0, 0};
+    int lines = 0;
+    std::vector<std::string> files = {base};
+    for (int i = 1; i <= 20; ++i) {
+        files.push_back(base + "." + std::to_string(i));
+    }
+    for (const auto& file : files) {
+        if (!std::filesystem::exists(file)) {
+            continue;
+        }
+        if (std::filesystem::file_size(file) > 4096) {
+            std::cerr << "ERROR: Mapped segment " << file << " is larger than the segment size" << std::endl;
+            ok = false;
+        }
+        std::ifstream input(file, std::ios::binary);
+        std::string line;
+        while (std::getline(input, line)) {
+            int thread = -1;
+            int message = -1;
+            if (std::sscanf(line.c_str(), "[INFO] Mapped thread %d message %d", &thread, &message) != 2 ||
+                thread < 0 || thread > 3 || line.find('\0') != std::string::npos) {
+                std::cerr << "ERROR: Corrupt mapped line '" << line << "'" << std::endl;
+                ok = false;
+                continue;
+            }
+            ++counts[thread];
+            ++lines;
+        }
+    }
+    if (lines != 400 || counts[0] != 100 || counts[3] != 100 || std::filesystem::exists(base + ".next")) {
+        std::cerr << "ERROR: Mapped sink wrote " << lines << " of 400 lines" << std::endl;
+        ok = false;
+    }
+    
+    // Reopening appends after the existing messages
+    const auto size_before = std::filesystem::file_size(base);
+    {
+        MappedFileSink sink(base, 4096, 20);
+        sink.write(LOG_INFO, "Appended");
+    }
+    if (std::filesystem::file_size(base) != size_before + 9) {
+        std::cerr << "ERROR: Reopened mapped file did not append" << std::endl;
+        ok = false;
+    }
+    
+    // A segment that could not be created is retried in the background
+    const std::string missing_dir = "mapped_retry_dir";
+    std::filesystem::remove_all(missing_dir);
+    {
+        MappedFileSink sink(missing_dir + "/retry.log", 4096, 2);
+        sink.write(LOG_INFO, "Dropped");
+        std::filesystem::create_directory(missing_dir);
+        for (int i = 0; i < 300 && !sink.is_open(); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        sink.write(LOG_INFO, "Recovered");
+    }
+    std::ifstream retried(missing_dir + "/retry.log");
+    std::string retried_line;
+    if (!std::getline(retried, retried_line) || retried_line != "Recovered") {
+        std::cerr << "ERROR: Mapped sink did not recover, read '" << retried_line << "'" << std::endl;
+        ok = false;
+    }
+    retried.close();
+    std::filesystem::remove_all(missing_dir);
+    
+    if (ok) {
+        std::cout << "Mapped file sink tests passed!" << std::endl;
+    }
+    
+    remove_files();
+}
+
+// Test function for call-site throttling and duplicate suppression
+void test_throttling() {
+    using namespace interlaced::core::logging;
+    
+    std::cout << "Testing log throttling..." << std::endl;
+    
+    Logger::set_level(LOG_INFO);
+    auto sink = std::make_shared<MemorySink>();
+    SinkOptions options;
+    options.formatter = std::make_shared<DefaultLogFormatter>(TimestampFormat::NONE);
+    Logger::add_sink("throttle", sink, options);
+    
+    bool ok = true;
+    for (int i = 0; i < 95; ++i) {
+        LOG_WARNING_EVERY_N(10, "Every tenth " + std::to_string(i));
+    }
+    std::vector<std::string> lines = sink->lines();
+    if (lines.size() != 10 || lines.front().find("Every tenth 0") == std::string::npos ||
+        lines.back().find("Every tenth 90") == std::string::npos) {
+        std::cerr << "ERROR: LOG_WARNING_EVERY_N logged " << lines.size() << " of 95 calls" << std::endl;
+        ok = false;
+    }
+    sink->clear();
+    
+    for (int i = 0; i < 1000; ++i) {
+        LOG_ERROR_RATE(5, "Rate limited");
+    }
+    if (sink->size() < 5 || sink->size() > 6) {
+        std::cerr << "ERROR: LOG_ERROR_RATE(5) logged " << sink->size() << " messages in a burst" << std::endl;
+        ok = false;
+    }
+    sink->clear();
+    
+    for (int i = 0; i < 10000; ++i) {
+        LOG_INFO_SAMPLED(10, "Sampled");
+    }
+    if (sink->size() < 500 || sink->size() > 1500) {
+        std::cerr << "ERROR: LOG_INFO_SAMPLED(10) logged " << sink->size() << " of 10000 calls" << std::endl;
+        ok = false;
+    }
+    sink->clear();
+    
+    // Disabled levels do not evaluate the message
+    int evaluations = 0;
+    auto expensive = [&evaluations]() {
+        ++evaluations;
+        return std::string("Expensive");
+    };
+    for (int i = 0; i < 10; ++i) {
+        LOG_DEBUG_EVERY_N(2, expensive());
+        LOG_DEBUG_RATE(100, expensive());
+        LOG_DEBUG_SAMPLED(1, expensive());
+    }
+    if (evaluations != 0 || sink->size() != 0) {
+        std::cerr << "ERROR: Throttled DEBUG messages were evaluated below the log level" << std::endl;
+        ok = false;
+    }
+    
+    // Consecutive identical messages collapse into a summary
+    Logger::set_duplicate_suppression(std::chrono::hours(1));
+    for (int i = 0; i < 5; ++i) {
+        Logger::warning(std::string("Downstream failed"));
+    }
+    Logger::warning(std::string("Downstream recovered"));
+    Logger::info(std::string("Downstream recovered"));
+    Logger::info(std::string("Downstream recovered"));
+    Logger::flush();
+    Logger::disable_duplicate_suppression();
+    Logger::info(std::string("Downstream recovered"));
+    
+    const std::vector<std::string> expected = {
+        "[WARNING] Downstream failed",
+        "[WARNING] Last message repeated 4 times",
+        "[WARNING] Downstream recovered",
+        "[INFO] Downstream recovered",
+        "[INFO] Last message repeated 1 time",
+        "[INFO] Downstream recovered"
+    };
+    if (sink->lines() != expected) {
+        std::cerr << "ERROR: Duplicate suppression produced:" << std::endl;
+        for (const auto& line : sink->lines()) {
+            std::cerr << "  " << line << std::endl;
+        }
+        ok = false;
+    }
+    
+    Logger::remove_sink("throttle");
+    Logger::set_level(LOG_DEBUG);
+    
+    if (ok) {
+        std::cout << "Log throttling tests passed!" << std::endl;
+    }
+}
+
+// Formatter that records the typed fields it receives
+class FieldCapturingFormatter : public interlaced::core::logging::LogFormatter {
+public:
+    std::vector<interlaced::core::logging::LogField> fields;
+    std::vector<std::string> keys;
+    std::vector<std::string> texts;
+    
+    std::string format(interlaced::core::logging::LogLevel, const std::string& message,
+                       const std::tm&, const char*, int) override {
+        return message;
+    }
+    
+    void format_to(std::string& out, const interlaced::core::logging::LogRecord& record) override {
+        fields.assign(record.fields, record.fields + record.field_count);
+        keys.clear();
+        texts.clear();
+        for (size_t i = 0; i < record.field_count; ++i) {
+            keys.emplace_back(record.fields[i].key);
+            texts.emplace_back(record.fields[i].text);
+        }
+        out.append(record.message.data(), record.message.size());
+    }
+};
+
+// Test function for typed structured fields and the JSON lines formatter
+void test_structured_fields() {
+    using namespace interlaced::core::logging;
+    
+    std::cout << "Testing structured fields..." << std::endl;
+    
+    Logger::set_level(LOG_DEBUG);
+    auto capture = std::make_shared<FieldCapturingFormatter>();
+    auto captured_sink = std::make_shared<MemorySink>();
+    auto text_sink = std::make_shared<MemorySink>();
+    auto json_sink = std::make_shared<MemorySink>();
+    SinkOptions capture_options;
+    capture_options.formatter = capture;
+    SinkOptions text_options;
+    text_options.formatter = std::make_shared<DefaultLogFormatter>(TimestampFormat::NONE);
+    SinkOptions json_options;
+    json_options.formatter = std::make_shared<JsonLinesFormatter>(TimestampFormat::NONE);
+    Logger::add_sink("capture", captured_sink, capture_options);
+    Logger::add_sink("text", text_sink, text_options);
+    Logger::add_sink("json", json_sink, json_options);
+    
+    const std::string name = "bob \"the\" builder\n";
+    Logger::info(std::string("Login"), "user_id", -12345, "ratio", 0.5, "admin", true,
+                 "name", name, "attempts", 3u, "grade", 'A', "missing", std::nan(""));
+    
+    bool ok = true;
+    const auto& fields = capture->fields;
+    if (fields.size() != 7 ||
+        fields[0].type != LogField::Type::INT || fields[0].value.integer != -12345 ||
+        fields[1].type != LogField::Type::DOUBLE || fields[1].value.number != 0.5 ||
+        fields[2].type != LogField::Type::BOOL || !fields[2].value.boolean ||
+        fields[3].type != LogField::Type::STRING || capture->texts[3] != name ||
+        fields[4].type != LogField::Type::UINT || fields[4].value.unsigned_integer != 3 ||
+        fields[5].type != LogField::Type::STRING || capture->texts[5] != "A" ||
+        capture->keys[0] != "user_id" || capture->keys[6] != "missing") {
+        std::cerr << "ERROR: Custom formatter did not receive the typed fields" << std::endl;
+        ok = false;
+    }
+    
+    // The text layout is unchanged from the stream-based key=value output
+    const std::string expected_text = "[INFO] Login user_id=-12345 ratio=0.5 admin=1 name=" + name +
+                                      " attempts=3 grade=A missing=nan";
+    if (text_sink->lines() != std::vector<std::string>{expected_text}) {
+        std::cerr << "ERROR: Default formatter wrote '" << text_sink->lines().front() << "'" << std::endl;
+        ok = false;
+    }
+    
+    const std::string expected_json = "{\"level\":\"INFO\",\"message\":\"Login\",\"fields\":{\"user_id\":-12345,"
+                                      "\"ratio\":0.5,\"admin\":true,\"name\":\"bob \\\"the\\\" builder\\n\","
+                                      "\"attempts\":3,\"grade\":\"A\",\"missing\":null}}";
+    if (json_sink->lines() != std::vector<std::string>{expected_json}) {
+        std::cerr << "ERROR: JSON formatter wrote '" << json_sink->lines().front() << "'" << std::endl;
+        ok = false;
+    }
+    Logger::remove_sink("capture");
+    Logger::remove_sink("text");
+    json_sink->clear();
+    
+    // Formatters that only override format() receive the category and fields in the message
+    TestFormatter legacy_formatter;
+    LogField legacy_fields[2];
+    legacy_fields[0].key = "user_id";
+    legacy_fields[0].type = LogField::Type::INT;
+    legacy_fields[0].value.integer = 7;
+    legacy_fields[1].key = "admin";
+    legacy_fields[1].type = LogField::Type::BOOL;
+    legacy_fields[1].value.boolean = true;
+    LogRecord legacy_record;
+    legacy_record.level = LOG_WARNING;
+    legacy_record.message = "Login";
+    legacy_record.category = "auth";
+    legacy_record.fields = legacy_fields;
+    legacy_record.field_count = 2;
+    std::string legacy;
+    legacy_formatter.format_to(legacy, legacy_record);
+    if (legacy != "[WARNING] [auth] Login user_id=7 admin=1") {
+        std::cerr << "ERROR: format() adapter wrote '" << legacy << "'" << std::endl;
+        ok = false;
+    }
+    
+    // Source location, control characters and a full timestamp
+    JsonLinesFormatter iso_formatter;
+    LogRecord record;
+    record.level = LOG_ERROR;
+    record.message = std::string_view("tab\there\x01", 9);
+    record.time = std::chrono::system_clock::from_time_t(0) + std::chrono::microseconds(1500);
+    record.file = "/src/app/main.cpp";
+    record.line = 42;
+    std::string json;
+    iso_formatter.format_to(json, record);
+    if (json != "{\"time\":\"1970-01-01T00:00:00.001500Z\",\"level\":\"ERROR\",\"message\":\"tab\\there\\u0001\","
+                "\"file\":\"main.cpp\",\"line\":42}") {
+        std::cerr << "ERROR: JSON formatter wrote '" << json << "'" << std::endl;
+        ok = false;
+    }
+    
+    // Structured JSON logging does not allocate once the buffers are warm
+    NullBuffer null_buffer;
+    std::ostream null_stream(&null_buffer);
+    Logger::remove_sink("json");
+    SinkOptions null_options;
+    null_options.formatter = std::make_shared<JsonLinesFormatter>();
+    Logger::add_sink("null", std::make_shared<ConsoleSink>(null_stream, null_stream), null_options);
+    const std::string request = "GET /index.html";
+    auto log_batch = [&]() {
+        Logger::info(std::string("Request served"), "request", request, "status", 200, "latency_ms", 1.25,
+                     "cached", false);
+    };
+    for (int i = 0; i < 10; ++i) {
+        log_batch();
+    }
+    size_t before = g_allocation_count.load();
+    for (int i = 0; i < 1000; ++i) {
+        log_batch();
+    }
+    size_t allocations = g_allocation_count.load() - before;
+    Logger::remove_sink("null");
+    if (allocations != 0) {
+        std::cerr << "ERROR: Structured JSON logging performed " << allocations << " heap allocations" << std::endl;
+        ok = false;
+    }
+    
+    if (ok) {
+        std::cout << "Structured field tests passed!" << std::endl;
+    }
+}
+
+// Test function for lazily evaluated LOG_* macros and stream-style logging
+void test_lazy_macros() {
+    using namespace interlaced::core::logging;
+    
+    std::cout << "Testing lazy logging macros..." << std::endl;
+    
+    auto sink = std::make_shared<MemorySink>();
+    SinkOptions options;
+    options.formatter = std::make_shared<DefaultLogFormatter>(TimestampFormat::NONE);
+    Logger::add_sink("lazy", sink, options);
+    
+    int evaluations = 0;
+    auto expensive = [&evaluations]() {
+        ++evaluations;
+        return std::string("expensive ") + std::to_string(evaluations);
+    };
+    
+    bool ok = true;
+    Logger::set_level(LOG_WARNING);
+    LOG_INFO("Value: " + expensive());
+    LOG_DEBUG_S << "Value: " << expensive();
+    if (evaluations != 0 || sink->size() != 0) {
+        std::cerr << "ERROR: Disabled LOG_* macros evaluated their arguments" << std::endl;
+        ok = false;
+    }
+    
+    Logger::set_level(LOG_INFO);
+    LOG_INFO("Value: " + expensive());
+    const int literal_line = __LINE__ + 1;
+    LOG_WARNING("Literal message");
+    const int stream_line = __LINE__ + 1;
+    LOG_ERROR_S << "Loaded " << 3 << " items, ratio " << 0.5 << ' ' << true << ' ' << expensive();
+    
+    // A stream macro nests safely in an unbraced if/else
+    bool else_taken = false;
+    if (evaluations < 0)
+        LOG_INFO_S << "never";
+    else
+        else_taken = true;
+    
+    const std::vector<std::string> expected = {
+        "[INFO] Value: expensive 1 (logging_test.cpp:" + std::to_string(literal_line - 2) + ")",
+        "[WARNING] Literal message (logging_test.cpp:" + std::to_string(literal_line) + ")",
+        "[ERROR] Loaded 3 items, ratio 0.5 1 expensive 2 (logging_test.cpp:" + std::to_string(stream_line) + ")"
+    };
+    if (sink->lines() != expected || !else_taken || evaluations != 2) {
+        std::cerr << "ERROR: Lazy LOG_* macros produced:" << std::endl;
+        for (const auto& line : sink->lines()) {
+            std::cerr << "  " << line << std::endl;
+        }
+        ok = false;
+    }
+    
+    Logger::remove_sink("lazy");
+    Logger::set_level(LOG_DEBUG);
+    
+    if (ok) {
+        std::cout << "Lazy macro tests passed!" << std::endl;
+    }
+}
+
+void test_flight_recorder() {
+    using namespace interlaced::core::logging;
+    
+    std::cout << "Testing flight recorder..." << std::endl;
+    
+    const std::string dump_file = "flight_test.dump";
+    std::filesystem::remove(dump_file);
+    auto read_dump = [&dump_file]() {
+        std::ifstream input(dump_file, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    };
+    
+    auto sink = std::make_shared<MemorySink>();
+    SinkOptions options;
+    options.formatter = std::make_shared<DefaultLogFormatter>(TimestampFormat::NONE);
+    Logger::add_sink("flight", sink, options);
+    Logger::set_level(LOG_INFO);
+    
+    FlightRecorderOptions recorder;
+    recorder.buffer_size = 4096;
+    Logger::enable_flight_recorder(dump_file, recorder);
+    
+    bool ok = true;
+    if (!Logger::is_enabled(LOG_DEBUG) || Logger::get_level() != LOG_INFO) {
+        std::cerr << "ERROR: Flight recorder did not enable DEBUG capture" << std::endl;
+        ok = false;
+    }
+    
+    // DEBUG is recorded but not written; the ERROR dumps the rings
+    Logger::debug("Cache miss for key {} after {} ms", "user:42", 1.5);
+    LOG_DEBUG("Lazy debug detail");
+    Logger::info("Request accepted");
+    std::thread worker([]() {
+        Logger::debug("Worker step {}", 7);
+    });
+    worker.join();
+    LOG_ERROR("Request failed");
+    
+    const std::vector<std::string> expected = {"[INFO] Request accepted", "[ERROR] Request failed"};
+    std::vector<std::string> written = sink->lines();
+    for (auto& line : written) {
+        line = line.substr(0, line.find(" ("));
+    }
+    if (written != expected) {
+        std::cerr << "ERROR: Flight recorder changed what the outputs receive" << std::endl;
+        ok = false;
+    }
+    
+    std::string dump = read_dump();
+    const std::vector<std::string> recorded = {
+        "==== Flight recorder dump (ERROR)",
+        "[DEBUG] Cache miss for key user:42 after 1.5 ms",
+        "[DEBUG] Lazy debug detail (logging_test.cpp:",
+        "[INFO] Request accepted",
+        "[DEBUG] Worker step 7",
+        "[ERROR] Request failed (logging_test.cpp:"
+    };
+    for (const auto& text : recorded) {
+        if (dump.find(text) == std::string::npos) {
+            std::cerr << "ERROR: Flight recorder dump is missing '" << text << "'" << std::endl;
+            ok = false;
+        }
+    }
+    if (dump.find("[DEBUG] Cache miss") > dump.find("[INFO] Request accepted")) {
+        std::cerr << "ERROR: Flight recorder dump is not oldest first" << std::endl;
+        ok = false;
+    }
+    
+    // Old records are evicted, and a dump only holds what came after the previous one
+    for (int i = 0; i < 500; ++i) {
+        Logger::debug("Filler record {}", i);
+    }
+    if (!Logger::dump_flight_recorder()) {
+        std::cerr << "ERROR: Explicit flight recorder dump failed" << std::endl;
+        ok = false;
+    }
+    const std::string second = read_dump().substr(dump.size());
+    if (second.find("==== Flight recorder dump (requested)") == std::string::npos ||
+        second.find("[DEBUG] Filler record 499") == std::string::npos ||
+        second.find("[DEBUG] Filler record 0\n") != std::string::npos ||
+        second.find("older records overwritten") == std::string::npos ||
+        second.find("Request failed") != std::string::npos) {
+        std::cerr << "ERROR: Flight recorder ring did not keep only the newest records" << std::endl;
+        ok = false;
+    }
+    
+    Logger::disable_flight_recorder();
+    if (Logger::is_enabled(LOG_DEBUG) || Logger::dump_flight_recorder()) {
+        std::cerr << "ERROR: Flight recorder is still active after disabling it" << std::endl;
+        ok = false;
+    }
+    
+    Logger::remove_sink("flight");
+    Logger::set_level(LOG_DEBUG);
+    std::filesystem::remove(dump_file);
+    
+    if (ok) {
+        std::cout << "Flight recorder tests passed!" << std::endl;
+    }
+}
+
+// Test function for hierarchical categories and cached call-site checks
+void test_categories() {
+    using namespace interlaced::core::logging;
+    
+    std::cout << "Testing log categories..." << std::endl;
+    
+    auto sink = std::make_shared<MemorySink>();
+    SinkOptions options;
+    options.formatter = std::make_shared<DefaultLogFormatter>(TimestampFormat::NONE);
+    Logger::add_sink("categories", sink, options);
+    Logger::set_level(LOG_INFO);
+    
+    int evaluations = 0;
+    auto message = [&evaluations](const std::string& text) {
+        ++evaluations;
+        return text;
+    };
+    auto log_all = [&message]() {
+        LOG_CATEGORY_DEBUG("net.http", message("http detail"));
+        LOG_CATEGORY_DEBUG("fs", message("fs detail"));
+        LOG_CATEGORY_INFO("net.http", message("http info"));
+    };
+    
+    bool ok = true;
+    log_all();
+    if (sink->size() != 1 || evaluations != 1) {
+        std::cerr << "ERROR: Categories did not follow the global level" << std::endl;
+        ok = false;
+    }
+    sink->clear();
+    evaluations = 0;
+    
+    // Children inherit a parent's level; the cached sites notice the change
+    Logger::set_category_level("net", LOG_DEBUG);
+    log_all();
+    const std::vector<std::string> expected = {"[DEBUG] [net.http] http detail", "[INFO] [net.http] http info"};
+    std::vector<std::string> written = sink->lines();
+    for (auto& line : written) {
+        line = line.substr(0, line.find(" ("));
+    }
+    if (written != expected || evaluations != 2) {
+        std::cerr << "ERROR: \"net.http\" did not inherit DEBUG from \"net\"" << std::endl;
+        ok = false;
+    }
+    if (Logger::category("net.http").parent() != &Logger::category("net") ||
+        Logger::category("net.http").level() != LOG_DEBUG || Logger::category("fs").level() != LOG_INFO) {
+        std::cerr << "ERROR: Category hierarchy reports the wrong levels" << std::endl;
+        ok = false;
+    }
+    sink->clear();
+    evaluations = 0;
+    
+    // A child's own level wins over its parent's
+    Logger::set_category_level("net.http", LOG_WARNING);
+    log_all();
+    if (sink->size() != 0 || evaluations != 0) {
+        std::cerr << "ERROR: A category's own level did not override its parent" << std::endl;
+        ok = false;
+    }
+    
+    Logger::clear_category_level("net.http");
+    Logger::clear_category_level("net");
+    Logger::set_level(LOG_DEBUG);
+    log_all();
+    if (sink->size() != 3 || evaluations != 3) {
+        std::cerr << "ERROR: Cleared categories did not follow the global level" << std::endl;
+        ok = false;
+    }
+    
+    Logger::remove_sink("categories");
+    
+    if (ok) {
+        std::cout << "Log category tests passed!" << std::endl;
+    }
+}
+
+// Test function for the logger's own counters and latency histograms
+void test_stats() {
+    using namespace interlaced::core::logging;
+    
+    std::cout << "Testing logger statistics..." << std::endl;
+    
+    bool ok = true;
+    LatencyHistogram histogram;
+    histogram.buckets[4] = 90; // 8-15 ns
+    histogram.buckets[11] = 10; // 1024-2047 ns
+    histogram.count = 100;
+    histogram.max_ns = 1500;
+    if (histogram.percentile(50) != 15 || histogram.percentile(90) != 15 || histogram.percentile(99) != 1500 ||
+        LatencyHistogram().percentile(99) != 0) {
+        std::cerr << "ERROR: LatencyHistogram percentiles are wrong" << std::endl;
+        ok = false;
+    }
+    
+    Logger::set_level(LOG_DEBUG);
+    auto sink = std::make_shared<MemorySink>();
+    SinkOptions options;
+    options.formatter = std::make_shared<DefaultLogFormatter>(TimestampFormat::NONE);
+    Logger::add_sink("stats", sink, options);
+    
+    const LoggerStats before = Logger::stats();
+    Logger::info("Counted {}", 1);
+    LOG_WARNING("Counted warning");
+    std::thread worker([]() {
+        Logger::error("Counted on a thread that exits");
+    });
+    worker.join();
+    for (int i = 0; i < 20; ++i) {
+        LOG_DEBUG_EVERY_N(10, "Throttled");
+    }
+    Logger::set_duplicate_suppression(std::chrono::hours(1));
+    Logger::info(std::string("Repeated"));
+    Logger::info(std::string("Repeated"));
+    Logger::info(std::string("Repeated"));
+    Logger::flush(); // Writes the "repeated" summary
+    Logger::disable_duplicate_suppression();
+    
+    const LoggerStats after = Logger::stats();
+    auto delta = [](const std::array<uint64_t, 4>& later, const std::array<uint64_t, 4>& earlier, LogLevel level) {
+        return later[level] - earlier[level];
+    };
+    // Two INFO messages, the "repeated" summary and the first "Repeated"
+    if (delta(after.emitted, before.emitted, LOG_INFO) != 3 || delta(after.emitted, before.emitted, LOG_WARNING) != 1 ||
+        delta(after.emitted, before.emitted, LOG_ERROR) != 1 || delta(after.emitted, before.emitted, LOG_DEBUG) != 2) {
+        std::cerr << "ERROR: Emitted counts per level are wrong" << std::endl;
+        ok = false;
+    }
+    if (delta(after.throttled, before.throttled, LOG_DEBUG) != 18 ||
+        delta(after.suppressed, before.suppressed, LOG_INFO) != 2) {
+        std::cerr << "ERROR: Throttled or suppressed counts are wrong" << std::endl;
+        ok = false;
+    }
+    const SinkStats* counted = nullptr;
+    for (const auto& entry : after.sinks) {
+        if (entry.name == "stats") {
+            counted = &entry;
+        }
+    }
+    size_t bytes = 0;
+    for (const auto& line : sink->lines()) {
+        bytes += line.size();
+    }
+    if (!counted || counted->messages != sink->size() || counted->bytes != bytes) {
+        std::cerr << "ERROR: Sink message and byte counts are wrong" << std::endl;
+        ok = false;
+    }
+    Logger::remove_sink("stats");
+    
+    // Drops are counted per level, and queue depth is tracked
+    std::atomic<bool> release{false};
+    SinkOptions slow;
+    slow.async = true;
+    slow.queue_capacity = 4;
+    slow.overflow = OverflowPolicy::DROP;
+    Logger::add_sink("slow", std::make_shared<CallbackSink>([&release](LogLevel, std::string_view) {
+        while (!release.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }), slow);
+    for (int i = 0; i < 100; ++i) {
+        Logger::error("Dropped {}", i);
+    }
+    release = true;
+    Logger::flush();
+    const LoggerStats dropped = Logger::stats();
+    for (const auto& entry : dropped.sinks) {
+        if (entry.name == "slow" &&
+            (entry.dropped == 0 || entry.messages + entry.dropped != 100 || entry.max_queue_depth > 4 ||
+             delta(dropped.dropped, after.dropped, LOG_ERROR) != entry.dropped)) {
+            std::cerr << "ERROR: Dropped counts or queue depth are wrong" << std::endl;
+            ok = false;
+        }
+    }
+    Logger::remove_sink("slow");
+    
+    // File writes and rotations are timed
+    const std::string test_file = "stats_test.log";
+    {
+        RotatingFileLogger file_logger(test_file, 1000, 2, FlushPolicy::explicit_only());
+        for (int i = 0; i < 50; ++i) {
+            file_logger.write(std::string(99, 'x'));
+        }
+    }
+    const LoggerStats files = Logger::stats();
+    if (files.file_messages - dropped.file_messages != 50 || files.file_bytes - dropped.file_bytes != 5000 ||
+        files.rotations - dropped.rotations != 4 || files.file_write.count - dropped.file_write.count != 50 ||
+        files.file_rotate.count - dropped.file_rotate.count != 4 ||
+        files.file_write.percentile(50) > files.file_write.percentile(99) ||
+        files.file_write.percentile(99) > files.file_write.max_ns) {
+        std::cerr << "ERROR: File write and rotation statistics are wrong" << std::endl;
+        ok = false;
+    }
+    std::filesystem::remove(test_file);
+    for (int i = 1; i <= 2; ++i) {
+        std::filesystem::remove(test_file + "." + std::to_string(i));
+    }
+    
+    if (ok) {
+        std::cout << "Logger statistics tests passed!" << std::endl;
+    }
+}
+
+#ifndef _WIN32
+// A local datagram socket for DatagramSink tests
+class DatagramListener {
+private:
+    int fd_ = -1;
+    std::string path_;
+
+public:
+    explicit DatagramListener(const std::string& path) : path_(path) {
+        std::remove(path_.c_str());
+        fd_ = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+        struct sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, path_.c_str(), sizeof(address.sun_path) - 1);
+        ::bind(fd_, reinterpret_cast<struct sockaddr*>(&address), sizeof(address));
+    }
+    
+    DatagramListener() {
+        fd_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+        struct sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ::bind(fd_, reinterpret_cast<struct sockaddr*>(&address), sizeof(address));
+    }
+    
+    ~DatagramListener() {
+        ::close(fd_);
+        if (!path_.empty()) {
+            std::remove(path_.c_str());
+        }
+    }
+    
+    uint16_t port() const {
+        struct sockaddr_in address = {};
+        socklen_t length = sizeof(address);
+        ::getsockname(fd_, reinterpret_cast<struct sockaddr*>(&address), &length);
+        return ntohs(address.sin_port);
+    }
+    
+    // Next datagram, or false after timeout_ms without one
+    bool receive(std::string& datagram, int timeout_ms = 2000) {
+        struct pollfd entry = {fd_, POLLIN, 0};
+        if (::poll(&entry, 1, timeout_ms) <= 0) {
+            return false;
+        }
+        char buffer[65536];
+        const ssize_t size = ::recv(fd_, buffer, sizeof(buffer), 0);
+        if (size < 0) {
+            return false;
+        }
+        datagram.assign(buffer, static_cast<size_t>(size));
+        return true;
+    }
+};
+#endif
+
+// Test function for the batched datagram sink
+void test_datagram_sink() {
+#ifndef _WIN32
+    using namespace interlaced::core::logging;
+    
+    std::cout << "Testing datagram sink..." << std::endl;
+    
+    bool ok = true;
+    std::string datagram;
+    {
+        // RFC 5424 over a Unix domain socket, one message per datagram
+        DatagramListener listener("datagram_test.sock");
+        DatagramSinkOptions options;
+        options.hostname = "test host";
+        options.app_name = "logging_test";
+        auto sink = std::make_shared<DatagramSink>(DatagramAddress::unix_socket("datagram_test.sock"), options);
+        sink->write(LOG_ERROR, "Disk full");
+        SinkOptions sink_options;
+        sink_options.formatter = std::make_shared<DefaultLogFormatter>(TimestampFormat::NONE);
+        Logger::add_sink("datagram", sink, sink_options);
+        Logger::warning("Retrying in {} s", 5);
+        Logger::flush();
+        Logger::remove_sink("datagram");
+        
+        const std::string tail = " test_host logging_test " + std::to_string(::getpid()) + " - - ";
+        if (!listener.receive(datagram) || datagram.compare(0, 6, "<11>1 ") != 0 || datagram[16] != 'T' ||
+            datagram.find("Z" + tail + "Disk full") != 32) {
+            std::cerr << "ERROR: RFC 5424 datagram is malformed: " << datagram << std::endl;
+            ok = false;
+        }
+        if (!listener.receive(datagram) || datagram.compare(0, 6, "<12>1 ") != 0 ||
+            datagram.find(tail + "[WARNING] Retrying in 5 s") == std::string::npos) {
+            std::cerr << "ERROR: Datagram sink did not send the logged warning: " << datagram << std::endl;
+            ok = false;
+        }
+    }
+    {
+        // Plain framing over UDP packs several messages into each datagram
+        DatagramListener listener;
+        DatagramSinkOptions options;
+        options.framing = DatagramFraming::PLAIN;
+        options.max_datagram_size = 64;
+        DatagramSink sink(DatagramAddress::udp("127.0.0.1", listener.port()), options);
+        std::string expected;
+        for (int i = 0; i < 20; ++i) {
+            const std::string message = "Packed message " + std::to_string(i);
+            sink.write(LOG_INFO, message);
+            expected += message + "\n";
+        }
+        sink.flush();
+        std::string received;
+        size_t datagrams = 0;
+        while (received.size() < expected.size() && listener.receive(datagram)) {
+            ok = ok && datagram.size() <= 64;
+            received += datagram;
+            ++datagrams;
+        }
+        if (received != expected || datagrams >= 20 || sink.sent() != datagrams) {
+            std::cerr << "ERROR: Plain datagrams were not packed correctly (" << datagrams << " datagrams)" << std::endl;
+            ok = false;
+        }
+    }
+    {
+        // A receiver that does not read fills up; the spill buffer keeps the newest datagrams
+        DatagramListener listener("datagram_spill.sock");
+        DatagramSinkOptions options;
+        options.spill_bytes = 16 * 1024;
+        DatagramSink sink(DatagramAddress::unix_socket("datagram_spill.sock"), options);
+        const int total = 5000;
+        for (int i = 0; i < total; ++i) {
+            sink.write(LOG_INFO, "Spilled message " + std::to_string(i));
+        }
+        sink.flush();
+        size_t received = 0;
+        std::string last;
+        for (int round = 0; round < 200 && (sink.pending() > 0 || received < sink.sent()); ++round) {
+            while (listener.receive(datagram, 10)) {
+                ++received;
+                last = datagram;
+            }
+            sink.flush();
+        }
+        if (sink.dropped() == 0 || sink.sent() + sink.dropped() != static_cast<uint64_t>(total) ||
+            received != sink.sent() || last.find("Spilled message 4999") == std::string::npos) {
+            std::cerr << "ERROR: Spill buffer lost track of datagrams (sent " << sink.sent() << ", dropped "
+                      << sink.dropped() << ", received " << received << ")" << std::endl;
+            ok = false;
+        }
+    }
+    {
+        // Messages wait for a receiver that starts late
+        std::remove("datagram_late.sock");
+        DatagramSink sink(DatagramAddress::unix_socket("datagram_late.sock"));
+        sink.write(LOG_INFO, "Before the receiver");
+        sink.flush();
+        DatagramListener listener("datagram_late.sock");
+        for (int round = 0; round < 60 && sink.pending() > 0; ++round) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            sink.flush();
+        }
+        if (!listener.receive(datagram) || datagram.find("Before the receiver") == std::string::npos) {
+            std::cerr << "ERROR: Datagram sink did not reconnect to a late receiver" << std::endl;
+            ok = false;
+        }
+    }
+    
+    if (ok) {
+        std::cout << "Datagram sink tests passed!" << std::endl;
+    }
+#endif
+}
+
+// Test function for indexed searches over rotated log files
+void test_log_search() {
+    using namespace interlaced::core::logging;
+    
+    std::cout << "Testing log search..." << std::endl;
+    
+    const std::string test_file = "log_search_test.log";
+    auto remove_generations = [&test_file]() {
+        for (const std::string& name : {test_file, test_file + ".next"}) {
+            std::filesystem::remove(name);
+            std::filesystem::remove(name + ".idx");
+        }
+        for (int i = 1; i <= 4; ++i) {
+            std::filesystem::remove(test_file + "." + std::to_string(i));
+            std::filesystem::remove(test_file + "." + std::to_string(i) + ".idx");
+        }
+    };
+    remove_generations();
+    bool ok = true;
+    
+    // The scanner must find needles at every alignment, including the unrolled SIMD path
+    std::string haystack(200, 'a');
+    for (size_t position = 0; position + 5 <= haystack.size() && ok; position += 7) {
+        std::string text = haystack;
+        text.replace(position, 5, "a-b-c");
+        const char* found = detail::find_substring(text.data(), text.data() + text.size(), "a-b-c");
+        if (found != text.data() + position) {
+            std::cerr << "ERROR: find_substring missed a needle at offset " << position << std::endl;
+            ok = false;
+        }
+    }
+    if (detail::find_substring(haystack.data(), haystack.data() + haystack.size(), "ab") != haystack.data() + haystack.size()) {
+        std::cerr << "ERROR: find_substring found a needle that is not there" << std::endl;
+        ok = false;
+    }
+    
+    std::chrono::system_clock::time_point failures_start;
+    {
+        RotatingFileLogger file_logger(test_file, 4000, 3, FlushPolicy::explicit_only());
+        file_logger.enable_index(512);
+        for (int i = 0; i < 300; ++i) {
+            file_logger.write("[DEBUG] request " + std::to_string(i) + " ok", LOG_DEBUG);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        failures_start = std::chrono::system_clock::now();
+        for (int i = 0; i < 10; ++i) {
+            file_logger.write("[ERROR] request " + std::to_string(i) + " failed: timeout", LOG_ERROR);
+            file_logger.write("[INFO] retrying request " + std::to_string(i), LOG_INFO);
+        }
+        file_logger.write("[WARNING] unindexed tail", LOG_WARNING);
+        file_logger.flush();
+        
+        LogSearcher searcher(test_file, 3);
+        if (searcher.file_count() < 2) {
+            std::cerr << "ERROR: Log search did not find the rotated files" << std::endl;
+            ok = false;
+        }
+        
+        std::vector<std::string> lines;
+        auto collect = [&lines](std::string_view line) { lines.emplace_back(line); };
+        
+        LogQuery query;
+        query.contains = "timeout";
+        if (searcher.search(query, collect) != 10 || lines.front() != "[ERROR] request 0 failed: timeout") {
+            std::cerr << "ERROR: Substring search returned " << lines.size() << " lines" << std::endl;
+            ok = false;
+        }
+        
+        lines.clear();
+        query = LogQuery();
+        query.min_level = LOG_WARNING;
+        const size_t warnings = searcher.search(query, collect);
+        if (warnings != 11 || lines.back() != "[WARNING] unindexed tail") {
+            std::cerr << "ERROR: Level search returned " << warnings << " lines" << std::endl;
+            ok = false;
+        }
+        if (searcher.last_stats().skipped_blocks == 0) {
+            std::cerr << "ERROR: Level search did not skip any debug-only blocks" << std::endl;
+            ok = false;
+        }
+        
+        lines.clear();
+        query = LogQuery();
+        query.from = failures_start;
+        query.contains = "request 3 ";
+        searcher.search(query, collect);
+        if (lines.size() != 1 || lines[0] != "[ERROR] request 3 failed: timeout") {
+            std::cerr << "ERROR: Time range search returned " << lines.size() << " lines" << std::endl;
+            ok = false;
+        }
+        const LogSearchStats stats = searcher.last_stats();
+        if (stats.skipped_blocks == 0 || stats.skipped_blocks > stats.indexed_blocks) {
+            std::cerr << "ERROR: Time range search skipped " << stats.skipped_blocks << " of "
+                      << stats.indexed_blocks << " blocks" << std::endl;
+            ok = false;
+        }
+        
+        lines.clear();
+        query = LogQuery();
+        const size_t all = searcher.search(query, collect);
+        if (all != 321 || lines.front() != "[DEBUG] request 0 ok") {
+            std::cerr << "ERROR: Unfiltered search returned " << all << " lines" << std::endl;
+            ok = false;
+        }
+    }
+    remove_generations();
+    
+    // Timestamps are read back from every TimestampFormat the formatters write
+    {
+        const auto time = std::chrono::system_clock::from_time_t(1700000000) + std::chrono::milliseconds(250);
+        const int64_t expected = 1700000000250000000LL;
+        detail::LineTimeParser parser;
+        std::string standard = "prefix [";
+        detail::append_timestamp(standard, TimestampFormat::STANDARD, TimestampPrecision::MILLISECONDS, time);
+        standard += "] [INFO] text";
+        std::string iso = "[";
+        detail::append_timestamp(iso, TimestampFormat::ISO8601, TimestampPrecision::MILLISECONDS, time);
+        iso += "] [INFO] text";
+        std::string json = "{\"time\":\"";
+        detail::append_timestamp(json, TimestampFormat::ISO8601, TimestampPrecision::MILLISECONDS, time);
+        json += "\",\"level\":\"INFO\"}";
+        std::string unix_seconds = "{\"time\":";
+        detail::append_timestamp(unix_seconds, TimestampFormat::UNIX, TimestampPrecision::MILLISECONDS, time);
+        unix_seconds += ",\"level\":\"INFO\"}";
+        for (const std::string& line : {standard, iso, json, unix_seconds}) {
+            int64_t first_ns = 0;
+            int64_t last_ns = 0;
+            if (!parser.parse(line, first_ns, last_ns) || first_ns != expected || last_ns != expected + 999999) {
+                std::cerr << "ERROR: Wrong time read from \"" << line << "\": " << first_ns << std::endl;
+                ok = false;
+            }
+        }
+        int64_t first_ns = 0;
+        int64_t last_ns = 0;
+        if (parser.parse("[INFO] [42] no timestamp", first_ns, last_ns)) {
+            std::cerr << "ERROR: Time read from a line without a timestamp" << std::endl;
+            ok = false;
+        }
+    }
+    
+    // The index holds record times, and compressed generations keep an index of their own
+    const std::string timed_file = "log_search_time_test.log";
+    auto remove_timed = [&timed_file]() {
+        for (const std::string& name : {timed_file, timed_file + ".next"}) {
+            std::filesystem::remove(name);
+            std::filesystem::remove(name + ".idx");
+        }
+        for (int i = 1; i <= 3; ++i) {
+            const std::string generation = timed_file + "." + std::to_string(i);
+            for (const std::string& name : {generation, generation + ".iclz"}) {
+                std::filesystem::remove(name);
+                std::filesystem::remove(name + ".idx");
+            }
+        }
+    };
+    remove_timed();
+    {
+        const auto now = std::chrono::system_clock::now();
+        auto timed_line = [](std::chrono::system_clock::time_point time, const std::string& text) {
+            std::string line = "[";
+            detail::append_timestamp(line, TimestampFormat::STANDARD, TimestampPrecision::MILLISECONDS, time);
+            return line + "] " + text;
+        };
+        
+        RotatingFileLogger file_logger(timed_file, 200000, 3, FlushPolicy::explicit_only());
+        file_logger.set_compression(LogCompression::LZ);
+        file_logger.enable_index(4096);
+        for (int i = 0; i < 3000; ++i) {
+            file_logger.write(timed_line(now - std::chrono::hours(3) + std::chrono::milliseconds(i),
+                                         "[DEBUG] old request " + std::to_string(i)), LOG_DEBUG);
+        }
+        for (int i = 0; i < 3000; ++i) {
+            file_logger.write(timed_line(now - std::chrono::minutes(10) + std::chrono::milliseconds(i),
+                                         "[INFO] new request " + std::to_string(i)), LOG_INFO);
+        }
+        // Delivered late, e.g. by an asynchronous queue
+        file_logger.write(timed_line(now - std::chrono::hours(2), "[ERROR] late record"), LOG_ERROR);
+        file_logger.flush();
+        file_logger.wait_for_rotation();
+        
+        if (!std::filesystem::exists(timed_file + ".1.iclz") || !std::filesystem::exists(timed_file + ".1.iclz.idx")) {
+            std::cerr << "ERROR: Compressed generation has no index" << std::endl;
+            ok = false;
+        }
+        
+        LogSearcher searcher(timed_file, 3);
+        size_t old_lines = 0;
+        auto count_old = [&old_lines](std::string_view line) {
+            old_lines += line.find("old request") != std::string_view::npos ? 1 : 0;
+        };
+        LogQuery query;
+        query.from = now - std::chrono::hours(1);
+        size_t found = searcher.search(query, count_old);
+        if (found != 3000 || old_lines != 0) {
+            std::cerr << "ERROR: Indexed time range search returned " << found << " lines, " << old_lines
+                      << " of them too old" << std::endl;
+            ok = false;
+        }
+        if (searcher.last_stats().skipped_blocks == 0) {
+            std::cerr << "ERROR: Time range search decoded every compressed block" << std::endl;
+            ok = false;
+        }
+        
+        query = LogQuery();
+        query.from = now - std::chrono::hours(2) - std::chrono::minutes(1);
+        query.to = now - std::chrono::hours(2) + std::chrono::minutes(1);
+        std::vector<std::string> lines;
+        searcher.search(query, [&lines](std::string_view line) { lines.emplace_back(line); });
+        if (lines.size() != 1 || lines[0].find("late record") == std::string::npos) {
+            std::cerr << "ERROR: Late record search returned " << lines.size() << " lines" << std::endl;
+            ok = false;
+        }
+        
+        // Without the indexes every line's own timestamp is checked
+        std::filesystem::remove(timed_file + ".idx");
+        std::filesystem::remove(timed_file + ".1.iclz.idx");
+        old_lines = 0;
+        query = LogQuery();
+        query.from = now - std::chrono::hours(1);
+        found = searcher.search(query, count_old);
+        if (found != 3000 || old_lines != 0 || searcher.last_stats().indexed_blocks != 0) {
+            std::cerr << "ERROR: Unindexed time range search returned " << found << " lines, " << old_lines
+                      << " of them too old" << std::endl;
+            ok = false;
+        }
+    }
+    remove_timed();
+    
+    if (ok) {
+        std::cout << "Log search tests passed!" << std::endl;
+    }
+}
+
+// Test function for the pattern-compiled formatter
+void test_pattern_formatter() {
+    using namespace interlaced::core::logging;
+    
+    std::cout << "Testing pattern formatter..." << std::endl;
+    
+    bool ok = true;
+    const LogField fields[] = {{"user", LogField::Type::STRING, {}, "bob"}};
+    LogRecord record;
+    record.level = LOG_WARNING;
+    record.message = "Disk almost full";
+    record.time = std::chrono::system_clock::from_time_t(1700000000) + std::chrono::nanoseconds(123456789);
+    record.file = "/src/app/storage.cpp";
+    record.line = 42;
+    record.fields = fields;
+    record.field_count = 1;
+    record.category = "io.disk";
+    
+    const std::time_t seconds = 1700000000;
+    std::tm local_tm;
+    localtime_threadsafe(&seconds, &local_tm);
+    char date[32];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", &local_tm);
+    
+    PatternFormatter formatter("%Y-%m-%dT%H:%M:%S.%f|%e|%F|%E [%l/%L] [%t] [%P] %n: %v%{ (%s:%# %g)%} 100%% %q");
+    std::string out;
+    formatter.format_to(out, record);
+    const std::string expected = std::string(date) + ".123456|123|123456789|1700000000 [WARNING/W] [" +
+                                 std::to_string(detail::current_thread_id()) + "] [" +
+                                 std::to_string(detail::current_process_id()) +
+                                 "] io.disk: Disk almost full user=bob (storage.cpp:42 /src/app/storage.cpp) 100% %q";
+    if (out != expected) {
+        std::cerr << "ERROR: Pattern formatter wrote '" << out << "', expected '" << expected << "'" << std::endl;
+        ok = false;
+    }
+#ifndef _WIN32
+    if (detail::current_process_id() != static_cast<long>(::getpid())) {
+        std::cerr << "ERROR: Pattern formatter reported the wrong process ID" << std::endl;
+        ok = false;
+    }
+#endif
+    
+    // Without a source location the %{ %} section is left out
+    record.file = nullptr;
+    record.line = 0;
+    out.clear();
+    PatternFormatter("[%l] %v%{ (%s:%#)%}!").format_to(out, record);
+    if (out != "[WARNING] Disk almost full user=bob!") {
+        std::cerr << "ERROR: Pattern formatter kept the source section: '" << out << "'" << std::endl;
+        ok = false;
+    }
+    
+    // Threads report their own IDs
+    uint64_t other_thread_id = 0;
+    std::thread([&other_thread_id]() { other_thread_id = detail::current_thread_id(); }).join();
+    if (other_thread_id == 0 || other_thread_id == detail::current_thread_id()) {
+        std::cerr << "ERROR: Pattern formatter thread IDs are not per thread" << std::endl;
+        ok = false;
+    }
+    
+    // The macros pass __FILE__ as given, plus its basename computed at compile time
+    static_assert(detail::basename_offset("/a/b\\c.cpp") == 5, "basename_offset must see both separators");
+    Logger::set_level(LOG_DEBUG);
+    auto sink = std::make_shared<MemorySink>();
+    SinkOptions options;
+    options.formatter = std::make_shared<PatternFormatter>("%l %s:%# %v|%g");
+    Logger::add_sink("pattern", sink, options);
+    auto legacy_sink = std::make_shared<MemorySink>();
+    SinkOptions legacy_options;
+    legacy_options.formatter = std::make_shared<CustomFormatter>();
+    Logger::add_sink("legacy", legacy_sink, legacy_options);
+    const int line = __LINE__ + 1;
+    LOG_INFO("From a macro");
+    Logger::remove_sink("pattern");
+    Logger::remove_sink("legacy");
+    if (sink->lines() != std::vector<std::string>{"INFO logging_test.cpp:" + std::to_string(line) + " From a macro|" +
+                                                  __FILE__}) {
+        std::cerr << "ERROR: LOG_INFO did not pass the source file and basename" << std::endl;
+        ok = false;
+    }
+    const std::string legacy_expected = "[Custom] INFO From a macro [" + std::string(__FILE__) + ":" +
+                                        std::to_string(line) + "]";
+    if (legacy_sink->lines() != std::vector<std::string>{legacy_expected}) {
+        std::cerr << "ERROR: format() received '" << legacy_sink->lines().front() << "'" << std::endl;
+        ok = false;
+    }
+    
+    if (ok) {
+        std::cout << "Pattern formatter tests passed!" << std::endl;
+    }
+}
+
+int main() {
+    using namespace interlaced::core::logging;
+    
+    std::cout << "=== Starting Comprehensive Logging Tests ===" << std::endl;
+    
+    // Test log level to string conversion
+    test_log_level_to_string();
+    
+    // Test basic logging
+    Logger::info("Starting comprehensive logging tests");
+    
+    // Test different log levels
+    Logger::debug("This is a debug message");
+    Logger::info("This is an info message");
+    Logger::warning("This is a warning message");
+    Logger::error("This is an error message");
+    
+    // Test log level filtering
+    Logger::set_level(LOG_WARNING);
+    Logger::info("This info message should NOT appear");
+    Logger::warning("This warning message SHOULD appear");
+    Logger::error("This error message SHOULD appear");
+    
+    Logger::set_level(LOG_DEBUG);
+    
+    // Test file/line information
+    LOG_INFO("This message includes file and line info");
+    LOG_ERROR("This error includes file and line info");
+    
+    // Test structured logging
+    Logger::info("User login", "user_id", 12345, "ip_address", "192.168.1.1");
+    Logger::warning("High memory usage", "used_mb", 850, "limit_mb", 1000);
+    Logger::error("Database connection failed", "error_code", 500, "server", "db01.prod");
+    
+    // Test variadic template logging
+    Logger::info("User {} logged in from IP {}", "john_doe", "192.168.1.100");
+    Logger::warning("Disk usage is at {}%", 95);
+    Logger::error("Database connection failed with code {} for user {}", 500, "admin");
+    
+    // Test custom streams
+    test_custom_streams();
+    
+    // Test custom formatter
+    test_custom_formatter();
+    
+    // Test lock-free level filtering
+    test_level_filtering();
+    
+    // Test timestamp formats and precision
+    test_timestamp_formats();
+    
+    // Test allocation-free formatting
+    test_allocation_free_formatting();
+    
+    // Test file flush policies
+    test_flush_policies();
+    
+    // Test rotation off the logging thread
+    test_background_rotation();
+    
+    // Test compression of rotated files
+    test_compressed_rotation();
+    
+    // Test io_uring and writer-thread file writes
+    test_async_file_writes();
+    
+    // Test asynchronous logging
+    test_async_logging();
+    
+    // Test binary logging and decoding
+    test_binary_logging();
+    
+    // Test compile-time parsed format strings
+    test_compile_time_format();
+    
+    // Test multi-sink fan-out
+    test_sinks();
+    
+    // Test per-thread sharded files and merging
+    test_sharded_files();
+    
+    // Test the memory-mapped segment sink
+    test_mapped_file_sink();
+    
+    // Test rate limiting, sampling and duplicate suppression
+    test_throttling();
+    
+    // Test typed structured fields and JSON lines
+    test_structured_fields();
+    
+    // Test level checks before argument evaluation in LOG_* macros
+    test_lazy_macros();
+    
+    // Test the in-memory flight recorder
+    test_flight_recorder();
+    
+    // Test hierarchical categories
+    test_categories();
+    
+    // Test the logger's own counters
+    test_stats();
+    
+    // Test the batched datagram sink
+    test_datagram_sink();
+    
+    // Test indexed log search
+    test_log_search();
+    
+    // Test the pattern formatter
+    test_pattern_formatter();
     
     // Test custom formatter with file/line info
     Logger::set_formatter(std::make_unique<CustomFormatter>());
@@ -55,9 +55,9 @@ int main() {
     std::string json = interlaced::core::json::JSON::stringify(data);
     LOG_INFO("JSON: " + json);
     
-    // Test network
-    std::string response = interlaced::core::network::Network::http_get("http://example.com");
-    LOG_INFO("HTTP Response: " + response);
+    // Test network; https:// is rejected before any lookup, so this needs no network access
+    auto response = interlaced::core::network::Network::http_get("https://example.com");
+    LOG_INFO("HTTP Response: " + (response.success ? std::to_string(response.status_code) : response.message));
     
     LOG_INFO("Tests completed");
     return 0;
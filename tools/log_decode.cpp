@@ -0,0 +1,102 @@
+/*
+ * Interlaced Core Library
+ * Copyright (c) 2025 Your Name or Organization
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Decodes a binary log file written by Logger::set_binary_logging() into the
+// text layout produced by DefaultLogFormatter.
+//
+// Usage: interlaced_log_decode [options] <file.binlog>
+//   --iso8601 | --unix | --no-timestamp   Timestamp format (default: local time)
+//   --ms | --us | --ns                     Fractional second digits (default: none)
+//   --prefix <text>                        Text placed before every line
+
+#include "interlaced_core/logging.hpp"
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+    void print_usage(const char* program) {
+        std::cerr << "Usage: " << program
+                  << " [--iso8601|--unix|--no-timestamp] [--ms|--us|--ns] [--prefix <text>] <file.binlog>" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    using namespace interlaced::core::logging;
+
+    TimestampFormat format = TimestampFormat::STANDARD;
+    TimestampPrecision precision = TimestampPrecision::SECONDS;
+    std::string prefix;
+    std::string filename;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--iso8601") == 0) {
+            format = TimestampFormat::ISO8601;
+        } else if (std::strcmp(arg, "--unix") == 0) {
+            format = TimestampFormat::UNIX;
+        } else if (std::strcmp(arg, "--no-timestamp") == 0) {
+            format = TimestampFormat::NONE;
+        } else if (std::strcmp(arg, "--ms") == 0) {
+            precision = TimestampPrecision::MILLISECONDS;
+        } else if (std::strcmp(arg, "--us") == 0) {
+            precision = TimestampPrecision::MICROSECONDS;
+        } else if (std::strcmp(arg, "--ns") == 0) {
+            precision = TimestampPrecision::NANOSECONDS;
+        } else if (std::strcmp(arg, "--prefix") == 0 && i + 1 < argc) {
+            prefix = argv[++i];
+        } else if (arg[0] != '-' && filename.empty()) {
+            filename = arg;
+        } else {
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+    if (filename.empty()) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    BinaryLogReader reader(filename);
+    if (!reader.is_open()) {
+        std::cerr << "interlaced_log_decode: " << reader.error() << std::endl;
+        return 1;
+    }
+
+    DefaultLogFormatter formatter(format, prefix, precision);
+    BinaryLogEntry entry;
+    std::string line;
+    while (reader.next(entry)) {
+        line.clear();
+        formatter.format_to(line, entry.record());
+        line += '\n';
+        std::cout.write(line.data(), static_cast<std::streamsize>(line.size()));
+    }
+    std::cout.flush();
+
+    if (!reader.error().empty()) {
+        std::cerr << "interlaced_log_decode: " << reader.error() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * Interlaced Core Library
+ * Copyright (c) 2025 Your Name or Organization
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Merges the per-thread shard files written by ShardedFileSink into one
+// time-ordered log on standard output.
+//
+// Usage: interlaced_log_merge [options] <base_filename>
+//   --max-files <n>       Rotated files kept per shard (default: 5)
+//   --keep-timestamps     Keep the nanosecond prefix on every line
+
+#include "interlaced_core/logging.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+    void print_usage(const char* program) {
+        std::cerr << "Usage: " << program << " [--max-files <n>] [--keep-timestamps] <base_filename>" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    using namespace interlaced::core::logging;
+
+    int max_files = 5;
+    bool keep_timestamps = false;
+    std::string base_filename;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--max-files") == 0 && i + 1 < argc) {
+            max_files = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--keep-timestamps") == 0) {
+            keep_timestamps = true;
+        } else if (arg[0] != '-' && base_filename.empty()) {
+            base_filename = arg;
+        } else {
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+    if (base_filename.empty() || max_files < 0) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    ShardedLogReader reader(base_filename, max_files);
+    if (reader.shard_count() == 0) {
+        std::cerr << "interlaced_log_merge: no shards found for " << base_filename << std::endl;
+        return 1;
+    }
+
+    ShardedLogLine line;
+    std::string out;
+    while (reader.next(line)) {
+        out.clear();
+        if (keep_timestamps) {
+            const long long nanoseconds =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(line.time.time_since_epoch()).count();
+            detail::append_zero_padded(out, static_cast<unsigned long long>(nanoseconds), ShardedFileSink::kTimestampDigits);
+            out += ' ';
+        }
+        out += line.text;
+        out += '\n';
+        std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
+    }
+    std::cout.flush();
+    return 0;
+}
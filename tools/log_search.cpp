@@ -0,0 +1,147 @@
+/*
+ * Interlaced Core Library
+ * Copyright (c) 2025 Your Name or Organization
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Searches the files of a rotating log by time, level and text, using the
+// sidecar indexes written by RotatingFileLogger::enable_index() when present.
+//
+// Usage: interlaced_log_search [options] <base_filename>
+//   --max-files <n>       Rotated files to search (default: 5)
+//   --from <time>         Only print lines logged at or after this time
+//   --to <time>           Only print lines logged at or before this time
+//   --level <level>       Minimum level: DEBUG, INFO, WARNING or ERROR
+//   --contains <text>     Only print lines containing text
+//   --stats               Print how much was scanned and skipped to stderr
+//
+// Times are unix seconds or local "YYYY-MM-DD HH:MM:SS" (a 'T' separator works too).
+
+#include "interlaced_core/logging.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+
+namespace {
+    void print_usage(const char* program) {
+        std::cerr << "Usage: " << program << " [--max-files <n>] [--from <time>] [--to <time>]"
+                  << " [--level <level>] [--contains <text>] [--stats] <base_filename>" << std::endl;
+    }
+
+    bool parse_time(const char* text, std::chrono::system_clock::time_point& time) {
+        char* end = nullptr;
+        const long long seconds = std::strtoll(text, &end, 10);
+        if (end != text && *end == '\0') {
+            time = std::chrono::system_clock::time_point(std::chrono::seconds(seconds));
+            return true;
+        }
+        std::tm parts = {};
+        char separator = 0;
+        if (std::sscanf(text, "%d-%d-%d%c%d:%d:%d", &parts.tm_year, &parts.tm_mon, &parts.tm_mday, &separator,
+                        &parts.tm_hour, &parts.tm_min, &parts.tm_sec) != 7 ||
+            (separator != ' ' && separator != 'T')) {
+            return false;
+        }
+        parts.tm_year -= 1900;
+        parts.tm_mon -= 1;
+        parts.tm_isdst = -1;
+        const std::time_t local = std::mktime(&parts);
+        if (local == static_cast<std::time_t>(-1)) {
+            return false;
+        }
+        time = std::chrono::system_clock::from_time_t(local);
+        return true;
+    }
+
+    bool parse_level(const char* text, interlaced::core::logging::LogLevel& level) {
+        using namespace interlaced::core::logging;
+        for (LogLevel candidate : {LOG_DEBUG, LOG_INFO, LOG_WARNING, LOG_ERROR}) {
+            if (std::strcmp(text, log_level_to_string(candidate)) == 0) {
+                level = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    using namespace interlaced::core::logging;
+
+    int max_files = 5;
+    bool show_stats = false;
+    LogQuery query;
+    std::string base_filename;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool valid = true;
+        if (std::strcmp(arg, "--max-files") == 0 && i + 1 < argc) {
+            max_files = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--from") == 0 && i + 1 < argc) {
+            valid = parse_time(argv[++i], query.from);
+        } else if (std::strcmp(arg, "--to") == 0 && i + 1 < argc) {
+            valid = parse_time(argv[++i], query.to);
+        } else if (std::strcmp(arg, "--level") == 0 && i + 1 < argc) {
+            valid = parse_level(argv[++i], query.min_level);
+        } else if (std::strcmp(arg, "--contains") == 0 && i + 1 < argc) {
+            query.contains = argv[++i];
+        } else if (std::strcmp(arg, "--stats") == 0) {
+            show_stats = true;
+        } else if (arg[0] != '-' && base_filename.empty()) {
+            base_filename = arg;
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+    if (base_filename.empty() || max_files < 0) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    LogSearcher searcher(base_filename, max_files);
+    if (searcher.file_count() == 0) {
+        std::cerr << "interlaced_log_search: no files found for " << base_filename << std::endl;
+        return 1;
+    }
+
+    std::string out;
+    searcher.search(query, [&out](std::string_view line) {
+        out.assign(line.data(), line.size());
+        out += '\n';
+        std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
+    });
+    std::cout.flush();
+
+    if (show_stats) {
+        const LogSearchStats& stats = searcher.last_stats();
+        std::cerr << stats.matches << " matches in " << stats.files << " files; scanned " << stats.bytes_scanned
+                  << " bytes, skipped " << stats.skipped_blocks << " of " << stats.indexed_blocks << " indexed blocks"
+                  << std::endl;
+    }
+    return 0;
+}